@@ -5,6 +5,7 @@
 
 #include <boot/multiboot2.h>
 #include <debug/debug.h>
+#include <memory/memory.h>
 #include <util/string.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -54,6 +55,7 @@ typedef struct acpi_found_tables {
 	const acpi_sdt_header* fadt; /* FACP */
 	const acpi_hpet* hpet;
 	const acpi_sdt_header* mcfg;
+	const acpi_sdt_header* dsdt; /* FADT'nin gösterdiği DSDT (S5 için) */
 } acpi_found_tables;
 
 static acpi_found_tables g_acpi_tables; /* Basit global durum */
@@ -65,6 +67,60 @@ const acpi_madt*        acpi_get_madt(void) { return g_acpi_tables.madt; }
 const acpi_sdt_header*  acpi_get_fadt(void) { return g_acpi_tables.fadt; }
 const acpi_hpet*        acpi_get_hpet(void) { return g_acpi_tables.hpet; }
 const acpi_sdt_header*  acpi_get_mcfg(void) { return g_acpi_tables.mcfg; }
+const acpi_sdt_header*  acpi_get_dsdt(void) { return g_acpi_tables.dsdt; }
+
+/*
+ * Kullandığımız tabloları heap'e kopyala. Firmware bunları genelde
+ * ACPI_RECLAIMABLE bölgelere koyar; pmm_reclaim_boot_memory() o bölgeleri
+ * PMM'e verdikten sonra orijinal adresler geçersiz olur.
+ */
+static const void* acpi_copy_table(const acpi_sdt_header* hdr)
+{
+	if (!hdr) return NULL;
+	void* copy = malloc(hdr->Length);
+	if (!copy) {
+		ERROR("ACPI: failed to copy %c%c%c%c (%u bytes)",
+			  hdr->Signature[0], hdr->Signature[1], hdr->Signature[2], hdr->Signature[3],
+			  (unsigned)hdr->Length);
+		return NULL;
+	}
+	memcpy(copy, hdr, hdr->Length);
+	return copy;
+}
+
+static const acpi_sdt_header* acpi_find_dsdt(const acpi_sdt_header* fadt_hdr)
+{
+	if (!fadt_hdr) return NULL;
+	const acpi_fadt_unified* fadt = (const acpi_fadt_unified*)fadt_hdr;
+
+	uintptr_t phys = 0;
+	/* XDsdt yalnızca FADT yeterince uzunsa geçerli */
+	if (fadt_hdr->Length >= offsetof(acpi_fadt_unified, XDsdt) + sizeof(fadt->XDsdt) && fadt->XDsdt) {
+		phys = (uintptr_t)fadt->XDsdt;
+	} else if (fadt->Dsdt) {
+		phys = (uintptr_t)fadt->Dsdt;
+	}
+
+	const acpi_sdt_header* dsdt = (const acpi_sdt_header*)phys;
+	if (!dsdt || !acpi_validate_signature(dsdt->Signature, ACPI_SIG_DSDT) || !acpi_validate_sdt(dsdt))
+		return NULL;
+	return dsdt;
+}
+
+static void acpi_relocate_tables(acpi_found_tables* t)
+{
+	const acpi_sdt_header* p;
+
+	if ((p = acpi_copy_table((const acpi_sdt_header*)t->madt)) != NULL) t->madt = (const acpi_madt*)p;
+	if ((p = acpi_copy_table(t->fadt)) != NULL) t->fadt = p;
+	if ((p = acpi_copy_table((const acpi_sdt_header*)t->hpet)) != NULL) t->hpet = (const acpi_hpet*)p;
+	if ((p = acpi_copy_table(t->mcfg)) != NULL) t->mcfg = p;
+	if ((p = acpi_copy_table(t->dsdt)) != NULL) t->dsdt = p;
+
+	/* Kök tablolar yalnızca açılışta taranır; girdileri orijinal adresleri gösterir */
+	t->xsdt = NULL;
+	t->rsdt = NULL;
+}
 
 static void acpi_scan_rsdt_xsdt(const acpi_sdt_header* root, acpi_found_tables* out)
 {
@@ -204,6 +260,14 @@ void acpi_init(void)
 	/* Kök tabloyu tara ve önemli tabloları keşfet */
 	acpi_scan_rsdt_xsdt(root, &found);
 
+	found.dsdt = acpi_find_dsdt(found.fadt);
+	if (!found.dsdt) {
+		WARN("ACPI: DSDT not found or invalid");
+	}
+
+	/* Reclaim öncesi kullanılan tabloları heap'e taşı */
+	acpi_relocate_tables(&found);
+
 	/* FADT ve MADT'yi global değişkenlere kopyala */
 	if (found.fadt) {
 		acpi_fadt_ptr = (void*)found.fadt;
@@ -230,9 +294,9 @@ void acpi_init(void)
 	}
 
 	/* Son durum raporu */
-	LOG("ACPI: Summary -> XSDT=%p RSDT=%p MADT=%p FADT=%p HPET=%p MCFG=%p",
-		(void*)found.xsdt, (void*)found.rsdt, (void*)found.madt,
-		(void*)found.fadt, (void*)found.hpet, (void*)found.mcfg);
+	LOG("ACPI: Summary -> MADT=%p FADT=%p HPET=%p MCFG=%p DSDT=%p (heap copies)",
+		(void*)found.madt, (void*)found.fadt, (void*)found.hpet,
+		(void*)found.mcfg, (void*)found.dsdt);
 
 	g_acpi_tables = found; /* Global durum güncelleme */
 }
@@ -134,6 +134,9 @@ static void acpi_enable_legacy_if_needed(const acpi_fadt_unified* fadt)
 static const acpi_sdt_header* acpi_get_dsdt_from_fadt(const acpi_fadt_unified* fadt)
 {
     if (!fadt) return NULL;
+    // acpi_init keeps a heap copy; the firmware copy may already be reclaimed
+    const acpi_sdt_header* copy = acpi_get_dsdt();
+    if (copy) return copy;
     // Prefer XDsdt if present (v2+), else Dsdt
     if (fadt->XDsdt) {
         return (const acpi_sdt_header*)(uintptr_t)fadt->XDsdt;
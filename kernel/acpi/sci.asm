@@ -2,6 +2,7 @@ section .text
 
 global sci_isr
 extern sci_isr_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -23,7 +24,8 @@ sci_isr:
     push r14
     push r15
 
-    call sci_isr_handler
+    mov rax, sci_isr_handler
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -49,7 +51,8 @@ sci_isr:
 
     pushad
 
-    call sci_isr_handler
+    mov eax, sci_isr_handler
+    call irq_fpu_call
 
     popad
 
@@ -0,0 +1,52 @@
+default rel
+section .text
+
+extern thread_bootstrap
+extern fiber_bootstrap
+
+; System V AMD64 calling convention
+; void arch_context_switch(size_t* old_sp, size_t new_sp)
+; Save callee-saved registers and RFLAGS on the current stack, store RSP into
+; *old_sp, switch to new_sp and pop the same frame there. Called with
+; interrupts disabled; the popped RFLAGS decides whether they come back on.
+global arch_context_switch
+arch_context_switch:
+	pushfq
+	push rbp
+	push rbx
+	push r12
+	push r13
+	push r14
+	push r15
+
+	mov [rdi], rsp
+	mov rsp, rsi
+
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rbp
+	popfq
+	ret
+
+; First "return" target of a new thread (frame built by thread_create)
+global arch_thread_trampoline
+arch_thread_trampoline:
+	xor ebp, ebp           ; end of frame chain for backtraces
+	and rsp, -16           ; SysV: 16-byte aligned before call
+	call thread_bootstrap
+.hang:
+	hlt                    ; thread_bootstrap never returns
+	jmp .hang
+
+; First "return" target of a new fiber (frame built by fiber_create)
+global arch_fiber_trampoline
+arch_fiber_trampoline:
+	xor ebp, ebp
+	and rsp, -16
+	call fiber_bootstrap
+.hang:
+	hlt                    ; fiber_bootstrap never returns
+	jmp .hang
@@ -1,28 +1,131 @@
 default rel
 section .bss
 
-; Global flag indicating ERMS support (0/1)
+; Global flags consumed by memcpy.asm (0/1)
 global erms_supported
+global fsrm_supported
+global mem_simd_level
 erms_supported: resb 1
+fsrm_supported: resb 1
+; 0: scalar only, 1: SSE2, 2: AVX2 (only when the OS-side enable bits are set)
+mem_simd_level: resb 1
+
+section .data
+
+; Copies/fills at least this large use non-temporal stores (bypass the cache)
+global mem_nt_threshold
+mem_nt_threshold: dq 0x100000
 
 section .text
 
-; void detect_erms(void)
-; - Detects Enhanced REP MOVSB/STOSB (ERMS) via CPUID.(EAX=7,ECX=0):EBX[9]
-; - Writes 0/1 to erms_supported and also returns it in AL/EAX (for convenience)
+; uint32_t detect_cpu_features(void)
+; - ERMS: CPUID.(EAX=7,ECX=0):EBX[9], FSRM: CPUID.(EAX=7,ECX=0):EDX[4]
+; - SSE2: CPUID.1:EDX[26] and CR4.OSFXSR
+; - AVX2: CPUID.1:ECX[27,28] (OSXSAVE, AVX), CPUID.7:EBX[5] and XCR0[2:1] == 11b
+; - Writes the flags above and returns erms_supported in EAX
+; - Safe to call again once the kernel changes CR4/XCR0
 ; - Preserves callee-saved registers as per SysV AMD64 (RBX is clobbered by CPUID, so we save it)
-global detect_erms
-detect_erms:
+global detect_cpu_features
+detect_cpu_features:
     push    rbx                ; preserve callee-saved
+
     xor     eax, eax
+    cpuid
+    mov     r8d, eax           ; highest basic leaf
+
+    xor     r9d, r9d           ; leaf 7 EBX
+    xor     r10d, r10d         ; leaf 7 EDX
+    cmp     r8d, 7
+    jb      .no_leaf7
     mov     eax, 7             ; CPUID leaf 7
     xor     ecx, ecx           ; subleaf 0
-    cpuid                      ; EBX has feature flags
+    cpuid
+    mov     r9d, ebx
+    mov     r10d, edx
+.no_leaf7:
+
+    bt      r9d, 9
+    setc    byte [rel erms_supported]
+    bt      r10d, 4
+    setc    byte [rel fsrm_supported]
+
+    mov     eax, 1
+    cpuid
+    mov     r11d, ecx          ; leaf 1 ECX
+    xor     r8d, r8d           ; SIMD level
+
+    bt      edx, 26            ; SSE2
+    jnc     .done
+    mov     rax, cr4
+    bt      rax, 9             ; CR4.OSFXSR
+    jnc     .done
+    mov     r8d, 1
+
+    bt      r11d, 27           ; OSXSAVE
+    jnc     .done
+    bt      r11d, 28           ; AVX
+    jnc     .done
+    bt      r9d, 5             ; AVX2
+    jnc     .done
+    xor     ecx, ecx
+    xgetbv                     ; XCR0 -> EDX:EAX
+    and     eax, 6
+    cmp     eax, 6             ; SSE and AVX state enabled
+    jne     .done
+    mov     r8d, 2
+
+.done:
+    mov     byte [rel mem_simd_level], r8b
+    movzx   eax, byte [rel erms_supported]
+    pop     rbx
+    ret
+
+; void enable_cpu_simd(void)
+; Turn on x87/SSE for kernel code and, when XSAVE exists, AVX state as well:
+; - CR0: MP=1, EM=0, TS=0 (no #NM traps, FWAIT honours TS)
+; - CR4: OSFXSR | OSXMMEXCPT (SSE, unmasked SIMD FP exceptions -> #XM)
+; - CR4.OSXSAVE + XCR0 = x87 | SSE (| AVX when CPUID.1:ECX[28])
+; AVX-512 state is intentionally left disabled so the XSAVE area stays small.
+; Call detect_cpu_features afterwards so memcpy sees the new SIMD level.
+global enable_cpu_simd
+enable_cpu_simd:
+    push    rbx
+
+    mov     eax, 1
+    cpuid
+
+    bt      edx, 0             ; FPU
+    jnc     .es_done
+    mov     rax, cr0
+    and     rax, ~((1 << 2) | (1 << 3)) ; EM=0, TS=0
+    or      rax, (1 << 1) | (1 << 5)    ; MP=1, NE=1
+    mov     cr0, rax
+    fninit
+
+    bt      edx, 24            ; FXSR
+    jnc     .es_done
+    bt      edx, 25            ; SSE
+    jnc     .es_done
+    mov     rax, cr4
+    or      rax, (1 << 9) | (1 << 10) ; OSFXSR, OSXMMEXCPT
+    mov     cr4, rax
+
+    bt      ecx, 26            ; XSAVE
+    jnc     .es_done
+    mov     rax, cr4
+    or      rax, (1 << 18)    ; OSXSAVE
+    mov     cr4, rax
+
+    mov     ebx, ecx
+    mov     eax, 3             ; x87 | SSE
+    bt      ebx, 28            ; AVX
+    jnc     .es_xcr0
+    or      eax, 4             ; AVX (YMM upper halves)
+.es_xcr0:
+    xor     edx, edx
+    xor     ecx, ecx
+    xsetbv
 
-    ; Check EBX bit 9 (ERMS)
-    bt      ebx, 9
-    setc    al                 ; AL = 1 if ERMS present, else 0
-    mov     byte [rel erms_supported], al
-    movzx   eax, al            ; return 0/1 in EAX as well
+.es_done:
     pop     rbx
     ret
@@ -0,0 +1,72 @@
+// Per-CPU GDT/TSS (amd64): boot GDT'nin kopyası + çekirdeğe ait TSS, GS tabanı = per-CPU blok
+#include <arch.h>
+#include <memory/memory.h>
+
+#define IA32_GS_BASE        0xC0000101u
+#define IA32_KERNEL_GS_BASE 0xC0000102u
+
+typedef struct {
+	uint16_t limit;
+	uint64_t base;
+} __attribute__((packed)) gdt_ptr64_t;
+
+extern uint64_t gdt_amd64[];
+extern gdt_ptr64_t gdtr_amd64;
+extern uint8_t idt_ptr[];
+
+static inline void wrmsr(uint32_t msr, uint64_t value)
+{
+	uint32_t lo = (uint32_t)(value & 0xFFFFFFFFu);
+	uint32_t hi = (uint32_t)(value >> 32);
+	__asm__ __volatile__("wrmsr" :: "c"(msr), "a"(lo), "d"(hi));
+}
+
+// 64-bit TSS tanımlayıcısı iki giriş kaplar
+static void __set_tss_descriptor(uint64_t* gdt, size_t index, uint64_t base, uint32_t limit)
+{
+	uint64_t low = (uint64_t)(limit & 0xFFFFu)
+	             | ((base & 0xFFFFFFull) << 16)
+	             | (0x89ull << 40)                       // present, 64-bit TSS (available)
+	             | ((uint64_t)((limit >> 16) & 0xFu) << 48)
+	             | (((base >> 24) & 0xFFull) << 56);
+	gdt[index] = low;
+	gdt[index + 1] = base >> 32;
+}
+
+void arch_cpu_tables_load(arch_cpu_tables_t* tables, void* percpu)
+{
+	size_t boot_entries = ((size_t)gdtr_amd64.limit + 1) / 8;
+	if (boot_entries > ARCH_GDT_ENTRIES) boot_entries = ARCH_GDT_ENTRIES;
+
+	memset(tables, 0, sizeof(*tables));
+	memcpy(tables->gdt, gdt_amd64, boot_entries * 8);
+
+	tables->tss.iomap_base = (uint16_t)sizeof(arch_tss_t); // I/O izin haritası yok
+	__set_tss_descriptor(tables->gdt, ARCH_GDT_TSS_SEL / 8,
+	                     (uint64_t)(uintptr_t)&tables->tss, (uint32_t)sizeof(arch_tss_t) - 1);
+
+	gdt_ptr64_t gdtr = { .limit = (uint16_t)(sizeof(tables->gdt) - 1), .base = (uint64_t)(uintptr_t)tables->gdt };
+	__asm__ __volatile__("lgdt %0" : : "m"(gdtr) : "memory");
+
+	// CS'yi yeni tablodan yeniden yükle, ardından veri segmentleri
+	__asm__ __volatile__(
+		"pushq $0x08\n\t"
+		"leaq 1f(%%rip), %%rax\n\t"
+		"pushq %%rax\n\t"
+		"lretq\n"
+		"1:\n\t"
+		"movw $0x10, %%ax\n\t"
+		"movw %%ax, %%ds\n\t"
+		"movw %%ax, %%es\n\t"
+		"movw %%ax, %%ss\n\t"
+		"movw %%ax, %%fs\n\t"
+		"movw %%ax, %%gs\n\t"
+		: : : "rax", "memory");
+
+	__asm__ __volatile__("ltr %w0" : : "r"((uint16_t)ARCH_GDT_TSS_SEL));
+	__asm__ __volatile__("lidt (%0)" : : "r"(idt_ptr) : "memory");
+
+	// GS seçicisi yüklenince taban sıfırlanır; MSR en son yazılmalı
+	wrmsr(IA32_GS_BASE, (uint64_t)(uintptr_t)percpu);
+	wrmsr(IA32_KERNEL_GS_BASE, (uint64_t)(uintptr_t)percpu);
+}
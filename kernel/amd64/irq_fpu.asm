@@ -0,0 +1,78 @@
+default rel
+section .text
+
+global irq_fpu_call
+extern fpu_irq_method
+
+use64
+
+; Vector state save around an IRQ handler.
+;
+; gcc is free to use xmm registers in -O2 kernel code, and IRQ handlers
+; interrupt arbitrary code, so every IRQ stub calls its C handler through
+; here instead of calling it directly. The state is saved on the current
+; stack (not in a per-CPU area) because the timer handler may switch
+; threads before returning; each interrupted context keeps its own copy.
+;
+; fpu_irq_method is set by fpu_init: 0 none, 1 fnsave, 2 fxsave, 3 xsave.
+
+IRQ_FPU_AREA  equ 1024          ; FPU_AREA_SIZE, aligned to 64 below
+
+; void irq_fpu_call(handler [RAX])
+; Caller-saved general-purpose registers are the stub's responsibility.
+irq_fpu_call:
+    push    rbp
+    push    rbx
+    mov     rbp, rsp
+    mov     rbx, rax
+
+    sub     rsp, IRQ_FPU_AREA
+    and     rsp, -64
+
+    mov     ecx, [fpu_irq_method]
+    cmp     ecx, 3
+    jae     .xsave
+    cmp     ecx, 2
+    je      .fxsave
+    cmp     ecx, 1
+    je      .fnsave
+    call    rbx
+    jmp     .done
+
+.xsave:
+    ; XRSTOR rejects a header with XCOMP_BV or reserved bytes set, and
+    ; XSAVE only writes XSTATE_BV, so clear the 64-byte header first
+    xor     eax, eax
+    mov     [rsp + 512], rax
+    mov     [rsp + 520], rax
+    mov     [rsp + 528], rax
+    mov     [rsp + 536], rax
+    mov     [rsp + 544], rax
+    mov     [rsp + 552], rax
+    mov     [rsp + 560], rax
+    mov     [rsp + 568], rax
+    mov     eax, -1             ; every component enabled in XCR0
+    mov     edx, -1
+    xsave   [rsp]
+    call    rbx
+    mov     eax, -1
+    mov     edx, -1
+    xrstor  [rsp]
+    jmp     .done
+
+.fxsave:
+    fxsave  [rsp]
+    call    rbx
+    fxrstor [rsp]
+    jmp     .done
+
+.fnsave:
+    fnsave  [rsp]               ; also reinitialises the x87 unit for the handler
+    call    rbx
+    frstor  [rsp]
+
+.done:
+    mov     rsp, rbp
+    pop     rbx
+    pop     rbp
+    ret
@@ -2,59 +2,545 @@ default rel
 section .text
 
 global memcpy
+global memmove
+global memset
 extern erms_supported
+extern fsrm_supported
+extern mem_simd_level
+extern mem_nt_threshold
 
 use64
 
+; Path selection (flags are filled by detect_cpu_features at boot):
+;   n < MEM_SIMD_MIN          -> rep movsb/stosb with FSRM, otherwise a qword loop
+;   n >= mem_nt_threshold     -> SSE2/AVX2 loop with non-temporal stores
+;   ERMS                      -> rep movsb/stosb
+;   SSE2/AVX2                 -> vector loop with aligned stores
+;   otherwise                 -> rep movsq/stosq
+;
+; The vector registers used here are caller-saved in the C ABI, and IRQ
+; handlers run through irq_fpu_call, which saves the interrupted vector state,
+; so the SIMD paths clobber xmm0-3/ymm0-3 freely. The AVX2 paths end with
+; vzeroupper to avoid SSE/AVX transition stalls in the caller.
+
+MEM_SIMD_MIN      equ 256
+MEM_MOVE_MIN_DIST equ 128       ; overlapping moves need at least one block of distance
+
+; void* memcpy(void* dest [RDI], const void* src [RSI], size_t n [RDX])
 memcpy:
     cld
     mov     rax, rdi            ; return dest
 
     test    rdx, rdx
-    jz      .ret
+    jz      .cpy_ret
+
+    cmp     rdx, MEM_SIMD_MIN
+    jb      .cpy_small
 
-    ; If ERMS supported, prefer rep movsb for all sizes
+    movzx   r8d, byte [rel mem_simd_level]
+    test    r8d, r8d
+    jz      .cpy_scalar
+
+    xor     r9d, r9d            ; r9 = 0: regular stores
+    cmp     rdx, [rel mem_nt_threshold]
+    jae     .cpy_nt
     cmp     byte [rel erms_supported], 0
-    je      .no_erms
+    jne     .cpy_movsb
+    jmp     .cpy_simd
+.cpy_nt:
+    mov     r9d, 1              ; r9 = 1: non-temporal stores
+.cpy_simd:
+    cmp     r8d, 2
+    je      mem_copy_fwd_avx2
+    jmp     mem_copy_fwd_sse2
+
+.cpy_small:
+    cmp     byte [rel fsrm_supported], 0
+    jne     .cpy_movsb
     mov     rcx, rdx
+    shr     rcx, 3              ; qword count
+    jz      .cpy_tail
+.cpy_qloop:
+    mov     r8, [rsi]
+    mov     [rdi], r8
+    add     rsi, 8
+    add     rdi, 8
+    dec     rcx
+    jnz     .cpy_qloop
+.cpy_tail:
+    mov     rcx, rdx
+    and     rcx, 7
     rep     movsb
-    jmp     .ret
+    ret
 
-.no_erms:
+.cpy_movsb:
     mov     rcx, rdx
-    cmp     rcx, 32
-    jb      .small              ; small sizes: byte copy
+    rep     movsb
+    ret
+
+.cpy_scalar:
+    cmp     byte [rel erms_supported], 0
+    jne     .cpy_movsb
 
     ; If src and dst share 8-byte alignment, align to 8 first
     mov     r8, rdi
     xor     r8, rsi
     test    r8, 7
-    jne     .bulk
+    jne     .cpy_bulk
 
     mov     r8, rdi
     and     r8, 7
-    jz      .bulk
+    jz      .cpy_bulk
     mov     r9, 8
     sub     r9, r8              ; bytes to reach 8-byte alignment
-    cmp     r9, rdx
-    cmova   r9, rdx             ; clamp to remaining length
     mov     rcx, r9
     rep     movsb
     sub     rdx, r9
 
-.bulk:
+.cpy_bulk:
     mov     rcx, rdx
-    mov     r8, rcx
     shr     rcx, 3              ; qword count
     rep     movsq
-    mov     rcx, r8
+    mov     rcx, rdx
     and     rcx, 7              ; tail bytes
     rep     movsb
-    jmp     .ret
 
-.small:
+.cpy_ret:
+    ret
+
+; void* memmove(void* dest [RDI], const void* src [RSI], size_t n [RDX])
+memmove:
+    cld
+    mov     rax, rdi
+
+    test    rdx, rdx
+    jz      .mv_ret
+    mov     r8, rdi
+    sub     r8, rsi             ; r8 = dst - src
+    jz      .mv_ret
+    cmp     r8, rdx
+    jb      .mv_backward        ; src < dst < src + n: copy from the end
+
+    ; Forward copy. Without overlap, or with at least one SIMD block of
+    ; distance, every memcpy path is safe.
+    mov     r9, rsi
+    sub     r9, rdi             ; src - dst
+    cmp     r9, rdx
+    jae     memcpy
+    cmp     r9, MEM_MOVE_MIN_DIST
+    jae     memcpy
     mov     rcx, rdx
     rep     movsb
+    ret
+
+.mv_backward:
+    cmp     rdx, MEM_SIMD_MIN
+    jb      .mv_back_scalar
+    cmp     r8, MEM_MOVE_MIN_DIST
+    jb      .mv_back_scalar
+    movzx   r9d, byte [rel mem_simd_level]
+    cmp     r9d, 2
+    je      mem_copy_bwd_avx2
+    cmp     r9d, 1
+    je      mem_copy_bwd_sse2
+
+.mv_back_scalar:
+    ; Descending loop instead of std/rep movs: DF must stay clear, an IRQ or
+    ; a preemption here would otherwise run C code with DF=1
+    cmp     r8, 8
+    jb      .mv_back_bytes
+.mv_back_qwords:
+    cmp     rdx, 8
+    jb      .mv_back_bytes
+    sub     rdx, 8
+    mov     rcx, [rsi+rdx]
+    mov     [rdi+rdx], rcx
+    jmp     .mv_back_qwords
+.mv_back_bytes:
+    test    rdx, rdx
+    jz      .mv_ret
+    dec     rdx
+    mov     cl, [rsi+rdx]
+    mov     [rdi+rdx], cl
+    jmp     .mv_back_bytes
+
+.mv_ret:
+    ret
+
+; void* memset(void* ptr [RDI], int value [RSI], size_t n [RDX])
+memset:
+    cld
+    mov     r10, rdi            ; return value
+    movzx   ecx, sil
+    mov     r9, 0x0101010101010101
+    imul    r9, rcx             ; byte pattern in every lane
+
+    test    rdx, rdx
+    jz      .set_ret
+
+    cmp     rdx, MEM_SIMD_MIN
+    jb      .set_small
+
+    movzx   r8d, byte [rel mem_simd_level]
+    test    r8d, r8d
+    jz      .set_scalar
+
+    xor     r11d, r11d
+    cmp     rdx, [rel mem_nt_threshold]
+    jae     .set_nt
+    cmp     byte [rel erms_supported], 0
+    jne     .set_stosb
+    jmp     .set_simd
+.set_nt:
+    mov     r11d, 1
+.set_simd:
+    cmp     r8d, 2
+    je      mem_set_avx2
+    jmp     mem_set_sse2
+
+.set_small:
+    cmp     byte [rel fsrm_supported], 0
+    jne     .set_stosb
+    mov     rcx, rdx
+    shr     rcx, 3
+    jz      .set_tail
+.set_qloop:
+    mov     [rdi], r9
+    add     rdi, 8
+    dec     rcx
+    jnz     .set_qloop
+.set_tail:
+    mov     rax, r9
+    mov     rcx, rdx
+    and     rcx, 7
+    rep     stosb
+    jmp     .set_ret
+
+.set_stosb:
+    mov     rax, r9
+    mov     rcx, rdx
+    rep     stosb
+    jmp     .set_ret
+
+.set_scalar:
+    cmp     byte [rel erms_supported], 0
+    jne     .set_stosb
+    mov     rax, r9
+    mov     rcx, rdi
+    neg     rcx
+    and     rcx, 7              ; bytes to reach 8-byte alignment
+    sub     rdx, rcx
+    rep     stosb
+    mov     rcx, rdx
+    shr     rcx, 3
+    rep     stosq
+    mov     rcx, rdx
+    and     rcx, 7
+    rep     stosb
+
+.set_ret:
+    mov     rax, r10
+    ret
+
+; ---------------------------------------------------------------------------
+; SIMD helpers. Entered by jmp with RAX already holding the return value.
+;   copy: RDI dst, RSI src, RDX n (>= MEM_SIMD_MIN), R9 = 1 for NT stores
+;   set : RDI dst, RDX n (>= MEM_SIMD_MIN), R9 pattern, R10 return, R11 NT
+; The unaligned head/tail blocks may rewrite bytes the loop already stored;
+; memmove only enters with at least MEM_MOVE_MIN_DIST bytes between buffers,
+; so those re-reads never see bytes overwritten by this call.
+; ---------------------------------------------------------------------------
+
+mem_copy_fwd_sse2:
+    ; Head: 16 unaligned bytes, then bring dst up to a 16-byte boundary
+    movdqu  xmm0, [rsi]
+    movdqu  [rdi], xmm0
+    mov     rcx, rdi
+    neg     rcx
+    and     rcx, 15
+    add     rdi, rcx
+    add     rsi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 6              ; 64-byte blocks
+    test    r9d, r9d
+    jnz     .fs_nt_loop
+.fs_loop:
+    movdqu  xmm0, [rsi]
+    movdqu  xmm1, [rsi+16]
+    movdqu  xmm2, [rsi+32]
+    movdqu  xmm3, [rsi+48]
+    movdqa  [rdi], xmm0
+    movdqa  [rdi+16], xmm1
+    movdqa  [rdi+32], xmm2
+    movdqa  [rdi+48], xmm3
+    add     rsi, 64
+    add     rdi, 64
+    dec     rcx
+    jnz     .fs_loop
+    jmp     .fs_tail
+.fs_nt_loop:
+    movdqu  xmm0, [rsi]
+    movdqu  xmm1, [rsi+16]
+    movdqu  xmm2, [rsi+32]
+    movdqu  xmm3, [rsi+48]
+    movntdq [rdi], xmm0
+    movntdq [rdi+16], xmm1
+    movntdq [rdi+32], xmm2
+    movntdq [rdi+48], xmm3
+    add     rsi, 64
+    add     rdi, 64
+    dec     rcx
+    jnz     .fs_nt_loop
+    sfence
+
+.fs_tail:
+    ; Last 64 bytes, ending exactly at dst + n
+    and     rdx, 63
+    add     rsi, rdx
+    add     rdi, rdx
+    movdqu  xmm0, [rsi-64]
+    movdqu  xmm1, [rsi-48]
+    movdqu  xmm2, [rsi-32]
+    movdqu  xmm3, [rsi-16]
+    movdqu  [rdi-64], xmm0
+    movdqu  [rdi-48], xmm1
+    movdqu  [rdi-32], xmm2
+    movdqu  [rdi-16], xmm3
+
+    ret
+
+mem_copy_fwd_avx2:
+    vmovdqu ymm0, [rsi]
+    vmovdqu [rdi], ymm0
+    mov     rcx, rdi
+    neg     rcx
+    and     rcx, 31
+    add     rdi, rcx
+    add     rsi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 7              ; 128-byte blocks
+    test    r9d, r9d
+    jnz     .fa_nt_loop
+.fa_loop:
+    vmovdqu ymm0, [rsi]
+    vmovdqu ymm1, [rsi+32]
+    vmovdqu ymm2, [rsi+64]
+    vmovdqu ymm3, [rsi+96]
+    vmovdqa [rdi], ymm0
+    vmovdqa [rdi+32], ymm1
+    vmovdqa [rdi+64], ymm2
+    vmovdqa [rdi+96], ymm3
+    add     rsi, 128
+    add     rdi, 128
+    dec     rcx
+    jnz     .fa_loop
+    jmp     .fa_tail
+.fa_nt_loop:
+    vmovdqu ymm0, [rsi]
+    vmovdqu ymm1, [rsi+32]
+    vmovdqu ymm2, [rsi+64]
+    vmovdqu ymm3, [rsi+96]
+    vmovntdq [rdi], ymm0
+    vmovntdq [rdi+32], ymm1
+    vmovntdq [rdi+64], ymm2
+    vmovntdq [rdi+96], ymm3
+    add     rsi, 128
+    add     rdi, 128
+    dec     rcx
+    jnz     .fa_nt_loop
+    sfence
+
+.fa_tail:
+    and     rdx, 127
+    add     rsi, rdx
+    add     rdi, rdx
+    vmovdqu ymm0, [rsi-128]
+    vmovdqu ymm1, [rsi-96]
+    vmovdqu ymm2, [rsi-64]
+    vmovdqu ymm3, [rsi-32]
+    vmovdqu [rdi-128], ymm0
+    vmovdqu [rdi-96], ymm1
+    vmovdqu [rdi-64], ymm2
+    vmovdqu [rdi-32], ymm3
+
+    vzeroupper
+    ret
+
+; Backward copies (memmove with src < dst < src + n): mirror of the above,
+; walking down from the end. R10/R11 keep the buffer starts for the tail.
+mem_copy_bwd_sse2:
+    mov     r10, rdi
+    mov     r11, rsi
+    add     rdi, rdx
+    add     rsi, rdx
+
+    movdqu  xmm0, [rsi-16]
+    movdqu  [rdi-16], xmm0
+    mov     rcx, rdi
+    and     rcx, 15             ; bring the dst end down to 16 bytes
+    sub     rdi, rcx
+    sub     rsi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 6
+.bs_loop:
+    movdqu  xmm0, [rsi-16]
+    movdqu  xmm1, [rsi-32]
+    movdqu  xmm2, [rsi-48]
+    movdqu  xmm3, [rsi-64]
+    movdqa  [rdi-16], xmm0
+    movdqa  [rdi-32], xmm1
+    movdqa  [rdi-48], xmm2
+    movdqa  [rdi-64], xmm3
+    sub     rsi, 64
+    sub     rdi, 64
+    dec     rcx
+    jnz     .bs_loop
+
+    ; First 64 bytes of the buffer
+    movdqu  xmm0, [r11]
+    movdqu  xmm1, [r11+16]
+    movdqu  xmm2, [r11+32]
+    movdqu  xmm3, [r11+48]
+    movdqu  [r10], xmm0
+    movdqu  [r10+16], xmm1
+    movdqu  [r10+32], xmm2
+    movdqu  [r10+48], xmm3
+
+    ret
+
+mem_copy_bwd_avx2:
+    mov     r10, rdi
+    mov     r11, rsi
+    add     rdi, rdx
+    add     rsi, rdx
+
+    vmovdqu ymm0, [rsi-32]
+    vmovdqu [rdi-32], ymm0
+    mov     rcx, rdi
+    and     rcx, 31
+    sub     rdi, rcx
+    sub     rsi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 7
+.ba_loop:
+    vmovdqu ymm0, [rsi-32]
+    vmovdqu ymm1, [rsi-64]
+    vmovdqu ymm2, [rsi-96]
+    vmovdqu ymm3, [rsi-128]
+    vmovdqa [rdi-32], ymm0
+    vmovdqa [rdi-64], ymm1
+    vmovdqa [rdi-96], ymm2
+    vmovdqa [rdi-128], ymm3
+    sub     rsi, 128
+    sub     rdi, 128
+    dec     rcx
+    jnz     .ba_loop
+
+    vmovdqu ymm0, [r11]
+    vmovdqu ymm1, [r11+32]
+    vmovdqu ymm2, [r11+64]
+    vmovdqu ymm3, [r11+96]
+    vmovdqu [r10], ymm0
+    vmovdqu [r10+32], ymm1
+    vmovdqu [r10+64], ymm2
+    vmovdqu [r10+96], ymm3
+
+    vzeroupper
+    ret
+
+mem_set_sse2:
+    movq    xmm0, r9
+    punpcklqdq xmm0, xmm0
+
+    lea     r8, [rdi+rdx]       ; end
+    movdqu  [rdi], xmm0
+    mov     rcx, rdi
+    neg     rcx
+    and     rcx, 15
+    add     rdi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 6
+    test    r11d, r11d
+    jnz     .ss_nt_loop
+.ss_loop:
+    movdqa  [rdi], xmm0
+    movdqa  [rdi+16], xmm0
+    movdqa  [rdi+32], xmm0
+    movdqa  [rdi+48], xmm0
+    add     rdi, 64
+    dec     rcx
+    jnz     .ss_loop
+    jmp     .ss_tail
+.ss_nt_loop:
+    movntdq [rdi], xmm0
+    movntdq [rdi+16], xmm0
+    movntdq [rdi+32], xmm0
+    movntdq [rdi+48], xmm0
+    add     rdi, 64
+    dec     rcx
+    jnz     .ss_nt_loop
+    sfence
+
+.ss_tail:
+    movdqu  [r8-64], xmm0
+    movdqu  [r8-48], xmm0
+    movdqu  [r8-32], xmm0
+    movdqu  [r8-16], xmm0
+
+    mov     rax, r10
+    ret
+
+mem_set_avx2:
+    vmovq   xmm0, r9
+    vpbroadcastq ymm0, xmm0
+
+    lea     r8, [rdi+rdx]
+    vmovdqu [rdi], ymm0
+    mov     rcx, rdi
+    neg     rcx
+    and     rcx, 31
+    add     rdi, rcx
+    sub     rdx, rcx
+
+    mov     rcx, rdx
+    shr     rcx, 7
+    test    r11d, r11d
+    jnz     .sa_nt_loop
+.sa_loop:
+    vmovdqa [rdi], ymm0
+    vmovdqa [rdi+32], ymm0
+    vmovdqa [rdi+64], ymm0
+    vmovdqa [rdi+96], ymm0
+    add     rdi, 128
+    dec     rcx
+    jnz     .sa_loop
+    jmp     .sa_tail
+.sa_nt_loop:
+    vmovntdq [rdi], ymm0
+    vmovntdq [rdi+32], ymm0
+    vmovntdq [rdi+64], ymm0
+    vmovntdq [rdi+96], ymm0
+    add     rdi, 128
+    dec     rcx
+    jnz     .sa_nt_loop
+    sfence
+
+.sa_tail:
+    vmovdqu [r8-128], ymm0
+    vmovdqu [r8-96], ymm0
+    vmovdqu [r8-64], ymm0
+    vmovdqu [r8-32], ymm0
 
-.ret:
+    vzeroupper
+    mov     rax, r10
     ret
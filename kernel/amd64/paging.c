@@ -1,5 +1,7 @@
-// AMD64 identity paging (now 4KiB granularity) with attribute hooks
+// AMD64 identity paging (1 GiB / 2 MiB pages, split to 4 KiB on demand) with attribute hooks
 #include <arch.h>
+#include <memory/pmm.h>
+#include <smp/smp.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -50,6 +52,16 @@ static inline void wbinvd(void)
 #define PTE_PS  (1ull << 7)  // Page Size (in PD: 2 MiB)
 #define PTE_G   (1ull << 8)  // Global
 
+#define PTE_PAT       (1ull << 7)  // PAT bit in a 4 KiB PTE
+#define PTE_PAT_LARGE (1ull << 12) // PAT bit in a 2 MiB PDE / 1 GiB PDPTE
+#define PTE_ADDR_MASK 0x000FFFFFFFFFF000ull
+
+#define PAGE_SIZE_4K  0x1000ull
+#define PAGE_SIZE_2M  0x200000ull
+#define PAGE_SIZE_1G  0x40000000ull
+
+#define IDENTITY_LIMIT (4ull * PAGE_SIZE_1G)
+
 // Statically allocated and 4KiB-aligned top-level tables
 static uint64_t pml4[512] __attribute__((aligned(4096)));
 static uint64_t pdpt[512] __attribute__((aligned(4096)));
@@ -57,22 +69,25 @@ static uint64_t pd0[512]  __attribute__((aligned(4096))); // covers 0..1GiB
 static uint64_t pd1[512]  __attribute__((aligned(4096))); // covers 1..2GiB
 static uint64_t pd2[512]  __attribute__((aligned(4096))); // covers 2..3GiB
 static uint64_t pd3[512]  __attribute__((aligned(4096))); // covers 3..4GiB
-
-// For full 4KiB mapping we need 512 page tables per 1GiB (512 * 2MiB / 4KiB = 512).
-// We'll allocate them statically: 4 * 512 tables = 2048 PTs.
-// Each PT has 512 entries (4KiB * 512 = 2MiB).
-// Naming convention: pt_g<GB index>_<PT index within that GB>
-static uint64_t pt_g0[512][512] __attribute__((aligned(4096))); // 0..1GiB
-static uint64_t pt_g1[512][512] __attribute__((aligned(4096))); // 1..2GiB
-static uint64_t pt_g2[512][512] __attribute__((aligned(4096))); // 2..3GiB
-static uint64_t pt_g3[512][512] __attribute__((aligned(4096))); // 3..4GiB
+static uint64_t* const pd_tables[4] = { pd0, pd1, pd2, pd3 };
+
+// The identity map uses 1 GiB / 2 MiB pages. Only the first 2 MiB (covered by
+// the fixed-range MTRRs: VGA hole, option ROMs, ...) is mapped with 4 KiB pages
+// up front; other large pages are split on demand when a caller needs per-page
+// attributes (MMIO). Split page tables come from a small static pool, then
+// from the PMM once it is up.
+#define PAGING_PT_POOL_SIZE 16
+static uint64_t pt_low[512] __attribute__((aligned(4096)));
+static uint64_t pt_pool[PAGING_PT_POOL_SIZE][512] __attribute__((aligned(4096)));
+static size_t   pt_pool_used = 0;
+static bool     g_has_1g_pages = false;
 
 static inline void write_cr3(uint64_t phys)
 {
 	__asm__ __volatile__("mov %0, %%cr3" :: "r"(phys) : "memory");
 }
 
-/* === Architecture paging attribute extension (amd64, 4KiB) ================= */
+/* === Architecture paging attribute extension (amd64) ======================== */
 
 static bool g_pat_initialized = false;
 
@@ -322,41 +337,102 @@ void arch_tlb_flush_all(void) {
 	asm volatile ("mov %0, %%cr3" :: "r"(cr3) : "memory");
 }
 
-static inline uint64_t* __get_pml4e(uintptr_t va) { (void)va; return &pml4[0]; }
-static inline uint64_t* __get_pdpte(uintptr_t va) { return &pdpt[(va >> 30) & 0x1FFull]; }
-static inline uint64_t* __get_pde(uintptr_t va) {
-	uint64_t gb = (va >> 30) & 0x3ull; // 0..3
-	uint64_t pd_index = (va >> 21) & 0x1FFull;
-	uint64_t* pd = (gb==0?pd0:gb==1?pd1:gb==2?pd2:pd3);
-	return &pd[pd_index];
+static uint64_t* __alloc_page_table(void)
+{
+	if (pt_pool_used < PAGING_PT_POOL_SIZE) {
+		return pt_pool[pt_pool_used++];
+	}
+	if (pmm_get_total_bytes() != 0) {
+		return (uint64_t*)pmm_alloc_pages(0);
+	}
+	return NULL;
+}
+
+/* Walk the identity map. Returns the leaf entry for va and its level
+ * (1: 4 KiB PTE, 2: 2 MiB PDE, 3: 1 GiB PDPTE) or NULL if not mapped. */
+static uint64_t* __walk(uintptr_t va, int* level)
+{
+	if ((uint64_t)va >= IDENTITY_LIMIT) return NULL;
+
+	uint64_t* pdpte = &pdpt[(va >> 30) & 0x1FFull];
+	if (!(*pdpte & PTE_P)) return NULL;
+	if (*pdpte & PTE_PS) { *level = 3; return pdpte; }
+
+	uint64_t* pd = (uint64_t*)(uintptr_t)(*pdpte & PTE_ADDR_MASK);
+	uint64_t* pde = &pd[(va >> 21) & 0x1FFull];
+	if (!(*pde & PTE_P)) return NULL;
+	if (*pde & PTE_PS) { *level = 2; return pde; }
+
+	uint64_t* pt = (uint64_t*)(uintptr_t)(*pde & PTE_ADDR_MASK);
+	*level = 1;
+	return &pt[(va >> 12) & 0x1FFull];
+}
+
+static inline uint64_t __level_size(int level)
+{
+	return level == 3 ? PAGE_SIZE_1G : (level == 2 ? PAGE_SIZE_2M : PAGE_SIZE_4K);
+}
+
+// Split a 1 GiB page into 512 x 2 MiB pages (uses the static PD for that GiB)
+static bool __split_1g(uintptr_t va)
+{
+	size_t gb = (size_t)((va >> 30) & 0x3ull);
+	uint64_t entry = pdpt[gb];
+	uint64_t* pd = pd_tables[gb];
+	uint64_t base = entry & PTE_ADDR_MASK & ~(PAGE_SIZE_1G - 1);
+	uint64_t attrs = entry & (PTE_RW | PTE_US | PTE_PWT | PTE_PCD | PTE_G | PTE_PAT_LARGE);
+
+	for (int i = 0; i < 512; ++i) {
+		pd[i] = (base + (uint64_t)i * PAGE_SIZE_2M) | PTE_P | PTE_PS | attrs;
+	}
+	pdpt[gb] = ((uint64_t)(uintptr_t)pd) | PTE_P | PTE_RW;
+	// CR3 AP'lerle paylasiliyor: eski buyuk sayfa girdisi her CPU'dan silinmeli
+	smp_tlb_shootdown(0, 0);
+	return true;
+}
+
+// Split a 2 MiB page into 512 x 4 KiB pages
+static bool __split_2m(uint64_t* pde)
+{
+	uint64_t* pt = __alloc_page_table();
+	if (!pt) return false;
+
+	uint64_t entry = *pde;
+	uint64_t base = entry & PTE_ADDR_MASK & ~(PAGE_SIZE_2M - 1);
+	uint64_t attrs = entry & (PTE_RW | PTE_US | PTE_PWT | PTE_PCD | PTE_G);
+	if (entry & PTE_PAT_LARGE) attrs |= PTE_PAT;
+
+	for (int i = 0; i < 512; ++i) {
+		pt[i] = (base + (uint64_t)i * PAGE_SIZE_4K) | PTE_P | attrs;
+	}
+	*pde = ((uint64_t)(uintptr_t)pt) | PTE_P | PTE_RW;
+	smp_tlb_shootdown(0, 0);
+	return true;
 }
-static inline uint64_t* __get_pte(uintptr_t va) {
-	uint64_t gb = (va >> 30) & 0x3ull;
-	uint64_t pt_index = (va >> 21) & 0x1FFull; // which PT inside that GB
-	uint64_t entry_index = (va >> 12) & 0x1FFull; // which PTE inside PT
-	uint64_t (*pt_block)[512] = (gb==0?pt_g0:gb==1?pt_g1:gb==2?pt_g2:pt_g3);
-	return &pt_block[pt_index][entry_index];
+
+// Break the leaf covering va down one level
+static bool __split(uintptr_t va, uint64_t* entry, int level)
+{
+	return level == 3 ? __split_1g(va) : __split_2m(entry);
 }
 
-static void __apply_type_to_pte(uint64_t* pte, arch_paging_memtype_t type) {
-	// Clear PWT, PCD, PAT bit (bit 7 in 4KiB PTE high part -> actually bit 7 overall is PS for PDE; here normal PTE so bit7 is PAT)
-	*pte &= ~(PTE_PWT | PTE_PCD | (1ull << 7));
+static void __apply_type(uint64_t* entry, int level, arch_paging_memtype_t type) {
+	uint64_t pat_bit = (level == 1) ? PTE_PAT : PTE_PAT_LARGE;
+	*entry &= ~(PTE_PWT | PTE_PCD | pat_bit);
 	switch (type) {
 		case ARCH_PAGING_MT_WB: /* nothing */ break;
-		case ARCH_PAGING_MT_WT: *pte |= PTE_PWT; break;
-		case ARCH_PAGING_MT_UC: *pte |= (PTE_PWT | PTE_PCD); break;
-		case ARCH_PAGING_MT_UC_MINUS: *pte |= PTE_PCD; break;
-		case ARCH_PAGING_MT_WC: *pte |= (1ull << 7); break; // PAT index with PAT=1, PWT=0, PCD=0
-		case ARCH_PAGING_MT_WP: *pte |= (1ull << 7) | PTE_PWT; break; // placeholder mapping
+		case ARCH_PAGING_MT_WT: *entry |= PTE_PWT; break;
+		case ARCH_PAGING_MT_UC: *entry |= (PTE_PWT | PTE_PCD); break;
+		case ARCH_PAGING_MT_UC_MINUS: *entry |= PTE_PCD; break;
+		case ARCH_PAGING_MT_WC: *entry |= pat_bit; break; // PAT index with PAT=1, PWT=0, PCD=0
+		case ARCH_PAGING_MT_WP: *entry |= pat_bit | PTE_PWT; break; // placeholder mapping
 	}
 }
 
-arch_paging_memtype_t arch_paging_get_memtype(uintptr_t virt_addr) {
-	uint64_t* pte = __get_pte(virt_addr);
-	if (!(*pte & PTE_P)) return ARCH_PAGING_MT_UC;
-	bool pat = (*pte & (1ull<<7)) != 0;
-	bool pcd = (*pte & PTE_PCD) != 0;
-	bool pwt = (*pte & PTE_PWT) != 0;
+static arch_paging_memtype_t __entry_memtype(uint64_t entry, int level) {
+	bool pat = (entry & (level == 1 ? PTE_PAT : PTE_PAT_LARGE)) != 0;
+	bool pcd = (entry & PTE_PCD) != 0;
+	bool pwt = (entry & PTE_PWT) != 0;
 	if (!pat && !pcd && !pwt) return ARCH_PAGING_MT_WB;
 	if (!pat && !pcd &&  pwt) return ARCH_PAGING_MT_WT;
 	if (!pat &&  pcd && !pwt) return ARCH_PAGING_MT_UC_MINUS;
@@ -366,84 +442,249 @@ arch_paging_memtype_t arch_paging_get_memtype(uintptr_t virt_addr) {
 	return ARCH_PAGING_MT_UC;
 }
 
+arch_paging_memtype_t arch_paging_get_memtype(uintptr_t virt_addr) {
+	int level = 0;
+	uint64_t* entry = __walk(virt_addr, &level);
+	if (!entry || !(*entry & PTE_P)) return ARCH_PAGING_MT_UC;
+	return __entry_memtype(*entry, level);
+}
+
 bool arch_paging_set_memtype(uintptr_t phys_start, size_t length, arch_paging_memtype_t type) {
 	if (length == 0) return true;
-	const uintptr_t page_size = 4096u;
-	uintptr_t start = phys_start & ~(page_size - 1);
-	uintptr_t end   = (phys_start + length + page_size - 1) & ~(page_size - 1);
-	size_t count = (end - start) / page_size;
-	size_t changed = 0;
-	for (size_t i = 0; i < count; ++i) {
-		uintptr_t cur = start + i * page_size;
-		uint64_t* pte = __get_pte(cur); // identity virt==phys
-		if (!(*pte & PTE_P)) continue; // skip unmapped
-		__apply_type_to_pte(pte, type);
-		arch_tlb_flush_one((void*)cur);
-		changed++;
+	uint64_t cur = (uint64_t)phys_start & ~(PAGE_SIZE_4K - 1);
+	uint64_t end = ((uint64_t)phys_start + length + PAGE_SIZE_4K - 1) & ~(PAGE_SIZE_4K - 1);
+	bool complete = true;
+
+	while (cur < end) {
+		int level = 0;
+		uint64_t* entry = __walk((uintptr_t)cur, &level); // identity virt==phys
+		if (!entry || !(*entry & PTE_P)) { // skip unmapped
+			complete = false;
+			cur += PAGE_SIZE_4K;
+			continue;
+		}
+
+		uint64_t size = __level_size(level);
+		uint64_t page_base = cur & ~(size - 1);
+		uint64_t page_end = page_base + size;
+
+		if (__entry_memtype(*entry, level) == type) {
+			cur = page_end < end ? page_end : end; // already right, no need to split
+			continue;
+		}
+
+		if (level > 1 && (cur != page_base || page_end > end)) {
+			// Only part of the large page changes type: go one level down
+			if (!__split((uintptr_t)cur, entry, level)) {
+				return false;
+			}
+			continue;
+		}
+
+		__apply_type(entry, level, type);
+		arch_tlb_flush_one((void*)(uintptr_t)cur);
+		cur = page_end;
 	}
-	return changed == count;
+	return complete;
 }
 
 bool arch_paging_map_with_type(uintptr_t phys_start, uintptr_t virt_start, size_t length,
 							   uint64_t base_flags, arch_paging_memtype_t type) {
 	if (length == 0) return true;
-	const uintptr_t page_size = 4096u;
-	uintptr_t phys = phys_start & ~(page_size - 1);
-	uintptr_t virt = virt_start & ~(page_size - 1);
-	uintptr_t end  = (phys_start + length + page_size - 1) & ~(page_size - 1);
-	size_t count = (end - phys) / page_size;
+	uint64_t phys = (uint64_t)phys_start & ~(PAGE_SIZE_4K - 1);
+	uint64_t virt = (uint64_t)virt_start & ~(PAGE_SIZE_4K - 1);
+	uint64_t end  = ((uint64_t)virt_start + length + PAGE_SIZE_4K - 1) & ~(PAGE_SIZE_4K - 1);
+	uint64_t extra = base_flags & (PTE_US | PTE_G);
+
+	while (virt < end) {
+		int level = 0;
+		uint64_t* entry = __walk((uintptr_t)virt, &level);
+		if (!entry) return false; // outside the identity-mapped window
+
+		if (level > 1) {
+			uint64_t size = __level_size(level);
+			uint64_t mapped = *entry & PTE_ADDR_MASK & ~(size - 1);
+			bool covers = (virt & (size - 1)) == 0 && virt + size <= end;
+			if (covers && mapped == phys && (phys & (size - 1)) == 0) {
+				// Identity large page fully inside the range: keep it large
+				*entry |= PTE_P | PTE_RW | extra;
+				__apply_type(entry, level, type);
+				arch_tlb_flush_one((void*)(uintptr_t)virt);
+				virt += size;
+				phys += size;
+				continue;
+			}
+			if (!__split((uintptr_t)virt, entry, level)) {
+				return false;
+			}
+			continue;
+		}
+
+		if (!(*entry & PTE_P) || (*entry & PTE_ADDR_MASK) != phys) {
+			*entry = (phys & PTE_ADDR_MASK) | PTE_P | PTE_RW | extra;
+		}
+		__apply_type(entry, level, type);
+		arch_tlb_flush_one((void*)(uintptr_t)virt);
+		virt += PAGE_SIZE_4K;
+		phys += PAGE_SIZE_4K;
+	}
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* vmalloc/vmap window: PML4[1] (512 GiB .. 576 GiB), 4 KiB pages only        */
+/* -------------------------------------------------------------------------- */
+
+#define VMM_WINDOW_BASE   0x0000008000000000ull
+#define VMM_WINDOW_SIZE   (64ull * PAGE_SIZE_1G)
+#define VMM_FLUSH_ALL_MIN 32   // Bundan fazla sayfa icin tek tek invlpg yerine CR3 yukle
+
+static uint64_t* __vmm_next_table(uint64_t* entry, bool create)
+{
+	if (*entry & PTE_P) {
+		return (uint64_t*)(uintptr_t)(*entry & PTE_ADDR_MASK);
+	}
+	if (!create) return NULL;
+
+	uint64_t* table = __alloc_page_table();
+	if (!table) return NULL;
+	for (int i = 0; i < 512; ++i) table[i] = 0;
+	*entry = ((uint64_t)(uintptr_t)table) | PTE_P | PTE_RW;
+	return table;
+}
+
+static uint64_t* __vmm_walk(uint64_t va, bool create)
+{
+	uint64_t* table = pml4;
+	for (int shift = 39; shift > 12; shift -= 9) {
+		table = __vmm_next_table(&table[(va >> shift) & 0x1FFull], create);
+		if (!table) return NULL;
+	}
+	return &table[(va >> 12) & 0x1FFull];
+}
+
+static inline bool __vmm_in_window(uint64_t va, size_t count)
+{
+	return va >= VMM_WINDOW_BASE &&
+	       count <= VMM_WINDOW_SIZE / PAGE_SIZE_4K &&
+	       va + (uint64_t)count * PAGE_SIZE_4K <= VMM_WINDOW_BASE + VMM_WINDOW_SIZE;
+}
+
+bool arch_vmm_get_window(uintptr_t* out_start, uintptr_t* out_end)
+{
+	if (out_start) *out_start = (uintptr_t)VMM_WINDOW_BASE;
+	if (out_end)   *out_end   = (uintptr_t)(VMM_WINDOW_BASE + VMM_WINDOW_SIZE);
+	return true;
+}
+
+bool arch_vmm_map_pages(uintptr_t virt, const uintptr_t* phys_pages, size_t count,
+						arch_paging_memtype_t type)
+{
+	uint64_t va = (uint64_t)virt & ~(PAGE_SIZE_4K - 1);
+	if (!phys_pages || !__vmm_in_window(va, count)) return false;
+
 	for (size_t i = 0; i < count; ++i) {
-		uintptr_t p = phys + i * page_size;
-		uintptr_t v = virt + i * page_size;
-		uint64_t* pte = __get_pte(v);
-		if (!(*pte & PTE_P)) {
-			*pte = (p & 0x000FFFFFFFFFF000ULL) | PTE_P | PTE_RW | (base_flags & (PTE_US|PTE_G));
+		uint64_t* pte = __vmm_walk(va + (uint64_t)i * PAGE_SIZE_4K, true);
+		if (!pte) {
+			// Yarim kalan eslemeyi geri al
+			arch_vmm_unmap_pages((uintptr_t)va, i, NULL);
+			return false;
 		}
-		__apply_type_to_pte(pte, type);
-		arch_tlb_flush_one((void*)v);
+		*pte = ((uint64_t)phys_pages[i] & PTE_ADDR_MASK) | PTE_P | PTE_RW;
+		__apply_type(pte, 1, type);
 	}
 	return true;
 }
 
-// Build identity 4KiB page tables for 0..4GiB
+void arch_vmm_unmap_pages(uintptr_t virt, size_t count, uintptr_t* out_phys)
+{
+	uint64_t va = (uint64_t)virt & ~(PAGE_SIZE_4K - 1);
+	if (!__vmm_in_window(va, count)) return;
+
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t* pte = __vmm_walk(va + (uint64_t)i * PAGE_SIZE_4K, false);
+		uintptr_t phys = 0;
+		if (pte && (*pte & PTE_P)) {
+			phys = (uintptr_t)(*pte & PTE_ADDR_MASK);
+			*pte = 0;
+		}
+		if (out_phys) out_phys[i] = phys;
+	}
+
+	// Tum PTE'ler temizlendikten sonra tek seferde, tum CPU'larda gecersiz kil;
+	// donuste hicbir CPU eski sayfaya erisemez, cagiran sayfalari birakabilir
+	smp_tlb_shootdown((uintptr_t)va, count > VMM_FLUSH_ALL_MIN ? 0 : count);
+}
+
+uintptr_t arch_vmm_translate(uintptr_t virt)
+{
+	uint64_t va = (uint64_t)virt;
+	uint64_t* entry;
+	int level = 1;
+
+	if (va < IDENTITY_LIMIT) {
+		entry = __walk((uintptr_t)va, &level);
+	} else {
+		entry = __vmm_walk(va, false);
+	}
+	if (!entry || !(*entry & PTE_P)) return 0;
+
+	uint64_t size = __level_size(level);
+	return (uintptr_t)((*entry & PTE_ADDR_MASK & ~(size - 1)) | (va & (size - 1)));
+}
+
+static bool __cpu_has_1g_pages(void)
+{
+	size_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+	arch_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx);
+	if (eax < 0x80000001u) return false;
+	arch_cpuid(0x80000001u, &eax, &ebx, &ecx, &edx);
+	return (edx & (1u << 26)) != 0; // Page1GB
+}
+
+// Build the 0..4GiB identity map from large pages
 void amd64_map_identity_low_4g(void)
 {
 	static bool done = false;
 	if (done) return;
 	done = true;
 
-    // Zero top structures
-    for (int i=0;i<512;i++){ pml4[i]=0; pdpt[i]=0; pd0[i]=0; pd1[i]=0; pd2[i]=0; pd3[i]=0; }
-
-    // Link PML4 -> PDPT
-    pml4[0] = ((uint64_t)(uintptr_t)pdpt) | PTE_P | PTE_RW;
-
-    // Link PDPT to PDs
-    pdpt[0] = ((uint64_t)(uintptr_t)pd0) | PTE_P | PTE_RW;
-    pdpt[1] = ((uint64_t)(uintptr_t)pd1) | PTE_P | PTE_RW;
-    pdpt[2] = ((uint64_t)(uintptr_t)pd2) | PTE_P | PTE_RW;
-    pdpt[3] = ((uint64_t)(uintptr_t)pd3) | PTE_P | PTE_RW;
-
-    // Each PD entry points to a 4KiB PT (remove use of large pages)
-    for (int gb=0; gb<4; ++gb) {
-        uint64_t *pd = (gb==0?pd0:gb==1?pd1:gb==2?pd2:pd3);
-        uint64_t (*pt_block)[512] = (gb==0?pt_g0:gb==1?pt_g1:gb==2?pt_g2:pt_g3);
-        for (int pt_index=0; pt_index<512; ++pt_index) {
-            pd[pt_index] = ((uint64_t)(uintptr_t)pt_block[pt_index]) | PTE_P | PTE_RW; // PS=0
-            // Fill the PT
-            uint64_t base_phys = ((uint64_t)gb * 1024ull * 1024ull * 1024ull) + ((uint64_t)pt_index * 2ull * 1024ull * 1024ull);
-            for (int e=0; e<512; ++e) {
-                uint64_t phys = base_phys + ((uint64_t)e * 4096ull);
-                pt_block[pt_index][e] = phys | PTE_P | PTE_RW; // default WB
-            }
-        }
-    }
-
-    // Mark IOAPIC & LAPIC pages uncacheable
-    uint64_t ioapic_phys = 0xFEC00000ull;
-    uint64_t lapic_phys  = 0xFEE00000ull;
-    arch_paging_set_memtype(ioapic_phys, 4096, ARCH_PAGING_MT_UC);
-    arch_paging_set_memtype(lapic_phys,  4096, ARCH_PAGING_MT_UC);
-
-    write_cr3((uint64_t)(uintptr_t)pml4);
+	g_has_1g_pages = __cpu_has_1g_pages();
+
+	// Zero top structures
+	for (int i=0;i<512;i++){ pml4[i]=0; pdpt[i]=0; }
+
+	// Link PML4 -> PDPT
+	pml4[0] = ((uint64_t)(uintptr_t)pdpt) | PTE_P | PTE_RW;
+
+	for (int gb=0; gb<4; ++gb) {
+		uint64_t base = (uint64_t)gb * PAGE_SIZE_1G;
+
+		// GiB 0 holds the fixed-range MTRR area and GiB 3 the MMIO hole
+		// (LAPIC/IOAPIC/PCI BARs), so keep those at 2 MiB granularity.
+		if (g_has_1g_pages && gb != 0 && gb != 3) {
+			pdpt[gb] = base | PTE_P | PTE_RW | PTE_PS; // default WB
+			continue;
+		}
+
+		uint64_t* pd = pd_tables[gb];
+		for (int i=0; i<512; ++i) {
+			pd[i] = (base + (uint64_t)i * PAGE_SIZE_2M) | PTE_P | PTE_RW | PTE_PS; // default WB
+		}
+		pdpt[gb] = ((uint64_t)(uintptr_t)pd) | PTE_P | PTE_RW;
+	}
+
+	// First 2 MiB with 4 KiB pages
+	for (int e=0; e<512; ++e) {
+		pt_low[e] = ((uint64_t)e * PAGE_SIZE_4K) | PTE_P | PTE_RW;
+	}
+	pd0[0] = ((uint64_t)(uintptr_t)pt_low) | PTE_P | PTE_RW;
+
+	// Mark IOAPIC & LAPIC pages uncacheable
+	uint64_t ioapic_phys = 0xFEC00000ull;
+	uint64_t lapic_phys  = 0xFEE00000ull;
+	arch_paging_set_memtype(ioapic_phys, 4096, ARCH_PAGING_MT_UC);
+	arch_paging_set_memtype(lapic_phys,  4096, ARCH_PAGING_MT_UC);
+
+	write_cr3((uint64_t)(uintptr_t)pml4);
 }
@@ -9,7 +9,8 @@ extern gdtr_amd64
 extern idt_init
 extern idt_ptr
 extern __boot_kernel_start
-extern detect_erms
+extern detect_cpu_features
+extern enable_cpu_simd
 extern amd64_map_identity_low_4g
 
 _start:
@@ -41,8 +42,10 @@ _start:
 
     lidt [idt_ptr] ; Load IDT pointer
 
-    ; Detect CPU features (ERMS) after segmentation set up
-    call detect_erms
+    ; Enable x87/SSE/AVX state (CR0/CR4/XCR0), then detect CPU features
+    ; (ERMS/FSRM/SSE2/AVX2) so memcpy can pick the SIMD paths
+    call enable_cpu_simd
+    call detect_cpu_features
 
     ; Ensure low 4GiB identity-mapped with 2MiB pages (MMIO reachable)
     call amd64_map_identity_low_4g
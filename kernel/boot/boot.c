@@ -1,4 +1,5 @@
 #include <boot/multiboot2.h>
+#include <boot/boot_trace.h>
 #include <debug/debug.h>
 #include <stream/OutputStream.h>
 #include <memory/heap.h>
@@ -6,10 +7,18 @@
 #include <time/timer.h>
 #include <irq/IRQ.h>
 #include <task/PeriodicTask.h>
+#include <task/Thread.h>
+#include <task/WorkQueue.h>
+#include <task/Executor.h>
+#include <time/tick.h>
+#include <time/clock.h>
+#include <smp/smp.h>
 #include <efi/efi.h>
 #include <pci/PCI.h>
 #include <memory/memory.h>
+#include <memory/pmm.h>
 #include <gfxterm/gfxterm.h>
+#include <arch.h>
 
 extern DriverBase pic8259_driver;
 extern DriverBase ps2kbd_driver;
@@ -52,18 +61,20 @@ extern char* journald_getBuffer();
 
 PeriodicTask* gfxTask;
 
-void uptime_counter_task()
-{
-    uptimeMs++;
-    periodic_task_run_all();
-}
-
 void __boot_kernel_start(void)
 {
+    // Aşama süreleri ham TSC ile ölçülür; heap ve saat kaynağı gerekmez
+    boot_trace_start();
 
     i386_processor_exceptions_init();
 
+    // BSP'nin kendi GDT/TSS'i ve per-CPU bloğu (GS/FS). Heap ve LOG kilitleri
+    // sahibi this_cpu() ile tuttuğu için ilk tahsisten önce gelmeli
+    smp_bsp_init();
+    boot_trace_mark("cpu_tables");
+
     heap_init();
+    boot_trace_mark("heap_init");
 
     gds_addStream(&journald_debugStream);
     gds_addStream(&uartDebugStream);
@@ -71,26 +82,43 @@ void __boot_kernel_start(void)
     debugStream->Open();
     currentOutputStream->Open();
 
+    boot_trace_mark("debug_streams");
+
     multiboot2_parse();
+    boot_trace_mark("multiboot2_parse");
 
     LOG("Booting AtomOS Kernel");
-    
+
+    // SSE/AVX start.asm'de açıldı; kernel_fpu_begin/end ve IRQ girişi (irq_fpu_call)
+    // için kaydetme yöntemini kesmeler açılmadan önce seç
+    fpu_init();
+    boot_trace_mark("fpu_init");
+
     if (mb2_is_efi_boot)
     {
         efi_init();
+        boot_trace_mark("efi_init");
     }
     else
     {
         bios_init();
+        boot_trace_mark("bios_init");
     }
 
     screen_init();
+    boot_trace_mark("screen_init");
 
     pmm_init();
     LOG("Physical Memory Manager initialized");
+    boot_trace_mark("pmm_init");
 
     acpi_init();
     LOG("ACPI initialized");
+    boot_trace_mark("acpi_init");
+
+    // ACPI tabloları kopyalandı; loader ve ACPI reclaimable bölgeleri PMM'e ver
+    pmm_reclaim_boot_memory();
+    boot_trace_mark("pmm_reclaim");
 
     void* large_alloc = malloc(1024 * 1024 * 10); // 10 MB test
     if (large_alloc)
@@ -103,9 +131,12 @@ void __boot_kernel_start(void)
         ERROR("Large memory allocation test failed");
         asm volatile ("cli; hlt"); // Halt the system
     }
+    boot_trace_mark("heap_test");
 
-    PCI_Init();
-    LOG("PCI bus initialized");
+    // Sürücü zaman aşımları (AHCI/ATA) için erken kalibrasyon: henüz tick yok,
+    // TSC PIT kanal 2'ye göre ölçülür; HPET açıldıktan sonra yeniden kalibre edilir
+    clock_init(NULL);
+    boot_trace_mark("clock_init_early");
 
     // APIC varsa onu kullan, yoksa PIC'e düş
     if (apic_supported())
@@ -120,30 +151,62 @@ void __boot_kernel_start(void)
         system_driver_register(&pic8259_driver);
         system_driver_enable(&pic8259_driver);
     }
+    boot_trace_mark("irq_controller");
+
+    // Zamanlayıcı tick'leri başlamadan önce: boot akışı "main" thread'i olur,
+    // periodic görevler IRQ yerine kendi worker thread'inde çalışır
+    if (scheduler_init())
+    {
+        if (!periodic_task_init())
+            WARN("Periodic task worker could not be started, running tasks from the timer softirq");
+
+        // ISR alt yarıları (PS/2 vb.) için softirq thread'i
+        work_queue_init();
+    }
+    boot_trace_mark("scheduler_init");
 
     system_driver_register(&pit_driver);
     system_driver_enable(&pit_driver);
     irq_controller->acknowledge(0); // Acknowledge PIT IRQ
 
     LOG("PIT enabled");
+    boot_trace_mark("pit");
 
     if (hpet_supported()) {
         LOG("HPET supported – using HPET for system tick");
         system_driver_register(&hpet_driver);
         system_driver_enable(&hpet_driver);
-        hpet_timer->setFrequency(1000);
-        hpet_timer->add_callback(uptime_counter_task);
+        // HPET: serbest sayaç + tek seferlik comparator, idle'da tickless
+        tick_init(hpet_timer);
     }else
     {
         LOG("HPET not available – falling back to PIT");
-        // Hook uptime tick to the active hardware timer
-        pit_timer->setFrequency(1000);
-        pit_timer->add_callback(uptime_counter_task);
+        // Hook uptime tick to the active hardware timer (periodic)
+        tick_init(pit_timer);
     }
+    boot_trace_mark("hpet_tick");
+
+    // ns çözünürlüklü monoton saat: TSC'yi HPET'e (yoksa PIT kanal 2'ye) göre yeniden kalibre et
+    clock_init(hpet_timer);
+    boot_trace_mark("clock_init");
+
+    // AP'leri başlat (APIC yoksa yalnızca BSP); AP'ler hlt döngüsünde iş bekler
+    smp_init();
+    boot_trace_mark("smp_init");
+
+    // AP'ler idle döngüsünden görev çalar; tek CPU'da görevler spawn anında çalışır
+    executor_init();
+    boot_trace_mark("executor_init");
+
+    // PCI taraması BAR boyutlandırmayı executor'a dağıtır
+    PCI_Init();
+    LOG("PCI bus initialized");
+    boot_trace_mark("PCI_Init");
 
     asm volatile ("sti"); // Enable interrupts
 
     gfx_init();
+    boot_trace_mark("gfx_init");
 
     gfxTask = periodic_task_create("gfx_draw_task", gfx_draw_task, NULL, 16);
     periodic_task_start(gfxTask);
@@ -157,11 +220,19 @@ void __boot_kernel_start(void)
     gos_addStream(&dbgGFXTermStream);
 
     gfxterm_visible(debug_terminal, true);
+    boot_trace_mark("gfxterm");
 
     system_driver_register(&ps2kbd_driver);
     if (system_driver_is_available(&ps2kbd_driver)) system_driver_enable(&ps2kbd_driver);
 
     system_driver_register(&ps2mouse_driver);
     if (system_driver_is_available(&ps2mouse_driver)) system_driver_enable(&ps2mouse_driver);
+    boot_trace_mark("input_drivers");
+
+    // Aşama dökümü; metin boot_trace_report / BOOT_TRACE_FILE ile sonradan da okunur
+    boot_trace_finish();
+
+    // HEAPPROF=1 / DEBUG=1: boot sonunda en çok bellek tutan çağrı noktaları (UART)
+    if (heap_prof_enabled()) heap_prof_dump(16);
 
 }
@@ -0,0 +1,312 @@
+#include <boot/boot_trace.h>
+#include <time/clock.h>
+#include <filesystem/VFS.h>
+#include <memory/memory.h>
+#include <debug/debug.h>
+#include <util/VPrintf.h>
+#include <util/string.h>
+#include <sleep.h>
+#include <spinlock.h>
+#include <smp/smp.h>
+#include <task/Fiber.h>
+#include <task/Thread.h>
+#include <arch.h>
+#include <stdarg.h>
+
+#define BOOT_TRACE_CALIBRATE_US  1000
+
+typedef enum {
+    BOOT_TRACE_STAGE = 0,   // boot_trace_mark: önceki işaretten bu yana
+    BOOT_TRACE_SPAN,        // boot_trace_begin/end
+} BootTraceKind;
+
+typedef struct {
+    char name[BOOT_TRACE_NAME_MAX];
+    uint64_t start;         // Ham sayaç (TSC yoksa ns)
+    uint64_t end;           // 0 = span hâlâ açık
+    const void* owner;      // Span'i açan bağlam (boot_trace_owner)
+    uint8_t depth;
+    uint8_t kind;
+} BootTraceEvent;
+
+// Span'ler executor görevlerinden ve fiber'lardan da gelir: kayıtlar s_lock
+// altında alınır, iç içelik her bağlamın kendi açık span'lerine göre sayılır
+static Spinlock s_lock = SPINLOCK_INIT;
+static BootTraceEvent s_events[BOOT_TRACE_MAX_EVENTS];
+static uint32_t s_event_count = 0;
+static uint32_t s_dropped = 0;
+static uint64_t s_t0 = 0;
+static uint64_t s_last_mark = 0;
+static bool s_started = false;
+static bool s_finished = false;
+static volatile uint32_t s_saved = 0;   // BOOT_TRACE_FILE yazımı denendi
+static bool s_has_tsc = false;
+static uint64_t s_hz = 0;
+
+static char* s_report = NULL;
+static size_t s_report_len = 0;
+static size_t s_report_cap = 0;
+
+static uint64_t boot_trace_now(void)
+{
+    return s_has_tsc ? arch_rdtsc() : time_now_ns();
+}
+
+static void boot_trace_set_name(BootTraceEvent* ev, const char* tag, const char* name)
+{
+    ev->name[0] = '\0';
+    if (tag) {
+        strncat(ev->name, tag, BOOT_TRACE_NAME_MAX - 1);
+        strncat(ev->name, ":", BOOT_TRACE_NAME_MAX - 1 - strlen(ev->name));
+    }
+    strncat(ev->name, name ? name : "?", BOOT_TRACE_NAME_MAX - 1 - strlen(ev->name));
+}
+
+// Çalışan fiber, BSP'de thread, yoksa (erken açılış, AP'de görev) CPU
+static const void* boot_trace_owner(void)
+{
+    Fiber* fiber = fiber_current();
+    if (fiber) return fiber;
+    return scheduler_is_running() ? (const void*)thread_current() : (const void*)this_cpu();
+}
+
+// s_lock tutulurken
+static BootTraceEvent* boot_trace_add(BootTraceKind kind, const char* tag, const char* name)
+{
+    if (!s_started || s_finished) return NULL;
+    if (s_event_count >= BOOT_TRACE_MAX_EVENTS) {
+        s_dropped++;
+        return NULL;
+    }
+
+    BootTraceEvent* ev = &s_events[s_event_count++];
+    boot_trace_set_name(ev, tag, name);
+    ev->kind = (uint8_t)kind;
+    ev->start = 0;
+    ev->end = 0;
+    ev->owner = NULL;
+    ev->depth = 0;
+    return ev;
+}
+
+void boot_trace_start(void)
+{
+    if (s_started) return;
+
+    size_t a, b, c, d;
+    arch_cpuid(1, &a, &b, &c, &d);
+    s_has_tsc = (d & (1u << 4)) != 0;
+
+    s_t0 = boot_trace_now();
+    s_last_mark = s_t0;
+    s_started = true;
+}
+
+void boot_trace_mark(const char* stage)
+{
+    size_t flags = spin_lock_irqsave(&s_lock);
+    BootTraceEvent* ev = boot_trace_add(BOOT_TRACE_STAGE, NULL, stage);
+    if (ev) {
+        uint64_t now = boot_trace_now();
+        ev->start = s_last_mark;
+        ev->end = now;
+        s_last_mark = now;
+    }
+    spin_unlock_irqrestore(&s_lock, flags);
+}
+
+uint32_t boot_trace_begin(const char* tag, const char* name)
+{
+    const void* owner = boot_trace_owner();
+
+    size_t flags = spin_lock_irqsave(&s_lock);
+    BootTraceEvent* ev = boot_trace_add(BOOT_TRACE_SPAN, tag, name);
+    uint32_t span = BOOT_TRACE_NONE;
+    if (ev) {
+        uint32_t depth = 1;
+        for (const BootTraceEvent* it = s_events; it < ev; it++) {
+            if (it->kind == BOOT_TRACE_SPAN && !it->end && it->owner == owner) depth++;
+        }
+        ev->owner = owner;
+        ev->depth = (uint8_t)depth;
+        ev->start = boot_trace_now();
+        span = (uint32_t)(ev - s_events);
+    }
+    spin_unlock_irqrestore(&s_lock, flags);
+    return span;
+}
+
+void boot_trace_end(uint32_t span)
+{
+    size_t flags = spin_lock_irqsave(&s_lock);
+    if (!s_finished && span < s_event_count) {
+        BootTraceEvent* ev = &s_events[span];
+        if (ev->kind == BOOT_TRACE_SPAN && !ev->end) ev->end = boot_trace_now();
+    }
+    spin_unlock_irqrestore(&s_lock, flags);
+}
+
+// Sayaç frekansı. TSC saat kaynağıysa kalibrasyonu hazır; değilse (değişmez
+// TSC yok) kısa bir aralıkta saat kaynağına göre ölçülür.
+static uint64_t boot_trace_counter_hz(void)
+{
+    if (!s_has_tsc) return 1000000000ull;
+    if (clock_source() == CLOCK_SOURCE_TSC) return clock_cycles_hz();
+
+    uint64_t ns0 = time_now_ns();
+    uint64_t c0 = arch_rdtsc();
+    udelay(BOOT_TRACE_CALIBRATE_US);
+    uint64_t c1 = arch_rdtsc();
+    uint64_t ns1 = time_now_ns();
+    if (ns1 <= ns0) return 0;
+    return (c1 - c0) * 1000000000ull / (ns1 - ns0);
+}
+
+static uint64_t boot_trace_to_us(uint64_t counts)
+{
+    if (!s_hz) return 0;
+    return counts / (s_hz / 1000000ull ? s_hz / 1000000ull : 1);
+}
+
+static void boot_trace_putc(char c)
+{
+    if (s_report_len + 1 >= s_report_cap) {
+        size_t cap = s_report_cap ? s_report_cap * 2 : 1024;
+        char* grown = (char*)realloc(s_report, cap);
+        if (!grown) return;
+        s_report = grown;
+        s_report_cap = cap;
+    }
+    s_report[s_report_len++] = c;
+    s_report[s_report_len] = '\0';
+}
+
+// Rapora bir satır ekle ve logla
+static void boot_trace_line(const char* fmt, ...)
+{
+    size_t line = s_report_len;
+
+    va_list args;
+    va_start(args, fmt);
+    vprintf(boot_trace_putc, fmt, args);
+    va_end(args);
+
+    if (s_report && s_report_len > line) {
+        LOG("%s", s_report + line);
+    }
+    boot_trace_putc('\n');
+}
+
+static uint64_t boot_trace_duration(const BootTraceEvent* ev)
+{
+    return ev->end > ev->start ? ev->end - ev->start : 0;
+}
+
+static void boot_trace_print_sorted(BootTraceKind kind, uint64_t total_us)
+{
+    uint8_t order[BOOT_TRACE_MAX_EVENTS];
+    uint32_t count = 0;
+
+    // Süreye göre azalan insertion sort; en fazla BOOT_TRACE_MAX_EVENTS kayıt
+    for (uint32_t i = 0; i < s_event_count; i++) {
+        if (s_events[i].kind != kind) continue;
+        uint64_t dur = boot_trace_duration(&s_events[i]);
+        uint32_t pos = count++;
+        while (pos > 0 && boot_trace_duration(&s_events[order[pos - 1]]) < dur) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = (uint8_t)i;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const BootTraceEvent* ev = &s_events[order[i]];
+        uint64_t us = boot_trace_to_us(boot_trace_duration(ev));
+        uint64_t permille = total_us ? us * 1000ull / total_us : 0;
+        const char* open = ev->end ? "" : " (open)";
+        boot_trace_line("  %-*s%-*s %10llu us %3llu.%llu%%%s",
+                        (int)(kind == BOOT_TRACE_SPAN ? (ev->depth - 1) * 2 : 0), "",
+                        BOOT_TRACE_NAME_MAX, ev->name,
+                        (unsigned long long)us,
+                        (unsigned long long)(permille / 10), (unsigned long long)(permille % 10), open);
+    }
+}
+
+// Rapor kök dosya sistemi hazır olunca bir kez kaydedilir: finish anında değilse
+// finish'ten sonraki ilk başarılı VFS_Mount'ta
+static void boot_trace_try_save(void)
+{
+    if (!s_finished || s_saved || !VFS_IsInitialized() || !VFS_GetMount("/")) return;
+    if (__sync_lock_test_and_set(&s_saved, 1)) return;
+    (void)boot_trace_save(BOOT_TRACE_FILE);
+}
+
+void boot_trace_finish(void)
+{
+    size_t flags = spin_lock_irqsave(&s_lock);
+    bool first = s_started && !s_finished;
+    uint64_t end = boot_trace_now();
+    s_finished = true;
+    spin_unlock_irqrestore(&s_lock, flags);
+    if (!first) return;
+
+    // Artık kayıt eklenmez; aşağıdaki okumalar kilitsiz
+    s_hz = boot_trace_counter_hz();
+
+    uint64_t total_us = boot_trace_to_us(end - s_t0);
+    uint32_t stages = 0;
+    for (uint32_t i = 0; i < s_event_count; i++) {
+        if (s_events[i].kind == BOOT_TRACE_STAGE) stages++;
+    }
+
+    boot_trace_line("Boot trace: %llu us total, %u stages, %u spans, counter %llu kHz%s",
+                    (unsigned long long)total_us, stages, s_event_count - stages,
+                    (unsigned long long)(s_hz / 1000ull), s_has_tsc ? " (tsc)" : "");
+    if (s_dropped) {
+        boot_trace_line("  %u events dropped (BOOT_TRACE_MAX_EVENTS=%u)", s_dropped, BOOT_TRACE_MAX_EVENTS);
+    }
+
+    boot_trace_line("Stages by time:");
+    boot_trace_print_sorted(BOOT_TRACE_STAGE, total_us);
+    boot_trace_line("Driver/mount spans by time (indent = nesting):");
+    boot_trace_print_sorted(BOOT_TRACE_SPAN, total_us);
+
+    boot_trace_try_save();
+}
+
+void boot_trace_on_mount(void)
+{
+    boot_trace_try_save();
+}
+
+bool boot_trace_finished(void)
+{
+    return s_finished;
+}
+
+const char* boot_trace_report(void)
+{
+    return s_finished ? s_report : NULL;
+}
+
+bool boot_trace_save(const char* path)
+{
+    if (!s_report || !path) return false;
+
+    VFSResult res = VFS_Create(path, VFS_NODE_REGULAR);
+    if (res != VFS_RES_OK && res != VFS_RES_EXISTS) {
+        WARN("boot_trace: cannot create %s (res=%d)", path, res);
+        return false;
+    }
+
+    VFS_HANDLE file = VFS_Open(path, VFS_OPEN_WRITE | VFS_OPEN_TRUNC);
+    if (!file) {
+        WARN("boot_trace: cannot open %s", path);
+        return false;
+    }
+
+    (void)VFS_TruncateHandle(file, 0);
+    int64_t written = VFS_Write(file, s_report, s_report_len);
+    VFS_Close(file);
+    return written == (int64_t)s_report_len;
+}
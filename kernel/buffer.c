@@ -1,6 +1,56 @@
 #include "buffer.h"
 #include "memory/heap.h"
 #include "memory/memory.h"
+#include "memory/slab.h"
+#include <arch.h>
+
+// Node boyutu (başlık + veri) başına paylaşılan slab cache'ler. Küçük ve sabit
+// boyutlu kuyruklar (ör. klavye olayları) buradan beslenir; büyük veya tabloya
+// sığmayan boyutlar heap'e düşer.
+#define BUFFER_NODE_CACHE_SLOTS 8
+#define BUFFER_NODE_SLAB_MAX    512
+
+static struct {
+    size_t node_size;
+    KmemCache* cache;
+} s_node_caches[BUFFER_NODE_CACHE_SLOTS];
+
+static KmemCache* buffer_node_cache(size_t data_size, bool create) {
+    size_t node_size = sizeof(BufferNode) + data_size;
+    if (node_size > BUFFER_NODE_SLAB_MAX) return NULL;
+
+    for (size_t i = 0; i < BUFFER_NODE_CACHE_SLOTS; i++) {
+        if (s_node_caches[i].cache && s_node_caches[i].node_size == node_size)
+            return s_node_caches[i].cache;
+    }
+
+    if (!create) return NULL;
+
+    // Kilit altında yeniden ara: eşzamanlı iki çağıran aynı boyuta iki cache açmasın
+    KmemCache* cache = NULL;
+    size_t flags = mm_lock();
+    for (size_t i = 0; i < BUFFER_NODE_CACHE_SLOTS && !cache; i++) {
+        if (s_node_caches[i].cache && s_node_caches[i].node_size == node_size)
+            cache = s_node_caches[i].cache;
+    }
+    for (size_t i = 0; i < BUFFER_NODE_CACHE_SLOTS && !cache; i++) {
+        if (!s_node_caches[i].cache) {
+            s_node_caches[i].node_size = node_size;
+            cache = kmem_cache_create("BufferNode", node_size, 0);
+            __asm__ __volatile__("" ::: "memory"); // node_size, cache'ten önce görünür
+            s_node_caches[i].cache = cache;
+            break;
+        }
+    }
+    mm_unlock(flags);
+    return cache;
+}
+
+static BufferNode* buffer_node_alloc(size_t data_size) {
+    KmemCache* cache = buffer_node_cache(data_size, true);
+    if (cache) return (BufferNode*)kmem_cache_alloc(cache);
+    return (BufferNode*)malloc(sizeof(BufferNode) + data_size);
+}
 
 // Create a new buffer with default data size
 Buffer* buffer_create(size_t default_data_size) {
@@ -14,7 +64,10 @@ Buffer* buffer_create(size_t default_data_size) {
     buffer->count = 0;
     buffer->total_size = 0;
     buffer->default_data_size = default_data_size;
-    
+
+    // Cache'i ilk push'tan önce hazırla (push ISR içinden gelebilir)
+    buffer_node_cache(default_data_size, true);
+
     return buffer;
 }
 
@@ -30,17 +83,20 @@ void buffer_destroy(Buffer* buffer) {
 void buffer_clear(Buffer* buffer) {
     if (!buffer) return;
     
+    // Üretici softirq, tüketici thread olabilir: listeyi kesmeler kapalıyken ayır
+    size_t flags = arch_irq_save();
     BufferNode* current = buffer->head;
-    while (current) {
-        BufferNode* next = current->next;
-        free(current);
-        current = next;
-    }
-    
     buffer->head = NULL;
     buffer->tail = NULL;
     buffer->count = 0;
     buffer->total_size = 0;
+    arch_irq_restore(flags);
+
+    while (current) {
+        BufferNode* next = current->next;
+        buffer_free_node(current);
+        current = next;
+    }
 }
 
 // Push data to buffer (FIFO - back of queue)
@@ -50,7 +106,7 @@ int buffer_push(Buffer* buffer, const void* data) {
     size_t data_size = buffer->default_data_size;
     
     // Node + veri için yer ayır (flexible array member)
-    BufferNode* new_node = (BufferNode*)malloc(sizeof(BufferNode) + data_size);
+    BufferNode* new_node = buffer_node_alloc(data_size);
     if (!new_node) {
         return -1;
     }
@@ -62,6 +118,7 @@ int buffer_push(Buffer* buffer, const void* data) {
     memcpy(new_node->data, data, data_size);
     
     // Queue'ya ekle (tail'e ekle)
+    size_t flags = arch_irq_save();
     if (buffer->count == 0) {
         buffer->head = new_node;
         buffer->tail = new_node;
@@ -72,6 +129,7 @@ int buffer_push(Buffer* buffer, const void* data) {
     
     buffer->count++;
     buffer->total_size += data_size;
+    arch_irq_restore(flags);
     return 0;
 }
 
@@ -82,7 +140,11 @@ int buffer_push_default(Buffer* buffer, const void* data) {
 
 // Pop data from buffer (FIFO - front of queue)
 void* buffer_pop(Buffer* buffer) {
-    if (!buffer || buffer->count == 0) {
+    if (!buffer) return NULL;
+
+    size_t flags = arch_irq_save();
+    if (buffer->count == 0) {
+        arch_irq_restore(flags);
         return NULL;
     }
     
@@ -98,9 +160,10 @@ void* buffer_pop(Buffer* buffer) {
     
     buffer->count--;
     buffer->total_size -= data_size;
+    arch_irq_restore(flags);
     
     // Not: Veri pointer'ını döndürüyoruz ama node'u silmiyoruz
-    // Kullanıcı veriyi aldıktan sonra buffer_free_node() çağırmalı
+    // Kullanıcı veriyi aldıktan sonra buffer_free_data() çağırmalı
     return data;
 }
 
@@ -140,7 +203,11 @@ int buffer_push_copy(Buffer* buffer, const void* data) {
 
 // Pop entire node (kullanıcı node'u kendisi yönetecek)
 BufferNode* buffer_pop_node(Buffer* buffer) {
-    if (!buffer || buffer->count == 0) {
+    if (!buffer) return NULL;
+
+    size_t flags = arch_irq_save();
+    if (buffer->count == 0) {
+        arch_irq_restore(flags);
         return NULL;
     }
     
@@ -154,6 +221,7 @@ BufferNode* buffer_pop_node(Buffer* buffer) {
     
     buffer->count--;
     buffer->total_size -= to_remove->data_size;
+    arch_irq_restore(flags);
     
     // Node'un bağlantısını kes
     to_remove->next = NULL;
@@ -163,9 +231,17 @@ BufferNode* buffer_pop_node(Buffer* buffer) {
 
 // Free a buffer node
 void buffer_free_node(BufferNode* node) {
-    if (node) {
-        free(node);
-    }
+    if (!node) return;
+
+    KmemCache* cache = buffer_node_cache(node->data_size, false);
+    if (cache) kmem_cache_free(cache, node);
+    else free(node);
+}
+
+// Free the node that owns a pointer returned by buffer_pop()
+void buffer_free_data(void* data) {
+    if (!data) return;
+    buffer_free_node((BufferNode*)((uint8_t*)data - offsetof(BufferNode, data)));
 }
 
 // Iterator functions
@@ -1,5 +1,8 @@
 #include <debug/debug.h>
+#include <debug/uart.h>
 #include <util/VPrintf.h>
+#include <memory/memory.h>
+#include <spinlock.h>
 #include <list.h>
 
 extern DebugStream uartDebugStream;
@@ -8,6 +11,22 @@ extern DebugStream genericDebugStream;
 List* debugStreams = NULL;
 DebugStream* debugStream = &genericDebugStream;
 
+// Bir mesaj tüm akışlara tek parça yazılsın diye CPU'lar bu kilitte sıraya girer.
+// Kilit sırası gds -> mm: journald ve gfxterm yazarken bellek ayırır. mm_lock'u
+// tutan bir CPU (heap/pmm içinden LOG) gds'yi bekleyemez, sahibi mm_lock'u
+// bekliyor olabilir; kilit boş değilse mesaj yalnızca UART'a gider.
+static RecursiveSpinlock s_gds_lock = RECURSIVE_SPINLOCK_INIT;
+
+static bool gds_lock(size_t* flags)
+{
+    if (!mm_lock_held())
+    {
+        *flags = rspin_lock_irqsave(&s_gds_lock);
+        return true;
+    }
+    return rspin_trylock_irqsave(&s_gds_lock, flags);
+}
+
 void gds_addStream(DebugStream* stream)
 {
     if (!stream) return;
@@ -53,7 +72,7 @@ static void gds_Close()
     }
 }
 
-static void gds_WriteChar(char c)
+static void gds_WriteCharLocked(char c)
 {
     if (debugStreams)
     {
@@ -68,12 +87,32 @@ static void gds_WriteChar(char c)
     }
 }
 
+static void gds_WriteChar(char c)
+{
+    size_t flags;
+    if (!gds_lock(&flags))
+    {
+        uart_write_char(c);
+        return;
+    }
+    gds_WriteCharLocked(c);
+    rspin_unlock_irqrestore(&s_gds_lock, flags);
+}
+
 static void gds_WriteString(const char* str)
 {
     if (!str) return;
+
+    size_t flags;
+    if (!gds_lock(&flags))
+    {
+        uart_write_string(str);
+        return;
+    }
     while (*str) {
-        gds_WriteChar(*str++);
+        gds_WriteCharLocked(*str++);
     }
+    rspin_unlock_irqrestore(&s_gds_lock, flags);
 }
 
 static void gds_print(const char* str)
@@ -86,7 +125,18 @@ static void gds_printf(const char* format, ...)
     if (!format) return;
     va_list args;
     va_start(args, format);
-    vprintf(gds_WriteChar, format, args);
+
+    size_t flags;
+    if (gds_lock(&flags))
+    {
+        vprintf(gds_WriteCharLocked, format, args);
+        rspin_unlock_irqrestore(&s_gds_lock, flags);
+    }
+    else
+    {
+        vprintf(uart_write_char, format, args);
+    }
+
     va_end(args);
 }
 
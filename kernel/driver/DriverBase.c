@@ -1,6 +1,7 @@
 #include <driver/DriverBase.h>
 #include <list.h>
 #include <debug/debug.h>
+#include <boot/boot_trace.h>
 
 List* system_driver_list = NULL;
 
@@ -38,7 +39,10 @@ void system_driver_register(DriverBase* driver) {
     List_Add(system_driver_list, driver);
 
     if (driver->init) {
-        if (!driver->init()) {
+        uint32_t span = boot_trace_begin("init", driver->name);
+        bool ok = driver->init();
+        boot_trace_end(span);
+        if (!ok) {
             ERROR("Failed to initialize driver: '%s'", driver->name);
             return;
         }
@@ -74,7 +78,9 @@ void system_driver_enable(DriverBase* driver)
     }
 
     if (driver->enable) {
+        uint32_t span = boot_trace_begin("enable", driver->name);
         driver->enable();
+        boot_trace_end(span);
         LOG("Driver '%s' enabled.", driver->name);
     }else {
         WARN("Driver '%s' does not have an enable function.", driver->name);
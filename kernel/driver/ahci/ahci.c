@@ -7,8 +7,16 @@
 #include <stddef.h>
 #include <memory/memory.h>
 #include <memory/heap.h>
+#include <memory/vmm.h>
 #include <storage/BlockDevice.h>
 #include <irq/IRQ.h>
+#include <sleep.h>
+#include <spinlock.h>
+#include <task/Fiber.h>
+#include <task/Thread.h>
+#include <task/WorkQueue.h>
+#include <time/clock.h>
+#include <arch.h>
 
 // Local helpers
 static const char* sig_to_str(uint32_t sig)
@@ -22,39 +30,116 @@ static const char* sig_to_str(uint32_t sig)
     }
 }
 
+// Komut tabloları 128 bayt hizalı olmalı; slotlar tek blokta bu adımla dizilir
+#define AHCI_CMD_TABLE_SIZE  ((sizeof(hba_cmd_table_t) + 127u) & ~(size_t)127u)
+#define AHCI_MAX_CMD_SECTORS 0xFFFFu  // 16 bit sayaç; FPDMA ve DMA EXT sınırı
+#define AHCI_CMD_HDR_BYTES   offsetof(hba_cmd_table_t, prdt) // PRDT'den önceki kısım
+
+// Slot başına tamamlanma kaydı. Senkron komutların durumu ctx'teki
+// done/failed bitlerindedir; BlockRequest'e bağlı slotlar bitince hemen
+// serbest kalır ve istek ctx->completed'a düşer.
+typedef struct {
+    Thread* waiter;       // Slotu bekleyip uyuyan thread; ISR uyandırıp NULL'lar
+    BlockRequest* req;    // Asenkron istek (yoksa NULL)
+    uint64_t issued_ns;   // Asenkron komutun verildiği an; zaman aşımı ahci_port_service'te
+} ahci_slot_rec_t;
+
 typedef struct {
     volatile hba_port_t* port;
     uint8_t port_no;
     void* clb_mem; // 1K aligned
     void* fb_mem;  // 256B aligned
     void* ctba0;   // command table for slot 0 (aligned 128B+)
+    uint8_t* ctbl; // command tables for all slots, AHCI_CMD_TABLE_SIZE apart (ctba0 == slot 0)
     BlockDevice* blk; // registered block device
-    volatile uint32_t irq_events; // last PxIS observed by IRQ handler
+
+    // Komut slotları (ATA diskler). Hepsi lock altında; ISR de aynı kilidi alır.
+    // NCQ'da slot numarası aynı zamanda tag'dir.
+    Spinlock lock;
+    uint32_t slots;       // HBA'nın slot sayısı (CAP.NCS + 1)
+    uint32_t depth;       // Aynı anda kullanılabilecek slot: NCQ'da min(slots, cihaz QD), değilse 1
+    bool ncq;             // READ/WRITE FPDMA QUEUED kullanılıyor
+    bool exclusive;       // Kuyruksuz bir komut uçuşta; NCQ komutlarıyla karışamaz
+    bool error;           // Hata sonrası kurtarma bekleniyor; yeni komut verilmez
+    volatile uint32_t recovering;
+    uint32_t busy;        // Ayrılmış slotlar (sahibi toplayana kadar)
+    uint32_t issued;      // Donanıma verilmiş, henüz bitmemiş
+    uint32_t done;        // Bitti, sahibi henüz toplamadı
+    uint32_t failed;      // done içinden hata ile bitenler
+    uint32_t aborted;     // NCQ hatasıyla durdurulan, kurtarma sonrası yeniden verilecekler
+    ahci_slot_rec_t rec[32];
+    BlockRequest* completed; // Tüm parçaları biten, henüz bildirilmemiş istekler
+    WorkItem finish_work;    // ISR'ın topladıklarını softirq thread'inde bildirir
 } ahci_port_ctx_t;
 
 static volatile hba_mem_t* s_hba = NULL;
 static ahci_port_ctx_t s_ports[32];
 static uint8_t s_ahci_irq_line = 0xFF; // legacy INTx line (0..15)
 
+// Açılışta (ahci_enable'a kadar) tamamlanma yoklanır; sonra bekleyen thread
+// uyur ve ISR onu uyandırır. Kesme gelmiyorsa yoklamaya geri dönülür.
+static volatile bool s_ahci_irq_mode = false;
+static volatile uint32_t s_ahci_irq_count = 0;
+static uint32_t s_ahci_irq_missed = 0;
+
+static void ahci_port_collect(ahci_port_ctx_t* ctx);
+static void ahci_port_finish(ahci_port_ctx_t* ctx);
+
 void ahci_irq_isr(void)
 {
     if (!s_hba || s_ahci_irq_line == 0xFF) return;
     uint32_t his = s_hba->is;
     if (his) {
+        s_ahci_irq_count++;
         for (uint8_t pi = 0; pi < 32; ++pi) {
             if ((his & (1u << pi)) == 0) continue;
+            ahci_port_ctx_t* ctx = &s_ports[pi];
+            if (ctx->slots) {
+                // Tamamlanan slotları işaretle ve uyuyan sahiplerini uyandır. İstek
+                // bildirimi kuyruğu yeniden doldurup sürücüye girer (slot bekleme,
+                // kurtarma); kesme bağlamında değil softirq thread'inde yapılır.
+                size_t flags = spin_lock_irqsave(&ctx->lock);
+                ahci_port_collect(ctx);
+                spin_unlock_irqrestore(&ctx->lock, flags);
+                if (ctx->completed) work_queue_post(&ctx->finish_work);
+                continue;
+            }
             volatile hba_port_t* pp = &s_hba->ports[pi];
-            uint32_t pis = pp->is;
-            pp->is = pis; // write-to-clear
-            if (pi < 32) s_ports[pi].irq_events |= pis;
+            pp->is = pp->is; // write-to-clear
         }
         s_hba->is = his; // write-to-clear summary
     }
     if (irq_controller && irq_controller->acknowledge) irq_controller->acknowledge(s_ahci_irq_line);
+    work_queue_irq_exit();
 }
 
 static inline void mmio_wmb(void) { (void)s_hba->is; }
 
+// Zaman aşımları (CPU hızından bağımsız)
+#define AHCI_PORT_CMD_TIMEOUT_US  500000   // PxCMD.CR/FR geçişleri (spec: 500 ms)
+#define AHCI_TFD_TIMEOUT_US       1000000  // BSY/DRQ temizlenmesi
+#define AHCI_IO_TIMEOUT_US        5000000  // Komut tamamlanması
+#define AHCI_BOHC_TIMEOUT_US      2000000  // BIOS handoff (BB ile 2 s'ye kadar)
+#define AHCI_IRQ_SLICE_MS         20       // Kesme kaçarsa uyuyan bekleyici bu aralıkla yoklar
+#define AHCI_IRQ_MISS_LIMIT       8        // Art arda bu kadar kaçan kesmede yoklamaya dönülür
+
+// PxCMD'deki bit(ler)in istenen duruma gelmesini bekle
+static bool ahci_wait_port_cmd(volatile hba_port_t* p, uint32_t mask, bool set)
+{
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_PORT_CMD_TIMEOUT_US);
+    while ((((p->cmd & mask) != 0) != set) && wait_deadline_poll(&wait)) ;
+    return ((p->cmd & mask) != 0) == set;
+}
+
+static bool ahci_wait_not_busy(volatile hba_port_t* p)
+{
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_TFD_TIMEOUT_US);
+    while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && wait_deadline_poll(&wait)) ;
+    return (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) == 0;
+}
+
 static void ahci_dump_port(volatile hba_port_t* p, uint8_t i, const char* tag)
 {
     uint32_t ssts = p->ssts;
@@ -77,18 +162,10 @@ static void ahci_port_stop(volatile hba_port_t* p)
     // Clear ST
     p->cmd &= ~HBA_PxCMD_ST;
     // Wait until CR cleared
-    {
-        uint32_t spin = 1000000;
-        while ((p->cmd & HBA_PxCMD_CR) && spin--) {asm volatile ("hlt");}
-        if (p->cmd & HBA_PxCMD_CR) WARN("AHCI: port stop timeout (CR still set)");
-    }
+    if (!ahci_wait_port_cmd(p, HBA_PxCMD_CR, false)) WARN("AHCI: port stop timeout (CR still set)");
     // Clear FRE and wait FR cleared
     p->cmd &= ~HBA_PxCMD_FRE;
-    {
-        uint32_t spin = 1000000;
-        while ((p->cmd & HBA_PxCMD_FR) && spin--) {asm volatile ("hlt"); }
-        if (p->cmd & HBA_PxCMD_FR) WARN("AHCI: port stop timeout (FR still set)");
-    }
+    if (!ahci_wait_port_cmd(p, HBA_PxCMD_FR, false)) WARN("AHCI: port stop timeout (FR still set)");
 }
 
 static void ahci_port_start(volatile hba_port_t* p)
@@ -99,19 +176,12 @@ static void ahci_port_start(volatile hba_port_t* p)
 
     // Enable FIS receive and wait FR asserts
     p->cmd |= HBA_PxCMD_FRE;
-    {
-        uint32_t spin = 1000000;
-        while (((p->cmd & HBA_PxCMD_FR) == 0) && spin--) {asm volatile ("hlt"); }
-        if ((p->cmd & HBA_PxCMD_FR) == 0) WARN("AHCI: PxCMD.FR did not assert after FRE");
-    }
+    if (!ahci_wait_port_cmd(p, HBA_PxCMD_FR, true)) WARN("AHCI: PxCMD.FR did not assert after FRE");
 
     // Start command processing and wait CR reflects engine state
     p->cmd |= HBA_PxCMD_ST;
-    {
-        uint32_t spin = 1000000;
-        while (((p->cmd & HBA_PxCMD_CR) == 0) && spin--) { asm volatile ("hlt"); }
-        // If CR doesn't set immediately it's still ok on some controllers
-    }
+    // If CR doesn't set immediately it's still ok on some controllers
+    (void)ahci_wait_port_cmd(p, HBA_PxCMD_CR, true);
 }
 
 static void ahci_port_comreset(volatile hba_port_t* p)
@@ -121,9 +191,9 @@ static void ahci_port_comreset(volatile hba_port_t* p)
     // Issue COMRESET: set DET=1 then 0
     uint32_t sctl = p->sctl;
     sctl &= ~0x0Fu; sctl |= 0x1u; p->sctl = sctl;
-    for (volatile int i=0;i<200000;i++) (void)p->ssts;
+    mdelay(1); // DET=1 en az 1 ms tutulmalı
     sctl &= ~0x0Fu; p->sctl = sctl;
-    for (volatile int i=0;i<200000;i++) (void)p->ssts;
+    mdelay(1);
 }
 
 static void ahci_port_recover(ahci_port_ctx_t* ctx, const char* tag)
@@ -135,23 +205,19 @@ static void ahci_port_recover(ahci_port_ctx_t* ctx, const char* tag)
     p->serr = 0xFFFFFFFFu;
     mmio_wmb();
     // Short settle
-    for (volatile int i = 0; i < 200000; ++i) (void)p->ssts;
+    mdelay(1);
 
     // If bus appears wedged (CI still set later), perform light engine restart
     uint32_t cmd = p->cmd;
     if ((cmd & (HBA_PxCMD_ST | HBA_PxCMD_FRE)) != 0) {
         // Stop engine
         p->cmd &= ~HBA_PxCMD_ST;
-        {
-            uint32_t spin = 1000000; while ((p->cmd & HBA_PxCMD_CR) && spin--) { asm volatile ("hlt"); }
-        }
+        (void)ahci_wait_port_cmd(p, HBA_PxCMD_CR, false);
         p->cmd &= ~HBA_PxCMD_FRE;
-        {
-            uint32_t spin = 1000000; while ((p->cmd & HBA_PxCMD_FR) && spin--) { asm volatile ("hlt"); }
-        }
+        (void)ahci_wait_port_cmd(p, HBA_PxCMD_FR, false);
         // Restart
         p->is = 0xFFFFFFFFu; p->serr = 0xFFFFFFFFu; mmio_wmb();
-        for (volatile int i = 0; i < 100000; ++i) (void)p->ssts;
+        udelay(500);
         p->cmd |= HBA_PxCMD_FRE;
         p->cmd |= HBA_PxCMD_ST;
     }
@@ -176,18 +242,22 @@ static bool ahci_port_configure(ahci_port_ctx_t* ctx)
     p->fb  = (uint32_t)((uint64_t)fb & 0xFFFFFFFFu);
     p->fbu = (uint32_t)(((uint64_t)fb >> 32) & 0xFFFFFFFFu);
 
-    // Command header for slot 0
-    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-    memset(hdr, 0, sizeof(hba_cmd_header_t));
-    hdr->prdtl = 1; // single PRDT
-
-    // Command table (align to 128)
-    ctx->ctba0 = heap_aligned_alloc(128, sizeof(hba_cmd_table_t));
-    if (!ctx->ctba0) return false;
-    memset(ctx->ctba0, 0, sizeof(hba_cmd_table_t));
-    uintptr_t ctba = (uintptr_t)ctx->ctba0;
-    hdr->ctba = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-    hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
+    // One command table per slot (align to 128); every header points at its own
+    uint32_t slots = HBA_CAP_NCS(s_hba->cap);
+    ctx->ctbl = (uint8_t*)heap_aligned_alloc(128, slots * AHCI_CMD_TABLE_SIZE);
+    if (!ctx->ctbl) return false;
+    memset(ctx->ctbl, 0, slots * AHCI_CMD_TABLE_SIZE);
+    ctx->ctba0 = ctx->ctbl;
+    for (uint32_t slot = 0; slot < slots; ++slot) {
+        hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem + slot;
+        uintptr_t ctba = (uintptr_t)(ctx->ctbl + slot * AHCI_CMD_TABLE_SIZE);
+        hdr->prdtl = 1; // single PRDT
+        hdr->ctba = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
+        hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
+    }
+    ctx->slots = slots;
+    ctx->depth = 1;
+    ctx->ncq = false;
 
     // Clear pending interrupts
     p->is = 0xFFFFFFFFu;
@@ -197,250 +267,706 @@ static bool ahci_port_configure(ahci_port_ctx_t* ctx)
     return true;
 }
 
-static bool ahci_read_sector(ahci_port_ctx_t* ctx, uint64_t lba, uint32_t count, void* buf)
+static inline uint32_t ahci_block_size(const ahci_port_ctx_t* ctx)
+{
+    return (ctx->blk && ctx->blk->logical_block_size) ? ctx->blk->logical_block_size : 512u;
+}
+
+static inline hba_cmd_table_t* ahci_slot_table(ahci_port_ctx_t* ctx, uint32_t slot)
+{
+    return (hba_cmd_table_t*)(ctx->ctbl + slot * AHCI_CMD_TABLE_SIZE);
+}
+
+// waiter'ın tüm kayıtlarını temizleyip uyandır. Zamanlayıcı yalnızca BSP'de;
+// AP'deki bir yoklayıcı topladıysa uyuyan kendi dilimi dolunca görür.
+static void ahci_port_wake(ahci_port_ctx_t* ctx, uint32_t finished)
+{
+    if (!scheduler_is_running()) return;
+    while (finished) {
+        Thread* waiter = ctx->rec[__builtin_ctz(finished)].waiter;
+        finished &= finished - 1;
+        if (!waiter) continue;
+        for (uint32_t slot = 0; slot < 32; ++slot) {
+            if (ctx->rec[slot].waiter == waiter) ctx->rec[slot].waiter = NULL;
+        }
+        thread_wake(waiter);
+    }
+}
+
+// Biten slotları sahiplerine dağıt: senkron olanlar done/failed'a geçer ve
+// bekleyen uyandırılır; asenkron istek slotları burada serbest kalır. ctx->lock tutulurken.
+static void ahci_port_retire(ahci_port_ctx_t* ctx, uint32_t finished, uint32_t failed)
+{
+    ctx->issued &= ~finished;
+    for (uint32_t m = finished; m; m &= m - 1) {
+        uint32_t slot = (uint32_t)__builtin_ctz(m);
+        BlockRequest* req = ctx->rec[slot].req;
+        if (!req) continue;
+
+        uint32_t bit = 1u << slot;
+        ctx->rec[slot].req = NULL;
+        ctx->busy &= ~bit;
+        if (slot == 0) ctx->exclusive = false;
+        if (failed & bit) req->failed = true;
+        finished &= ~bit;
+        failed &= ~bit;
+        if (--req->pending == 0) {
+            req->next = ctx->completed;
+            ctx->completed = req;
+        }
+    }
+    ctx->done |= finished;
+    ctx->failed |= failed;
+    if (finished) ahci_port_wake(ctx, finished);
+}
+
+// Biten istekleri kilit dışında bildir; geri çağrılar yeni istek gönderebilir
+static void ahci_port_finish(ahci_port_ctx_t* ctx)
+{
+    if (!ctx->completed) return;
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    BlockRequest* list = ctx->completed;
+    ctx->completed = NULL;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+
+    while (list) {
+        BlockRequest* req = list;
+        list = req->next;
+        req->next = NULL;
+        BlockRequest_Complete(req, !req->failed);
+    }
+}
+
+static void ahci_port_finish_work(void* arg)
+{
+    ahci_port_finish((ahci_port_ctx_t*)arg);
+}
+
+// PxIS/PxCI/PxSACT'e bakıp biten slotları sahiplerine dağıt. ctx->lock
+// tutulurken; hem ISR'dan hem de bekleyen çağıranlardan çağrılır.
+static void ahci_port_collect(ahci_port_ctx_t* ctx)
 {
-    if (count == 0) return true;
     volatile hba_port_t* p = ctx->port;
-    // Wait if busy (bounded)
-    {
-        uint32_t spin = 1000000;
-        while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && spin--) { asm volatile ("pause"); }
-        if (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) {
-            ERROR("AHCI: Port %u busy before READ DMA (TFD=0x%08x)", ctx->port_no, p->tfd);
+    uint32_t pis = p->is;
+    if (pis) p->is = pis; // write-to-clear
+
+    if (pis & HBA_PxIS_ERRORS) {
+        WARN("AHCI: Port %u error (IS=0x%08x TFD=0x%08x SACT=0x%08x CI=0x%08x)",
+             ctx->port_no, pis, p->tfd, p->sact, p->ci);
+        ctx->error = true;
+        // Biti inmiş olanlar hatadan önce başarıyla bitti
+        uint32_t stopped = ctx->issued & (p->ci | p->sact);
+        ahci_port_retire(ctx, ctx->issued & ~stopped, 0);
+        if (!ctx->ncq || ctx->exclusive || ctx->recovering) {
+            // Kuyruksuz komut (kurtarmadaki READ LOG EXT dahil) tek başına uçuşur; hatalı olan odur
+            ahci_port_retire(ctx, stopped, stopped);
+        } else {
+            // Hangi tag'in bozulduğunu log 10h söyler (ahci_port_restart);
+            // cihaz diğerlerini iptal etti, kurtarmadan sonra yeniden verilirler
+            ctx->issued &= ~stopped;
+            ctx->aborted |= stopped;
+            ahci_port_wake(ctx, stopped);
+        }
+        return;
+    }
+
+    // NCQ komutu SACT biti (SDB FIS) inince, kuyruksuz komut CI inince biter
+    uint32_t finished = ctx->issued & ~(p->ci | p->sact);
+    if (finished) ahci_port_retire(ctx, finished, 0);
+}
+
+// Boş bir slot ayır; yoksa (ya da port hata kurtarmasındaysa) -1. Kuyruksuz
+// komutlar portun tamamen boşalmasını bekler ve NCQ komutlarıyla karışmaz.
+static int ahci_slot_alloc(ahci_port_ctx_t* ctx, bool queued)
+{
+    int slot = -1;
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    if (!ctx->error && !ctx->exclusive) {
+        if (!queued) {
+            if (ctx->busy == 0) {
+                slot = 0;
+                ctx->exclusive = true;
+            }
+        } else if ((uint32_t)__builtin_popcount(ctx->busy) < ctx->depth) {
+            uint32_t free_mask = ~ctx->busy & (ctx->depth >= 32 ? 0xFFFFFFFFu : ((1u << ctx->depth) - 1u));
+            if (free_mask) slot = __builtin_ctz(free_mask);
+        }
+        if (slot >= 0) ctx->busy |= 1u << slot;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    return slot;
+}
+
+// req NULL değilse slot o isteğin bir parçasıdır ve bitince isteğe sayılır
+static void ahci_slot_issue(ahci_port_ctx_t* ctx, uint32_t slot, bool queued, BlockRequest* req)
+{
+    volatile hba_port_t* p = ctx->port;
+    uint32_t bit = 1u << slot;
+
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ctx->rec[slot].req = req;
+    if (req) {
+        req->pending++;
+        ctx->rec[slot].issued_ns = time_now_ns();
+    }
+    ctx->issued |= bit;
+    mmio_wmb();
+    if (queued) p->sact = bit; // NCQ: SACT, CI'dan önce
+    p->ci = bit;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+// Ayrılıp hiç verilmemiş slotu geri bırak
+static void ahci_slot_free(ahci_port_ctx_t* ctx, uint32_t slot)
+{
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ctx->busy &= ~(1u << slot);
+    if (slot == 0) ctx->exclusive = false;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+// mask içindeki bitmiş slotları topla ve serbest bırak; hata ile bitenler *failed'a
+static uint32_t ahci_slot_reap(ahci_port_ctx_t* ctx, uint32_t mask, uint32_t* failed)
+{
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ahci_port_collect(ctx);
+    uint32_t done = ctx->done & mask;
+    *failed = ctx->failed & done;
+    ctx->done &= ~done;
+    ctx->failed &= ~done;
+    ctx->busy &= ~done;
+    if (done & 1u) ctx->exclusive = false;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+    return done;
+}
+
+static int ahci_port_read_ncq_log(ahci_port_ctx_t* ctx);
+
+// Hata bildiren portu kurtar: motoru yeniden başlat, NCQ'da log 10h'den hatalı
+// tag'i öğren ve yalnızca onu hatalı say; cihazın iptal ettiği diğer tag'ler
+// aynı komut tablolarıyla yeniden verilir. Tag bilinmiyorsa hepsi hatalıdır.
+// Aynı anda tek kurtarma çalışır; bitene kadar ahci_slot_alloc yeni komut vermez.
+static void ahci_port_restart(ahci_port_ctx_t* ctx, const char* tag)
+{
+    if (!__sync_bool_compare_and_swap(&ctx->recovering, 0, 1)) return;
+    ahci_port_recover(ctx, tag);
+    // NCQ hatasından sonra cihaz log 10h okunana kadar kuyruklu komut kabul etmez
+    int bad = ctx->ncq ? ahci_port_read_ncq_log(ctx) : -1;
+
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    uint32_t retry = ctx->aborted;
+    ctx->aborted = 0;
+    uint32_t failed = (bad >= 0) ? (retry & (1u << bad)) : retry;
+    ahci_port_retire(ctx, failed, failed);
+    retry &= ~failed;
+    ctx->error = false;
+    if (retry) {
+        LOG("AHCI: Port %u reissuing aborted tags 0x%08x", ctx->port_no, retry);
+        uint64_t now = time_now_ns();
+        for (uint32_t m = retry; m; m &= m - 1) {
+            uint32_t slot = (uint32_t)__builtin_ctz(m);
+            ((hba_cmd_header_t*)ctx->clb_mem + slot)->prdbc = 0;
+            ctx->rec[slot].issued_ns = now;
+        }
+        ctx->issued |= retry;
+        mmio_wmb();
+        ctx->port->sact = retry;
+        ctx->port->ci = retry;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+    ctx->recovering = 0;
+}
+
+// Uçuştaki her şeyi (zaman aşımında suçlu bilinmez) hatalı say ve portu kurtar
+static void ahci_port_abort(ahci_port_ctx_t* ctx, const char* tag)
+{
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ahci_port_collect(ctx);
+    uint32_t all = ctx->issued | ctx->aborted;
+    ctx->aborted = 0;
+    ahci_port_retire(ctx, all, all);
+    ctx->error = true;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+
+    ahci_port_restart(ctx, tag);
+}
+
+// mask'taki slotlardan biri bitene ya da süre dolana kadar bekle; süre
+// dolduysa false. Kesme kipinde ve zamanlayıcı bu CPU'daysa thread uyur, ISR
+// uyandırır. Erken açılışta, AP'lerde ve fiber'larda wait_deadline_poll ile yoklanır.
+static bool ahci_port_wait(ahci_port_ctx_t* ctx, uint32_t mask, WaitDeadline* wait)
+{
+    if (!mask || !s_ahci_irq_mode || !scheduler_is_running() || fiber_current() || !arch_irq_enabled())
+        return wait_deadline_poll(wait);
+
+    uint64_t elapsed = time_now_ns() - wait->start_ns;
+    if (elapsed >= wait->timeout_ns) return false;
+
+    Thread* self = thread_current();
+    uint32_t irqs = s_ahci_irq_count;
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ahci_port_collect(ctx);
+    bool ready = (ctx->done & mask) != 0;
+    if (!ready) {
+        for (uint32_t m = mask; m; m &= m - 1) ctx->rec[__builtin_ctz(m)].waiter = self;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+    if (ready) return true;
+
+    // Kilit bırakıldıktan sonra gelen uyandırma kaybolmaz (wake_pending)
+    uint64_t left_ms = (wait->timeout_ns - elapsed) / 1000000ull + 1u;
+    thread_sleep_ms(left_ms < AHCI_IRQ_SLICE_MS ? (uint32_t)left_ms : AHCI_IRQ_SLICE_MS);
+
+    flags = spin_lock_irqsave(&ctx->lock);
+    bool woken = ctx->rec[__builtin_ctz(mask)].waiter != self;
+    for (uint32_t m = mask; m; m &= m - 1) ctx->rec[__builtin_ctz(m)].waiter = NULL;
+    if (woken) {
+        s_ahci_irq_missed = 0;
+    } else {
+        ahci_port_collect(ctx);
+        if ((ctx->done & mask) && s_ahci_irq_count == irqs && ++s_ahci_irq_missed >= AHCI_IRQ_MISS_LIMIT) {
+            s_ahci_irq_mode = false;
+            WARN("AHCI: IRQ%u not delivering completions; falling back to polling", s_ahci_irq_line);
+        }
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+    return true;
+}
+
+// Biteni topla, bildir; asenkron bir hata portu durdurduysa ya da asenkron
+// bir komut süresini aştıysa kurtar. ISR dışında çağrılır.
+static void ahci_port_service(ahci_port_ctx_t* ctx)
+{
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    ahci_port_collect(ctx);
+    bool error = ctx->error;
+    bool stale = false;
+    uint64_t now = time_now_ns();
+    for (uint32_t m = ctx->issued; m; m &= m - 1) {
+        const ahci_slot_rec_t* rec = &ctx->rec[__builtin_ctz(m)];
+        if (rec->req && now - rec->issued_ns > (uint64_t)AHCI_IO_TIMEOUT_US * 1000ull) stale = true;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
+
+    if (stale) {
+        ERROR("AHCI: async command timeout on port %u (SACT=0x%08x CI=0x%08x TFD=0x%08x)",
+              ctx->port_no, ctx->port->sact, ctx->port->ci, ctx->port->tfd);
+        ahci_port_abort(ctx, "ASYNC-TIMEOUT");
+    } else if (error && !ctx->recovering) {
+        ahci_port_restart(ctx, "ASYNC");
+    }
+}
+
+// Tek bir kuyruksuz komutun bitmesini bekle; hata ya da zaman aşımında portu kurtarır
+static bool ahci_slot_wait_one(ahci_port_ctx_t* ctx, uint32_t slot, const char* tag)
+{
+    uint32_t failed = 0;
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+    while (!ahci_slot_reap(ctx, 1u << slot, &failed)) {
+        if (!ahci_port_wait(ctx, 1u << slot, &wait)) {
+            ERROR("AHCI: %s timeout on port %u (TFD=0x%08x CI=0x%08x)", tag, ctx->port_no, ctx->port->tfd, ctx->port->ci);
+            ahci_port_abort(ctx, tag);
+            (void)ahci_slot_reap(ctx, 1u << slot, &failed);
             return false;
         }
     }
+    if (failed) ahci_port_abort(ctx, tag);
+    return failed == 0;
+}
 
-    // Build command in slot 0
-    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-    // Program CTBA in case controller expects it each time
-    uintptr_t ctba = (uintptr_t)ctx->ctba0;
-    hdr->ctba  = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-    hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
+// Kuyruksuz komut için slot 0'ı bekleyerek ayır; süre dolarsa -1
+static int ahci_slot_alloc_wait(ahci_port_ctx_t* ctx)
+{
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+    int slot;
+    while ((slot = ahci_slot_alloc(ctx, false)) < 0) {
+        ahci_port_service(ctx);
+        if (!wait_deadline_poll(&wait)) return -1;
+    }
+    return slot;
+}
+
+// Slot'un komut başlığını ve CFIS'ini hazırla; PRDT'yi ahci_slot_map doldurur
+static fis_reg_h2d_t* ahci_slot_setup(ahci_port_ctx_t* ctx, uint32_t slot, bool write)
+{
+    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem + slot;
     hdr->cfl = sizeof(fis_reg_h2d_t) / 4; // FIS length in dwords
     hdr->a = 0; // ATA
-    hdr->w = 0; // read
-    hdr->prdtl = 1;
+    hdr->w = write ? 1 : 0;
+    hdr->p = 0;
+    hdr->c = 0;
     hdr->prdbc = 0;
 
-    hba_cmd_table_t* tbl = (hba_cmd_table_t*)ctx->ctba0;
-    memset(tbl, 0, sizeof(hba_cmd_table_t));
+    hba_cmd_table_t* tbl = ahci_slot_table(ctx, slot);
+    memset(tbl, 0, AHCI_CMD_HDR_BYTES);
 
-    // PRDT sized by logical block size (default 512 when unknown)
-    uintptr_t bufp = (uintptr_t)buf;
-    tbl->prdt[0].dba = (uint32_t)((uint64_t)bufp & 0xFFFFFFFFu);
-    tbl->prdt[0].dbau = (uint32_t)(((uint64_t)bufp >> 32) & 0xFFFFFFFFu);
-    uint32_t bsz = (ctx->blk && ctx->blk->logical_block_size) ? ctx->blk->logical_block_size : 512u;
-    uint32_t byte_count = count * bsz;
-    tbl->prdt[0].dbc_i = ((byte_count - 1) & 0x003FFFFFu) | (1u << 31); // ioc=1
-
-    // CFIS: READ DMA EXT (0x25)
     fis_reg_h2d_t* cfis = (fis_reg_h2d_t*)tbl->cfis;
-    memset(cfis, 0, sizeof(*cfis));
     cfis->fis_type = FIS_TYPE_REG_H2D;
     cfis->c = 1;
-    cfis->command = 0x25; // READ DMA EXT
     cfis->device = 1 << 6; // LBA mode
-    // LBA48
+    return cfis;
+}
+
+// it'ten başlayan en fazla bytes baytı fiziksel olarak sürekli parçalara
+// bölüp slot'un PRDT'sine yaz; komşu parçalar tek girdide birleşir. Tablo
+// dolarsa kısa kalır; eşlenen bayt sayısı align'ın katına kırpılır ve it o
+// kadar ilerler. Tamponlar word hizalı olmalı (DBA bit 0 ve çift bayt sayısı).
+static uint32_t ahci_slot_map(ahci_port_ctx_t* ctx, uint32_t slot, BlockSegIter* it, uint32_t bytes, uint32_t align)
+{
+    hba_cmd_table_t* tbl = ahci_slot_table(ctx, slot);
+    BlockSegIter pos = *it;
+    uint32_t entries = 0;
+    uint32_t mapped = 0;
+    uint64_t next_phys = 0; // son girdinin bittiği fiziksel adres
+
+    while (mapped < bytes) {
+        uint32_t want = bytes - mapped;
+        if (want > AHCI_PRDT_MAX_BYTES) want = AHCI_PRDT_MAX_BYTES;
+        uintptr_t phys = 0;
+        uint32_t run = BlockSegIter_Extent(&pos, want, &phys);
+        if (run == 0) break;
+
+        hba_prdt_entry_t* e = entries ? &tbl->prdt[entries - 1] : NULL;
+        uint32_t len = e ? (e->dbc_i & 0x003FFFFFu) + 1u : 0;
+        if (e && (uint64_t)phys == next_phys && len + run <= AHCI_PRDT_MAX_BYTES) {
+            e->dbc_i = (len + run - 1u) & 0x003FFFFFu;
+        } else {
+            if (entries == AHCI_PRDT_ENTRIES) break;
+            e = &tbl->prdt[entries++];
+            e->dba = (uint32_t)((uint64_t)phys & 0xFFFFFFFFu);
+            e->dbau = (uint32_t)(((uint64_t)phys >> 32) & 0xFFFFFFFFu);
+            e->rsv0 = 0;
+            e->dbc_i = (run - 1) & 0x003FFFFFu;
+        }
+        next_phys = (uint64_t)phys + run;
+        mapped += run;
+        BlockSegIter_Advance(&pos, run);
+    }
+
+    // Sektörün ortasında kaldıysak sondaki girdileri kırp
+    uint32_t keep = mapped - mapped % align;
+    while (entries && mapped > keep) {
+        hba_prdt_entry_t* e = &tbl->prdt[entries - 1];
+        uint32_t len = (e->dbc_i & 0x003FFFFFu) + 1u;
+        uint32_t cut = mapped - keep;
+        if (cut >= len) {
+            entries--;
+            mapped -= len;
+        } else {
+            e->dbc_i = len - cut - 1u;
+            mapped -= cut;
+        }
+    }
+    if (entries) tbl->prdt[entries - 1].dbc_i |= (1u << 31); // ioc on the last entry
+
+    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem + slot;
+    hdr->prdtl = (uint16_t)entries;
+    BlockSegIter_Advance(it, mapped);
+    return mapped;
+}
+
+// Tek tamponlu komutlar (IDENTIFY, ATAPI, senkron okuma/yazma) için
+static uint32_t ahci_slot_map_buf(ahci_port_ctx_t* ctx, uint32_t slot, void* buf, uint32_t bytes, uint32_t align)
+{
+    BlockSegment seg = { buf, bytes };
+    BlockSegIter it;
+    BlockSegIter_Init(&it, &seg, buf ? 1u : 0u);
+    return ahci_slot_map(ctx, slot, &it, bytes, align);
+}
+
+static void ahci_fis_set_lba(fis_reg_h2d_t* cfis, uint64_t lba)
+{
     cfis->lba0 = (uint8_t)(lba & 0xFF);
     cfis->lba1 = (uint8_t)((lba >> 8) & 0xFF);
     cfis->lba2 = (uint8_t)((lba >> 16) & 0xFF);
     cfis->lba3 = (uint8_t)((lba >> 24) & 0xFF);
     cfis->lba4 = (uint8_t)((lba >> 32) & 0xFF);
     cfis->lba5 = (uint8_t)((lba >> 40) & 0xFF);
-    cfis->countl = (uint8_t)(count & 0xFF);
-    cfis->counth = (uint8_t)((count >> 8) & 0xFF);
+}
 
-    // Issue command on slot 0
-    p->is = 0xFFFFFFFFu; // clear
-    mmio_wmb();
-    p->ci = 1u; // slot 0
+// Slot'a en fazla count sektörlük okuma/yazma kur; PRDT'ye sığan sektör sayısını döndürür
+static uint32_t ahci_setup_rw(ahci_port_ctx_t* ctx, uint32_t slot, uint64_t lba, uint32_t count, BlockSegIter* it, bool write)
+{
+    uint32_t bsz = ahci_block_size(ctx);
+    count = ahci_slot_map(ctx, slot, it, count * bsz, bsz) / bsz;
+    if (count == 0) return 0;
+
+    fis_reg_h2d_t* cfis = ahci_slot_setup(ctx, slot, write);
+    ahci_fis_set_lba(cfis, lba);
+    if (ctx->ncq) {
+        // FPDMA QUEUED: sektör sayısı FEATURE'da, tag COUNT[7:3]'te
+        cfis->command = write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+        cfis->featurel = (uint8_t)(count & 0xFF);
+        cfis->featureh = (uint8_t)((count >> 8) & 0xFF);
+        cfis->countl = (uint8_t)(slot << 3);
+    } else {
+        cfis->command = write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+        cfis->countl = (uint8_t)(count & 0xFF);
+        cfis->counth = (uint8_t)((count >> 8) & 0xFF);
+    }
+    return count;
+}
 
-    // Wait for completion: prefer IRQ event, fall back to CI polling
-    {
-        uint32_t spin = 5000000; // generous spin
-        while (spin--) {
-            if ((p->ci & 1u) == 0) break; // done
-            if (ctx->irq_events) break;   // IRQ signaled
-            if (p->is & HBA_PxIS_TFES) {
-                ERROR("AHCI: TFES error on port %u (IS=0x%08x TFD=0x%08x)", ctx->port_no, p->is, p->tfd);
-                return false;
+// İsteği komutlara böler (AHCI_MAX_CMD_SECTORS ya da PRDT'nin aldığı kadar;
+// sürekli tamponda tek komut) ve kuyruk derinliği kadarını aynı anda uçuşta
+// tutar; biten slotlar yeni parçalarla doldurulur.
+static bool ahci_rw(ahci_port_ctx_t* ctx, uint64_t lba, uint32_t count, uint8_t* buf, bool write)
+{
+    if (!ctx || !ctx->slots) return false;
+    uint32_t mine = 0; // bu çağrının uçuştaki slotları
+    bool ok = true;
+
+    BlockSegment seg = { buf, 0 };
+    seg.bytes = count * ahci_block_size(ctx);
+    BlockSegIter it;
+    BlockSegIter_Init(&it, &seg, 1);
+
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+    while (count || mine) {
+        int slot = (ok && count) ? ahci_slot_alloc(ctx, ctx->ncq) : -1;
+        if (slot >= 0) {
+            uint32_t n = (count > AHCI_MAX_CMD_SECTORS) ? AHCI_MAX_CMD_SECTORS : count;
+            n = ahci_setup_rw(ctx, (uint32_t)slot, lba, n, &it, write);
+            if (n == 0) {
+                ERROR("AHCI: %s buffer %p not DMA-mappable on port %u", write ? "WRITE" : "READ", buf, ctx->port_no);
+                ahci_slot_free(ctx, (uint32_t)slot);
+                ok = false;
+                continue;
             }
-            asm volatile ("pause");  
+            ahci_slot_issue(ctx, (uint32_t)slot, ctx->ncq, NULL);
+            mine |= 1u << slot;
+            lba += n; count -= n;
+            continue;
         }
-        // Clear any latched irq events
-        ctx->irq_events = 0;
-        if (p->ci & 1u) {
-            ERROR("AHCI: READ DMA timeout on port %u (IS=0x%08x TFD=0x%08x)", ctx->port_no, p->is, p->tfd);
-            return false;
+        if (!ok && !mine) break;
+        // Slotlar asenkron isteklerde ya da port kurtarma bekliyor; NCQ hatasıyla
+        // durdurulan slotlarımız da ancak kurtarmadan sonra yeniden verilir
+        if (!mine || ctx->error) ahci_port_service(ctx);
+
+        // Kuyruk dolu ya da gönderilecek parça kalmadı: bitenleri topla
+        uint32_t failed = 0;
+        uint32_t done = mine ? ahci_slot_reap(ctx, mine, &failed) : 0;
+        if (done) {
+            mine &= ~done;
+            if (failed) {
+                ERROR("AHCI: %s failed on port %u (slots 0x%08x)", write ? "WRITE" : "READ", ctx->port_no, failed);
+                ok = false;
+                // Hata henüz kurtarılmadıysa kurtar; diğer tag'lerimiz yeniden verilir
+                ahci_port_service(ctx);
+            }
+            wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+            continue;
+        }
+        if (!ahci_port_wait(ctx, mine, &wait)) {
+            ERROR("AHCI: %s timeout on port %u (busy 0x%08x SACT=0x%08x CI=0x%08x TFD=0x%08x)",
+                  write ? "WRITE" : "READ", ctx->port_no, mine, ctx->port->sact, ctx->port->ci, ctx->port->tfd);
+            ok = false;
+            if (mine) ahci_port_abort(ctx, "TIMEOUT");
+            else break; // başkasının komutları slotları tutuyor
+            wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
         }
     }
-    // success
-    return true;
+    return ok && count == 0;
 }
 
-static bool ahci_issue_flush(ahci_port_ctx_t* ctx, uint8_t opcode)
+// Veri aktarmayan kuyruksuz komut (FLUSH CACHE)
+static bool ahci_issue_nodata(ahci_port_ctx_t* ctx, uint8_t opcode)
 {
-    volatile hba_port_t* p = ctx->port;
-    // Wait if busy
-    {
-        uint32_t spin = 1000000;
-        while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && spin--) { asm volatile ("pause"); }
-        if (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) return false;
-    }
+    if (!ctx || !ctx->slots) return false;
 
-    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-    uintptr_t ctba = (uintptr_t)ctx->ctba0;
-    hdr->ctba  = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-    hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
-    hdr->cfl = sizeof(fis_reg_h2d_t) / 4;
-    hdr->a = 0; // ATA
-    hdr->w = 0;
-    hdr->prdtl = 0; // no data
-    hdr->prdbc = 0;
+    int slot = ahci_slot_alloc_wait(ctx);
+    if (slot < 0) return false;
 
-    hba_cmd_table_t* tbl = (hba_cmd_table_t*)ctx->ctba0;
-    memset(tbl, 0, sizeof(hba_cmd_table_t));
+    (void)ahci_slot_map_buf(ctx, (uint32_t)slot, NULL, 0, 1);
+    fis_reg_h2d_t* cfis = ahci_slot_setup(ctx, (uint32_t)slot, false);
+    cfis->command = opcode;
+    ahci_slot_issue(ctx, (uint32_t)slot, false, NULL);
+    return ahci_slot_wait_one(ctx, (uint32_t)slot, "FLUSH");
+}
 
-    fis_reg_h2d_t* cfis = (fis_reg_h2d_t*)tbl->cfis;
-    memset(cfis, 0, sizeof(*cfis));
-    cfis->fis_type = FIS_TYPE_REG_H2D;
-    cfis->c = 1;
-    cfis->command = opcode; // 0xEA FLUSH CACHE EXT or 0xE7 FLUSH CACHE
-    cfis->device = 1 << 6; // LBA mode
+// Kurtarma sırasında (ctx->error açıkken, ahci_slot_alloc kapalı) kuyruksuz
+// READ LOG EXT 10h: cihazın NCQ hata durumunu temizler. Hatalı tag'i döndürür;
+// log okunamadıysa ya da hata kuyruksuz bir komuttaysa -1.
+static int ahci_port_read_ncq_log(ahci_port_ctx_t* ctx)
+{
+    uint8_t log[512] __attribute__((aligned(16)));
+    memset(log, 0, sizeof(log));
+
+    // Uçuştakiler emekli edildi ya da ctx->aborted'da bekliyor; motor boş, ayrılmış slotlara dokunma
+    int slot = -1;
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    uint32_t free_mask = ~ctx->busy & (ctx->slots >= 32 ? 0xFFFFFFFFu : ((1u << ctx->slots) - 1u));
+    if (free_mask) {
+        slot = __builtin_ctz(free_mask);
+        ctx->busy |= 1u << slot;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    if (slot < 0) {
+        WARN("AHCI: Port %u no slot for READ LOG EXT", ctx->port_no);
+        return -1;
+    }
 
-    p->is = 0xFFFFFFFFu;
-    mmio_wmb();
-    p->ci = 1u;
+    if (ahci_slot_map_buf(ctx, (uint32_t)slot, log, sizeof(log), 512) != sizeof(log)) {
+        ahci_slot_free(ctx, (uint32_t)slot);
+        return -1;
+    }
+    fis_reg_h2d_t* cfis = ahci_slot_setup(ctx, (uint32_t)slot, false);
+    cfis->command = ATA_CMD_READ_LOG_EXT;
+    cfis->lba0 = ATA_LOG_NCQ_ERROR;
+    cfis->countl = 1;
+    ahci_slot_issue(ctx, (uint32_t)slot, false, NULL);
+
+    uint32_t bit = 1u << slot;
+    uint32_t failed = 0;
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+    while (!ahci_slot_reap(ctx, bit, &failed)) {
+        if (!wait_deadline_poll(&wait)) {
+            WARN("AHCI: Port %u READ LOG EXT timeout (TFD=0x%08x CI=0x%08x)",
+                 ctx->port_no, ctx->port->tfd, ctx->port->ci);
+            ahci_port_recover(ctx, "LOG-TIMEOUT");
+            flags = spin_lock_irqsave(&ctx->lock);
+            ctx->issued &= ~bit;
+            ctx->busy &= ~bit;
+            spin_unlock_irqrestore(&ctx->lock, flags);
+            return -1;
+        }
+    }
 
-    uint32_t spin = 5000000;
-    while (spin--) {
-        if ((p->ci & 1u) == 0) break;
-        if (ctx->irq_events) break;
-        if (p->is & HBA_PxIS_TFES) return false;
-        asm volatile ("pause"); 
+    if (failed) {
+        WARN("AHCI: Port %u READ LOG EXT failed (TFD=0x%08x)", ctx->port_no, ctx->port->tfd);
+        ahci_port_recover(ctx, "LOG");
+        return -1;
     }
-    ctx->irq_events = 0;
-    if (p->ci & 1u) return false;
-    return true;
+
+    uint64_t lba = (uint64_t)log[4] | (uint64_t)log[5] << 8 | (uint64_t)log[6] << 16 |
+                   (uint64_t)log[8] << 24 | (uint64_t)log[9] << 32 | (uint64_t)log[10] << 40;
+    if (log[0] & ATA_LOG_NCQ_NQ) {
+        LOG("AHCI: Port %u NCQ error log: non-queued command (status 0x%02x error 0x%02x)",
+            ctx->port_no, log[2], log[3]);
+        return -1;
+    }
+    LOG("AHCI: Port %u NCQ error log: tag %u status 0x%02x error 0x%02x LBA %llu",
+        ctx->port_no, log[0] & 0x1Fu, log[2], log[3], (unsigned long long)lba);
+    return (int)(log[0] & 0x1Fu);
 }
 
 static bool ahci_blk_read(struct BlockDevice* bdev, uint64_t lba, uint32_t count, void* buffer)
 {
-    ahci_port_ctx_t* ctx = (ahci_port_ctx_t*)bdev->driver_ctx;
-    // Read in chunks if count is large (limit to 128 sectors per command)
-    uint8_t* out = (uint8_t*)buffer;
-    while (count) {
-        uint32_t n = (count > 128) ? 128 : count;
-        if (!ahci_read_sector(ctx, lba, n, out)) return false;
-        lba += n; out += n * 512; count -= n;
-        asm volatile ("pause"); 
-    }
-    return true;
+    if (count == 0) return true;
+    return ahci_rw((ahci_port_ctx_t*)bdev->driver_ctx, lba, count, (uint8_t*)buffer, false);
 }
 
 static bool ahci_blk_write(struct BlockDevice* bdev, uint64_t lba, uint32_t count, const void* buffer)
+{
+    if (count == 0) return true;
+    return ahci_rw((ahci_port_ctx_t*)bdev->driver_ctx, lba, count, (uint8_t*)buffer, true);
+}
+
+static bool ahci_blk_flush(struct BlockDevice* bdev)
 {
     ahci_port_ctx_t* ctx = (ahci_port_ctx_t*)bdev->driver_ctx;
-    // Write in chunks (limit to 128 sectors per command)
-    const uint8_t* in = (const uint8_t*)buffer;
-    while (count) {
-        uint32_t n = (count > 128) ? 128 : count;
-        // Issue WRITE DMA EXT
-        if (!ctx) return false;
-        volatile hba_port_t* p = ctx->port;
-
-        // Wait if busy
-        {
-            uint32_t spin = 1000000;
-            while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && spin--) { asm volatile ("hlt"); }
-            if (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) {
-                ERROR("AHCI: Port %u busy before WRITE DMA (TFD=0x%08x)", ctx->port_no, p->tfd);
-                return false;
-            }
-        }
+    if (!ctx) return false;
+    // Try FLUSH CACHE EXT first; fall back to FLUSH CACHE if needed.
+    if (ahci_issue_nodata(ctx, ATA_CMD_FLUSH_CACHE_EXT)) return true;
+    return ahci_issue_nodata(ctx, ATA_CMD_FLUSH_CACHE);
+}
 
-        hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-        // Ensure CTBA is programmed (some controllers require this per command)
-        uintptr_t ctba = (uintptr_t)ctx->ctba0;
-        hdr->ctba  = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-        hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
-        hdr->cfl = sizeof(fis_reg_h2d_t) / 4; // 5 dwords
-        hdr->w = 1; // write
-        hdr->a = 0; // ATA
-        hdr->prdtl = 1;
-        hdr->prdbc = 0;
-
-        hba_cmd_table_t* tbl = (hba_cmd_table_t*)ctx->ctba0;
-        memset(tbl, 0, sizeof(hba_cmd_table_t));
-
-        // PRDT sized by logical block size (default 512 when unknown)
-        uintptr_t bufp = (uintptr_t)in;
-        tbl->prdt[0].dba = (uint32_t)((uint64_t)bufp & 0xFFFFFFFFu);
-        tbl->prdt[0].dbau = (uint32_t)(((uint64_t)bufp >> 32) & 0xFFFFFFFFu);
-        uint32_t bsz = (ctx->blk && ctx->blk->logical_block_size) ? ctx->blk->logical_block_size : 512u;
-        uint32_t byte_count = n * bsz;
-        tbl->prdt[0].dbc_i = ((byte_count - 1) & 0x003FFFFFu) | (1u << 31); // ioc=1
-
-        // CFIS: WRITE DMA EXT (0x35)
-        fis_reg_h2d_t* cfis = (fis_reg_h2d_t*)tbl->cfis;
-        memset(cfis, 0, sizeof(*cfis));
-        cfis->fis_type = FIS_TYPE_REG_H2D;
-        cfis->c = 1;
-        cfis->command = 0x35; // WRITE DMA EXT
-        cfis->device = 1 << 6; // LBA mode
-        // LBA48
-        cfis->lba0 = (uint8_t)(lba & 0xFF);
-        cfis->lba1 = (uint8_t)((lba >> 8) & 0xFF);
-        cfis->lba2 = (uint8_t)((lba >> 16) & 0xFF);
-        cfis->lba3 = (uint8_t)((lba >> 24) & 0xFF);
-        cfis->lba4 = (uint8_t)((lba >> 32) & 0xFF);
-        cfis->lba5 = (uint8_t)((lba >> 40) & 0xFF);
-        cfis->countl = (uint8_t)(n & 0xFF);
-        cfis->counth = (uint8_t)((n >> 8) & 0xFF);
-
-        // Issue command
-        p->is = 0xFFFFFFFFu; // clear
-        mmio_wmb();
-        p->ci = 1u; // slot 0
-
-        // Wait for completion
-        {
-            uint32_t spin = 5000000;
-            while (spin--) {
-                if ((p->ci & 1u) == 0) break;
-                if (ctx->irq_events) break;
-                if (p->is & HBA_PxIS_TFES) {
-                    ERROR("AHCI: TFES error on WRITE port %u (IS=0x%08x TFD=0x%08x)", ctx->port_no, p->is, p->tfd);
-                    return false;
+// İsteği komutlara bölüp slotlara dağıtır ve beklemeden döner; parçalar
+// ahci_port_retire'da sayılır, sonuncusu bitince istek tamamlanır. Kuyruk
+// doluysa yalnızca slot boşalana kadar bekler. BLKREQ_FLAG_NOWAIT ile (tamamlanma
+// bağlamından gönderim) ilk slot yoksa beklemek yerine reddeder, istek kuyrukta
+// kalır. FLUSH kuyruksuz komut olduğundan senkron yoldan gider.
+static bool ahci_blk_submit(struct BlockDevice* bdev, BlockRequest* req)
+{
+    ahci_port_ctx_t* ctx = (ahci_port_ctx_t*)bdev->driver_ctx;
+    if (!ctx || !ctx->slots || req->op == BLKREQ_FLUSH) return false;
+    for (uint32_t i = 0; i < req->sg_count; ++i) {
+        if (((uintptr_t)req->sg[i].buffer & 1u) != 0) return false; // DBA bit 0
+    }
+
+    int first = ahci_slot_alloc(ctx, ctx->ncq);
+    if (first < 0 && (req->flags & BLKREQ_FLAG_NOWAIT)) return false;
+
+    bool write = req->op == BLKREQ_WRITE;
+    uint64_t lba = req->lba;
+    uint32_t count = req->count;
+    BlockSegIter it;
+    BlockSegIter_Init(&it, req->sg, req->sg_count);
+    req->pending = 1; // gönderim referansı: parçalar erken biterse istek yarım tamamlanmasın
+
+    WaitDeadline wait;
+    wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
+    while (count) {
+        int slot = first >= 0 ? first : ahci_slot_alloc(ctx, ctx->ncq);
+        first = -1;
+        if (slot < 0) {
+            if (req->flags & BLKREQ_FLAG_NOWAIT) {
+                // Kalan parçalar bu isteğin kendi slotlarını bekler: yalnızca topla,
+                // kurtarmayı (mdelay) thread bağlamındaki ahci_blk_poll'a bırak
+                size_t lflags = spin_lock_irqsave(&ctx->lock);
+                ahci_port_collect(ctx);
+                bool error = ctx->error;
+                spin_unlock_irqrestore(&ctx->lock, lflags);
+                if (error) {
+                    req->failed = true;
+                    break;
                 }
-                asm volatile ("pause"); 
+            } else {
+                ahci_port_service(ctx);
             }
-            ctx->irq_events = 0;
-            if (p->ci & 1u) {
-                ERROR("AHCI: WRITE DMA timeout on port %u (IS=0x%08x TFD=0x%08x)", ctx->port_no, p->is, p->tfd);
-                return false;
+            if (!wait_deadline_poll(&wait)) {
+                ERROR("AHCI: no free slot on port %u for async %s", ctx->port_no, write ? "WRITE" : "READ");
+                req->failed = true;
+                break;
             }
+            continue;
         }
 
-        lba += n; in += n * bsz; count -= n;
+        uint32_t n = (count > AHCI_MAX_CMD_SECTORS) ? AHCI_MAX_CMD_SECTORS : count;
+        n = ahci_setup_rw(ctx, (uint32_t)slot, lba, n, &it, write);
+        if (n == 0) {
+            ERROR("AHCI: async %s buffer not DMA-mappable on port %u", write ? "WRITE" : "READ", ctx->port_no);
+            ahci_slot_free(ctx, (uint32_t)slot);
+            req->failed = true;
+            break;
+        }
+        ahci_slot_issue(ctx, (uint32_t)slot, ctx->ncq, req);
+        lba += n; count -= n;
+        wait_deadline_start(&wait, AHCI_IO_TIMEOUT_US);
     }
+
+    size_t flags = spin_lock_irqsave(&ctx->lock);
+    if (--req->pending == 0) {
+        req->next = ctx->completed;
+        ctx->completed = req;
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    ahci_port_finish(ctx);
     return true;
 }
 
-static bool ahci_blk_flush(struct BlockDevice* bdev)
+static void ahci_blk_poll(struct BlockDevice* bdev)
 {
     ahci_port_ctx_t* ctx = (ahci_port_ctx_t*)bdev->driver_ctx;
-    if (!ctx) return false;
-    // Try FLUSH CACHE EXT first; fall back to FLUSH CACHE if needed.
-    if (ahci_issue_flush(ctx, 0xEA)) return true;
-    return ahci_issue_flush(ctx, 0xE7);
+    if (ctx && ctx->slots) ahci_port_service(ctx);
 }
 
 static const BlockDeviceOps s_ahci_blk_ops = {
     .read = ahci_blk_read,
     .write = ahci_blk_write,
     .flush = ahci_blk_flush,
+    .submit = ahci_blk_submit,
+    .poll = ahci_blk_poll,
 };
 
 // ---- AHCI ATAPI (CD/DVD) support (READ(12), 2048B sectors) ----
@@ -449,75 +975,38 @@ static bool ahci_atapi_packet_cmd(ahci_port_ctx_t* ctx, const uint8_t* cdb, uint
     volatile hba_port_t* p = ctx->port;
     // Wait if busy
     {
-        uint32_t spin = 1000000;
-        while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && spin--) { asm volatile ("pause"); }
+        (void)ahci_wait_not_busy(p);
         if (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) {
             ERROR("AHCI: ATAPI busy before PACKET (TFD=0x%08x)", p->tfd);
             return false;
         }
     }
 
-    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-    // Do NOT clear the header entirely, CTBA must remain valid.
-    // Ensure CTBA points to our command table.
-    uintptr_t ctba = (uintptr_t)ctx->ctba0;
-    hdr->ctba  = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-    hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
-    hdr->cfl = sizeof(fis_reg_h2d_t) / 4; // 5 dwords
-    hdr->a = 1; // ATAPI
-    hdr->w = is_write ? 1 : 0;
-    hdr->c = 1; // clear BSY on R_OK (safer for some controllers)
-    hdr->prdtl = (byte_count > 0) ? 1 : 0;
-    hdr->prdbc = 0;
-
-    hba_cmd_table_t* tbl = (hba_cmd_table_t*)ctx->ctba0;
-    memset(tbl, 0, sizeof(hba_cmd_table_t));
-
-    if (byte_count) {
-        uintptr_t bufp = (uintptr_t)buf;
-        tbl->prdt[0].dba = (uint32_t)((uint64_t)bufp & 0xFFFFFFFFu);
-        tbl->prdt[0].dbau = (uint32_t)(((uint64_t)bufp >> 32) & 0xFFFFFFFFu);
-        tbl->prdt[0].dbc_i = ((byte_count - 1) & 0x003FFFFFu) | (1u << 31);
+    int slot = ahci_slot_alloc_wait(ctx);
+    if (slot < 0) return false;
+    if (ahci_slot_map_buf(ctx, (uint32_t)slot, buf, byte_count, 1) != byte_count) {
+        ERROR("AHCI: ATAPI buffer %p not DMA-mappable", buf);
+        ahci_slot_free(ctx, (uint32_t)slot);
+        return false;
     }
 
     // PACKET CFIS
-    fis_reg_h2d_t* cfis = (fis_reg_h2d_t*)tbl->cfis;
-    memset(cfis, 0, sizeof(*cfis));
-    cfis->fis_type = FIS_TYPE_REG_H2D;
-    cfis->c = 1;
+    fis_reg_h2d_t* cfis = ahci_slot_setup(ctx, (uint32_t)slot, is_write);
+    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem + slot;
+    hdr->a = 1; // ATAPI
+    hdr->c = 1; // clear BSY on R_OK (safer for some controllers)
+    cfis->device = 0;
     cfis->command = 0xA0; // PACKET
     // ATAPI byte count in Feature[15:0]
     cfis->featurel = (uint8_t)(byte_count & 0xFF);
     cfis->featureh = (uint8_t)((byte_count >> 8) & 0xFF);
 
     // Copy CDB (12 or 10 bytes typical)
-    memcpy(tbl->acmd, cdb, cdb_len);
-
-    // Issue command
-    p->is = 0xFFFFFFFFu;
-    mmio_wmb();
-    p->ci = 1u; // slot 0
-    LOG("AHCI: ATAPI PACKET issued (byte_count=%u, opcode=0x%02x CI=0x%08x)", byte_count, cdb ? cdb[0] : 0xFF, p->ci);
+    memcpy(ahci_slot_table(ctx, (uint32_t)slot)->acmd, cdb, cdb_len);
 
-    // Completion: prefer IRQ event
-    {
-        uint32_t spin = 5000000;
-        while (spin--) {
-            if ((p->ci & 1u) == 0) break;
-            if (ctx->irq_events) break;
-            if (p->is & HBA_PxIS_TFES) {
-                WARN("AHCI: ATAPI TFES (IS=0x%08x TFD=0x%08x)", p->is, p->tfd);
-                return false;
-            }
-            asm volatile ("pause");
-        }
-        ctx->irq_events = 0;
-        if (p->ci & 1u) {
-            ERROR("AHCI: ATAPI PACKET timeout (IS=0x%08x TFD=0x%08x PRDBC=%u)", p->is, p->tfd, hdr->prdbc);
-            return false;
-        }
-    }
-    return true;
+    ahci_slot_issue(ctx, (uint32_t)slot, false, NULL);
+    LOG("AHCI: ATAPI PACKET issued (byte_count=%u, opcode=0x%02x)", byte_count, cdb ? cdb[0] : 0xFF);
+    return ahci_slot_wait_one(ctx, (uint32_t)slot, "ATAPI");
 }
 
 static void ahci_atapi_request_sense(ahci_port_ctx_t* ctx)
@@ -550,8 +1039,8 @@ static bool ahci_atapi_read_blocks(ahci_port_ctx_t* ctx, uint32_t lba, uint32_t
     cdb10[7] = (uint8_t)((blocks >> 8) & 0xFF);
     cdb10[8] = (uint8_t)(blocks & 0xFF);
 
+    // Hata durumunda port ahci_slot_wait_one içinde kurtarıldı
     if (ahci_atapi_packet_cmd(ctx, cdb10, 12, buf, byte_count, false)) return true;
-    ahci_port_recover(ctx, "READ10-TFES");
     ahci_atapi_request_sense(ctx);
 
     // Fallback READ(12)
@@ -566,7 +1055,6 @@ static bool ahci_atapi_read_blocks(ahci_port_ctx_t* ctx, uint32_t lba, uint32_t
     cdb12[8] = (uint8_t)(blocks & 0xFF);
 
     if (ahci_atapi_packet_cmd(ctx, cdb12, 12, buf, byte_count, false)) return true;
-    ahci_port_recover(ctx, "READ12-TFES");
     ahci_atapi_request_sense(ctx);
     return false;
 }
@@ -597,49 +1085,23 @@ static bool ahci_identify_ata(ahci_port_ctx_t* ctx, uint16_t* id512)
     volatile hba_port_t* p = ctx->port;
     // Wait if busy
     {
-        uint32_t spin = 1000000;
-        while ((p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) && spin--) { asm volatile ("hlt"); }
+        (void)ahci_wait_not_busy(p);
         if (p->tfd & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)) return false;
     }
 
-    hba_cmd_header_t* hdr = (hba_cmd_header_t*)ctx->clb_mem;
-    uintptr_t ctba = (uintptr_t)ctx->ctba0;
-    hdr->ctba  = (uint32_t)((uint64_t)ctba & 0xFFFFFFFFu);
-    hdr->ctbau = (uint32_t)(((uint64_t)ctba >> 32) & 0xFFFFFFFFu);
-    hdr->cfl = sizeof(fis_reg_h2d_t) / 4;
-    hdr->a = 0; // ATA
-    hdr->w = 0;
-    hdr->c = 1;
-    hdr->prdtl = 1;
-    hdr->prdbc = 0;
-
-    hba_cmd_table_t* tbl = (hba_cmd_table_t*)ctx->ctba0;
-    memset(tbl, 0, sizeof(hba_cmd_table_t));
-
-    uintptr_t bufp = (uintptr_t)id512;
-    tbl->prdt[0].dba = (uint32_t)((uint64_t)bufp & 0xFFFFFFFFu);
-    tbl->prdt[0].dbau = (uint32_t)(((uint64_t)bufp >> 32) & 0xFFFFFFFFu);
-    tbl->prdt[0].dbc_i = (512 - 1) | (1u << 31);
+    int slot = ahci_slot_alloc_wait(ctx);
+    if (slot < 0) return false;
+    if (ahci_slot_map_buf(ctx, (uint32_t)slot, id512, 512, 512) != 512) {
+        ahci_slot_free(ctx, (uint32_t)slot);
+        return false;
+    }
 
-    fis_reg_h2d_t* cfis = (fis_reg_h2d_t*)tbl->cfis;
-    memset(cfis, 0, sizeof(*cfis));
-    cfis->fis_type = FIS_TYPE_REG_H2D;
-    cfis->c = 1;
+    fis_reg_h2d_t* cfis = ahci_slot_setup(ctx, (uint32_t)slot, false);
+    ((hba_cmd_header_t*)ctx->clb_mem + slot)->c = 1;
     cfis->command = 0xEC; // IDENTIFY DEVICE
-    cfis->device = 1 << 6; // LBA mode
 
-    p->is = 0xFFFFFFFFu;
-    mmio_wmb();
-    p->ci = 1u;
-
-    uint32_t spin = 5000000;
-    while (spin--) {
-        if ((p->ci & 1u) == 0) break;
-        if (p->is & HBA_PxIS_TFES) return false;
-        asm volatile ("pause"); 
-    }
-    if (p->ci & 1u) return false;
-    return true;
+    ahci_slot_issue(ctx, (uint32_t)slot, false, NULL);
+    return ahci_slot_wait_one(ctx, (uint32_t)slot, "IDENTIFY");
 }
 
 static bool ahci_atapi_read_capacity(ahci_port_ctx_t* ctx, uint32_t* last_lba, uint32_t* block_len)
@@ -655,6 +1117,89 @@ static bool ahci_atapi_read_capacity(ahci_port_ctx_t* ctx, uint32_t* last_lba, u
     return true;
 }
 
+// Tek bir portun yoklama sonucu; BlockDevice kaydı fiber'lar bittikten sonra yapılır
+typedef struct {
+    ahci_port_ctx_t* ctx;
+    bool present;
+    uint32_t sig;
+    uint32_t block_size;
+    uint64_t total;
+} ahci_port_probe_t;
+
+static void ahci_probe_port(void* arg)
+{
+    ahci_port_probe_t* probe = (ahci_port_probe_t*)arg;
+    ahci_port_ctx_t* ctx = probe->ctx;
+    volatile hba_port_t* p = ctx->port;
+    uint8_t i = ctx->port_no;
+
+    ctx->blk = NULL;
+    if (!ahci_port_configure(ctx)) {
+        WARN("AHCI: Port %u configuration failed", i);
+        return;
+    }
+    // Clear and enable all port interrupts
+    p->is = 0xFFFFFFFFu; p->ie = 0xFFFFFFFFu;
+
+    // Issue COMRESET and wait a bit for device detection
+    ahci_port_comreset(p);
+    {
+        // PHY iletişimi kurulana kadar (DET=3) kısa süre bekle; boş portlar süreyi doldurur
+        WaitDeadline wait;
+        wait_deadline_start(&wait, 10000);
+        while ((p->ssts & HBA_SSTS_DET_MASK) != HBA_DET_PRESENT && wait_deadline_poll(&wait)) ;
+    }
+
+    uint32_t ssts = p->ssts;
+    uint8_t det = (uint8_t)(ssts & HBA_SSTS_DET_MASK);
+    uint8_t spd = HBA_SSTS_SPD(ssts);
+    uint8_t ipm = HBA_SSTS_IPM(ssts);
+    uint32_t sig = p->sig;
+    LOG("AHCI: Port %u SSTS=0x%08x DET=%u SPD=%u IPM=%u SIG=0x%08x (%s)", i, ssts, det, spd, ipm, sig, sig_to_str(sig));
+    if (det != HBA_DET_PRESENT) return;
+
+    if (sig == SATA_SIG_ATA) {
+        uint16_t id[256]; memset(id, 0, sizeof(id));
+        uint32_t bsz = 512; uint64_t total = 0;
+        if (ahci_identify_ata(ctx, id)) {
+            uint16_t w106 = id[106];
+            if (w106 & (1u << 12)) {
+                uint32_t sz = ((uint32_t)id[118] << 16) | id[117];
+                if (sz >= 512 && (sz % 512) == 0) bsz = sz;
+            }
+            uint32_t lba28 = ((uint32_t)id[61] << 16) | id[60];
+            bool lba48 = (id[83] & (1u << 10)) != 0;
+            uint64_t lba48_cnt = 0;
+            if (lba48) {
+                lba48_cnt = ((uint64_t)id[103] << 48) | ((uint64_t)id[102] << 32) | ((uint64_t)id[101] << 16) | id[100];
+            }
+            total = lba48 ? lba48_cnt : lba28;
+            LOG("AHCI: IDENTIFY -> sector=%u total=%u (lba48=%d)", bsz, (unsigned)total, (int)lba48);
+
+            // NCQ: HBA CAP.SNCQ ve IDENTIFY word 76 bit 8; derinlik word 75[4:0] + 1
+            if ((s_hba->cap & HBA_CAP_SNCQ) && (id[76] & (1u << 8))) {
+                uint32_t qd = (id[75] & 0x1Fu) + 1u;
+                ctx->depth = qd < ctx->slots ? qd : ctx->slots;
+                ctx->ncq = true;
+                LOG("AHCI: Port %u NCQ enabled (device QD=%u, HBA slots=%u)", i, qd, ctx->slots);
+            }
+        } else {
+            WARN("AHCI: IDENTIFY ATA failed; using defaults");
+        }
+        probe->block_size = bsz;
+        probe->total = total;
+    } else if (sig == SATA_SIG_ATAPI) {
+        uint32_t last=0, blen=2048;
+        (void)ahci_atapi_read_capacity(ctx, &last, &blen);
+        probe->block_size = blen ? blen : 2048;
+        probe->total = (uint64_t)last + 1u;
+    } else {
+        return;
+    }
+    probe->sig = sig;
+    probe->present = true;
+}
+
 static void ahci_probe_controller(void)
 {
     PCI_Init();
@@ -695,9 +1240,10 @@ static void ahci_probe_controller(void)
     if (hba->bohc & HBA_BOHC_BOS) {
         LOG("AHCI: BOHC BIOS-owned detected; requesting OS ownership");
         hba->bohc |= HBA_BOHC_OOS;
-        // Spec allows BIOS up to 1 second typically; we spin bounded
-        uint32_t spin = 5000000; // ~ a few ms worth of MMIO polls
-        while ((hba->bohc & HBA_BOHC_BOS) && spin--) { asm volatile ("hlt"); }
+        // Spec: BIOS 25 ms içinde bırakmalı, BB (busy) ile 2 s'ye kadar sürebilir
+        WaitDeadline wait;
+        wait_deadline_start(&wait, AHCI_BOHC_TIMEOUT_US);
+        while ((hba->bohc & HBA_BOHC_BOS) && wait_deadline_poll(&wait)) ;
         if (hba->bohc & HBA_BOHC_BOS) {
             WARN("AHCI: BIOS did not release ownership; continuing anyway");
         } else {
@@ -727,70 +1273,49 @@ static void ahci_probe_controller(void)
         WARN("AHCI: No legacy IRQ line reported; continuing with polling");
     }
 
-    // Iterate ports implemented
+    // Her port kendi fiber'ında yoklanır: COMRESET/DET ve IDENTIFY beklemeleri
+    // portlar arasında üst üste biner. Kayıt sırası port numarasına göre kalır.
+    ahci_port_probe_t probes[32];
+    memset(probes, 0, sizeof(probes));
     for (uint8_t i = 0; i < 32; ++i) {
         if ((pi & (1u << i)) == 0) continue;
-        volatile hba_port_t* p = &hba->ports[i];
-
-        ahci_port_ctx_t* ctx = &s_ports[i];
-        ctx->port = p; ctx->port_no = i; ctx->blk = NULL;
-        ctx->irq_events = 0;
-        if (!ahci_port_configure(ctx)) {
-            WARN("AHCI: Port %u configuration failed", i);
-            continue;
-        }
-        // Clear and enable all port interrupts
-        p->is = 0xFFFFFFFFu; p->ie = 0xFFFFFFFFu;
-
-        // Issue COMRESET and wait a bit for device detection
-        ahci_port_comreset(p);
-        for (volatile int dly = 0; dly < 100000; ++dly) asm volatile ("pause"); // small settle
+        ahci_port_probe_t* probe = &probes[i];
+        probe->ctx = &s_ports[i];
+        probe->ctx->port = &hba->ports[i];
+        probe->ctx->port_no = i;
+        work_init(&probe->ctx->finish_work, ahci_port_finish_work, probe->ctx, WORK_PRIO_HIGH);
+        if (!fiber_create("ahci-port", ahci_probe_port, probe))
+            ahci_probe_port(probe);
+    }
+    fiber_run_all();
 
-        uint32_t ssts = p->ssts;
-        uint8_t det = (uint8_t)(ssts & HBA_SSTS_DET_MASK);
-        uint8_t spd = HBA_SSTS_SPD(ssts);
-        uint8_t ipm = HBA_SSTS_IPM(ssts);
-        uint32_t sig = p->sig;
-        LOG("AHCI: Port %u SSTS=0x%08x DET=%u SPD=%u IPM=%u SIG=0x%08x (%s)", i, ssts, det, spd, ipm, sig, sig_to_str(sig));
-        if (det != HBA_DET_PRESENT) continue;
+    for (uint8_t i = 0; i < 32; ++i) {
+        ahci_port_probe_t* probe = &probes[i];
+        if (!probe->present) continue;
+        ahci_port_ctx_t* ctx = probe->ctx;
 
         // Register BlockDevice for ATA disks
-        if (sig == SATA_SIG_ATA) {
-            uint16_t id[256]; memset(id, 0, sizeof(id));
-            uint32_t bsz = 512; uint64_t total = 0;
-            if (ahci_identify_ata(ctx, id)) {
-                uint16_t w106 = id[106];
-                if (w106 & (1u << 12)) {
-                    uint32_t sz = ((uint32_t)id[118] << 16) | id[117];
-                    if (sz >= 512 && (sz % 512) == 0) bsz = sz;
-                }
-                uint32_t lba28 = ((uint32_t)id[61] << 16) | id[60];
-                bool lba48 = (id[83] & (1u << 10)) != 0;
-                uint64_t lba48_cnt = 0;
-                if (lba48) {
-                    lba48_cnt = ((uint64_t)id[103] << 48) | ((uint64_t)id[102] << 32) | ((uint64_t)id[101] << 16) | id[100];
-                }
-                total = lba48 ? lba48_cnt : lba28;
-                LOG("AHCI: IDENTIFY -> sector=%u total=%u (lba48=%d)", bsz, (unsigned)total, (int)lba48);
-            } else {
-                WARN("AHCI: IDENTIFY ATA failed; using defaults");
-            }
+        if (probe->sig == SATA_SIG_ATA) {
             BlockDevice_InitRegistry();
             char* nm = (char*)malloc(8);
             if (nm) { nm[0]='a'; nm[1]='h'; nm[2]='c'; nm[3]='i'; nm[4]='0'+(i%10); nm[5]='\0'; }
-            ctx->blk = BlockDevice_Register(nm ? nm : "ahci", BLKDEV_TYPE_DISK, bsz, total, &s_ahci_blk_ops, ctx);
-        } else if (sig == SATA_SIG_ATAPI) {
-            uint32_t last=0, blen=2048;
-            (void)ahci_atapi_read_capacity(ctx, &last, &blen);
+            ctx->blk = BlockDevice_Register(nm ? nm : "ahci", BLKDEV_TYPE_DISK, probe->block_size, probe->total, &s_ahci_blk_ops, ctx);
+            // Komut slotları kendi kilidiyle korunur; eşzamanlı çağıranlar kuyruğu doldurur.
+            // Blok kuyruğu da cihazın derinliği kadar birleştirilmiş komut uçurur.
+            if (ctx->blk) {
+                ctx->blk->flags |= BLKDEV_FLAG_QUEUED;
+                (void)BlockDevice_SetQueueDepth(ctx->blk, ctx->depth);
+            }
+        } else if (probe->sig == SATA_SIG_ATAPI) {
             BlockDevice_InitRegistry();
             char* nm = (char*)malloc(6);
             if (nm) { nm[0]='c'; nm[1]='d'; nm[2]='0'+(i%10); nm[3]='\0'; }
-            ctx->blk = BlockDevice_Register(nm ? nm : "cd", BLKDEV_TYPE_CDROM, blen ? blen : 2048, (uint64_t)last + 1u, &s_ahci_atapi_ops, ctx);
-            LOG("AHCI: Port %u ATAPI device registered as BlockDevice (block=%u total=%u)", i, blen, last+1u);
+            ctx->blk = BlockDevice_Register(nm ? nm : "cd", BLKDEV_TYPE_CDROM, probe->block_size, probe->total, &s_ahci_atapi_ops, ctx);
+            LOG("AHCI: Port %u ATAPI device registered as BlockDevice (block=%u total=%u)", i, probe->block_size, (unsigned)probe->total);
         }
     }
 
-    // (IRQ already registered earlier)
+    // IRQ hattı ahci_enable'a kadar kapalı kalır; o zamana dek tamamlanma yoklanır
 }
 
 bool ahci_init(void)
@@ -801,11 +1326,20 @@ bool ahci_init(void)
 
 void ahci_enable(void)
 {
+    // Açılış yoklamasından kesme kipine geç: bekleyen thread'ler uyur, ISR uyandırır
+    if (s_hba && s_ahci_irq_line != 0xFF && irq_controller) {
+        s_ahci_irq_missed = 0;
+        s_ahci_irq_mode = true;
+        irq_controller->enable(s_ahci_irq_line);
+        LOG("AHCI: IRQ%u enabled; completions are interrupt-driven", s_ahci_irq_line);
+    }
     ahci_driver.enabled = true;
 }
 
 void ahci_disable(void)
 {
+    s_ahci_irq_mode = false;
+    if (s_ahci_irq_line != 0xFF && irq_controller) irq_controller->disable(s_ahci_irq_line);
     ahci_driver.enabled = false;
 }
 
@@ -3,6 +3,7 @@ section .text
 global ahci_isr_stub
 
 extern ahci_irq_isr
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -23,7 +24,8 @@ ahci_isr_stub:
     push r14
     push r15
 
-    call ahci_irq_isr
+    mov rax, ahci_irq_isr
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -47,7 +49,8 @@ use32
 ahci_isr_stub:
     cli
     pushad
-    call ahci_irq_isr
+    mov eax, ahci_irq_isr
+    call irq_fpu_call
     popad
     sti
     iret
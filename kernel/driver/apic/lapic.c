@@ -3,6 +3,7 @@
 #include <debug/debug.h>
 #include <arch.h>
 #include <memory/mmio.h>
+#include <sleep.h>
 
 /* APIC log kategorileri */
 #ifdef APIC_DEBUG
@@ -17,6 +18,10 @@
 
 static volatile uint32_t* lapic_mmio = 0; // identity-mapped phys assumed
 static uintptr_t lapic_base_phys = 0;
+static uint32_t lapic_timer_hz = 0;       // bölücü 16 ile saniyedeki tick
+
+#define LAPIC_IPI_TIMEOUT_US     10000
+#define LAPIC_TIMER_CALIB_MS     10
 
 /* IA32_APIC_BASE MSR */
 #define IA32_APIC_BASE_MSR       0x1B
@@ -128,3 +133,76 @@ uint8_t lapic_get_id(void)
     uint32_t v = lapic_read(LAPIC_REG_ID);
     return (uint8_t)(v >> 24);
 }
+
+bool lapic_send_ipi(uint8_t apic_id, uint32_t icr_low)
+{
+    if (!lapic_mmio) return false;
+
+    size_t flags = arch_irq_save();
+    lapic_write(LAPIC_REG_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, icr_low); // Yazma gönderimi başlatır
+
+    WaitDeadline wait;
+    wait_deadline_start(&wait, LAPIC_IPI_TIMEOUT_US);
+    bool sent;
+    while (!(sent = (lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) == 0)) {
+        if (!wait_deadline_poll(&wait)) break;
+    }
+    arch_irq_restore(flags);
+
+    if (!sent) WARN("LAPIC: IPI 0x%x to APIC %u not delivered", icr_low, apic_id);
+    return sent;
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL | LAPIC_ICR_ASSERT);
+    // De-assert: eski (82489DX) LAPIC'ler için; modern işlemciler yok sayar
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+}
+
+void lapic_send_startup(uint8_t apic_id, uintptr_t entry_phys)
+{
+    // SIPI vektörü başlangıç sayfasının numarasıdır: CS:IP = (vektör << 8):0000
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | (uint32_t)((entry_phys >> 12) & 0xFFu));
+}
+
+uint32_t lapic_timer_calibrate(void)
+{
+    if (!lapic_mmio) return 0;
+    if (lapic_timer_hz) return lapic_timer_hz;
+
+    size_t flags = arch_irq_save();
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED); // tek seferlik, kesme yok
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFFu);
+
+    mdelay(LAPIC_TIMER_CALIB_MS);
+
+    uint32_t elapsed = 0xFFFFFFFFu - lapic_read(LAPIC_REG_TIMER_CURRENT);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+    arch_irq_restore(flags);
+
+    lapic_timer_hz = elapsed * (1000u / LAPIC_TIMER_CALIB_MS);
+    APIC_LOG_G("LAPIC: timer %u Hz (divide 16)", lapic_timer_hz);
+    return lapic_timer_hz;
+}
+
+void lapic_timer_start_periodic(uint8_t vector, uint32_t hz)
+{
+    if (!lapic_mmio || !lapic_timer_hz || hz == 0) return;
+
+    uint32_t count = lapic_timer_hz / hz;
+    if (count == 0) count = 1;
+
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, (uint32_t)vector | LAPIC_TIMER_PERIODIC);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, count);
+}
+
+void lapic_timer_stop(void)
+{
+    if (!lapic_mmio) return;
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
@@ -7,6 +7,18 @@
 #include <storage/BlockDevice.h>
 #include <pci/PCI.h>
 #include <irq/IRQ.h>
+#include <sleep.h>
+#include <spinlock.h>
+#include <task/Fiber.h>
+#include <task/WorkQueue.h>
+#include <time/clock.h>
+
+// Zaman aşımları (CPU hızından bağımsız)
+#define ATA_TIMEOUT_US       1000000  // BSY temizlenmesi / DRQ
+#define ATA_LONG_TIMEOUT_US  2000000  // ATAPI paketleri, FLUSH
+#define ATA_DMA_TIMEOUT_US   5000000  // Bus master DMA tamamlanması
+
+#define ATA_PRD_ENTRIES      32       // 64 KiB sınırında bölünen parçalar; tablo 256 bayt
 
 static ata_device_t s_ata_devs[4]; // primary: master/slave, secondary: master/slave
 static BlockDevice* s_ata_blkdevs[4];
@@ -19,11 +31,26 @@ typedef struct {
     uint8_t  irq_compat; // 14 or 15 in compatibility mode; 0xFF otherwise
     uint16_t bm_base;     // Bus Master IDE base for this channel (0 if unavailable)
     ata_prd_t* prdt;      // PRD table (virt == phys under identity mapping)
+    Spinlock lock;        // master/slave share the taskfile; one command per channel
+
+    // Asenkron DMA istekleri (BlockDevice submit). qlock ISR ile paylaşılır;
+    // lock bir isteğin tüm parçaları boyunca tutulur, son parçada bırakılır.
+    Spinlock qlock;
+    BlockRequest* q_head;
+    BlockRequest* q_tail;
+    BlockRequest* active;
+    ata_device_t* active_dev;
+    uint64_t lba;         // Aktif isteğin sıradaki LBA'sı
+    uint32_t left;        // Aktif istekte kalan sektör
+    uint32_t part;        // Uçuştaki DMA komutunun sektör sayısı
+    BlockSegIter it;
+    uint64_t started_ns;
+    WorkItem pump_work;   // IRQ14/15 tamamlanmayı ve sıradaki DMA'yı softirq thread'inde yapar
 } ata_channel_t;
 
 static ata_channel_t s_channels[2] = {
-    { ATA_PRIM_IO, ATA_PRIM_CTRL, 14, 0, NULL },
-    { ATA_SEC_IO,  ATA_SEC_CTRL,  15, 0, NULL }
+    { ATA_PRIM_IO, ATA_PRIM_CTRL, 14, 0, NULL, SPINLOCK_INIT, .qlock = SPINLOCK_INIT },
+    { ATA_SEC_IO,  ATA_SEC_CTRL,  15, 0, NULL, SPINLOCK_INIT, .qlock = SPINLOCK_INIT }
 };
 
 static uint16_t s_bmide_base = 0; // BAR4 (I/O)
@@ -54,10 +81,10 @@ static void ata_channel_soft_reset(uint16_t ctrl_base)
     // Assert SRST (bit2) then deassert, with required delays
     outb((uint16_t)(ctrl_base + ATA_REG_DEVCTRL), ATA_DEVCTRL_SRST | ATA_DEVCTRL_NIEN);
     ata_delay_400ns(ctrl_base);
-    for (volatile int i = 0; i < 100000; ++i) (void)inb((uint16_t)(ctrl_base + ATA_REG_ALTSTATUS));
+    udelay(5); // SRST en az 5 us
     outb((uint16_t)(ctrl_base + ATA_REG_DEVCTRL), 0x00);
-    // Allow device to settle
-    for (volatile int i = 0; i < 100000; ++i) (void)inb((uint16_t)(ctrl_base + ATA_REG_ALTSTATUS));
+    // Allow device to settle (BSY'ye bakmadan önce en az 2 ms)
+    mdelay(2);
 }
 
 // --- PCI discovery for legacy IDE controllers (PIIX3/PIIX4 and others) ---
@@ -98,9 +125,9 @@ static void ata_setup_channels_from_pci(void)
         s_bmide_base = (uint16_t)ide->bars[4].address;
         s_channels[0].bm_base = s_bmide_base + 0x00;
         s_channels[1].bm_base = s_bmide_base + ATA_BM_CH_SECONDARY;
-        // Allocate small PRDT for each channel (up to 4 entries suffices for <= 256 KiB, 64KiB boundary aware)
-        s_channels[0].prdt = (ata_prd_t*)malloc_aligned(16, sizeof(ata_prd_t) * 4);
-        s_channels[1].prdt = (ata_prd_t*)malloc_aligned(16, sizeof(ata_prd_t) * 4);
+        // PRDT per channel; aligned to its size so it never crosses a 64 KiB boundary
+        s_channels[0].prdt = (ata_prd_t*)malloc_aligned(sizeof(ata_prd_t) * ATA_PRD_ENTRIES, sizeof(ata_prd_t) * ATA_PRD_ENTRIES);
+        s_channels[1].prdt = (ata_prd_t*)malloc_aligned(sizeof(ata_prd_t) * ATA_PRD_ENTRIES, sizeof(ata_prd_t) * ATA_PRD_ENTRIES);
         LOG("ATA: BMIDE present at %x (PRDT allocated)", s_bmide_base);
     } else {
         LOG("ATA: BMIDE (BAR4) not present; using PIO only");
@@ -111,52 +138,65 @@ static inline uint16_t ata_bm_reg_cmd(uint8_t ch)    { return (uint16_t)(s_chann
 static inline uint16_t ata_bm_reg_stat(uint8_t ch)   { return (uint16_t)(s_channels[ch].bm_base + ATA_BM_REG_STATUS); }
 static inline uint16_t ata_bm_reg_prdt(uint8_t ch)   { return (uint16_t)(s_channels[ch].bm_base + ATA_BM_REG_PRDT); }
 
-static uint32_t ata_build_prdt(uint8_t ch, void* buf, uint32_t bytes)
+// it'ten başlayan en fazla bytes baytı PRDT'ye yaz. Girdiler 64 KiB sınırında
+// bölünür ve 4 GiB'ın altında olmalı; tablo dolarsa kısa kalır. Eşlenen
+// bayt sayısı sektörün katına kırpılır ve it o kadar ilerler.
+static uint32_t ata_build_prdt(uint8_t ch, BlockSegIter* it, uint32_t bytes)
 {
     ata_prd_t* prdt = s_channels[ch].prdt;
     if (!prdt) return 0;
+
+    BlockSegIter pos = *it;
     uint32_t built = 0;
-    uint32_t remaining = bytes;
-    uintptr_t p = (uintptr_t)buf; // phys==virt
-    int idx = 0;
-    while (remaining && idx < 4) {
+    uint32_t idx = 0;
+    while (built < bytes && idx < ATA_PRD_ENTRIES) {
+        uintptr_t p = 0;
+        uint32_t run = BlockSegIter_Extent(&pos, bytes - built, &p);
+        if (run == 0 || (uint64_t)p + run > 0x100000000ull) break;
+
         // Do not cross 64 KiB boundary per PRD entry
-        uint32_t offset_in_64k = (uint32_t)(p & 0xFFFFu);
-        uint32_t space = 0x10000u - offset_in_64k;
-        uint32_t chunk = (remaining < space) ? remaining : space;
+        uint32_t space = 0x10000u - (uint32_t)(p & 0xFFFFu);
+        uint32_t chunk = (run < space) ? run : space;
         // PRD count: 0 means 64KiB
         prdt[idx].base = (uint32_t)p;
-        prdt[idx].byte_count = (uint16_t)((chunk & 0xFFFFu) ? (chunk & 0xFFFFu) : 0);
+        prdt[idx].byte_count = (uint16_t)(chunk & 0xFFFFu);
         prdt[idx].flags = 0x0000;
         built += chunk;
-        remaining -= chunk;
-        p += chunk;
         idx++;
+        BlockSegIter_Advance(&pos, chunk);
+    }
+
+    // Sektörün ortasında kaldıysak sondaki girdileri kırp
+    uint32_t keep = built - built % 512u;
+    while (idx && built > keep) {
+        uint32_t len = prdt[idx - 1].byte_count ? prdt[idx - 1].byte_count : 0x10000u;
+        uint32_t cut = built - keep;
+        if (cut >= len) {
+            idx--;
+            built -= len;
+        } else {
+            prdt[idx - 1].byte_count = (uint16_t)((len - cut) & 0xFFFFu);
+            built -= cut;
+        }
     }
     if (idx == 0) return 0;
     prdt[idx - 1].flags |= 0x8000; // EOT
+    BlockSegIter_Advance(it, built);
     return built;
 }
 
-static bool ata_dma_rw(ata_device_t* dev, uint64_t lba, uint16_t sects, void* buffer, bool is_write)
+// Taskfile'ı yazar, BM motorunu başlatır ve komutu verir; PRDT hazır olmalı
+static void ata_dma_start(ata_device_t* dev, uint8_t ch, uint64_t lba, uint16_t sects, bool is_write)
 {
-    int ch = ata_channel_from_io(dev->io_base);
-    if (ch < 0) return false;
-    if (s_channels[ch].bm_base == 0 || s_channels[ch].prdt == NULL) return false;
-
-    uint32_t bytes = (uint32_t)sects * 512u;
-    uint32_t prepared = ata_build_prdt((uint8_t)ch, buffer, bytes);
-    if (prepared != bytes) return false;
-
     uint16_t io = dev->io_base;
     uint16_t ctl = dev->ctrl_base;
 
     // Program PRDT base
-    outl(ata_bm_reg_prdt((uint8_t)ch), (uint32_t)(uintptr_t)s_channels[ch].prdt);
+    outl(ata_bm_reg_prdt(ch), (uint32_t)(uintptr_t)s_channels[ch].prdt);
 
     // Clear BM status (write 1 to clear IRQ and ERR)
-    uint8_t st = inb(ata_bm_reg_stat((uint8_t)ch));
-    outb(ata_bm_reg_stat((uint8_t)ch), (uint8_t)(st | ATA_BM_ST_IRQ | ATA_BM_ST_ERR));
+    uint8_t st = inb(ata_bm_reg_stat(ch));
+    outb(ata_bm_reg_stat(ch), (uint8_t)(st | ATA_BM_ST_IRQ | ATA_BM_ST_ERR));
 
     // Prepare drive registers
     if (dev->lba48_supported) {
@@ -184,13 +224,13 @@ static bool ata_dma_rw(ata_device_t* dev, uint64_t lba, uint16_t sects, void* bu
     }
 
     // Set BM command (direction + start)
-    uint8_t cmd = inb(ata_bm_reg_cmd((uint8_t)ch));
+    uint8_t cmd = inb(ata_bm_reg_cmd(ch));
     cmd &= ~ATA_BM_CMD_WRITE;
     if (is_write) cmd |= ATA_BM_CMD_WRITE; // direction
-    outb(ata_bm_reg_cmd((uint8_t)ch), cmd);
+    outb(ata_bm_reg_cmd(ch), cmd);
 
     // Start BM DMA engine
-    outb(ata_bm_reg_cmd((uint8_t)ch), (uint8_t)(cmd | ATA_BM_CMD_START));
+    outb(ata_bm_reg_cmd(ch), (uint8_t)(cmd | ATA_BM_CMD_START));
 
     // Issue ATA command
     if (dev->lba48_supported) {
@@ -198,27 +238,134 @@ static bool ata_dma_rw(ata_device_t* dev, uint64_t lba, uint16_t sects, void* bu
     } else {
         outb((uint16_t)(io + ATA_REG_COMMAND), is_write ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA);
     }
+}
+
+// BM motorunu durdurur, IRQ/ERR'yi temizler ve cihaz durumuna bakar
+static bool ata_dma_stop(ata_device_t* dev, uint8_t ch)
+{
+    // Stop BM DMA engine
+    uint8_t cmd = inb(ata_bm_reg_cmd(ch));
+    outb(ata_bm_reg_cmd(ch), (uint8_t)(cmd & ~ATA_BM_CMD_START));
+
+    // Clear IRQ and check device status
+    uint8_t bst = inb(ata_bm_reg_stat(ch));
+    outb(ata_bm_reg_stat(ch), (uint8_t)(bst | ATA_BM_ST_IRQ | ATA_BM_ST_ERR));
+
+    uint8_t st2 = inb((uint16_t)(dev->io_base + ATA_REG_STATUS));
+    return (st2 & (ATA_SR_ERR | ATA_SR_DF)) == 0 && (bst & ATA_BM_ST_ERR) == 0;
+}
+
+static bool ata_dma_rw(ata_device_t* dev, uint64_t lba, uint16_t sects, void* buffer, bool is_write)
+{
+    int ch = ata_channel_from_io(dev->io_base);
+    if (ch < 0) return false;
+    if (s_channels[ch].bm_base == 0 || s_channels[ch].prdt == NULL) return false;
+
+    uint32_t bytes = (uint32_t)sects * 512u;
+    BlockSegment seg = { buffer, bytes };
+    BlockSegIter it;
+    BlockSegIter_Init(&it, &seg, 1);
+    uint32_t prepared = ata_build_prdt((uint8_t)ch, &it, bytes);
+    if (prepared != bytes) return false;
+
+    ata_dma_start(dev, (uint8_t)ch, lba, sects, is_write);
 
     // Wait for completion by polling BM status IRQ or ATA status
-    uint32_t spin = 5000000;
+    WaitDeadline wait;
+    wait_deadline_start(&wait, ATA_DMA_TIMEOUT_US);
     bool ok = false;
-    while (spin--) {
+    do {
         uint8_t bst = inb(ata_bm_reg_stat((uint8_t)ch));
         if (bst & ATA_BM_ST_ERR) { ok = false; break; }
         if (bst & ATA_BM_ST_IRQ) { ok = true; break; }
-    }
+    } while (wait_deadline_poll(&wait));
 
-    // Stop BM DMA engine
-    cmd = inb(ata_bm_reg_cmd((uint8_t)ch));
-    outb(ata_bm_reg_cmd((uint8_t)ch), (uint8_t)(cmd & ~ATA_BM_CMD_START));
+    if (!ata_dma_stop(dev, (uint8_t)ch)) ok = false;
+    return ok;
+}
 
-    // Clear IRQ and check device status
-    uint8_t bst = inb(ata_bm_reg_stat((uint8_t)ch));
-    outb(ata_bm_reg_stat((uint8_t)ch), (uint8_t)(bst | ATA_BM_ST_IRQ | ATA_BM_ST_ERR));
+// Aktif isteğin sıradaki parçasını (PRDT'nin aldığı kadar) başlat
+static bool ata_async_start_part(uint8_t ch)
+{
+    ata_channel_t* c = &s_channels[ch];
+    ata_device_t* dev = c->active_dev;
+    uint32_t nmax = dev->lba48_supported ? 65535u : 255u;
+    uint32_t n = (c->left > nmax) ? nmax : c->left;
+
+    n = ata_build_prdt(ch, &c->it, n * 512u) / 512u;
+    if (n == 0) return false;
+    c->part = n;
+    c->started_ns = time_now_ns();
+    ata_dma_start(dev, ch, c->lba, (uint16_t)n, c->active->op == BLKREQ_WRITE);
+    return true;
+}
 
-    uint8_t st2 = inb((uint16_t)(io + ATA_REG_STATUS));
-    if (st2 & (ATA_SR_ERR | ATA_SR_DF)) ok = false;
-    return ok;
+// Kanalın asenkron kuyruğunu ilerlet: biten DMA parçasını kapatıp sıradakini
+// ya da sıradaki isteği başlatır. IRQ14/15'in softirq işinden, poll'dan,
+// submit'ten ve senkron kullanıcı kanalı bırakırken çağrılır; tamamlananlar
+// kilit dışında bildirilir.
+static void ata_channel_pump(uint8_t ch)
+{
+    ata_channel_t* c = &s_channels[ch];
+    BlockRequest* finished = NULL;
+
+    size_t flags = spin_lock_irqsave(&c->qlock);
+    for (;;) {
+        if (c->active) {
+            uint8_t bst = inb(ata_bm_reg_stat(ch));
+            bool timeout = time_now_ns() - c->started_ns > (uint64_t)ATA_DMA_TIMEOUT_US * 1000ull;
+            if (!(bst & (ATA_BM_ST_IRQ | ATA_BM_ST_ERR)) && !timeout) break; // hâlâ aktarıyor
+
+            BlockRequest* req = c->active;
+            bool ok = ata_dma_stop(c->active_dev, ch) && !timeout;
+            if (timeout) WARN("ATA: async DMA timeout on channel %u (LBA=%llu)", ch, (unsigned long long)c->lba);
+            if (ok) {
+                c->lba += c->part;
+                c->left -= c->part;
+                if (c->left && ata_async_start_part(ch)) break;
+            }
+            if (!ok || c->left) req->failed = true;
+            req->next = finished;
+            finished = req;
+            c->active = NULL;
+            spin_unlock(&c->lock);
+            continue;
+        }
+
+        // Senkron bir komut kanalı tutuyorsa bırakırken tekrar çağırır
+        if (!c->q_head || !spin_trylock(&c->lock)) break;
+        BlockRequest* req = c->q_head;
+        c->q_head = req->next;
+        if (!c->q_head) c->q_tail = NULL;
+        req->next = NULL;
+
+        c->active = req;
+        c->active_dev = (ata_device_t*)req->dev->driver_ctx;
+        c->lba = req->lba;
+        c->left = req->count;
+        BlockSegIter_Init(&c->it, req->sg, req->sg_count);
+        if (!ata_async_start_part(ch)) {
+            WARN("ATA: async request buffer not DMA-mappable on channel %u", ch);
+            req->failed = true;
+            req->next = finished;
+            finished = req;
+            c->active = NULL;
+            spin_unlock(&c->lock);
+        }
+    }
+    spin_unlock_irqrestore(&c->qlock, flags);
+
+    while (finished) {
+        BlockRequest* req = finished;
+        finished = req->next;
+        req->next = NULL;
+        BlockRequest_Complete(req, !req->failed);
+    }
+}
+
+static void ata_channel_pump_work(void* arg)
+{
+    ata_channel_pump((uint8_t)(uintptr_t)arg);
 }
 
 // --- Identify device (ATA or ATAPI) ---
@@ -237,8 +384,10 @@ static bool ata_identify(ata_device_t* dev)
     if (st == 0xFF) { LOG("ATA: floating bus (no device)"); return false; }
 
     // Poll for BSY clear
-    uint32_t spin = 1000000;
-    while ((st & ATA_SR_BSY) && spin--) st = ata_status(io);
+    WaitDeadline wait;
+    wait_deadline_start(&wait, ATA_TIMEOUT_US);
+    while ((st & ATA_SR_BSY) && wait_deadline_poll(&wait)) st = ata_status(io);
+    st = ata_status(io);
     if (st & ATA_SR_BSY) { LOG("ATA: timeout waiting BSY clear (st=0x%02x)", st); return false; }
 
     // Detect device type via LBA1/LBA2 signature (after BSY clear)
@@ -253,9 +402,10 @@ static bool ata_identify(ata_device_t* dev)
     }
 
     // Wait for DRQ
-    spin = 1000000;
-    while (((st = ata_status(io)) & (ATA_SR_BSY | ATA_SR_DRQ)) != ATA_SR_DRQ && spin--) {
+    wait_deadline_start(&wait, ATA_TIMEOUT_US);
+    while (((st = ata_status(io)) & (ATA_SR_BSY | ATA_SR_DRQ)) != ATA_SR_DRQ) {
         if (st & (ATA_SR_ERR | ATA_SR_DF)) return false;
+        if (!wait_deadline_poll(&wait)) break;
     }
     if ((st & ATA_SR_DRQ) == 0) { LOG("ATA: DRQ not set (st=0x%02x)", st); return false; }
 
@@ -311,16 +461,29 @@ static void ata_probe_channel(uint16_t io_base, uint16_t ctrl_base, uint8_t ch)
     }
 }
 
+// Kanallar ayrı taskfile'lardır; reset ve IDENTIFY beklemeleri fiber'larda üst üste biner
+static void ata_probe_channel_fiber(void* arg)
+{
+    uint8_t ch = (uint8_t)(uintptr_t)arg;
+    ata_probe_channel(s_channels[ch].io_base, s_channels[ch].ctrl_base, ch);
+}
+
 // --- PIO helpers (28-bit only for now) ---
-static bool ata_wait_not_busy(uint16_t io, uint32_t spin)
+static bool ata_wait_not_busy(uint16_t io, uint32_t timeout_us)
 {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
     uint8_t st;
-    do { st = inb((uint16_t)(io + ATA_REG_STATUS)); } while ((st & ATA_SR_BSY) && spin--);
-    return (st & ATA_SR_BSY) == 0;
+    while ((st = inb((uint16_t)(io + ATA_REG_STATUS))) & ATA_SR_BSY) {
+        if (!wait_deadline_poll(&wait)) return (inb((uint16_t)(io + ATA_REG_STATUS)) & ATA_SR_BSY) == 0;
+    }
+    return true;
 }
 
-static bool ata_wait_drq_set(uint16_t io, uint32_t spin)
+static bool ata_wait_drq_set(uint16_t io, uint32_t timeout_us)
 {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
     uint8_t st;
     int ch = ata_channel_from_io(io);
     do {
@@ -333,7 +496,7 @@ static bool ata_wait_drq_set(uint16_t io, uint32_t spin)
             st = inb((uint16_t)(io + ATA_REG_STATUS));
             if (st & ATA_SR_DRQ) return true;
         }
-    } while (spin--);
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
@@ -355,8 +518,8 @@ static bool ata_pio_read28(ata_device_t* dev, uint32_t lba, uint8_t count, void*
 
     uint16_t* out = (uint16_t*)buffer;
     for (uint8_t s = 0; s < count; ++s) {
-        if (!ata_wait_not_busy(io, 1000000)) return false;
-        if (!ata_wait_drq_set(io, 1000000)) return false;
+        if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
+        if (!ata_wait_drq_set(io, ATA_TIMEOUT_US)) return false;
         for (int i = 0; i < 256; ++i) {
             out[i] = inw((uint16_t)(io + ATA_REG_DATA));
         }
@@ -392,8 +555,8 @@ static bool ata_pio_read48(ata_device_t* dev, uint64_t lba, uint16_t count, void
 
     uint16_t* out = (uint16_t*)buffer;
     for (uint16_t s = 0; s < count; ++s) {
-        if (!ata_wait_not_busy(io, 1000000)) return false;
-        if (!ata_wait_drq_set(io, 1000000)) return false;
+        if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
+        if (!ata_wait_drq_set(io, ATA_TIMEOUT_US)) return false;
         for (int i = 0; i < 256; ++i) {
             out[i] = inw((uint16_t)(io + ATA_REG_DATA));
         }
@@ -419,8 +582,8 @@ static bool ata_pio_write28(ata_device_t* dev, uint32_t lba, uint8_t count, cons
 
     const uint16_t* in = (const uint16_t*)buffer;
     for (uint8_t s = 0; s < count; ++s) {
-        if (!ata_wait_not_busy(io, 1000000)) return false;
-        if (!ata_wait_drq_set(io, 1000000)) return false;
+        if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
+        if (!ata_wait_drq_set(io, ATA_TIMEOUT_US)) return false;
         for (int i = 0; i < 256; ++i) {
             outw((uint16_t)(io + ATA_REG_DATA), in[i]);
         }
@@ -456,8 +619,8 @@ static bool ata_pio_write48(ata_device_t* dev, uint64_t lba, uint16_t count, con
 
     const uint16_t* in = (const uint16_t*)buffer;
     for (uint16_t s = 0; s < count; ++s) {
-        if (!ata_wait_not_busy(io, 1000000)) return false;
-        if (!ata_wait_drq_set(io, 1000000)) return false;
+        if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
+        if (!ata_wait_drq_set(io, ATA_TIMEOUT_US)) return false;
         for (int i = 0; i < 256; ++i) {
             outw((uint16_t)(io + ATA_REG_DATA), in[i]);
         }
@@ -466,20 +629,26 @@ static bool ata_pio_write48(ata_device_t* dev, uint64_t lba, uint16_t count, con
     return true;
 }
 
-// IRQ handlers for primary (IRQ14) and secondary (IRQ15) channels
+// IRQ handlers for primary (IRQ14) and secondary (IRQ15) channels. Only the
+// device is acknowledged here; DMA completion, the done callbacks and the next
+// dispatch run from the channel's WorkItem in the softirq thread.
 void ata_irq14(void)
 {
     // Read status to acknowledge device interrupt, then flag event
     (void)inb((uint16_t)(ATA_PRIM_IO + ATA_REG_STATUS));
     s_ata_irq_event[0] = 1;
+    if (s_channels[0].active) work_queue_post(&s_channels[0].pump_work);
     if (irq_controller && irq_controller->acknowledge) irq_controller->acknowledge(14);
+    work_queue_irq_exit();
 }
 
 void ata_irq15(void)
 {
     (void)inb((uint16_t)(ATA_SEC_IO + ATA_REG_STATUS));
     s_ata_irq_event[1] = 1;
+    if (s_channels[1].active) work_queue_post(&s_channels[1].pump_work);
     if (irq_controller && irq_controller->acknowledge) irq_controller->acknowledge(15);
+    work_queue_irq_exit();
 }
 
 // ---- ATAPI support (PIO) ----
@@ -506,8 +675,8 @@ static bool ata_atapi_packet_cmd(ata_device_t* dev, const uint8_t* cdb, uint32_t
     outb((uint16_t)(io + ATA_REG_COMMAND), ATA_CMD_PACKET);
 
     // Wait for DRQ
-    if (!ata_wait_not_busy(io, 1000000)) return false;
-    if (!ata_wait_drq_set(io, 2000000)) return false;
+    if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
+    if (!ata_wait_drq_set(io, ATA_LONG_TIMEOUT_US)) return false;
 
     // Write CDB (12 or 16 bytes) to data port as words
     uint16_t cdb_words = (uint16_t)((cdb_len + 1) / 2);
@@ -522,7 +691,7 @@ static bool ata_atapi_packet_cmd(ata_device_t* dev, const uint8_t* cdb, uint32_t
     uint32_t remaining = byte_count;
     while (remaining) {
         // Wait for DRQ or completion
-        if (!ata_wait_not_busy(io, 1000000)) return false;
+        if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
         uint8_t st = inb((uint16_t)(io + ATA_REG_STATUS));
         if (st & (ATA_SR_ERR | ATA_SR_DF)) return false;
         if ((st & ATA_SR_DRQ) == 0) break; // device may finish with smaller xfer
@@ -548,7 +717,7 @@ static bool ata_atapi_packet_cmd(ata_device_t* dev, const uint8_t* cdb, uint32_t
     }
 
     // Final status check
-    if (!ata_wait_not_busy(io, 1000000)) return false;
+    if (!ata_wait_not_busy(io, ATA_TIMEOUT_US)) return false;
     {
         uint8_t st = inb((uint16_t)(io + ATA_REG_STATUS));
         if (st & (ATA_SR_ERR | ATA_SR_DF)) return false;
@@ -614,7 +783,7 @@ static bool ata_atapi_read_blocks(ata_device_t* dev, uint32_t lba, uint32_t bloc
 }
 
 // BlockDevice ops wrappers
-static bool ata_blk_read(struct BlockDevice* bdev, uint64_t lba, uint32_t count, void* buf)
+static bool ata_blk_read_locked(struct BlockDevice* bdev, uint64_t lba, uint32_t count, void* buf)
 {
     ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
     if (!dev) return false;
@@ -655,7 +824,7 @@ static bool ata_blk_read(struct BlockDevice* bdev, uint64_t lba, uint32_t count,
     return false;
 }
 
-static bool ata_blk_write(struct BlockDevice* bdev, uint64_t lba, uint32_t count, const void* buf)
+static bool ata_blk_write_locked(struct BlockDevice* bdev, uint64_t lba, uint32_t count, const void* buf)
 {
     ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
     if (!dev) return false;
@@ -684,7 +853,7 @@ static bool ata_blk_write(struct BlockDevice* bdev, uint64_t lba, uint32_t count
     return true;
 }
 
-static bool ata_blk_flush(struct BlockDevice* bdev)
+static bool ata_blk_flush_locked(struct BlockDevice* bdev)
 {
     ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
     if (!dev) return false;
@@ -700,15 +869,106 @@ static bool ata_blk_flush(struct BlockDevice* bdev)
     outb((uint16_t)(io + ATA_REG_COMMAND), dev->lba48_supported ? ATA_CMD_FLUSH_CACHE_EXT : ATA_CMD_FLUSH_CACHE);
 
     // Poll until not busy and check errors
-    if (!ata_wait_not_busy(io, 2000000)) return false;
+    if (!ata_wait_not_busy(io, ATA_LONG_TIMEOUT_US)) return false;
     uint8_t st = inb((uint16_t)(io + ATA_REG_STATUS));
     return (st & (ATA_SR_ERR | ATA_SR_DF)) == 0;
 }
 
+static uint8_t ata_channel_index(const ata_device_t* dev)
+{
+    // Native PCI modunda io_base BAR'dan gelir; ATA_PRIM_IO ile karşılaştırılamaz
+    return dev->io_base == s_channels[1].io_base ? 1 : 0;
+}
+
+// Senkron komutlar kanalı, varsa aktif asenkron istek bitene kadar bekleyerek
+// alır; kesme gelmiyor olabileceğinden beklerken tamamlanmayı kendisi ilerletir
+static void ata_channel_acquire(uint8_t ch)
+{
+    while (!spin_trylock(&s_channels[ch].lock)) {
+        ata_channel_pump(ch);
+        cpu_relax();
+    }
+}
+
+static void ata_channel_release(uint8_t ch)
+{
+    spin_unlock(&s_channels[ch].lock);
+    ata_channel_pump(ch); // bekleyen asenkron istekleri başlat
+}
+
+static bool ata_blk_read(struct BlockDevice* bdev, uint64_t lba, uint32_t count, void* buf)
+{
+    ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
+    if (!dev) return false;
+    uint8_t ch = ata_channel_index(dev);
+    ata_channel_acquire(ch);
+    bool ok = ata_blk_read_locked(bdev, lba, count, buf);
+    ata_channel_release(ch);
+    return ok;
+}
+
+static bool ata_blk_write(struct BlockDevice* bdev, uint64_t lba, uint32_t count, const void* buf)
+{
+    ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
+    if (!dev) return false;
+    uint8_t ch = ata_channel_index(dev);
+    ata_channel_acquire(ch);
+    bool ok = ata_blk_write_locked(bdev, lba, count, buf);
+    ata_channel_release(ch);
+    return ok;
+}
+
+static bool ata_blk_flush(struct BlockDevice* bdev)
+{
+    ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
+    if (!dev) return false;
+    uint8_t ch = ata_channel_index(dev);
+    ata_channel_acquire(ch);
+    bool ok = ata_blk_flush_locked(bdev);
+    ata_channel_release(ch);
+    return ok;
+}
+
+// Bus master DMA ile yapılabilen okuma/yazmaları kanal kuyruğuna ekler ve
+// döner; tamamlanma IRQ14/15'in softirq işinden ya da poll'dan gelir. PIO'ya düşmesi
+// gerekenler (BMIDE yok, ATAPI, hizasız tampon) senkron yoldan gider.
+static bool ata_blk_submit(struct BlockDevice* bdev, BlockRequest* req)
+{
+    ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
+    if (!dev || dev->type != ATA_TYPE_ATA || req->op == BLKREQ_FLUSH) return false;
+    if (bdev->logical_block_size != 512) return false;
+    if (!dev->lba48_supported && ((req->lba + req->count) >> 28) != 0) return false;
+
+    uint8_t ch = ata_channel_index(dev);
+    ata_channel_t* c = &s_channels[ch];
+    if (c->bm_base == 0 || c->prdt == NULL) return false;
+    for (uint32_t i = 0; i < req->sg_count; ++i) {
+        if (((uintptr_t)req->sg[i].buffer & 1u) != 0) return false;
+    }
+
+    size_t flags = spin_lock_irqsave(&c->qlock);
+    req->next = NULL;
+    if (c->q_tail) c->q_tail->next = req;
+    else c->q_head = req;
+    c->q_tail = req;
+    spin_unlock_irqrestore(&c->qlock, flags);
+
+    ata_channel_pump(ch);
+    return true;
+}
+
+static void ata_blk_poll(struct BlockDevice* bdev)
+{
+    ata_device_t* dev = (ata_device_t*)bdev->driver_ctx;
+    if (dev) ata_channel_pump(ata_channel_index(dev));
+}
+
 static const BlockDeviceOps s_ata_blk_ops = {
     .read = ata_blk_read,
     .write = ata_blk_write,
     .flush = ata_blk_flush,
+    .submit = ata_blk_submit,
+    .poll = ata_blk_poll,
 };
 
 bool ata_init(void)
@@ -728,6 +988,8 @@ bool ata_init(void)
     ata_setup_channels_from_pci();
 
     LOG("ATA: Probing ATA/ATAPI devices");
+    for (uint8_t ch = 0; ch < 2; ++ch)
+        work_init(&s_channels[ch].pump_work, ata_channel_pump_work, (void*)(uintptr_t)ch, WORK_PRIO_HIGH);
     // Register legacy IRQ handlers only when in compatibility mode
     if (irq_controller && irq_controller->register_handler && irq_controller->enable) {
         extern void ata_irq14_stub(void);
@@ -744,8 +1006,11 @@ bool ata_init(void)
     } else {
         WARN("ATA: IRQ controller not ready; using polling only");
     }
-    ata_probe_channel(s_channels[0].io_base, s_channels[0].ctrl_base, 0);
-    ata_probe_channel(s_channels[1].io_base, s_channels[1].ctrl_base, 1);
+    for (uint8_t ch = 0; ch < 2; ++ch) {
+        if (!fiber_create(ch == 0 ? "ata-primary" : "ata-secondary", ata_probe_channel_fiber, (void*)(uintptr_t)ch))
+            ata_probe_channel_fiber((void*)(uintptr_t)ch);
+    }
+    fiber_run_all();
 
     // Register found devices as block devices (ATA disks + ATAPI CD/DVD)
     BlockDevice_InitRegistry();
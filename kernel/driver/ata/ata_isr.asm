@@ -5,6 +5,7 @@ global ata_irq15_stub
 
 extern ata_irq14
 extern ata_irq15
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -24,7 +25,8 @@ ata_irq14_stub:
     push r13
     push r14
     push r15
-    call ata_irq14
+    mov rax, ata_irq14
+    call irq_fpu_call
     pop r15
     pop r14
     pop r13
@@ -58,7 +60,8 @@ ata_irq15_stub:
     push r13
     push r14
     push r15
-    call ata_irq15
+    mov rax, ata_irq15
+    call irq_fpu_call
     pop r15
     pop r14
     pop r13
@@ -81,7 +84,8 @@ use32
 ata_irq14_stub:
     cli
     pushad
-    call ata_irq14
+    mov eax, ata_irq14
+    call irq_fpu_call
     popad
     sti
     iret
@@ -89,7 +93,8 @@ ata_irq14_stub:
 ata_irq15_stub:
     cli
     pushad
-    call ata_irq15
+    mov eax, ata_irq15
+    call irq_fpu_call
     popad
     sti
     iret
@@ -2,6 +2,7 @@ section .text
 
 global hpet_timer_isr
 extern hpet_timer_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -24,7 +25,8 @@ hpet_timer_isr:
     push r14
     push r15
 
-    call hpet_timer_handler
+    mov rax, hpet_timer_handler
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -50,7 +52,8 @@ use32
 hpet_timer_isr:
     cli
     pushad
-    call hpet_timer_handler
+    mov eax, hpet_timer_handler
+    call irq_fpu_call
     popad
     sti
     iret
@@ -8,7 +8,10 @@
 #include <irq/IRQ.h>
 #include <debug/debug.h>
 #include <memory/mmio.h>
+#include <spinlock.h>
 #include <list.h>
+#include <task/Thread.h>
+#include <task/WorkQueue.h>
 
 // ---- HPET registers & helpers ----
 #define HPET_REG_CAP_ID      0x000ull // General Capabilities and ID (RO)
@@ -48,6 +51,16 @@ static volatile uint64_t* s_hpet_mmio = NULL; // identity-mapped
 static uint32_t s_hpet_period_fs = 0;         // femtoseconds per tick
 static uint64_t s_hpet_counter_hz = 0;        // derived: Hz
 static bool     s_hpet_running = false;
+static bool     s_hpet_counter64 = false;     // CAP.COUNT_SIZE_CAP
+static bool     s_hpet_oneshot = false;       // comparator 0 tek seferlik modda
+
+// 32-bit sayaç genişletme (tick en fazla TICK_NOHZ_MAX_SLEEP_MS'de bir okur)
+static uint32_t s_hpet_last_lo = 0;
+static uint64_t s_hpet_wraps = 0;
+// 32 bit sayacın taşma takibi; AP'ler de okuduğundan kesme kapatmak yetmez
+static Spinlock s_hpet_wrap_lock = SPINLOCK_INIT;
+
+#define HPET_MIN_DELTA_NS 10000ull            // Daha yakın vadeler en az bu kadar ileri atılır
 
 // Callback list for tick
 static List* s_hpet_callbacks = NULL;
@@ -72,6 +85,87 @@ static inline uint64_t hpet_now_ticks(void)
     return hpet_read64(HPET_REG_MAIN_CNT);
 }
 
+// Free-running main counter; 64-bit reads are split (hi/lo/hi) so they are
+// tear-free on i386 too. 32-bit counters are extended in software.
+static uint64_t hpet_read_counter(void)
+{
+    volatile uint32_t* cnt = (volatile uint32_t*)((volatile uint8_t*)s_hpet_mmio + HPET_REG_MAIN_CNT);
+
+    if (s_hpet_counter64)
+    {
+        uint32_t hi, lo, hi2;
+        do {
+            hi = cnt[1];
+            lo = cnt[0];
+            hi2 = cnt[1];
+        } while (hi != hi2);
+        return ((uint64_t)hi << 32) | lo;
+    }
+
+    // Okuma kilidin içinde: iki CPU aynı taşmayı iki kez sayamaz
+    size_t flags = spin_lock_irqsave(&s_hpet_wrap_lock);
+    uint32_t lo = cnt[0];
+    if (lo < s_hpet_last_lo) s_hpet_wraps++;
+    s_hpet_last_lo = lo;
+    uint64_t value = (s_hpet_wraps << 32) | lo;
+    spin_unlock_irqrestore(&s_hpet_wrap_lock, flags);
+    return value;
+}
+
+static uint64_t hpet_ticks_to_ns(uint64_t ticks)
+{
+    uint64_t hz = s_hpet_counter_hz;
+    return (ticks / hz) * 1000000000ull + (ticks % hz) * 1000000000ull / hz;
+}
+
+static uint64_t hpet_ns_to_ticks(uint64_t ns)
+{
+    uint64_t hz = s_hpet_counter_hz;
+    return (ns / 1000000000ull) * hz + (ns % 1000000000ull) * hz / 1000000000ull;
+}
+
+static uint64_t hpet_read_ns()
+{
+    if (!s_hpet_mmio || s_hpet_counter_hz == 0) return 0;
+    return hpet_ticks_to_ns(hpet_read_counter());
+}
+
+// Comparator 0'ı tek seferlik moda al ve hpet_read_ns() zamanındaki vadeye kur.
+// Ana sayaç durdurulmaz (zaman kaynağı olarak kullanılıyor).
+static int hpet_set_oneshot(uint64_t deadline_ns)
+{
+    if (!s_hpet_mmio || !s_hpet_running) return -1;
+
+    size_t flags = arch_irq_save();
+
+    if (!s_hpet_oneshot)
+    {
+        uint64_t tcfg = hpet_read64(HPET_TN_CFG(HPET_TIMER_INDEX));
+        tcfg &= ~(uint64_t)(HPET_TN_TYPE_PERIOD | HPET_TN_32MODE);
+        tcfg |= (uint64_t)HPET_TN_INT_ENB;
+        hpet_write64(HPET_TN_CFG(HPET_TIMER_INDEX), tcfg);
+        s_hpet_oneshot = true;
+    }
+
+    uint64_t target = hpet_ns_to_ticks(deadline_ns);
+    uint64_t min_delta = hpet_ns_to_ticks(HPET_MIN_DELTA_NS);
+    if (min_delta == 0) min_delta = 1;
+
+    for (;;)
+    {
+        uint64_t now = hpet_read_counter();
+        if ((int64_t)(target - now) < (int64_t)min_delta) target = now + min_delta;
+        hpet_write64(HPET_TN_CMP(HPET_TIMER_INDEX), target);
+
+        // Yazma sürerken sayaç vadeyi geçtiyse kesme ancak taşmada gelir; daha ileri kur
+        if ((int64_t)(target - hpet_read_counter()) > 0) break;
+        min_delta *= 2;
+    }
+
+    arch_irq_restore(flags);
+    return 0;
+}
+
 // Convert desired frequency (Hz) to HPET ticks per interrupt
 static uint64_t hpet_ticks_for_hz(uint32_t hz)
 {
@@ -129,6 +223,7 @@ static void hpet_program_periodic(uint32_t hz)
     // Enable legacy replacement route and main counter
     cfg |= (HPET_CFG_LEG_RT_CNF | HPET_CFG_ENABLE);
     hpet_write64(HPET_REG_CONFIG, cfg);
+    s_hpet_oneshot = false;
 }
 
 static int hpet_start()
@@ -196,6 +291,10 @@ void hpet_timer_handler()
     }
 
     if (irq_controller) irq_controller->acknowledge(HPET_IRQ_LEGACY);
+
+    // EOI'den sonra: vadesi gelen zamanlayıcılar softirq'a, zaman dilimi dolduysa başka thread'e
+    work_queue_irq_exit();
+    scheduler_irq_exit();
 }
 
 static void hpet_timer_init_wrapper() { /* no-op; start() programs hardware */ }
@@ -228,6 +327,7 @@ static bool hpet_init()
         return false;
     }
     s_hpet_counter_hz = 1000000000000000ull / (uint64_t)s_hpet_period_fs;
+    s_hpet_counter64 = (cap & HPET_CAP_CNT_SIZE) != 0;
     uint32_t num_timers = HPET_CAP_NUM_TIMERS(cap);
     bool legacy_capable = (cap & HPET_CAP_LEG_RT_CAP) != 0;
 
@@ -254,6 +354,8 @@ static bool hpet_init()
     hpet_timer->setFrequency = hpet_setFrequency;
     hpet_timer->add_callback = hpet_add_callback;
     hpet_timer->remove_callback = hpet_remove_callback;
+    hpet_timer->read_ns = hpet_read_ns;
+    hpet_timer->set_oneshot = hpet_set_oneshot;
 
     // Install ISR but do not unmask yet; start() will enable
     if (irq_controller && irq_controller->register_handler) {
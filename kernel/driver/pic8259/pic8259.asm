@@ -8,6 +8,7 @@ global pic8259_master_default_isr
 extern pic8259_irq2_isr_addr
 extern pic8259_slave_default_isr_handler
 extern pic8259_irq2_isr_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -30,7 +31,8 @@ pic8259_irq2:
     push r14
     push r15
 
-    call pic8259_irq2_isr_handler
+    mov rax, pic8259_irq2_isr_handler
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -68,9 +70,26 @@ pic8259_slave_default_isr:
     cli
 
     push rax
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push r8
+    push r9
+    push r10
+    push r11
 
-    call pic8259_slave_default_isr_handler
+    mov rax, pic8259_slave_default_isr_handler
+    call irq_fpu_call
 
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
     pop rax
 
     sti
@@ -83,7 +102,8 @@ pic8259_irq2:
     cli
 
     pushad
-    call pic8259_irq2_isr_handler
+    mov eax, pic8259_irq2_isr_handler
+    call irq_fpu_call
     popad
 
     push dword [pic8259_irq2_isr_addr]
@@ -106,11 +126,12 @@ pic8259_master_default_isr:
 pic8259_slave_default_isr:
     cli
 
-    push eax
+    pushad
 
-    call pic8259_slave_default_isr_handler
+    mov eax, pic8259_slave_default_isr_handler
+    call irq_fpu_call
 
-    pop eax
+    popad
 
     sti
     iret
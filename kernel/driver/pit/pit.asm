@@ -2,6 +2,7 @@ section .text
 
 global pit_timer_isr
 extern pit_timer_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 use64
@@ -24,7 +25,8 @@ pit_timer_isr:
     push r14
     push r15
 
-    call pit_timer_handler
+    mov rax, pit_timer_handler
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -52,7 +54,8 @@ pit_timer_isr:
 
     pushad
 
-    call pit_timer_handler
+    mov eax, pit_timer_handler
+    call irq_fpu_call
 
     popad
 
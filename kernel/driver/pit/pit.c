@@ -5,6 +5,8 @@
 #include <arch.h>
 #include <debug/debug.h>
 #include <list.h>
+#include <task/Thread.h>
+#include <task/WorkQueue.h>
 
 // PIT (8253/8254) Channel 0 – IRQ0
 #define IRQ_PIT 0
@@ -191,6 +193,10 @@ void pit_timer_handler()
     if (irq_controller && irq_controller->acknowledge) {
         irq_controller->acknowledge(IRQ_PIT);
     }
+
+    // EOI'den sonra: vadesi gelen zamanlayıcılar softirq'a, zaman dilimi dolduysa başka thread'e
+    work_queue_irq_exit();
+    scheduler_irq_exit();
 }
 
 static void pit_timer_init_wrapper()
@@ -3,6 +3,7 @@ section .text
 global ps2kbd_isr
 
 extern ps2kbd_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 
@@ -24,7 +25,8 @@ ps2kbd_isr:
     push r14
     push r15
 
-    call ps2kbd_handler
+    mov rax, ps2kbd_handler
+    call irq_fpu_call
 
     pop r15
     pop r14
@@ -53,7 +55,8 @@ ps2kbd_isr:
     cli
     pushad
 
-    call ps2kbd_handler
+    mov eax, ps2kbd_handler
+    call irq_fpu_call
 
     popad
     sti
@@ -9,6 +9,7 @@
 #include <stream/OutputStream.h>
 #include <debug/debug.h>
 #include <sleep.h>
+#include <task/WorkQueue.h>
 
 #define IRQ_PS2_KEYBOARD 1 // IRQ numarası, genelde 1 (IRQ1) PS/2 klavye için kullanılır
 
@@ -94,21 +95,24 @@ static bool scancodeSetCorrect = false;
 static uint8_t scancodeSetRetryCount = 0;
 
 // --- Local 8042 helpers (keyboard/port1 safe) ---
+// Zaman aşımları gerçek süredir; döngü başına sleep_ms(1) saymak süreyi şişiriyordu
 static bool ps2_wait_input_clear_ms(uint32_t timeout_ms)
 {
-    while (timeout_ms--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_ms * 1000u);
+    do {
         if ((inb(PS2_STATUS_PORT) & PS2_STATUS_IBF) == 0) return true;
-        sleep_ms(1);
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
 static bool ps2_wait_output_full_ms(uint32_t timeout_ms)
 {
-    while (timeout_ms--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_ms * 1000u);
+    do {
         if (inb(PS2_STATUS_PORT) & PS2_STATUS_OBF) return true;
-        sleep_ms(1);
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
@@ -118,7 +122,7 @@ static void ps2_flush_output(void)
         if (inb(PS2_STATUS_PORT) & PS2_STATUS_OBF) {
             (void)inb(PS2_DATA_PORT);
             // Give the controller a brief moment between reads
-            sleep_ms(1);
+            udelay(50);
         } else {
             break;
         }
@@ -142,14 +146,15 @@ static bool ps2_write_data(uint8_t data)
 // Read byte that must be from keyboard (AUX=0)
 static bool ps2_read_kbd(uint8_t* out, uint32_t timeout_ms)
 {
-    while (timeout_ms--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_ms * 1000u);
+    do {
         uint8_t st = inb(PS2_STATUS_PORT);
         if ((st & (PS2_STATUS_OBF)) && ((st & PS2_STATUS_AUX) == 0)) {
             *out = inb(PS2_DATA_PORT);
             return true;
         }
-        sleep_ms(1);
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
@@ -396,26 +401,51 @@ extern void __ps2kbd_us_qwerty_handle(uint8_t scancode);
 extern void __ps2kbd_tr_qwerty_handle(uint8_t scancode);
 extern void __ps2kbd_tr_f_handle(uint8_t scancode);
 
+// ISR yalnızca scancode'u halkaya yazar; layout işleme softirq'da yapılır
+#define PS2KBD_SCANCODE_RING 64
+
+static volatile uint8_t s_scancode_ring[PS2KBD_SCANCODE_RING];
+static volatile uint32_t s_scancode_head = 0; // ISR yazar
+static volatile uint32_t s_scancode_tail = 0; // work yazar
+
+static void ps2kbd_process_scancodes(void* arg)
+{
+    (void)arg;
+
+    while (s_scancode_tail != s_scancode_head) {
+        uint8_t scancode = s_scancode_ring[s_scancode_tail % PS2KBD_SCANCODE_RING];
+        s_scancode_tail++;
+
+        if (currentLayout == LAYOUT_US_QWERTY) {
+            __ps2kbd_us_qwerty_handle(scancode);
+        } else if (currentLayout == LAYOUT_TR_QWERTY) {
+            __ps2kbd_tr_qwerty_handle(scancode);
+        } else if (currentLayout == LAYOUT_TR_F) {
+            __ps2kbd_tr_f_handle(scancode);
+        }
+    }
+}
+
+static WorkItem s_kbd_work = WORK_ITEM_INIT(ps2kbd_process_scancodes, NULL, WORK_PRIO_HIGH);
+
 void ps2kbd_handler() {
 
+    uint8_t scancode = inb(0x60); // PS/2 data port; okunmazsa 8042 yeni IRQ üretmez
+
     if (!ps2_event_buffer) {
         goto _ret;
     }
 
-    char scancode = inb(0x60); // PS/2 data port
-
-    if (currentLayout == LAYOUT_US_QWERTY) {
-        __ps2kbd_us_qwerty_handle(scancode);
-    } else if (currentLayout == LAYOUT_TR_QWERTY) {
-        __ps2kbd_tr_qwerty_handle(scancode);
-    } else if (currentLayout == LAYOUT_TR_F) {
-        __ps2kbd_tr_f_handle(scancode);
-    } else {
-        goto _ret;
+    // Halka doluysa en yeni scancode düşer (work gecikmiş demektir)
+    if (s_scancode_head - s_scancode_tail < PS2KBD_SCANCODE_RING) {
+        s_scancode_ring[s_scancode_head % PS2KBD_SCANCODE_RING] = scancode;
+        s_scancode_head++;
+        work_queue_post(&s_kbd_work);
     }
 
 _ret:
     irq_controller->acknowledge(IRQ_PS2_KEYBOARD);
+    work_queue_irq_exit();
 }
 
 static int ps2kbd_stream_open() {
@@ -436,15 +466,19 @@ static int ps2kbd_stream_readChar(char* c) {
 
     KeyboardKeyEventData* event;
 
-    do {
+    for (;;) {
         event = (KeyboardKeyEventData*)buffer_pop(ps2_event_buffer);
         if (!event) {
             return -1;
         }
-    } while (event->isPressed == false || event->key == KEY_UNKNOWN);
+        if (event->isPressed && event->key != KEY_UNKNOWN) {
+            break;
+        }
+        buffer_free_data(event);
+    }
 
     *c = event->ascii;
-    free(event);
+    buffer_free_data(event);
     return 1;
 }
 
@@ -2,6 +2,7 @@ section .text
 
 global ps2mouse_isr
 extern ps2mouse_isr_handler
+extern irq_fpu_call
 
 %if __BITS__ == 64
 
@@ -21,7 +22,8 @@ ps2mouse_isr:
     push r11
 
     ; Call the handler function
-    call ps2mouse_isr_handler
+    mov rax, ps2mouse_isr_handler
+    call irq_fpu_call
 
 
     ; Restore registers
@@ -49,7 +51,8 @@ ps2mouse_isr:
     pushad
 
     ; Call the handler function
-    call ps2mouse_isr_handler
+    mov eax, ps2mouse_isr_handler
+    call irq_fpu_call
 
     ; Restore registers
     popad
@@ -3,6 +3,8 @@
 #include <driver/DriverBase.h>
 #include <debug/debug.h>
 #include <driver/ps2mouse/ps2mouse.h>
+#include <task/WorkQueue.h>
+#include <sleep.h>
 
 #define IRQ_PS2_MOUSE 12 // IRQ numarası, genelde 12 (IRQ12) PS/2 mouse için kullanılır
 
@@ -21,23 +23,26 @@ extern void ps2mouse_isr(void);
 #define PS2_STATUS_IBF 0x02   // Input Buffer Full
 #define PS2_STATUS_AUX 0x20   // 1=mouse (AUX) verisi
 
-static bool ps2_wait_input_clear(uint32_t limit)
+// limit/timeout değerleri mikrosaniyedir (io_wait sayımı değil)
+static bool ps2_wait_input_clear(uint32_t timeout_us)
 {
-    while (limit--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
+    do {
         if ((inb(0x64) & PS2_STATUS_IBF) == 0)
             return true;
-        io_wait();
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
-static bool ps2_wait_output_full(uint32_t limit)
+static bool ps2_wait_output_full(uint32_t timeout_us)
 {
-    while (limit--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
+    do {
         if (inb(0x64) & PS2_STATUS_OBF)
             return true;
-        io_wait();
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
@@ -75,23 +80,24 @@ static bool ps2_write_aux(uint8_t data)
     return ps2_write_data(data);
 }
 
-static bool ps2_read_aux(uint8_t* out, uint32_t limit)
+static bool ps2_read_aux(uint8_t* out, uint32_t timeout_us)
 {
-    while (limit--) {
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
+    do {
         uint8_t st = inb(0x64);
         if ((st & (PS2_STATUS_OBF | PS2_STATUS_AUX)) == (PS2_STATUS_OBF | PS2_STATUS_AUX)) {
             *out = inb(0x60);
             return true;
         }
-        io_wait();
-    }
+    } while (wait_deadline_poll(&wait));
     return false;
 }
 
-static bool ps2_expect_aux(uint8_t expected, uint32_t limit)
+static bool ps2_expect_aux(uint8_t expected, uint32_t timeout_us)
 {
     uint8_t b;
-    if (!ps2_read_aux(&b, limit)) return false;
+    if (!ps2_read_aux(&b, timeout_us)) return false;
     return b == expected;
 }
 
@@ -267,6 +273,52 @@ bool ps2mouse_enabled(void) {
     return enabled;
 }
 
+// ISR ham baytları halkaya yazar; paket toplama ve imleç güncellemesi softirq'da
+#define PS2MOUSE_BYTE_RING 96
+
+static volatile uint8_t s_byte_ring[PS2MOUSE_BYTE_RING];
+static volatile uint32_t s_byte_head = 0; // ISR yazar
+static volatile uint32_t s_byte_tail = 0; // work yazar
+
+static void ps2mouse_process_bytes(void* arg)
+{
+    (void)arg;
+
+    while (s_byte_tail != s_byte_head) {
+        uint8_t data = s_byte_ring[s_byte_tail % PS2MOUSE_BYTE_RING];
+        s_byte_tail++;
+
+        // Packet topla
+        packet_buffer[packet_index++] = data;
+
+        if (packet_index >= 3) {
+            uint8_t flags = packet_buffer[0];
+
+            if (flags & PS2_MOUSE_ALWAYS_1) {
+                int delta_x = packet_buffer[1];
+                int delta_y = packet_buffer[2];
+
+                if (!(flags & (PS2_MOUSE_X_OVERFLOW | PS2_MOUSE_Y_OVERFLOW))) {
+                    if (flags & PS2_MOUSE_X_SIGN) {
+                        delta_x |= ~0xFF;
+                    }
+                    if (flags & PS2_MOUSE_Y_SIGN) {
+                        delta_y |= ~0xFF;
+                    }
+
+                    cursor_X += delta_x;
+                    cursor_Y -= delta_y;
+
+                }
+            }
+
+            packet_index = 0;
+        }
+    }
+}
+
+static WorkItem s_mouse_work = WORK_ITEM_INIT(ps2mouse_process_bytes, NULL, WORK_PRIO_HIGH);
+
 void ps2mouse_isr_handler(void) {
     
     // Status register'ı oku
@@ -285,35 +337,16 @@ void ps2mouse_isr_handler(void) {
     // Veriyi oku
     uint8_t data = inb(PS2_DATA_PORT);
 
-    // Packet topla
-    packet_buffer[packet_index++] = data;
-    
-    if (packet_index >= 3) {
-        uint8_t flags = packet_buffer[0];
-        
-        if (flags & PS2_MOUSE_ALWAYS_1) {
-            int delta_x = packet_buffer[1];
-            int delta_y = packet_buffer[2];
-            
-            if (!(flags & (PS2_MOUSE_X_OVERFLOW | PS2_MOUSE_Y_OVERFLOW))) {
-                if (flags & PS2_MOUSE_X_SIGN) {
-                    delta_x |= ~0xFF;
-                }
-                if (flags & PS2_MOUSE_Y_SIGN) {
-                    delta_y |= ~0xFF;
-                }
-                
-                cursor_X += delta_x;
-                cursor_Y -= delta_y;
-
-            }
-        }
-        
-        packet_index = 0;
+    // Halka doluysa (work gecikmiş) yeni bayt atılır
+    if (s_byte_head - s_byte_tail < PS2MOUSE_BYTE_RING) {
+        s_byte_ring[s_byte_head % PS2MOUSE_BYTE_RING] = data;
+        s_byte_head++;
+        work_queue_post(&s_mouse_work);
     }
 
 _ret:
     irq_controller->acknowledge(IRQ_PS2_MOUSE);
+    work_queue_irq_exit();
 }
 
 DriverBase ps2mouse_driver = {
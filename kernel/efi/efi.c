@@ -58,10 +58,11 @@ void efi_exit_boot_services() {
         efi_image_handle, bs_map_key);
     
     if (status != EFI_SUCCESS) {
+        // Firmware still owns its boot services memory; do not hand it to the PMM
         ERROR("Failed to exit EFI boot services: status code %lu", status);
-    } else {
-        LOG("Successfully exited EFI boot services");
+        return;
     }
+    LOG("Successfully exited EFI boot services");
 
     // After this point, boot services are no longer available
     // After that set 'usable' EFI CODE & EFI DATA sections.
@@ -69,11 +70,12 @@ void efi_exit_boot_services() {
     for (ListNode* node = memory_regions->head; node != NULL; node = node->next) {
         MemoryRegion* region = (MemoryRegion*)node->data;
         if (region->type == MemoryRegionType_EFI_BS_CODE || region->type == MemoryRegionType_EFI_BS_DATA) {
+            pmm_release_region(region->base, region->size);
             region->type = MemoryRegionType_USABLE;
         }
     }
     
-    pmm_maintain(); // Rebuild free memory list after changes
+    pmm_maintain(); // Merge the now-usable entries in the region map
 
 }
 
@@ -1,9 +1,11 @@
 #include <filesystem/VFS.h>
 #include <list.h>
 #include <memory/memory.h>
+#include <memory/slab.h>
 #include <util/string.h>
 #include <debug/debug.h>
 #include <stream/FileStream.h>
+#include <boot/boot_trace.h>
 
 #define VFS_MAX_SEGMENTS (VFS_PATH_MAX / 2)
 #define VFS_DEFAULT_CACHE_CAPACITY 128
@@ -26,6 +28,8 @@ typedef struct VFSCacheEntry {
 } VFSCacheEntry;
 
 static List* s_cache_entries = NULL;
+static KmemCache* s_cache_entry_cache = NULL;
+static KmemCache* s_node_cache = NULL;
 static size_t s_cache_capacity = VFS_DEFAULT_CACHE_CAPACITY;
 static size_t s_cache_hits = 0;
 static size_t s_cache_misses = 0;
@@ -71,7 +75,7 @@ static void vfs_cache_cleanup_entry(VFSCacheEntry* entry)
 {
     if (!entry) return;
     if (entry->path) free(entry->path);
-    free(entry);
+    kmem_cache_free(s_cache_entry_cache, entry);
 }
 
 static void vfs_cache_clear(void)
@@ -212,13 +216,16 @@ static void vfs_cache_insert(const char* normalized_path, VFSNode* node)
         List_RemoveAt(s_cache_entries, tail_index);
     }
 
-    VFSCacheEntry* entry = (VFSCacheEntry*)malloc(sizeof(VFSCacheEntry));
+    if (!kmem_cache_get(&s_cache_entry_cache, "VFSCacheEntry", sizeof(VFSCacheEntry), 0))
+        return;
+
+    VFSCacheEntry* entry = (VFSCacheEntry*)kmem_cache_alloc(s_cache_entry_cache);
     if (!entry) return;
 
     entry->path = strdup(normalized_path);
     if (!entry->path)
     {
-        free(entry);
+        kmem_cache_free(s_cache_entry_cache, entry);
         return;
     }
 
@@ -267,6 +274,18 @@ bool VFS_IsInitialized(void)
     return s_vfs_initialized;
 }
 
+VFSNode* VFS_AllocNode(void)
+{
+    KmemCache* cache = kmem_cache_get(&s_node_cache, "VFSNode", sizeof(VFSNode), 0);
+    return cache ? (VFSNode*)kmem_cache_alloc(cache) : NULL;
+}
+
+void VFS_FreeNode(VFSNode* node)
+{
+    if (!node) return;
+    kmem_cache_free(s_node_cache, node);
+}
+
 void VFS_CacheFlush(void)
 {
     if (!s_cache_entries) return;
@@ -369,7 +388,9 @@ VFSMount* VFS_Mount(const char* target, VFSFileSystem* fs, const VFSMountParams*
     }
 
     VFSNode* root_node = NULL;
+    uint32_t span = boot_trace_begin("mount", normalized);
     VFSResult mount_res = fs->ops->mount(fs, params, &root_node);
+    boot_trace_end(span);
     if (mount_res != VFS_RES_OK || !root_node)
     {
         WARN("VFS_Mount: filesystem '%s' mount handler failed (%d)", fs->name, mount_res);
@@ -416,6 +437,7 @@ VFSMount* VFS_Mount(const char* target, VFSFileSystem* fs, const VFSMountParams*
     vfs_cache_insert(mount->path, mount->root);
 
     LOG("VFS: mounted '%s' at '%s'", fs->name, mount->path);
+    boot_trace_on_mount();
     return mount;
 }
 
@@ -139,6 +139,7 @@ bool fat_volume_init(FATVolume* volume,
 bool fat_volume_probe_type(FATVolume* volume, const FAT_BootSector* bpb);
 bool fat_volume_read_sector(FATVolume* volume, uint32_t sector, void* buffer);
 bool fat_volume_read_cluster(FATVolume* volume, uint32_t cluster, void* buffer);
+bool fat_volume_submit_clusters(FATVolume* volume, uint32_t cluster, uint32_t count, void* buffer, BlockRequest* req);
 bool fat_volume_is_end(FATVolume* volume, uint32_t value);
 bool fat_volume_is_bad(FATVolume* volume, uint32_t value);
 uint32_t fat_volume_get_next_cluster(FATVolume* volume, uint32_t cluster);
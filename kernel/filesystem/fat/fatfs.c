@@ -2,6 +2,7 @@
 #include "fat_internal.h"
 #include <list.h>
 #include <memory/memory.h>
+#include <memory/slab.h>
 #include <util/string.h>
 #include <debug/debug.h>
 
@@ -9,6 +10,9 @@
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif
 
+#define FAT_READ_BATCH_BYTES  (128u * 1024u)  // fatfs_read_file'ın tur başına tamponu
+#define FAT_READ_BATCH_RUNS   4              // Aynı anda gönderilen ardışık küme dizisi
+
 static VFSFileSystem s_fat_fs = {
     .name = "fat",
     .flags = 0,
@@ -59,6 +63,13 @@ static FATNodeInfo* fat_node_info(VFSNode* node)
     return (FATNodeInfo*)node->internal_data;
 }
 
+static KmemCache* s_fat_info_cache = NULL;
+
+static KmemCache* fatfs_info_cache(void)
+{
+    return kmem_cache_get(&s_fat_info_cache, "FATNodeInfo", sizeof(FATNodeInfo), 0);
+}
+
 static void fatfs_free_node(VFSNode* node)
 {
     if (!node) return;
@@ -69,10 +80,10 @@ static void fatfs_free_node(VFSNode* node)
             free(info->overlay_data);
         if (info->overlay_children)
             List_Destroy(info->overlay_children, false);
-        free(info);
+        kmem_cache_free(s_fat_info_cache, info);
     }
     if (node->name) free(node->name);
-    free(node);
+    VFS_FreeNode(node);
 }
 
 static void fatfs_destroy_volume(FATVolume* volume)
@@ -94,13 +105,13 @@ static void fatfs_destroy_volume(FATVolume* volume)
 static VFSNode* fatfs_alloc_node(FATVolume* volume, VFSNode* parent, const char* name, VFSNodeType type, FATNodeInfo** out_info)
 {
     if (!volume) return NULL;
-    VFSNode* node = (VFSNode*)malloc(sizeof(VFSNode));
+    VFSNode* node = VFS_AllocNode();
     if (!node) return NULL;
 
-    FATNodeInfo* info = (FATNodeInfo*)malloc(sizeof(FATNodeInfo));
+    FATNodeInfo* info = (FATNodeInfo*)kmem_cache_alloc(fatfs_info_cache());
     if (!info)
     {
-        free(node);
+        VFS_FreeNode(node);
         return NULL;
     }
 
@@ -110,8 +121,8 @@ static VFSNode* fatfs_alloc_node(FATVolume* volume, VFSNode* parent, const char*
         node_name = strdup(name);
         if (!node_name)
         {
-            free(info);
-            free(node);
+            kmem_cache_free(s_fat_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -141,8 +152,8 @@ static VFSNode* fatfs_alloc_node(FATVolume* volume, VFSNode* parent, const char*
         if (!volume->nodes)
         {
             if (node_name) free(node_name);
-            free(info);
-            free(node);
+            kmem_cache_free(s_fat_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -444,31 +455,88 @@ static int64_t fatfs_read_file(FATNodeInfo* node, uint64_t offset, void* buffer,
             return 0;
     }
 
-    uint8_t* temp = (uint8_t*)malloc(cluster_size);
+    // Bir turda en fazla FAT_READ_BATCH_BYTES; zincirdeki ardışık kümeler tek
+    // istekte, en fazla FAT_READ_BATCH_RUNS istek birlikte uçuşta
+    uint32_t batch = FAT_READ_BATCH_BYTES / cluster_size;
+    if (batch == 0) batch = 1;
+
+    uint8_t* temp = (uint8_t*)malloc((size_t)cluster_size * batch);
     if (!temp) return -1;
 
     size_t total_read = 0;
+    bool last = false;
 
-    while (to_read > 0 && !fat_volume_is_end(volume, cluster))
+    while (to_read > 0 && !last && !fat_volume_is_end(volume, cluster))
     {
-        if (!fat_volume_read_cluster(volume, cluster, temp))
-            break;
+        uint32_t run_start[FAT_READ_BATCH_RUNS];
+        uint32_t run_len[FAT_READ_BATCH_RUNS];
+        uint32_t runs = 0;
+        uint32_t clusters = 0;
+        uint32_t want = (uint32_t)MIN((uint64_t)batch, ((uint64_t)cluster_offset + to_read + cluster_size - 1) / cluster_size);
 
-        size_t start = total_read == 0 ? cluster_offset : 0;
-        size_t available = cluster_size - start;
-        size_t chunk = MIN(to_read, available);
+        while (clusters < want && !fat_volume_is_end(volume, cluster))
+        {
+            if (runs && cluster == run_start[runs - 1] + run_len[runs - 1])
+                run_len[runs - 1]++;
+            else if (runs < FAT_READ_BATCH_RUNS)
+            {
+                run_start[runs] = cluster;
+                run_len[runs++] = 1;
+            }
+            else
+                break;
+            clusters++;
 
-        memcpy((uint8_t*)buffer + total_read, temp + start, chunk);
+            uint32_t next = fat_volume_get_next_cluster(volume, cluster);
+            if (fat_volume_is_bad(volume, next))
+            {
+                last = true;
+                break;
+            }
+            cluster = next;
+        }
 
-        total_read += chunk;
-        to_read -= chunk;
+        // Tur boyunca tıkaç: diziler kuyrukta birleşip LBA sırasıyla çıkar
+        BlockDevice* device = volume->backing_volume ? volume->backing_volume->device : volume->device;
+        BlockRequest reqs[FAT_READ_BATCH_RUNS];
+        uint32_t offset_clusters = 0;
+        BlockDevice_Plug(device);
+        for (uint32_t i = 0; i < runs; ++i)
+        {
+            if (!fat_volume_submit_clusters(volume, run_start[i], run_len[i],
+                                            temp + (size_t)offset_clusters * cluster_size, &reqs[i]))
+            {
+                // Gönderilenler beklenir; okuma bu dizide kısa biter
+                runs = i;
+                last = true;
+                break;
+            }
+            offset_clusters += run_len[i];
+        }
+        BlockDevice_Unplug(device);
 
-        uint32_t next = fat_volume_get_next_cluster(volume, cluster);
-        if (fat_volume_is_bad(volume, next))
+        // Yalnızca baştan itibaren başarılı dizileri kopyala
+        uint32_t good = 0;
+        for (uint32_t i = 0; i < runs; ++i)
         {
-            break;
+            if (!BlockDevice_Wait(&reqs[i]))
+            {
+                BlockDevice_WaitAll(&reqs[i + 1], runs - i - 1);
+                last = true;
+                break;
+            }
+            good += run_len[i];
         }
-        cluster = next;
+
+        size_t available = (size_t)good * cluster_size;
+        if (available <= cluster_offset)
+            break;
+        size_t chunk = MIN(to_read, available - cluster_offset);
+
+        memcpy((uint8_t*)buffer + total_read, temp + cluster_offset, chunk);
+
+        total_read += chunk;
+        to_read -= chunk;
         cluster_offset = 0;
     }
 
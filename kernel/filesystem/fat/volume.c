@@ -58,6 +58,27 @@ bool fat_volume_read_cluster(FATVolume* volume, uint32_t cluster, void* buffer)
     return BlockDevice_Read(volume->device, volume->lba_offset + first_sector, sectors, buffer);
 }
 
+// Ardışık 'count' kümeyi asenkron okumaya gönderir; BlockDevice_Wait ile beklenir.
+// false dönerse req BLKREQ_ERROR durumundadır, beklemek hemen false verir.
+bool fat_volume_submit_clusters(FATVolume* volume, uint32_t cluster, uint32_t count, void* buffer, BlockRequest* req)
+{
+    if (!req) return false;
+    BlockRequest_Init(req, BLKREQ_READ, 0, 0, buffer);
+    req->status = BLKREQ_ERROR;
+    if (!volume || !buffer) return false;
+    if (cluster < 2 || count == 0) return false;
+
+    uint32_t first_sector = volume->first_data_sector + (cluster - 2) * volume->sectors_per_cluster;
+    uint32_t sectors = volume->sectors_per_cluster * count;
+    if (volume->backing_volume)
+    {
+        BlockRequest_Init(req, BLKREQ_READ, first_sector, sectors, buffer);
+        return Volume_SubmitSectors(volume->backing_volume, req);
+    }
+    BlockRequest_Init(req, BLKREQ_READ, volume->lba_offset + first_sector, sectors, buffer);
+    return BlockDevice_Submit(volume->device, req);
+}
+
 uint32_t fat_volume_get_next_cluster(FATVolume* volume, uint32_t cluster)
 {
     if (!volume) return 0xFFFFFFFFu;
@@ -1,5 +1,6 @@
 #include <filesystem/iso9660.h>
 #include <memory/memory.h>
+#include <memory/slab.h>
 #include <util/string.h>
 #include <debug/debug.h>
 #include <list.h>
@@ -151,13 +152,20 @@ static ISO9660NodeInfo* iso9660_node_info(VFSNode* node)
     return node ? (ISO9660NodeInfo*)node->internal_data : NULL;
 }
 
+static KmemCache* s_iso_info_cache = NULL;
+
+static KmemCache* iso9660_info_cache(void)
+{
+    return kmem_cache_get(&s_iso_info_cache, "ISO9660NodeInfo", sizeof(ISO9660NodeInfo), 0);
+}
+
 static void iso9660_free_node(VFSNode* node)
 {
     if (!node) return;
     ISO9660NodeInfo* info = iso9660_node_info(node);
-    if (info) free(info);
+    if (info) kmem_cache_free(s_iso_info_cache, info);
     if (node->name) free(node->name);
-    free(node);
+    VFS_FreeNode(node);
 }
 
 static void iso9660_destroy_volume(ISO9660Volume* volume)
@@ -184,13 +192,13 @@ static VFSNode* iso9660_alloc_node(ISO9660Volume* volume,
 {
     if (!volume) return NULL;
 
-    VFSNode* node = (VFSNode*)malloc(sizeof(VFSNode));
+    VFSNode* node = VFS_AllocNode();
     if (!node) return NULL;
 
-    ISO9660NodeInfo* info = (ISO9660NodeInfo*)malloc(sizeof(ISO9660NodeInfo));
+    ISO9660NodeInfo* info = (ISO9660NodeInfo*)kmem_cache_alloc(iso9660_info_cache());
     if (!info)
     {
-        free(node);
+        VFS_FreeNode(node);
         return NULL;
     }
 
@@ -200,8 +208,8 @@ static VFSNode* iso9660_alloc_node(ISO9660Volume* volume,
         node_name = strdup(name);
         if (!node_name)
         {
-            free(info);
-            free(node);
+            kmem_cache_free(s_iso_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -226,8 +234,8 @@ static VFSNode* iso9660_alloc_node(ISO9660Volume* volume,
         if (!volume->nodes)
         {
             if (node_name) free(node_name);
-            free(info);
-            free(node);
+            kmem_cache_free(s_iso_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -282,18 +290,38 @@ static bool iso9660_iterate_directory(ISO9660NodeInfo* dir,
     if (dir->data_length == 0)
         return true; // empty directory
 
-    uint8_t* block = (uint8_t*)malloc(block_size);
-    if (!block)
+    // Çift tampon: bir blok ayrıştırılırken sonraki blok okunuyor
+    uint8_t* blocks = (uint8_t*)malloc((size_t)block_size * 2);
+    if (!blocks)
         return false;
 
     uint32_t total_blocks = (dir->data_length + block_size - 1) / block_size;
+    BlockRequest reqs[2];
+    BlockRequest* ahead = NULL;
+    bool result = true;
+
+    BlockRequest_Init(&reqs[0], BLKREQ_READ, dir->extent_lba, 1, blocks);
+    (void)BlockDevice_Submit(volume->device, &reqs[0]);
 
     for (uint32_t block_index = 0; block_index < total_blocks; ++block_index)
     {
-        if (!BlockDevice_Read(volume->device, dir->extent_lba + block_index, 1, block))
+        uint32_t cur = block_index & 1u;
+        uint8_t* block = blocks + (size_t)cur * block_size;
+        ahead = NULL;
+        if (!BlockDevice_Wait(&reqs[cur]))
+        {
+            result = false;
+            goto done;
+        }
+
+        if (block_index + 1 < total_blocks)
         {
-            free(block);
-            return false;
+            BlockRequest* next = &reqs[cur ^ 1u];
+            BlockRequest_Init(next, BLKREQ_READ, dir->extent_lba + block_index + 1, 1,
+                              blocks + (size_t)(cur ^ 1u) * block_size);
+            next->flags |= BLKREQ_FLAG_READAHEAD;
+            (void)BlockDevice_Submit(volume->device, next);
+            ahead = next;
         }
 
         size_t pos = 0;
@@ -316,8 +344,8 @@ static bool iso9660_iterate_directory(ISO9660NodeInfo* dir,
             if (absolute_offset + length > dir->data_length)
             {
                 // Malformed entry that overflows directory size
-                free(block);
-                return false;
+                result = false;
+                goto done;
             }
 
             const uint8_t* identifier = (const uint8_t*)(block + pos + sizeof(ISO9660DirectoryRecordHeader));
@@ -338,10 +366,7 @@ static bool iso9660_iterate_directory(ISO9660NodeInfo* dir,
                 {
                     bool keep = callback(&parsed, context);
                     if (!keep)
-                    {
-                        free(block);
-                        return true;
-                    }
+                        goto done;
                 }
             }
 
@@ -349,8 +374,12 @@ static bool iso9660_iterate_directory(ISO9660NodeInfo* dir,
         }
     }
 
-    free(block);
-    return true;
+done:
+    // Okuma-önü isteği tampona yazmayı bitirmeden serbest bırakılamaz
+    if (ahead)
+        (void)BlockDevice_Wait(ahead);
+    free(blocks);
+    return result;
 }
 
 void ISO9660_Register(void)
@@ -613,43 +642,80 @@ static int64_t iso9660_node_read(VFSNode* node, void* handle, uint64_t offset, v
     if (block_size == 0)
         block_size = 2048;
 
-    uint8_t* temp = (uint8_t*)malloc(block_size);
+    // Baştaki ve sondaki kısmi bloklar geçici tampona, aradaki tam bloklar
+    // doğrudan hedefe; üç istek birlikte gönderilir
+    uint8_t* temp = (uint8_t*)malloc((size_t)block_size * 2);
     if (!temp)
         return -1;
 
     uint8_t* out = (uint8_t*)buffer;
-    size_t total_read = 0;
+    uint32_t lba = info->extent_lba + (uint32_t)(offset / block_size);
+    size_t intra = (size_t)(offset % block_size);
+
+    size_t head = 0;
+    if (intra != 0 || remaining < block_size)
+        head = MIN(remaining, block_size - intra);
+    size_t rest = remaining - head;
+    size_t bulk_blocks = rest / block_size;
+    size_t tail = rest % block_size;
+    if (bulk_blocks > UINT32_MAX)
+    {
+        bulk_blocks = UINT32_MAX;
+        tail = 0;
+    }
 
-    while (total_read < remaining)
+    uint32_t bulk_lba = lba + (head ? 1u : 0u);
+    uint32_t tail_lba = bulk_lba + (uint32_t)bulk_blocks;
+
+    // Üçü bitişik; tıkaç altında kuyrukta tek komuta birleşir
+    BlockRequest head_req, bulk_req, tail_req;
+    BlockDevice_Plug(volume->device);
+    if (head)
+    {
+        BlockRequest_Init(&head_req, BLKREQ_READ, lba, 1, temp);
+        (void)BlockDevice_Submit(volume->device, &head_req);
+    }
+    if (bulk_blocks)
+    {
+        BlockRequest_Init(&bulk_req, BLKREQ_READ, bulk_lba, (uint32_t)bulk_blocks, out + head);
+        (void)BlockDevice_Submit(volume->device, &bulk_req);
+    }
+    if (tail)
     {
-        uint64_t abs_offset = offset + total_read;
-        uint32_t lba = info->extent_lba + (uint32_t)(abs_offset / block_size);
-        size_t intra = (size_t)(abs_offset % block_size);
-        size_t chunk = MIN(remaining - total_read, block_size - intra);
+        BlockRequest_Init(&tail_req, BLKREQ_READ, tail_lba, 1, temp + block_size);
+        (void)BlockDevice_Submit(volume->device, &tail_req);
+    }
+    BlockDevice_Unplug(volume->device);
 
-        if (intra == 0 && chunk == block_size && (remaining - total_read) >= block_size)
+    // Hepsini bekle (tamponlar serbest kalmadan önce); ilk hatada okunan kısım döner
+    bool head_ok = !head || BlockDevice_Wait(&head_req);
+    bool bulk_ok = !bulk_blocks || BlockDevice_Wait(&bulk_req);
+    bool tail_ok = !tail || BlockDevice_Wait(&tail_req);
+
+    size_t total_read = 0;
+    if (!head_ok)
+    {
+        WARN("ISO9660: read failed at LBA=%u", lba);
+    }
+    else
+    {
+        memcpy(out, temp + intra, head);
+        total_read = head;
+        if (!bulk_ok)
         {
-            size_t max_blocks = (remaining - total_read) / block_size;
-            if (max_blocks > UINT32_MAX)
-                max_blocks = UINT32_MAX;
-            if (!BlockDevice_Read(volume->device, lba, (uint32_t)max_blocks, out + total_read))
-            {
-                WARN("ISO9660: bulk read failed at LBA=%u count=%zu", lba, max_blocks);
-                break;
-            }
-            size_t bytes = max_blocks * block_size;
-            total_read += bytes;
-            continue;
+            WARN("ISO9660: bulk read failed at LBA=%u count=%zu", bulk_lba, bulk_blocks);
         }
-
-        if (!BlockDevice_Read(volume->device, lba, 1, temp))
+        else
         {
-            WARN("ISO9660: read failed at LBA=%u", lba);
-            break;
+            total_read += bulk_blocks * block_size;
+            if (!tail_ok)
+                WARN("ISO9660: read failed at LBA=%u", tail_lba);
+            else if (tail)
+            {
+                memcpy(out + total_read, temp + block_size, tail);
+                total_read += tail;
+            }
         }
-
-        memcpy(out + total_read, temp + intra, chunk);
-        total_read += chunk;
     }
 
     free(temp);
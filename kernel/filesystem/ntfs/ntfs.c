@@ -1,5 +1,6 @@
 #include <filesystem/ntfs.h>
 #include <memory/memory.h>
+#include <memory/slab.h>
 #include <util/string.h>
 #include <debug/debug.h>
 #include <list.h>
@@ -17,6 +18,9 @@
 #endif
 
 #define NTFS_SIGNATURE "FILE"
+
+#define NTFS_READ_CHUNK_BYTES  (128u * 1024u)  // Tek okuma isteğinin en büyük boyu
+#define NTFS_READ_INFLIGHT     4               // ntfs_read_from_runlist'te uçuştaki istek
 #define NTFS_OEM_STRING "NTFS    "
 
 #define NTFS_ATTR_STANDARD_INFORMATION 0x10
@@ -193,6 +197,15 @@ typedef struct NTFSNodeInfo {
     List*    overlay_children;  // runtime-only children (directories)
 } NTFSNodeInfo;
 
+// ntfs_read_from_runlist'in uçuştaki bir parçası
+typedef struct NTFSReadChunk {
+    BlockRequest req;
+    uint8_t* temp;
+    uint8_t* dst;
+    size_t skip;                 // temp içindeki blok hizası farkı
+    size_t bytes;
+} NTFSReadChunk;
+
 typedef struct NTFSHandle {
     NTFSNodeInfo* node;
     NTFSRunlist   runlist;
@@ -270,6 +283,8 @@ static int64_t ntfs_read_from_runlist(NTFSNodeInfo* info, NTFSRunlist* runlist,
 static bool ntfs_enumerate_directory(NTFSNodeInfo* dir, size_t target_index, VFSDirEntry* out_entry, const char* find_name, uint64_t* out_child_ref);
 static uint32_t ntfs_device_block_size(const NTFSVolume* volume);
 static bool ntfs_read_blocks(NTFSVolume* volume, uint64_t lba, uint32_t count, void* buffer);
+static bool ntfs_submit_blocks(NTFSVolume* volume, uint64_t lba, uint32_t count, void* buffer, BlockRequest* req);
+static bool ntfs_read_chunks_finish(NTFSReadChunk* chunks, size_t count);
 static bool ntfs_overlay_reserve(NTFSNodeInfo* info, size_t required);
 static VFSNode* ntfs_overlay_find_child(NTFSNodeInfo* dir, const char* name);
 static size_t ntfs_overlay_child_count(NTFSNodeInfo* dir);
@@ -997,6 +1012,39 @@ static bool ntfs_read_blocks(NTFSVolume* volume, uint64_t lba, uint32_t count, v
     return BlockDevice_Read(volume->device, volume->lba_offset + lba, count, buffer);
 }
 
+// false dönerse req BLKREQ_ERROR durumundadır, beklemek hemen false verir
+static bool ntfs_submit_blocks(NTFSVolume* volume, uint64_t lba, uint32_t count, void* buffer, BlockRequest* req)
+{
+    if (!req) return false;
+    BlockRequest_Init(req, BLKREQ_READ, 0, 0, buffer);
+    req->status = BLKREQ_ERROR;
+    if (!volume || !buffer || count == 0) return false;
+    if (volume->backing_volume)
+    {
+        BlockRequest_Init(req, BLKREQ_READ, lba, count, buffer);
+        return Volume_SubmitSectors(volume->backing_volume, req);
+    }
+    if (!volume->device)
+        return false;
+    BlockRequest_Init(req, BLKREQ_READ, volume->lba_offset + lba, count, buffer);
+    return BlockDevice_Submit(volume->device, req);
+}
+
+// Uçuştaki parçaları sırayla bekler, hedefe kopyalar ve tamponlarını bırakır
+static bool ntfs_read_chunks_finish(NTFSReadChunk* chunks, size_t count)
+{
+    bool ok = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (BlockDevice_Wait(&chunks[i].req) && ok)
+            memcpy(chunks[i].dst, chunks[i].temp + chunks[i].skip, chunks[i].bytes);
+        else
+            ok = false;
+        free(chunks[i].temp);
+    }
+    return ok;
+}
+
 static bool ntfs_overlay_reserve(NTFSNodeInfo* info, size_t required)
 {
     if (!info) return false;
@@ -1338,6 +1386,13 @@ static void ntfs_destroy_volume(NTFSVolume* volume)
     free(volume);
 }
 
+static KmemCache* s_ntfs_info_cache = NULL;
+
+static KmemCache* ntfs_info_cache(void)
+{
+    return kmem_cache_get(&s_ntfs_info_cache, "NTFSNodeInfo", sizeof(NTFSNodeInfo), 0);
+}
+
 static void ntfs_free_node(VFSNode* node)
 {
     if (!node) return;
@@ -1348,10 +1403,10 @@ static void ntfs_free_node(VFSNode* node)
             free(info->overlay_data);
         if (info->overlay_children)
             List_Destroy(info->overlay_children, false);
-        free(info);
+        kmem_cache_free(s_ntfs_info_cache, info);
     }
     if (node->name) free(node->name);
-    free(node);
+    VFS_FreeNode(node);
 }
 
 static VFSNode* ntfs_alloc_node(NTFSVolume* volume,
@@ -1364,13 +1419,13 @@ static VFSNode* ntfs_alloc_node(NTFSVolume* volume,
 {
     if (!volume) return NULL;
 
-    VFSNode* node = (VFSNode*)malloc(sizeof(VFSNode));
+    VFSNode* node = VFS_AllocNode();
     if (!node) return NULL;
 
-    NTFSNodeInfo* info = (NTFSNodeInfo*)malloc(sizeof(NTFSNodeInfo));
+    NTFSNodeInfo* info = (NTFSNodeInfo*)kmem_cache_alloc(ntfs_info_cache());
     if (!info)
     {
-        free(node);
+        VFS_FreeNode(node);
         return NULL;
     }
 
@@ -1380,8 +1435,8 @@ static VFSNode* ntfs_alloc_node(NTFSVolume* volume,
         node_name = strdup(name);
         if (!node_name)
         {
-            free(info);
-            free(node);
+            kmem_cache_free(s_ntfs_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -1412,8 +1467,8 @@ static VFSNode* ntfs_alloc_node(NTFSVolume* volume,
         if (!volume->nodes)
         {
             if (node_name) free(node_name);
-            free(info);
-            free(node);
+            kmem_cache_free(s_ntfs_info_cache, info);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -1580,10 +1635,20 @@ static int64_t ntfs_read_from_runlist(NTFSNodeInfo* info,
     if (!info || !info->volume || !runlist || runlist->count == 0 || !buffer) return -1;
 
     NTFSVolume* volume = info->volume;
+    uint32_t block_size = ntfs_device_block_size(volume);
     uint8_t* dst = (uint8_t*)buffer;
     uint64_t remaining = size;
     uint64_t relative = offset;
 
+    // Run'lar NTFS_READ_CHUNK_BYTES'lık parçalar halinde birlikte gönderilir,
+    // NTFS_READ_INFLIGHT dolunca sırayla beklenip kopyalanır
+    NTFSReadChunk chunks[NTFS_READ_INFLIGHT];
+    size_t inflight = 0;
+
+    // Aynı run'ın parçaları kuyrukta yeniden birleşir
+    BlockDevice* device = volume->backing_volume ? volume->backing_volume->device : volume->device;
+    BlockDevice_Plug(device);
+
     for (size_t i = 0; i < runlist->count && remaining > 0; ++i)
     {
         const NTFSDataRun* run = &runlist->runs[i];
@@ -1598,13 +1663,54 @@ static int64_t ntfs_read_from_runlist(NTFSNodeInfo* info,
         uint64_t in_run_remaining = run_bytes - in_run_offset;
         uint64_t chunk = MIN(in_run_remaining, remaining);
         uint64_t lcn_byte_offset = (uint64_t)run->lcn * volume->bytes_per_cluster + in_run_offset;
-        if (!ntfs_read_bytes(volume, lcn_byte_offset, dst, (size_t)chunk))
-            return -1;
-        dst += chunk;
-        remaining -= chunk;
+
+        while (chunk > 0)
+        {
+            uint64_t part = MIN(chunk, (uint64_t)NTFS_READ_CHUNK_BYTES);
+            uint64_t start_block = lcn_byte_offset / block_size;
+            uint64_t end_block = (lcn_byte_offset + part + block_size - 1) / block_size;
+
+            NTFSReadChunk* c = &chunks[inflight];
+            c->temp = (uint8_t*)malloc((size_t)((end_block - start_block) * block_size));
+            c->dst = dst;
+            c->skip = (size_t)(lcn_byte_offset - start_block * block_size);
+            c->bytes = (size_t)part;
+            if (!c->temp)
+            {
+                BlockDevice_Unplug(device);
+                (void)ntfs_read_chunks_finish(chunks, inflight);
+                return -1;
+            }
+            if (!ntfs_submit_blocks(volume, start_block, (uint32_t)(end_block - start_block), c->temp, &c->req))
+            {
+                free(c->temp);
+                BlockDevice_Unplug(device);
+                (void)ntfs_read_chunks_finish(chunks, inflight);
+                return -1;
+            }
+            inflight++;
+
+            if (inflight == NTFS_READ_INFLIGHT)
+            {
+                BlockDevice_Unplug(device);
+                bool ok = ntfs_read_chunks_finish(chunks, inflight);
+                inflight = 0;
+                if (!ok)
+                    return -1;
+                BlockDevice_Plug(device);
+            }
+
+            dst += part;
+            remaining -= part;
+            lcn_byte_offset += part;
+            chunk -= part;
+        }
         relative = 0;
     }
 
+    BlockDevice_Unplug(device);
+    if (!ntfs_read_chunks_finish(chunks, inflight))
+        return -1;
     return (int64_t)(size - remaining);
 }
 
@@ -78,18 +78,18 @@ static void ramfs_free_node(VFSNode* node)
     }
 
     if (node->name) free(node->name);
-    free(node);
+    VFS_FreeNode(node);
 }
 
 static VFSNode* ramfs_new_node(const char* name, VFSNodeType type)
 {
-    VFSNode* node = (VFSNode*)malloc(sizeof(VFSNode));
+    VFSNode* node = VFS_AllocNode();
     if (!node) return NULL;
 
     RamFSNode* payload = (RamFSNode*)malloc(sizeof(RamFSNode));
     if (!payload)
     {
-        free(node);
+        VFS_FreeNode(node);
         return NULL;
     }
 
@@ -100,7 +100,7 @@ static VFSNode* ramfs_new_node(const char* name, VFSNodeType type)
         if (!node_name)
         {
             free(payload);
-            free(node);
+            VFS_FreeNode(node);
             return NULL;
         }
     }
@@ -114,7 +114,7 @@ static VFSNode* ramfs_new_node(const char* name, VFSNodeType type)
     {
         if (node_name) free(node_name);
         free(payload);
-        free(node);
+        VFS_FreeNode(node);
         return NULL;
     }
 
@@ -0,0 +1,210 @@
+#include <arch.h>
+#include <debug/debug.h>
+#include <panic.h>
+#include <task/Thread.h>
+#include <smp/smp.h>
+
+#define CR4_OSFXSR        (1u << 9)
+#define CR4_OSXSAVE       (1u << 18)
+
+typedef enum {
+    FPU_SAVE_NONE = 0,   // FPU yok
+    FPU_SAVE_FNSAVE,     // yalnızca x87
+    FPU_SAVE_FXSAVE,     // x87 + SSE
+    FPU_SAVE_XSAVE,      // XCR0'daki tüm bileşenler
+    FPU_SAVE_XSAVEOPT,   // XSAVE + değişmemiş/başlangıç durumundaki bileşenleri atla
+} FpuSaveMethod;
+
+static const char* const s_method_names[] = { "none", "fnsave", "fxsave", "xsave", "xsaveopt" };
+
+// Her CPU'nun ve her iç içe seviyenin sabit alanı var: XSAVEOPT'un "modified"
+// optimizasyonu aynı adrese yapılan XRSTOR/XSAVEOPT çiftlerinde devreye girer.
+// BSP'ninki statik; AP'lerinki smp_start_ap'te ayrılır (PerCpu.fpu_nest_areas).
+static uint8_t s_bsp_nest_areas[FPU_NEST_BYTES] __attribute__((aligned(64)));
+
+static bool s_probed = false;
+static FpuSaveMethod s_method = FPU_SAVE_NONE;
+static uint64_t s_xcr0 = 0;
+static size_t s_state_size = 0;
+
+// IRQ giriş sarmalayıcısı (irq_fpu_call) bunu okur: 0 yok, 1 fnsave, 2 fxsave, 3 xsave.
+// XSAVEOPT yığın üzerindeki değişken adreste işe yaramaz, orada düz XSAVE kullanılır.
+uint32_t fpu_irq_method = 0;
+
+static inline void fpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d)
+{
+    __asm__ __volatile__("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(subleaf));
+}
+
+static inline size_t fpu_read_cr4(void)
+{
+    size_t cr4;
+    __asm__ __volatile__("mov %%cr4, %0" : "=r"(cr4));
+    return cr4;
+}
+
+static inline uint64_t fpu_xgetbv(uint32_t index)
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(index));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+void fpu_init(void)
+{
+    if (s_probed) return;
+    s_probed = true;
+
+    uint32_t a, b, c, d;
+    fpu_cpuid(1, 0, &a, &b, &c, &d);
+
+    size_t cr4 = fpu_read_cr4();
+
+    if (!(d & (1u << 0)))
+    {
+        s_method = FPU_SAVE_NONE;
+        s_state_size = 0;
+    }
+    else if (!(d & (1u << 24)) || !(cr4 & CR4_OSFXSR))
+    {
+        s_method = FPU_SAVE_FNSAVE;
+        s_state_size = 108;
+    }
+    else
+    {
+        s_method = FPU_SAVE_FXSAVE;
+        s_state_size = 512;
+    }
+
+    if ((c & (1u << 26)) && (cr4 & CR4_OSXSAVE))
+    {
+        s_xcr0 = fpu_xgetbv(0);
+
+        uint32_t max_leaf;
+        fpu_cpuid(0, 0, &max_leaf, &b, &c, &d);
+        if (max_leaf >= 0xD)
+        {
+            fpu_cpuid(0xD, 0, &a, &b, &c, &d);
+            size_t size = b; // XCR0'da açık bileşenler için gereken boyut
+
+            if (size <= FPU_AREA_SIZE)
+            {
+                fpu_cpuid(0xD, 1, &a, &b, &c, &d);
+                s_method = (a & (1u << 0)) ? FPU_SAVE_XSAVEOPT : FPU_SAVE_XSAVE;
+                s_state_size = size;
+            }
+            else
+            {
+                WARN("FPU: XSAVE area %zu bytes exceeds %u, using fxsave", size, FPU_AREA_SIZE);
+            }
+        }
+    }
+
+    fpu_irq_method = (s_method >= FPU_SAVE_XSAVE) ? 3u : (uint32_t)s_method;
+
+    LOG("FPU: save method %s, state %zu bytes, XCR0=0x%llx",
+        s_method_names[s_method], s_state_size, (unsigned long long)s_xcr0);
+}
+
+size_t fpu_state_size(void)
+{
+    fpu_init();
+    return s_state_size;
+}
+
+void fpu_save(void* area)
+{
+    uint32_t lo = (uint32_t)s_xcr0;
+    uint32_t hi = (uint32_t)(s_xcr0 >> 32);
+
+    switch (s_method)
+    {
+    case FPU_SAVE_XSAVEOPT:
+        __asm__ __volatile__("xsaveopt %0" : "+m"(*(uint8_t (*)[FPU_AREA_SIZE])area) : "a"(lo), "d"(hi));
+        break;
+    case FPU_SAVE_XSAVE:
+        __asm__ __volatile__("xsave %0" : "+m"(*(uint8_t (*)[FPU_AREA_SIZE])area) : "a"(lo), "d"(hi));
+        break;
+    case FPU_SAVE_FXSAVE:
+        __asm__ __volatile__("fxsave %0" : "=m"(*(uint8_t (*)[512])area));
+        break;
+    case FPU_SAVE_FNSAVE:
+        // fnsave x87'yi sıfırlar; çağıranın durumu korunsun diye geri yükle
+        __asm__ __volatile__("fnsave %0\n\tfrstor %0" : "+m"(*(uint8_t (*)[108])area));
+        break;
+    default:
+        break;
+    }
+}
+
+void fpu_restore(const void* area)
+{
+    uint32_t lo = (uint32_t)s_xcr0;
+    uint32_t hi = (uint32_t)(s_xcr0 >> 32);
+
+    switch (s_method)
+    {
+    case FPU_SAVE_XSAVEOPT:
+    case FPU_SAVE_XSAVE:
+        __asm__ __volatile__("xrstor %0" : : "m"(*(const uint8_t (*)[FPU_AREA_SIZE])area), "a"(lo), "d"(hi));
+        break;
+    case FPU_SAVE_FXSAVE:
+        __asm__ __volatile__("fxrstor %0" : : "m"(*(const uint8_t (*)[512])area));
+        break;
+    case FPU_SAVE_FNSAVE:
+        __asm__ __volatile__("frstor %0" : : "m"(*(const uint8_t (*)[108])area));
+        break;
+    default:
+        break;
+    }
+}
+
+static uint8_t* fpu_nest_area(PerCpu* cpu, uint32_t depth)
+{
+    if (!cpu->fpu_nest_areas)
+    {
+        if (cpu->id != 0)
+            PANIC("kernel_fpu_begin: AP has no FPU nesting area");
+        cpu->fpu_nest_areas = s_bsp_nest_areas;
+    }
+    return cpu->fpu_nest_areas + (size_t)depth * FPU_AREA_SIZE;
+}
+
+void kernel_fpu_begin(void)
+{
+    // İç içe alanlar CPU'ya ait; bölge bitene kadar thread başka CPU'ya/thread'e geçmemeli
+    preempt_disable();
+
+    size_t flags = arch_irq_save();
+
+    if (!s_probed) fpu_init();
+
+    PerCpu* cpu = this_cpu();
+    if (cpu->fpu_nest_depth >= FPU_MAX_NESTING)
+        PANIC("kernel_fpu_begin: nesting too deep");
+
+    // Kaydetme kesmeler kapalıyken yapılır; araya giren bir IRQ bir üst seviyeyi kullanır
+    fpu_save(fpu_nest_area(cpu, cpu->fpu_nest_depth));
+    cpu->fpu_nest_depth++;
+
+    arch_irq_restore(flags);
+}
+
+void kernel_fpu_end(void)
+{
+    size_t flags = arch_irq_save();
+
+    PerCpu* cpu = this_cpu();
+    if (cpu->fpu_nest_depth == 0)
+    {
+        WARN("kernel_fpu_end without kernel_fpu_begin");
+        arch_irq_restore(flags);
+        return;
+    }
+
+    cpu->fpu_nest_depth--;
+    fpu_restore(fpu_nest_area(cpu, cpu->fpu_nest_depth));
+
+    arch_irq_restore(flags);
+    preempt_enable();
+}
@@ -1,6 +1,7 @@
 #include <graphics/gfx.h>
 #include <list.h>
 #include <memory/memory.h>
+#include <memory/vmm.h>
 #include <boot/multiboot2.h>
 #include <stream/OutputStream.h>
 #include <math.h>
@@ -94,7 +95,7 @@ gfx_buffer* gfx_create_buffer(size_t width, size_t height)
 
     buffer->size.width = width;
     buffer->size.height = height;
-    buffer->buffer = malloc(width * height * sizeof(uint32_t)); // Assuming 32 bits per pixel
+    buffer->buffer = vmalloc(width * height * sizeof(uint32_t)); // Assuming 32 bits per pixel
 
     if (!buffer->buffer)
     {
@@ -117,7 +118,7 @@ void gfx_destroy_buffer(gfx_buffer *buffer)
     if (!buffer)
         return;
 
-    free(buffer->buffer);
+    vfree(buffer->buffer);
 
     // Remove from the list
     List_Remove(gfx_buffers, buffer);
@@ -573,7 +574,7 @@ bool gfx_resize_buffer(gfx_buffer* buffer, size_t newWidth, size_t newHeight)
     if (!buffer) return false;
     if (newWidth == 0 || newHeight == 0) return false;
 
-    void* newBuffer = malloc(newWidth * newHeight * (buffer->bpp / 8));
+    void* newBuffer = vmalloc(newWidth * newHeight * (buffer->bpp / 8));
     if (!newBuffer) return false;
 
     // Copy old content to new buffer
@@ -586,7 +587,7 @@ bool gfx_resize_buffer(gfx_buffer* buffer, size_t newWidth, size_t newHeight)
                copyWidth * (buffer->bpp / 8));
     }
 
-    free(buffer->buffer);
+    vfree(buffer->buffer);
     buffer->buffer = newBuffer;
     buffer->size.width = newWidth;
     buffer->size.height = newHeight;
@@ -0,0 +1,72 @@
+; AP başlangıç kodu (INIT-SIPI-SIPI). smp.c bu bloğu AP_BASE'e kopyalar,
+; ap_trampoline_params'ı doldurur ve SIPI vektörü olarak bu sayfayı gönderir.
+; Kod kopyalandığı adreste çalışır: tüm adresler AP_REL ile AP_BASE'e göre.
+;
+; Gerçek mod -> korumalı mod (geçici GDT); i386 çekirdeği sayfalamasız
+; çalıştığından doğrudan C girişine (PerCpu* yığında) kendi yığınıyla atlar.
+
+section .rodata
+
+%define AP_BASE 0x8000          ; SMP_TRAMPOLINE_ADDR (smp/smp.h) ile aynı
+%define AP_REL(x) (AP_BASE + (x) - ap_trampoline_start)
+
+global ap_trampoline_start
+global ap_trampoline_end
+global ap_trampoline_params
+
+align 16
+ap_trampoline_start:
+use16
+    cli
+    cld
+    mov ax, cs                  ; CS = AP_BASE >> 4, IP = 0
+    mov ds, ax
+
+    o32 lgdt [ap_gdtr - ap_trampoline_start]
+
+    mov eax, cr0
+    or eax, 1                   ; PE
+    mov cr0, eax
+    jmp dword 0x08:AP_REL(ap_pm32)
+
+use32
+ap_pm32:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+    mov fs, ax
+    mov gs, ax
+
+    mov esp, [AP_REL(ap_trampoline_params) + 8]
+    mov eax, [AP_REL(ap_trampoline_params) + 16]
+    and esp, -16
+    sub esp, 12                 ; call anında 16 bayt hizalı
+    push eax
+    xor ebp, ebp
+    call [AP_REL(ap_trampoline_params) + 24]    ; smp_ap_entry geri dönmez
+
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+align 8
+ap_gdt:
+    dq 0x0000000000000000       ; null
+    dq 0x00CF9A000000FFFF       ; 0x08: 32-bit kod
+    dq 0x00CF92000000FFFF       ; 0x10: veri
+ap_gdt_end:
+
+ap_gdtr:
+    dw ap_gdt_end - ap_gdt - 1
+    dd AP_REL(ap_gdt)
+
+; smp.c'deki ApTrampolineParams ile aynı düzen
+align 8
+ap_trampoline_params:
+    dq 0                        ; cr3 (kullanılmıyor)
+    dq 0                        ; yığın tepesi
+    dq 0                        ; PerCpu*
+    dq 0                        ; C giriş noktası
+ap_trampoline_end:
@@ -0,0 +1,49 @@
+section .text
+
+extern thread_bootstrap
+extern fiber_bootstrap
+
+; void arch_context_switch(size_t* old_sp, size_t new_sp)
+; Save callee-saved registers and EFLAGS on the current stack, store ESP into
+; *old_sp, switch to new_sp and pop the same frame there. Called with
+; interrupts disabled; the popped EFLAGS decides whether they come back on.
+global arch_context_switch
+arch_context_switch:
+	mov eax, [esp+4]       ; old_sp
+	mov edx, [esp+8]       ; new_sp
+
+	pushfd
+	push ebp
+	push ebx
+	push esi
+	push edi
+
+	mov [eax], esp
+	mov esp, edx
+
+	pop edi
+	pop esi
+	pop ebx
+	pop ebp
+	popfd
+	ret
+
+; First "return" target of a new thread (frame built by thread_create)
+global arch_thread_trampoline
+arch_thread_trampoline:
+	xor ebp, ebp           ; end of frame chain for backtraces
+	and esp, -16
+	call thread_bootstrap
+.hang:
+	hlt                    ; thread_bootstrap never returns
+	jmp .hang
+
+; First "return" target of a new fiber (frame built by fiber_create)
+global arch_fiber_trampoline
+arch_fiber_trampoline:
+	xor ebp, ebp
+	and esp, -16
+	call fiber_bootstrap
+.hang:
+	hlt                    ; fiber_bootstrap never returns
+	jmp .hang
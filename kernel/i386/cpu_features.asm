@@ -1,26 +1,131 @@
 section .bss
 
-; Global flag indicating ERMS support (0/1)
+; Global flags consumed by memcpy.asm (0/1)
 global erms_supported
+global fsrm_supported
+global mem_simd_level
 erms_supported: resb 1
+fsrm_supported: resb 1
+; 0: scalar only, 1: SSE2, 2: AVX2 (only when the OS-side enable bits are set)
+mem_simd_level: resb 1
+
+section .data
+
+; Copies/fills at least this large use non-temporal stores (bypass the cache)
+global mem_nt_threshold
+mem_nt_threshold: dd 0x100000
 
 section .text
 use32
 
-; void detect_erms(void)
-; Detect ERMS via CPUID.(EAX=7,ECX=0):EBX[9]
-; Writes 0/1 into erms_supported and returns it in EAX
-global detect_erms
-detect_erms:
+; uint32_t detect_cpu_features(void)
+; Detect ERMS/FSRM (leaf 7) and the usable SIMD level (SSE2 + CR4.OSFXSR,
+; AVX2 + OSXSAVE + XCR0). Writes the flags above and returns erms_supported
+; in EAX. Safe to call again once the kernel changes CR4/XCR0.
+global detect_cpu_features
+detect_cpu_features:
     push    ebx                ; preserve callee-saved
+    push    esi
+    push    edi
+
     xor     eax, eax
+    cpuid
+    mov     edi, eax           ; highest basic leaf
+
+    xor     esi, esi           ; leaf 7 EBX
+    xor     edx, edx           ; leaf 7 EDX
+    cmp     edi, 7
+    jb      .no_leaf7
     mov     eax, 7             ; leaf 7
     xor     ecx, ecx           ; subleaf 0
     cpuid
-    ; Check EBX bit 9
-    bt      ebx, 9
-    setc    al
-    mov     byte [erms_supported], al
-    movzx   eax, al
+    mov     esi, ebx
+.no_leaf7:
+
+    bt      esi, 9
+    setc    byte [erms_supported]
+    bt      edx, 4
+    setc    byte [fsrm_supported]
+
+    mov     eax, 1
+    cpuid
+    mov     edi, ecx           ; leaf 1 ECX
+    xor     ebx, ebx           ; SIMD level
+
+    bt      edx, 26            ; SSE2
+    jnc     .done
+    mov     eax, cr4
+    bt      eax, 9             ; CR4.OSFXSR
+    jnc     .done
+    mov     ebx, 1
+
+    bt      edi, 27            ; OSXSAVE
+    jnc     .done
+    bt      edi, 28            ; AVX
+    jnc     .done
+    bt      esi, 5             ; AVX2
+    jnc     .done
+    xor     ecx, ecx
+    xgetbv                     ; XCR0 -> EDX:EAX
+    and     eax, 6
+    cmp     eax, 6             ; SSE and AVX state enabled
+    jne     .done
+    mov     ebx, 2
+
+.done:
+    mov     byte [mem_simd_level], bl
+    movzx   eax, byte [erms_supported]
+    pop     edi
+    pop     esi
+    pop     ebx
+    ret
+
+; void enable_cpu_simd(void)
+; Turn on x87/SSE for kernel code and, when XSAVE exists, AVX state as well:
+; - CR0: MP=1, EM=0, TS=0 (no #NM traps, FWAIT honours TS)
+; - CR4: OSFXSR | OSXMMEXCPT (SSE, unmasked SIMD FP exceptions -> #XM)
+; - CR4.OSXSAVE + XCR0 = x87 | SSE (| AVX when CPUID.1:ECX[28])
+; AVX-512 state is intentionally left disabled so the XSAVE area stays small.
+; Call detect_cpu_features afterwards so memcpy sees the new SIMD level.
+global enable_cpu_simd
+enable_cpu_simd:
+    push    ebx
+
+    mov     eax, 1
+    cpuid
+
+    bt      edx, 0             ; FPU
+    jnc     .es_done
+    mov     eax, cr0
+    and     eax, ~((1 << 2) | (1 << 3)) ; EM=0, TS=0
+    or      eax, (1 << 1) | (1 << 5)    ; MP=1, NE=1
+    mov     cr0, eax
+    fninit
+
+    bt      edx, 24            ; FXSR
+    jnc     .es_done
+    bt      edx, 25            ; SSE
+    jnc     .es_done
+    mov     eax, cr4
+    or      eax, (1 << 9) | (1 << 10) ; OSFXSR, OSXMMEXCPT
+    mov     cr4, eax
+
+    bt      ecx, 26            ; XSAVE
+    jnc     .es_done
+    mov     eax, cr4
+    or      eax, (1 << 18)    ; OSXSAVE
+    mov     cr4, eax
+
+    mov     ebx, ecx
+    mov     eax, 3             ; x87 | SSE
+    bt      ebx, 28            ; AVX
+    jnc     .es_xcr0
+    or      eax, 4             ; AVX (YMM upper halves)
+.es_xcr0:
+    xor     edx, edx
+    xor     ecx, ecx
+    xsetbv
+
+.es_done:
     pop     ebx
     ret
@@ -0,0 +1,58 @@
+// Per-CPU GDT/TSS (i386): boot GDT'nin kopyası + çekirdeğe ait TSS ve FS için per-CPU veri segmenti
+#include <arch.h>
+#include <memory/memory.h>
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) gdt_ptr32_t;
+
+extern uint64_t gdt_i386[];
+extern gdt_ptr32_t gdtr_i386;
+extern uint8_t idt_ptr[];
+
+static uint64_t __make_descriptor(uint32_t base, uint32_t limit, uint8_t access, uint8_t flags)
+{
+    return (uint64_t)(limit & 0xFFFFu)
+         | ((uint64_t)(base & 0xFFFFFFu) << 16)
+         | ((uint64_t)access << 40)
+         | ((uint64_t)((limit >> 16) & 0xFu) << 48)
+         | ((uint64_t)(flags & 0xFu) << 52)
+         | ((uint64_t)((base >> 24) & 0xFFu) << 56);
+}
+
+void arch_cpu_tables_load(arch_cpu_tables_t* tables, void* percpu)
+{
+    size_t boot_entries = ((size_t)gdtr_i386.limit + 1) / 8;
+    if (boot_entries > ARCH_GDT_ENTRIES) boot_entries = ARCH_GDT_ENTRIES;
+
+    memset(tables, 0, sizeof(*tables));
+    memcpy(tables->gdt, gdt_i386, boot_entries * 8);
+
+    tables->tss.ss0 = 0x10;
+    tables->tss.iomap_base = (uint16_t)sizeof(arch_tss_t); // I/O izin haritası yok
+
+    // 0x89: present, 32-bit TSS (available); 0x92: ring 0 veri, 4 KiB granül (0xC)
+    tables->gdt[ARCH_GDT_TSS_SEL / 8] =
+        __make_descriptor((uint32_t)(uintptr_t)&tables->tss, (uint32_t)sizeof(arch_tss_t) - 1, 0x89, 0x0);
+    tables->gdt[ARCH_GDT_PERCPU_SEL / 8] =
+        __make_descriptor((uint32_t)(uintptr_t)percpu, 0xFFFFFu, 0x92, 0xC);
+
+    gdt_ptr32_t gdtr = { .limit = (uint16_t)(sizeof(tables->gdt) - 1), .base = (uint32_t)(uintptr_t)tables->gdt };
+    __asm__ __volatile__("lgdt %0" : : "m"(gdtr) : "memory");
+
+    __asm__ __volatile__(
+        "ljmp $0x08, $1f\n"
+        "1:\n\t"
+        "movw $0x10, %%ax\n\t"
+        "movw %%ax, %%ds\n\t"
+        "movw %%ax, %%es\n\t"
+        "movw %%ax, %%ss\n\t"
+        "movw %%ax, %%gs\n\t"
+        "movw %0, %%ax\n\t"
+        "movw %%ax, %%fs\n\t"
+        : : "i"(ARCH_GDT_PERCPU_SEL) : "eax", "memory");
+
+    __asm__ __volatile__("ltr %w0" : : "r"((uint16_t)ARCH_GDT_TSS_SEL));
+    __asm__ __volatile__("lidt (%0)" : : "r"(idt_ptr) : "memory");
+}
@@ -0,0 +1,75 @@
+section .text
+
+global irq_fpu_call
+extern fpu_irq_method
+
+use32
+
+; Vector state save around an IRQ handler.
+;
+; gcc is free to use x87/SSE registers in kernel code, and IRQ handlers
+; interrupt arbitrary code, so every IRQ stub calls its C handler through
+; here instead of calling it directly. The state is saved on the current
+; stack (not in a per-CPU area) because the timer handler may switch
+; threads before returning; each interrupted context keeps its own copy.
+;
+; fpu_irq_method is set by fpu_init: 0 none, 1 fnsave, 2 fxsave, 3 xsave.
+
+IRQ_FPU_AREA  equ 1024          ; FPU_AREA_SIZE, aligned to 64 below
+
+; void irq_fpu_call(handler [EAX])
+; Caller-saved general-purpose registers are the stub's responsibility.
+irq_fpu_call:
+	push    ebp
+	push    ebx
+	mov     ebp, esp
+	mov     ebx, eax
+
+	sub     esp, IRQ_FPU_AREA
+	and     esp, -64
+
+	mov     ecx, [fpu_irq_method]
+	cmp     ecx, 3
+	jae     .xsave
+	cmp     ecx, 2
+	je      .fxsave
+	cmp     ecx, 1
+	je      .fnsave
+	call    ebx
+	jmp     .done
+
+.xsave:
+	; XRSTOR rejects a header with XCOMP_BV or reserved bytes set, and
+	; XSAVE only writes XSTATE_BV, so clear the 64-byte header first
+	push    edi
+	lea     edi, [esp + 4 + 512]
+	xor     eax, eax
+	mov     ecx, 16
+	cld
+	rep stosd
+	pop     edi
+	mov     eax, -1             ; every component enabled in XCR0
+	mov     edx, -1
+	xsave   [esp]
+	call    ebx
+	mov     eax, -1
+	mov     edx, -1
+	xrstor  [esp]
+	jmp     .done
+
+.fxsave:
+	fxsave  [esp]
+	call    ebx
+	fxrstor [esp]
+	jmp     .done
+
+.fnsave:
+	fnsave  [esp]               ; also reinitialises the x87 unit for the handler
+	call    ebx
+	frstor  [esp]
+
+.done:
+	mov     esp, ebp
+	pop     ebx
+	pop     ebp
+	ret
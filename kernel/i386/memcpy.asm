@@ -1,10 +1,33 @@
 section .text
 
 global memcpy
+global memmove
+global memset
 extern erms_supported
+extern fsrm_supported
+extern mem_simd_level
+extern mem_nt_threshold
 
 use32
 
+; Path selection (flags are filled by detect_cpu_features at boot):
+;   n < MEM_SIMD_MIN          -> rep movsb/stosb with FSRM, otherwise a dword loop
+;   n >= mem_nt_threshold     -> SSE2/AVX2 loop with non-temporal stores
+;   ERMS                      -> rep movsb/stosb
+;   SSE2/AVX2                 -> vector loop with aligned stores
+;   otherwise                 -> rep movsd/stosd
+;
+; The vector registers used here are caller-saved in the C ABI, and IRQ
+; handlers run through irq_fpu_call, which saves the interrupted vector state,
+; so the SIMD paths clobber xmm0-3/ymm0-3 freely. The AVX2 paths end with
+; vzeroupper to avoid SSE/AVX transition stalls in the caller.
+;
+; All three entry points push EDI, ESI, EBX and leave through mem_ret32, so
+; the SIMD helpers below are entered with jmp and share that epilogue.
+
+MEM_SIMD_MIN      equ 256
+MEM_MOVE_MIN_DIST equ 128       ; overlapping moves need at least one block of distance
+
 ; void* memcpy(void* dest [ESP+4], const void* src [ESP+8], size_t n [ESP+12])
 memcpy:
 	push    edi
@@ -13,55 +36,521 @@ memcpy:
 
 	mov     edi, [esp+16]     ; dest
 	mov     esi, [esp+20]     ; src
-	mov     ecx, [esp+24]     ; n
+	mov     edx, [esp+24]     ; n
 	mov     eax, edi          ; return dest in EAX
+	cld
+
+	test    edx, edx
+	jz      mem_ret32
 
-	test    ecx, ecx
-	jz      .ret
+	cmp     edx, MEM_SIMD_MIN
+	jb      .cpy_small
 
-	; If ERMS supported, prefer rep movsb for all sizes
+	cmp     byte [mem_simd_level], 0
+	je      .cpy_scalar
+
+	xor     ebx, ebx          ; EBX = 0: regular stores
+	cmp     edx, [mem_nt_threshold]
+	jae     .cpy_nt
 	cmp     byte [erms_supported], 0
-	je      .no_erms
+	jne     .cpy_movsb
+	jmp     .cpy_simd
+.cpy_nt:
+	mov     ebx, 1            ; EBX = 1: non-temporal stores
+.cpy_simd:
+	cmp     byte [mem_simd_level], 2
+	je      mem_copy_fwd_avx2
+	jmp     mem_copy_fwd_sse2
+
+.cpy_small:
+	cmp     byte [fsrm_supported], 0
+	jne     .cpy_movsb
+	mov     ecx, edx
+	shr     ecx, 2            ; dword count
+	jz      .cpy_tail
+.cpy_dloop:
+	mov     ebx, [esi]
+	mov     [edi], ebx
+	add     esi, 4
+	add     edi, 4
+	dec     ecx
+	jnz     .cpy_dloop
+.cpy_tail:
+	mov     ecx, edx
+	and     ecx, 3
 	rep     movsb
-	jmp     .ret
+	jmp     mem_ret32
 
-.no_erms:
-	cmp     ecx, 32
-	jb      .small
+.cpy_movsb:
+	mov     ecx, edx
+	rep     movsb
+	jmp     mem_ret32
+
+.cpy_scalar:
+	cmp     byte [erms_supported], 0
+	jne     .cpy_movsb
 
 	; If src and dst share 4-byte alignment, align to 4 first
 	mov     ebx, edi
 	xor     ebx, esi
 	test    ebx, 3
-	jne     .bulk
+	jne     .cpy_bulk
 
-	; Align dest to 4 bytes
-	mov     ebx, edi
-	and     ebx, 3
-	jz      .bulk
-	mov     edx, 4
-	sub     edx, ebx           ; bytes to reach 4-byte alignment
-	cmp     edx, ecx
-	cmova   edx, ecx
-	mov     ecx, edx
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 3            ; bytes to reach 4-byte alignment
+	sub     edx, ecx
 	rep     movsb
-	mov     ecx, [esp+24]
-	sub     ecx, edx
 
-.bulk:
-	mov     edx, ecx
-	shr     ecx, 2             ; dword count
+.cpy_bulk:
+	mov     ecx, edx
+	shr     ecx, 2            ; dword count
 	rep     movsd
 	mov     ecx, edx
-	and     ecx, 3             ; tail bytes
+	and     ecx, 3            ; tail bytes
 	rep     movsb
-	jmp     .ret
+	jmp     mem_ret32
+
+; void* memmove(void* dest [ESP+4], const void* src [ESP+8], size_t n [ESP+12])
+memmove:
+	push    edi
+	push    esi
+	push    ebx
+
+	mov     edi, [esp+16]
+	mov     esi, [esp+20]
+	mov     edx, [esp+24]
+	mov     eax, edi
+	cld
 
-.small:
+	test    edx, edx
+	jz      mem_ret32
+	mov     ecx, edi
+	sub     ecx, esi          ; ECX = dst - src
+	jz      mem_ret32
+	cmp     ecx, edx
+	jb      .mv_backward      ; src < dst < src + n: copy from the end
+
+	; Forward copy. Without overlap, or with at least one SIMD block of
+	; distance, every memcpy path is safe.
+	mov     ecx, esi
+	sub     ecx, edi          ; src - dst
+	cmp     ecx, edx
+	jae     .mv_forward
+	cmp     ecx, MEM_MOVE_MIN_DIST
+	jae     .mv_forward
+	mov     ecx, edx
 	rep     movsb
+	jmp     mem_ret32
+
+.mv_forward:
+	; Re-enter memcpy with the original arguments
+	pop     ebx
+	pop     esi
+	pop     edi
+	jmp     memcpy
+
+.mv_backward:
+	cmp     edx, MEM_SIMD_MIN
+	jb      .mv_back_scalar
+	cmp     ecx, MEM_MOVE_MIN_DIST
+	jb      .mv_back_scalar
+	mov     ebx, esi          ; src start for the SIMD tail
+	cmp     byte [mem_simd_level], 2
+	je      mem_copy_bwd_avx2
+	cmp     byte [mem_simd_level], 1
+	je      mem_copy_bwd_sse2
+
+.mv_back_scalar:
+	; Descending loop instead of std/rep movs: DF must stay clear, an IRQ or
+	; a preemption here would otherwise run C code with DF=1
+	cmp     ecx, 4
+	jb      .mv_back_bytes
+.mv_back_dwords:
+	cmp     edx, 4
+	jb      .mv_back_bytes
+	sub     edx, 4
+	mov     ebx, [esi+edx]
+	mov     [edi+edx], ebx
+	jmp     .mv_back_dwords
+.mv_back_bytes:
+	test    edx, edx
+	jz      mem_ret32
+	dec     edx
+	mov     bl, [esi+edx]
+	mov     [edi+edx], bl
+	jmp     .mv_back_bytes
+
+; void* memset(void* ptr [ESP+4], int value [ESP+8], size_t n [ESP+12])
+memset:
+	push    edi
+	push    esi
+	push    ebx
+
+	mov     edi, [esp+16]
+	movzx   eax, byte [esp+20]
+	imul    eax, eax, 0x01010101 ; byte pattern in every lane
+	mov     edx, [esp+24]
+	cld
+
+	test    edx, edx
+	jz      .set_ret
+
+	cmp     edx, MEM_SIMD_MIN
+	jb      .set_small
+
+	cmp     byte [mem_simd_level], 0
+	je      .set_scalar
+
+	xor     ebx, ebx
+	cmp     edx, [mem_nt_threshold]
+	jae     .set_nt
+	cmp     byte [erms_supported], 0
+	jne     .set_stosb
+	jmp     .set_simd
+.set_nt:
+	mov     ebx, 1
+.set_simd:
+	cmp     byte [mem_simd_level], 2
+	je      mem_set_avx2
+	jmp     mem_set_sse2
+
+.set_small:
+	cmp     byte [fsrm_supported], 0
+	jne     .set_stosb
+	mov     ecx, edx
+	shr     ecx, 2
+	rep     stosd
+	mov     ecx, edx
+	and     ecx, 3
+	rep     stosb
+	jmp     .set_ret
+
+.set_stosb:
+	mov     ecx, edx
+	rep     stosb
+	jmp     .set_ret
+
+.set_scalar:
+	cmp     byte [erms_supported], 0
+	jne     .set_stosb
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 3            ; bytes to reach 4-byte alignment
+	sub     edx, ecx
+	rep     stosb
+	mov     ecx, edx
+	shr     ecx, 2
+	rep     stosd
+	mov     ecx, edx
+	and     ecx, 3
+	rep     stosb
+
+.set_ret:
+	mov     eax, [esp+16]     ; return ptr
 
-.ret:
+mem_ret32:
 	pop     ebx
 	pop     esi
 	pop     edi
 	ret
+
+; ---------------------------------------------------------------------------
+; SIMD helpers (entered by jmp, leave through mem_ret32).
+;   copy: EDI dst, ESI src, EDX n (>= MEM_SIMD_MIN), EBX = 1 for NT stores,
+;         EAX return value (backward copies also use it as the dst start
+;         and EBX as the src start)
+;   set : EDI dst, EDX n (>= MEM_SIMD_MIN), EAX pattern, EBX = 1 for NT
+; The unaligned head/tail blocks may rewrite bytes the loop already stored;
+; memmove only enters with at least MEM_MOVE_MIN_DIST bytes between buffers,
+; so those re-reads never see bytes overwritten by this call.
+; ---------------------------------------------------------------------------
+
+mem_copy_fwd_sse2:
+	; Head: 16 unaligned bytes, then bring dst up to a 16-byte boundary
+	movdqu  xmm0, [esi]
+	movdqu  [edi], xmm0
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 15
+	add     edi, ecx
+	add     esi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 6            ; 64-byte blocks
+	test    ebx, ebx
+	jnz     .fs_nt_loop
+.fs_loop:
+	movdqu  xmm0, [esi]
+	movdqu  xmm1, [esi+16]
+	movdqu  xmm2, [esi+32]
+	movdqu  xmm3, [esi+48]
+	movdqa  [edi], xmm0
+	movdqa  [edi+16], xmm1
+	movdqa  [edi+32], xmm2
+	movdqa  [edi+48], xmm3
+	add     esi, 64
+	add     edi, 64
+	dec     ecx
+	jnz     .fs_loop
+	jmp     .fs_tail
+.fs_nt_loop:
+	movdqu  xmm0, [esi]
+	movdqu  xmm1, [esi+16]
+	movdqu  xmm2, [esi+32]
+	movdqu  xmm3, [esi+48]
+	movntdq [edi], xmm0
+	movntdq [edi+16], xmm1
+	movntdq [edi+32], xmm2
+	movntdq [edi+48], xmm3
+	add     esi, 64
+	add     edi, 64
+	dec     ecx
+	jnz     .fs_nt_loop
+	sfence
+
+.fs_tail:
+	; Last 64 bytes, ending exactly at dst + n
+	and     edx, 63
+	add     esi, edx
+	add     edi, edx
+	movdqu  xmm0, [esi-64]
+	movdqu  xmm1, [esi-48]
+	movdqu  xmm2, [esi-32]
+	movdqu  xmm3, [esi-16]
+	movdqu  [edi-64], xmm0
+	movdqu  [edi-48], xmm1
+	movdqu  [edi-32], xmm2
+	movdqu  [edi-16], xmm3
+
+	jmp     mem_ret32
+
+mem_copy_fwd_avx2:
+	vmovdqu ymm0, [esi]
+	vmovdqu [edi], ymm0
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 31
+	add     edi, ecx
+	add     esi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 7            ; 128-byte blocks
+	test    ebx, ebx
+	jnz     .fa_nt_loop
+.fa_loop:
+	vmovdqu ymm0, [esi]
+	vmovdqu ymm1, [esi+32]
+	vmovdqu ymm2, [esi+64]
+	vmovdqu ymm3, [esi+96]
+	vmovdqa [edi], ymm0
+	vmovdqa [edi+32], ymm1
+	vmovdqa [edi+64], ymm2
+	vmovdqa [edi+96], ymm3
+	add     esi, 128
+	add     edi, 128
+	dec     ecx
+	jnz     .fa_loop
+	jmp     .fa_tail
+.fa_nt_loop:
+	vmovdqu ymm0, [esi]
+	vmovdqu ymm1, [esi+32]
+	vmovdqu ymm2, [esi+64]
+	vmovdqu ymm3, [esi+96]
+	vmovntdq [edi], ymm0
+	vmovntdq [edi+32], ymm1
+	vmovntdq [edi+64], ymm2
+	vmovntdq [edi+96], ymm3
+	add     esi, 128
+	add     edi, 128
+	dec     ecx
+	jnz     .fa_nt_loop
+	sfence
+
+.fa_tail:
+	and     edx, 127
+	add     esi, edx
+	add     edi, edx
+	vmovdqu ymm0, [esi-128]
+	vmovdqu ymm1, [esi-96]
+	vmovdqu ymm2, [esi-64]
+	vmovdqu ymm3, [esi-32]
+	vmovdqu [edi-128], ymm0
+	vmovdqu [edi-96], ymm1
+	vmovdqu [edi-64], ymm2
+	vmovdqu [edi-32], ymm3
+
+	vzeroupper
+	jmp     mem_ret32
+
+; Backward copies (memmove with src < dst < src + n), walking down from the end
+mem_copy_bwd_sse2:
+	add     edi, edx
+	add     esi, edx
+
+	movdqu  xmm0, [esi-16]
+	movdqu  [edi-16], xmm0
+	mov     ecx, edi
+	and     ecx, 15           ; bring the dst end down to 16 bytes
+	sub     edi, ecx
+	sub     esi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 6
+.bs_loop:
+	movdqu  xmm0, [esi-16]
+	movdqu  xmm1, [esi-32]
+	movdqu  xmm2, [esi-48]
+	movdqu  xmm3, [esi-64]
+	movdqa  [edi-16], xmm0
+	movdqa  [edi-32], xmm1
+	movdqa  [edi-48], xmm2
+	movdqa  [edi-64], xmm3
+	sub     esi, 64
+	sub     edi, 64
+	dec     ecx
+	jnz     .bs_loop
+
+	; First 64 bytes of the buffer
+	movdqu  xmm0, [ebx]
+	movdqu  xmm1, [ebx+16]
+	movdqu  xmm2, [ebx+32]
+	movdqu  xmm3, [ebx+48]
+	movdqu  [eax], xmm0
+	movdqu  [eax+16], xmm1
+	movdqu  [eax+32], xmm2
+	movdqu  [eax+48], xmm3
+
+	jmp     mem_ret32
+
+mem_copy_bwd_avx2:
+	add     edi, edx
+	add     esi, edx
+
+	vmovdqu ymm0, [esi-32]
+	vmovdqu [edi-32], ymm0
+	mov     ecx, edi
+	and     ecx, 31
+	sub     edi, ecx
+	sub     esi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 7
+.ba_loop:
+	vmovdqu ymm0, [esi-32]
+	vmovdqu ymm1, [esi-64]
+	vmovdqu ymm2, [esi-96]
+	vmovdqu ymm3, [esi-128]
+	vmovdqa [edi-32], ymm0
+	vmovdqa [edi-64], ymm1
+	vmovdqa [edi-96], ymm2
+	vmovdqa [edi-128], ymm3
+	sub     esi, 128
+	sub     edi, 128
+	dec     ecx
+	jnz     .ba_loop
+
+	vmovdqu ymm0, [ebx]
+	vmovdqu ymm1, [ebx+32]
+	vmovdqu ymm2, [ebx+64]
+	vmovdqu ymm3, [ebx+96]
+	vmovdqu [eax], ymm0
+	vmovdqu [eax+32], ymm1
+	vmovdqu [eax+64], ymm2
+	vmovdqu [eax+96], ymm3
+
+	vzeroupper
+	jmp     mem_ret32
+
+mem_set_sse2:
+	movd    xmm0, eax
+	pshufd  xmm0, xmm0, 0
+
+	lea     esi, [edi+edx]    ; end
+	movdqu  [edi], xmm0
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 15
+	add     edi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 6
+	test    ebx, ebx
+	jnz     .ss_nt_loop
+.ss_loop:
+	movdqa  [edi], xmm0
+	movdqa  [edi+16], xmm0
+	movdqa  [edi+32], xmm0
+	movdqa  [edi+48], xmm0
+	add     edi, 64
+	dec     ecx
+	jnz     .ss_loop
+	jmp     .ss_tail
+.ss_nt_loop:
+	movntdq [edi], xmm0
+	movntdq [edi+16], xmm0
+	movntdq [edi+32], xmm0
+	movntdq [edi+48], xmm0
+	add     edi, 64
+	dec     ecx
+	jnz     .ss_nt_loop
+	sfence
+
+.ss_tail:
+	movdqu  [esi-64], xmm0
+	movdqu  [esi-48], xmm0
+	movdqu  [esi-32], xmm0
+	movdqu  [esi-16], xmm0
+
+	mov     eax, [esp+16]     ; return ptr
+	jmp     mem_ret32
+
+mem_set_avx2:
+	vmovd   xmm0, eax
+	vpbroadcastd ymm0, xmm0
+
+	lea     esi, [edi+edx]
+	vmovdqu [edi], ymm0
+	mov     ecx, edi
+	neg     ecx
+	and     ecx, 31
+	add     edi, ecx
+	sub     edx, ecx
+
+	mov     ecx, edx
+	shr     ecx, 7
+	test    ebx, ebx
+	jnz     .sa_nt_loop
+.sa_loop:
+	vmovdqa [edi], ymm0
+	vmovdqa [edi+32], ymm0
+	vmovdqa [edi+64], ymm0
+	vmovdqa [edi+96], ymm0
+	add     edi, 128
+	dec     ecx
+	jnz     .sa_loop
+	jmp     .sa_tail
+.sa_nt_loop:
+	vmovntdq [edi], ymm0
+	vmovntdq [edi+32], ymm0
+	vmovntdq [edi+64], ymm0
+	vmovntdq [edi+96], ymm0
+	add     edi, 128
+	dec     ecx
+	jnz     .sa_nt_loop
+	sfence
+
+.sa_tail:
+	vmovdqu [esi-128], ymm0
+	vmovdqu [esi-96], ymm0
+	vmovdqu [esi-64], ymm0
+	vmovdqu [esi-32], ymm0
+
+	vzeroupper
+	mov     eax, [esp+16]     ; return ptr
+	jmp     mem_ret32
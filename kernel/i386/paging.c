@@ -435,3 +435,27 @@ bool arch_paging_map_with_type(uintptr_t phys_start, uintptr_t virt_start, size_
     }
     return true;
 }
+
+/* i386 kernel runs with paging disabled, so there is no separate VA window:
+ * vmalloc falls back to physically contiguous PMM blocks. */
+bool arch_vmm_get_window(uintptr_t* out_start, uintptr_t* out_end) {
+    (void)out_start; (void)out_end;
+    return false;
+}
+
+bool arch_vmm_map_pages(uintptr_t virt, const uintptr_t* phys_pages, size_t count,
+                        arch_paging_memtype_t type) {
+    (void)virt; (void)phys_pages; (void)count; (void)type;
+    return false;
+}
+
+void arch_vmm_unmap_pages(uintptr_t virt, size_t count, uintptr_t* out_phys) {
+    (void)virt;
+    if (out_phys) {
+        for (size_t i = 0; i < count; ++i) out_phys[i] = 0;
+    }
+}
+
+uintptr_t arch_vmm_translate(uintptr_t virt) {
+    return virt;
+}
@@ -7,7 +7,8 @@ extern idt_init
 extern idt_ptr
 extern __boot_kernel_start
 extern gdtr_i386
-extern detect_erms
+extern detect_cpu_features
+extern enable_cpu_simd
 extern __stack_end
 
 extern page_directory
@@ -38,8 +39,10 @@ _start:
 
     lidt [idt_ptr] ; Load IDT pointer
 
-    ; Detect CPU features (ERMS)
-    call detect_erms
+    ; Enable x87/SSE/AVX state (CR0/CR4/XCR0), then detect CPU features
+    ; (ERMS/FSRM/SSE2/AVX2) so memcpy can pick the SIMD paths
+    call enable_cpu_simd
+    call detect_cpu_features
     
     ; Enable disable by clearing the PG bit in CR0
     mov eax, cr0 ; Read CR0
@@ -1,6 +1,19 @@
 #include <memory/memory.h>
+#include <memory/slab.h>
 #include <list.h>
 
+// ListNode'lar cok sik ve hep ayni boyutta tahsis edilir; slab cache'ten gelir
+static KmemCache* s_list_node_cache = NULL;
+
+static ListNode* list_node_alloc(void) {
+	KmemCache* cache = kmem_cache_get(&s_list_node_cache, "ListNode", sizeof(ListNode), 0);
+	return cache ? (ListNode*)kmem_cache_alloc(cache) : NULL;
+}
+
+static void list_node_free(ListNode* node) {
+	kmem_cache_free(s_list_node_cache, node);
+}
+
 void List_Init(List* list) {
 	if (!list) return;
 	list->head = NULL;
@@ -23,7 +36,7 @@ void List_Destroy(List* list, bool freeData) {
 
 void List_Add(List* self, void* item) {
 	if (!self) return;
-	ListNode* node = (ListNode*)malloc(sizeof(ListNode));
+	ListNode* node = list_node_alloc();
 	if (!node) return; // out of memory, sessizce düş
 	node->data = item;
 	node->next = NULL;
@@ -57,7 +70,7 @@ bool List_RemoveAt(List* self, size_t index) {
 		if (self->tail == cur) self->tail = prev;
 	}
 
-	free(cur);
+	list_node_free(cur);
 	self->count--;
 	return true;
 }
@@ -79,7 +92,7 @@ bool List_Remove(List* self, void* item) {
 				prev->next = cur->next;
 				if (self->tail == cur) self->tail = prev;
 			}
-			free(cur);
+			list_node_free(cur);
 			self->count--;
 			return true;
 		}
@@ -115,7 +128,7 @@ bool List_InsertAt(List* self, size_t index, void* item) {
 		return true;
 	}
 
-	ListNode* node = (ListNode*)malloc(sizeof(ListNode));
+	ListNode* node = list_node_alloc();
 	if (!node) return false;
 	node->data = item;
 
@@ -144,7 +157,7 @@ void List_Clear(List* self, bool freeData) {
 		if (freeData && n->data) {
 			free(n->data);
 		}
-		free(n);
+		list_node_free(n);
 		n = next;
 	}
 	self->head = self->tail = NULL;
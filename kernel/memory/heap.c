@@ -4,18 +4,90 @@
 #include <efi/efi.h>
 #include <list.h>
 #include <debug/debug.h>
-
-#define HEAP_MAGIC 0xDEADBEEF
-#define HEAP_NODE_MIN_SIZE (sizeof(size_t) * 2)
-
-typedef struct HeapNode
+#include <debug/uart.h>
+#include <arch.h>
+
+/*
+ * TLSF (Two-Level Segregated Fit) heap.
+ *
+ * Her blogun basinda fiziksel olarak onceki bloga isaret eden bir pointer ve
+ * boyut alani vardir (boundary tag). Serbest bloklar boyutlarina gore iki
+ * seviyeli bir tabloda (fl: 2'nin kuvveti, sl: o araligin 16 alt dilimi)
+ * tutulur; hangi listelerin dolu oldugu bitmap'lerden okunur. Boylece hem
+ * tahsis hem serbest birakma (iki komsuyla birlestirme dahil) O(1) calisir.
+ *
+ * Tum heap bolgeleri (linker'in verdigi local heap, heap_register_region ile
+ * eklenenler ve PMM'den buyutulenler) ayni kontrol yapisini paylasir. Her
+ * bolgenin sonunda boyutu 0 olan, hic serbest olmayan bir sentinel blok
+ * bulunur; bu sayede bolge sinirlari asla birlestirilmez.
+ */
+
+typedef struct HeapBlock
+{
+    struct HeapBlock* prev_phys; // Fiziksel olarak onceki blok (bolgenin ilk blogunda NULL)
+    size_t size;                 // Payload boyutu; bit0 = serbest
+    // Asagidaki alanlar yalnizca blok serbestken gecerlidir (payload'un icinde)
+    struct HeapBlock* next_free;
+    struct HeapBlock* prev_free;
+} HeapBlock;
+
+#define HEAP_BLOCK_FREE      ((size_t)1)
+#define HEAP_BLOCK_HDR       (offsetof(HeapBlock, next_free))
+#define HEAP_ALIGN           (sizeof(size_t) * 2)
+#define HEAP_BLOCK_MIN       (sizeof(HeapBlock) - HEAP_BLOCK_HDR)
+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define HEAP_ALIGN_LOG2      4
+#define HEAP_FL_INDEX_MAX    32   // En buyuk blok < 4 GiB
+#else
+#define HEAP_ALIGN_LOG2      3
+#define HEAP_FL_INDEX_MAX    30   // En buyuk blok < 1 GiB
+#endif
+
+#define HEAP_SL_INDEX_LOG2   4
+#define HEAP_SL_INDEX_COUNT  (1u << HEAP_SL_INDEX_LOG2)
+#define HEAP_FL_INDEX_SHIFT  (HEAP_SL_INDEX_LOG2 + HEAP_ALIGN_LOG2)
+#define HEAP_FL_INDEX_COUNT  (HEAP_FL_INDEX_MAX - HEAP_FL_INDEX_SHIFT + 1)
+#define HEAP_SMALL_BLOCK     ((size_t)1 << HEAP_FL_INDEX_SHIFT)
+#define HEAP_BLOCK_MAX       ((size_t)1 << HEAP_FL_INDEX_MAX)
+
+#if defined(HEAPPROF) || defined(DEBUG)
+#define HEAP_PROFILER        1
+#define HEAP_PROF_SITES      512   // 2'nin kuvveti; slot 0 "diger/tasan" siteler
+#define HEAP_PROF_MAGIC      0x48505246u
+#define HEAP_PROF_TOP_MAX    32
+
+// Profil modunda her kullanilan blogun payload sonunda durur
+typedef struct HeapProfTag
 {
-    uint32_t magic; // Magic number for validation
-    bool is_free; // Flag to indicate if the block is free
-    struct HeapNode* next; // Pointer to the next node in the free list
-} HeapNode;
+    uint32_t slot;
+    uint32_t check;   // slot ^ HEAP_PROF_MAGIC
+    size_t size;      // Istenen boyut
+} HeapProfTag;
+
+#define HEAP_PROF_TAG_SIZE   sizeof(HeapProfTag)
+#else
+#define HEAP_PROFILER        0
+#define HEAP_PROF_TAG_SIZE   0
+#endif
+
+// Heap büyürken PMM'den en az bu kadar istenir (küçük tahsislerde sık büyümeyi önler)
+#define HEAP_GROW_MIN                   (256 * 1024)
+#define HEAP_DEFAULT_RELEASE_WATERMARK  (1024 * 1024)
+
+typedef struct HeapControl
+{
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[HEAP_FL_INDEX_COUNT];
+    HeapBlock* blocks[HEAP_FL_INDEX_COUNT][HEAP_SL_INDEX_COUNT];
+} HeapControl;
+
+static HeapControl s_heap;
 
-#define NODE_SIZE(node) (node->next ? ((size_t)node->next - (size_t)node - sizeof(HeapNode)) : 0)
+static size_t s_heap_free_bytes = 0;
+static size_t s_heap_release_watermark = HEAP_DEFAULT_RELEASE_WATERMARK;
+static size_t s_heap_grow_count = 0;
+static size_t s_heap_release_count = 0;
 
 // Linker-provided symbols that delimit the local heap region
 // Declare as arrays to avoid array-bounds warnings and allow taking addresses safely.
@@ -28,101 +100,258 @@ HeapRegion localHeapRegion;
 
 extern List* memory_regions; // From pmm.c
 
-static void initRegion(HeapRegion* region)
+/* ---- Blok yardimcilari ---- */
+
+static inline size_t block_size(const HeapBlock* block)
 {
-    if (region == NULL) return;
+    return block->size & ~HEAP_BLOCK_FREE;
+}
 
-    if (region->base == 0 || region->size == 0) return;
+static inline bool block_is_free(const HeapBlock* block)
+{
+    return (block->size & HEAP_BLOCK_FREE) != 0;
+}
+
+static inline void* block_to_ptr(HeapBlock* block)
+{
+    return (void*)((uint8_t*)block + HEAP_BLOCK_HDR);
+}
+
+static inline HeapBlock* block_from_ptr(const void* ptr)
+{
+    return (HeapBlock*)((uint8_t*)ptr - HEAP_BLOCK_HDR);
+}
+
+static inline HeapBlock* block_next(const HeapBlock* block)
+{
+    return (HeapBlock*)((uint8_t*)block + HEAP_BLOCK_HDR + block_size(block));
+}
 
-    // Require at least room for a head node and a terminal end node
-    if (region->size < 2 * sizeof(HeapNode)) return;
+static inline size_t align_up(size_t x, size_t align)
+{
+    return (x + (align - 1)) & ~(align - 1);
+}
 
-    HeapNode* initial_node = (HeapNode*)region->base;
-    HeapNode* end_node = (HeapNode*)(region->base + region->size - sizeof(HeapNode));
+static inline int heap_fls(size_t x)
+{
+    return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)x);
+}
+
+/* ---- Boyut -> (fl, sl) esleme ---- */
+
+static void mapping_insert(size_t size, int* fl, int* sl)
+{
+    if (size < HEAP_SMALL_BLOCK)
+    {
+        *fl = 0;
+        *sl = (int)(size / (HEAP_SMALL_BLOCK / HEAP_SL_INDEX_COUNT));
+    }
+    else
+    {
+        int f = heap_fls(size);
+        *sl = (int)(size >> (f - HEAP_SL_INDEX_LOG2)) ^ (int)HEAP_SL_INDEX_COUNT;
+        *fl = f - (HEAP_FL_INDEX_SHIFT - 1);
+    }
+}
 
-    initial_node->magic = (uint32_t)HEAP_MAGIC;
-    initial_node->is_free = true;
-    initial_node->next = end_node;
+// Arama icin boyutu bir ust dilime yuvarla; bulunan her blok istegi karsilar
+static void mapping_search(size_t size, int* fl, int* sl)
+{
+    if (size >= HEAP_SMALL_BLOCK)
+        size += ((size_t)1 << (heap_fls(size) - HEAP_SL_INDEX_LOG2)) - 1;
+    mapping_insert(size, fl, sl);
+}
 
-    end_node->magic = 0; // Mark the end node with a magic value of 0
-    end_node->next = NULL;
-    end_node->is_free = false; // End node is not free
+static HeapBlock* search_suitable_block(int* fl, int* sl)
+{
+    if (*fl >= (int)HEAP_FL_INDEX_COUNT)
+        return NULL;
 
+    uint32_t sl_map = s_heap.sl_bitmap[*fl] & (~0u << *sl);
+    if (!sl_map)
+    {
+        uint32_t fl_map = (*fl + 1 < 32) ? (s_heap.fl_bitmap & (~0u << (*fl + 1))) : 0;
+        if (!fl_map)
+            return NULL;
+        *fl = __builtin_ctz(fl_map);
+        sl_map = s_heap.sl_bitmap[*fl];
+    }
+    *sl = __builtin_ctz(sl_map);
+    return s_heap.blocks[*fl][*sl];
 }
 
-static void* alloc_region(HeapRegion* region, size_t size)
+static void remove_free_block(HeapBlock* block, int fl, int sl)
 {
-    HeapNode* node = (HeapNode*)(region->base);
-    while (node && node->magic == HEAP_MAGIC)
+    HeapBlock* prev = block->prev_free;
+    HeapBlock* next = block->next_free;
+    if (next) next->prev_free = prev;
+    if (prev) prev->next_free = next;
+
+    s_heap_free_bytes -= block_size(block);
+
+    if (s_heap.blocks[fl][sl] == block)
     {
-        
-        if (node->is_free && NODE_SIZE(node) >= size)
+        s_heap.blocks[fl][sl] = next;
+        if (!next)
         {
-            size_t remaining_size = NODE_SIZE(node) - size;
-            if (remaining_size >= HEAP_NODE_MIN_SIZE + sizeof(HeapNode))
-            {
-                // Split the block
-                HeapNode* new_node = (HeapNode*)((char*)node + size + sizeof(HeapNode));
-                new_node->magic = HEAP_MAGIC;
-                new_node->is_free = true;
-                new_node->next = node->next;
-
-                node->is_free = false;
-                node->next = new_node;
-
-                return (void*)((char*)node + sizeof(HeapNode));
-            }
-            else
-            {
-                // Use the entire block
-                node->is_free = false;
-                return (void*)((char*)node + sizeof(HeapNode));
-            }
+            s_heap.sl_bitmap[fl] &= ~(1u << sl);
+            if (!s_heap.sl_bitmap[fl])
+                s_heap.fl_bitmap &= ~(1u << fl);
         }
-        // Advance to next node when not returning above
-        node = node->next;
     }
+}
+
+static void insert_free_block(HeapBlock* block, int fl, int sl)
+{
+    HeapBlock* head = s_heap.blocks[fl][sl];
+    s_heap_free_bytes += block_size(block);
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) head->prev_free = block;
+    s_heap.blocks[fl][sl] = block;
+    s_heap.fl_bitmap |= (1u << fl);
+    s_heap.sl_bitmap[fl] |= (1u << sl);
+}
+
+static void block_remove(HeapBlock* block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(block, fl, sl);
+}
+
+static void block_insert(HeapBlock* block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    insert_free_block(block, fl, sl);
+}
+
+// block'u payload'u 'size' olacak sekilde kes; kalan kismi yeni blok olarak dondur
+static HeapBlock* block_split(HeapBlock* block, size_t size)
+{
+    HeapBlock* remaining = (HeapBlock*)((uint8_t*)block_to_ptr(block) + size);
+    remaining->size = block_size(block) - size - HEAP_BLOCK_HDR;
+    remaining->prev_phys = block;
+    block->size = size | (block->size & HEAP_BLOCK_FREE);
+    block_next(remaining)->prev_phys = remaining;
+    return remaining;
+}
 
-    return NULL; // No suitable block found
+static bool block_can_split(const HeapBlock* block, size_t size)
+{
+    return block_size(block) >= size + HEAP_BLOCK_HDR + HEAP_BLOCK_MIN;
 }
 
-static bool free_region(HeapRegion* region, void* ptr)
+// Serbest blogu sonraki serbest komsusuyla birlestir (komsu listeden cikarilir)
+static HeapBlock* block_absorb(HeapBlock* prev, HeapBlock* block)
 {
-    if (ptr == NULL) return false;
+    prev->size += block_size(block) + HEAP_BLOCK_HDR;
+    block_next(prev)->prev_phys = prev;
+    return prev;
+}
 
-    HeapNode* node = (HeapNode*)region->base;
-    HeapNode* prev = NULL;
+static HeapBlock* block_merge_prev(HeapBlock* block)
+{
+    HeapBlock* prev = block->prev_phys;
+    if (prev && block_is_free(prev))
+    {
+        block_remove(prev);
+        block = block_absorb(prev, block);
+    }
+    return block;
+}
 
-    while (node && node->magic == HEAP_MAGIC)
+static HeapBlock* block_merge_next(HeapBlock* block)
+{
+    HeapBlock* next = block_next(block);
+    if (block_is_free(next))
     {
-        if (
-            (size_t)node < (size_t)ptr &&
-            (size_t)ptr < (size_t)node->next
-        )
-        {
-            node->is_free = true;
+        block_remove(next);
+        block = block_absorb(block, next);
+    }
+    return block;
+}
 
-            // Coalesce with next node if it's free
-            if (node->next && node->next->is_free)
-            {
-                node->next = node->next->next;
-            }
+// Kullanilan blogun fazlasini serbest listeye geri ver
+static void block_trim_used(HeapBlock* block, size_t size)
+{
+    if (!block_can_split(block, size))
+        return;
 
-            // If have previous node and it's free, coalesce with it
-            if (prev && prev->is_free)
-            {
-                prev->next = node->next;
-                prev->is_free = true;
-                prev->magic = HEAP_MAGIC;
-            }
+    HeapBlock* remaining = block_split(block, size);
+    remaining->size |= HEAP_BLOCK_FREE;
+    remaining = block_merge_next(remaining);
+    block_insert(remaining);
+}
 
-            return true;
-        }
-        prev = node;
-        node = node->next;
+static size_t adjust_request_size(size_t size)
+{
+    if (size == 0 || size >= HEAP_BLOCK_MAX)
+        return 0;
+
+    size_t adjusted = align_up(size + HEAP_PROF_TAG_SIZE, HEAP_ALIGN);
+    return adjusted < HEAP_BLOCK_MIN ? HEAP_BLOCK_MIN : adjusted;
+}
+
+static void* heap_alloc_block(size_t adjusted)
+{
+    int fl, sl;
+    mapping_search(adjusted, &fl, &sl);
+
+    HeapBlock* block = search_suitable_block(&fl, &sl);
+    if (!block)
+        return NULL;
+
+    remove_free_block(block, fl, sl);
+    block->size &= ~HEAP_BLOCK_FREE;
+    block_trim_used(block, adjusted);
+    return block_to_ptr(block);
+}
+
+// Bolgeyi tek bir serbest blok + sonda sentinel olacak sekilde hazirla
+static bool initRegion(HeapRegion* region)
+{
+    if (region == NULL) return false;
+
+    if (region->base == 0 || region->size == 0) return false;
+
+    size_t start = align_up(region->base, HEAP_ALIGN);
+    size_t end = (region->base + region->size) & ~(HEAP_ALIGN - 1);
+
+    // Require at least room for one minimal block and the terminal sentinel
+    if (end <= start || end - start < 2 * HEAP_BLOCK_HDR + HEAP_BLOCK_MIN) return false;
+
+    size_t payload = end - start - 2 * HEAP_BLOCK_HDR;
+    if (payload >= HEAP_BLOCK_MAX)
+        payload = HEAP_BLOCK_MAX - HEAP_ALIGN;
+
+    HeapBlock* block = (HeapBlock*)start;
+    block->prev_phys = NULL;
+    block->size = payload | HEAP_BLOCK_FREE;
+
+    HeapBlock* sentinel = block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size = 0; // Serbest degil, boyutu 0: bolge sonu
+
+    block_insert(block);
+    return true;
+}
+
+static void heap_link_region(HeapRegion* region)
+{
+    region->next = NULL;
+
+    if (first_heap_region == NULL) {
+        first_heap_region = region;
+        return;
     }
 
-    return false;
+    HeapRegion* last = first_heap_region;
+    while (last->next) {
+        last = last->next;
+    }
+    last->next = region;
 }
 
 void heap_init()
@@ -131,166 +360,600 @@ void heap_init()
     localHeapRegion.size = (size_t)((uintptr_t)__local_heap_end - (uintptr_t)__local_heap_start);
     localHeapRegion.next = NULL;
 
+    localHeapRegion.flags = 0;
+
+    memset(&s_heap, 0, sizeof(s_heap));
+    s_heap_free_bytes = 0;
     first_heap_region = &localHeapRegion;
 
     initRegion(&localHeapRegion);
 
 }
 
-void* heap_alloc(size_t n) {
-    if (n <= 0) return NULL;
+// PMM'den yeni bir bolge al; HeapRegion tanimlayicisi bolgenin basinda durur
+static bool heap_expand(size_t adjusted)
+{
+    size_t header = align_up(sizeof(HeapRegion), HEAP_ALIGN);
+    size_t regionSize = adjusted + header + 2 * HEAP_BLOCK_HDR + HEAP_ALIGN;
+    if (regionSize < HEAP_GROW_MIN) regionSize = HEAP_GROW_MIN;
+    regionSize = align_up(regionSize, 4096);
+
+    void* newRegionPtr = pmm_alloc(regionSize / 1024); // PMM'den KB cinsinden al
+    if (!newRegionPtr) {
+        ERROR("heap_alloc: pmm_alloc failed to allocate new heap region of size %zu bytes ( %zu kb, %zu mb )", regionSize, regionSize / 1024, regionSize / (1024 * 1024));
+        return false;
+    }
+
+    HeapRegion* region = (HeapRegion*)newRegionPtr;
+    region->base = (size_t)(uintptr_t)newRegionPtr + header;
+    region->size = regionSize - header;
+    region->flags = HEAP_REGION_PMM;
 
-    if (first_heap_region == NULL) {
-        heap_init();
+    if (!initRegion(region)) {
+        pmm_free(newRegionPtr);
+        return false;
     }
+    heap_link_region(region);
+    s_heap_grow_count++;
 
-    HeapRegion* region = first_heap_region;
-    while (region) {
-        void* ptr = alloc_region(region, n);
-        if (ptr) {
-            return ptr;
-        }else region = region->next;
+    LOG("Heap expanded by %zu bytes", regionSize);
+    return true;
+}
+
+// Tamamen serbest kalan bir PMM bolgesini, watermark izin veriyorsa geri ver.
+// block, bolgenin ilk (ve tek) blogu olmali; true donerse blok artik yok.
+static bool heap_try_release(HeapBlock* block)
+{
+    if (s_heap_free_bytes < s_heap_release_watermark)
+        return false;
+
+    HeapRegion* prev = NULL;
+    for (HeapRegion* region = first_heap_region; region; prev = region, region = region->next) {
+        if (align_up(region->base, HEAP_ALIGN) != (size_t)(uintptr_t)block)
+            continue;
+        if (!(region->flags & HEAP_REGION_PMM))
+            return false;
+
+        if (prev) prev->next = region->next;
+        else first_heap_region = region->next;
+
+        s_heap_release_count++;
+        LOG("Heap released %zu bytes back to PMM", region->size);
+        pmm_free(region); // Tanimlayici bolgenin basinda duruyor
+        return true;
     }
 
-    if (memory_regions)
-    {
+    return false;
+}
 
-        LOG("Heap exhausted, attempting to expand...");
+/* ---- Cagri noktasi profili ---- */
 
-        // PMM active ise PMM'den yeni bir heap bölgesi al
-        size_t regionSize = n + (4096 - (n % 4096));  // Align up to page size
+#if HEAP_PROFILER
 
-        regionSize += 0x1000; // Extra space for HeapNode structures
+typedef struct HeapProfSite
+{
+    uintptr_t site;
+    size_t alloc_count;
+    size_t free_count;
+    size_t alloc_bytes;      // Toplam istenen bayt
+    size_t live_bytes;
+    size_t live_count;
+    size_t peak_live_bytes;
+} HeapProfSite;
+
+struct HeapProfSnapshot
+{
+    size_t live_bytes[HEAP_PROF_SITES];
+    size_t live_count[HEAP_PROF_SITES];
+};
 
-        void* newRegionPtr = pmm_alloc(regionSize / 1024); // PMM'den KB cinsinden al
-        if (!newRegionPtr) {
-            ERROR("heap_alloc: pmm_alloc failed to allocate new heap region of size %zu bytes ( %zu kb, %zu mb )", regionSize, regionSize / 1024, regionSize / (1024 * 1024));
-            return NULL;
+static HeapProfSite s_prof_sites[HEAP_PROF_SITES];
+static size_t s_prof_site_count = 0;
+
+static void* heap_alloc_internal(size_t n);
+static void heap_free_internal(void* ptr);
+
+static uint32_t heap_prof_slot(uintptr_t site)
+{
+    uint32_t mask = HEAP_PROF_SITES - 1;
+    uint32_t idx = (uint32_t)((site >> 2) * 2654435761u) & mask;
+
+    for (uint32_t probe = 0; probe < HEAP_PROF_SITES; probe++, idx = (idx + 1) & mask)
+    {
+        if (idx == 0) continue; // Slot 0 tasan siteler icin ayrildi
+        if (s_prof_sites[idx].site == site) return idx;
+        if (s_prof_sites[idx].site == 0)
+        {
+            s_prof_sites[idx].site = site;
+            s_prof_site_count++;
+            return idx;
         }
+    }
+    return 0;
+}
+
+static inline HeapProfTag* heap_prof_tag(HeapBlock* block)
+{
+    return (HeapProfTag*)((uint8_t*)block_to_ptr(block) + block_size(block) - HEAP_PROF_TAG_SIZE);
+}
+
+static void heap_prof_track(void* ptr, size_t size, void* site)
+{
+    if (!ptr) return;
+
+    uint32_t slot = heap_prof_slot((uintptr_t)site);
+    HeapProfSite* entry = &s_prof_sites[slot];
+    entry->alloc_count++;
+    entry->alloc_bytes += size;
+    entry->live_count++;
+    entry->live_bytes += size;
+    if (entry->live_bytes > entry->peak_live_bytes)
+        entry->peak_live_bytes = entry->live_bytes;
+
+    HeapProfTag* tag = heap_prof_tag(block_from_ptr(ptr));
+    tag->slot = slot;
+    tag->check = slot ^ HEAP_PROF_MAGIC;
+    tag->size = size;
+}
+
+static void heap_prof_untrack(HeapBlock* block)
+{
+    HeapProfTag* tag = heap_prof_tag(block);
+    if (tag->slot >= HEAP_PROF_SITES || tag->check != (tag->slot ^ HEAP_PROF_MAGIC))
+        return; // Etiketsiz blok (ornegin snapshot tamponu)
+
+    HeapProfSite* entry = &s_prof_sites[tag->slot];
+    entry->free_count++;
+    entry->live_count--;
+    entry->live_bytes -= tag->size;
+    tag->check = 0;
+}
+
+// Tablodan en buyuk top_n degeri sec (key: slot -> siralama degeri)
+static size_t heap_prof_select_top(size_t (*key)(uint32_t, const void*), const void* ctx,
+                                   uint32_t* out, size_t top_n)
+{
+    size_t count = 0;
+    for (uint32_t slot = 0; slot < HEAP_PROF_SITES; slot++)
+    {
+        size_t value = key(slot, ctx);
+        if (value == 0) continue;
+
+        size_t pos = count < top_n ? count++ : top_n;
+        if (pos == top_n && value <= key(out[top_n - 1], ctx)) continue;
+        if (pos == top_n) pos = top_n - 1;
 
-        HeapRegion newRegion;
-        newRegion.base = (size_t)(uintptr_t)newRegionPtr;
-        newRegion.size = regionSize;
-        newRegion.next = NULL;
-        initRegion(&newRegion);
-
-        HeapRegion* region = (HeapRegion*)alloc_region(&newRegion, sizeof(HeapRegion));
-        
-        region->base = newRegion.base;
-        region->size = newRegion.size;
-        region->next = NULL;
-
-        // Bağlantı listesinin sonuna ekle
-        HeapRegion* last = first_heap_region;
-        while (last->next) {
-            last = last->next;
+        while (pos > 0 && key(out[pos - 1], ctx) < value)
+        {
+            out[pos] = out[pos - 1];
+            pos--;
         }
+        out[pos] = slot;
+    }
+    return count;
+}
 
-        last->next = region;
+static size_t heap_prof_key_live(uint32_t slot, const void* ctx)
+{
+    (void)ctx;
+    return s_prof_sites[slot].live_bytes;
+}
 
-        void* _Ret = alloc_region(region, n);
-        if (!_Ret) {
-            ERROR("heap_alloc: alloc_region failed after expanding heap");
-            return NULL;
+typedef struct HeapProfDiffCtx
+{
+    const HeapProfSnapshot* before;
+    const HeapProfSnapshot* after;
+} HeapProfDiffCtx;
+
+static size_t heap_prof_after_bytes(const HeapProfDiffCtx* diff, uint32_t slot)
+{
+    return diff->after ? diff->after->live_bytes[slot] : s_prof_sites[slot].live_bytes;
+}
+
+static size_t heap_prof_key_growth(uint32_t slot, const void* ctx)
+{
+    const HeapProfDiffCtx* diff = (const HeapProfDiffCtx*)ctx;
+    size_t before = diff->before->live_bytes[slot];
+    size_t after = heap_prof_after_bytes(diff, slot);
+    return after > before ? after - before : 0;
+}
+
+bool heap_prof_enabled(void)
+{
+    return true;
+}
+
+void heap_prof_dump(size_t top_n)
+{
+    uint32_t top[HEAP_PROF_TOP_MAX];
+    if (top_n == 0 || top_n > HEAP_PROF_TOP_MAX) top_n = HEAP_PROF_TOP_MAX;
+
+    size_t live_total = 0, live_blocks = 0;
+    for (uint32_t slot = 0; slot < HEAP_PROF_SITES; slot++)
+    {
+        live_total += s_prof_sites[slot].live_bytes;
+        live_blocks += s_prof_sites[slot].live_count;
+    }
+
+    size_t count = heap_prof_select_top(heap_prof_key_live, NULL, top, top_n);
+
+    uart_printf("heapprof: %zu sites, %zu live blocks, %zu live bytes\n",
+                s_prof_site_count, live_blocks, live_total);
+    uart_printf("  %-18s %10s %8s %10s %10s %10s\n", "site", "live", "blocks", "peak", "allocs", "frees");
+    for (size_t i = 0; i < count; i++)
+    {
+        const HeapProfSite* entry = &s_prof_sites[top[i]];
+        uart_printf("  %-18p %10zu %8zu %10zu %10zu %10zu\n", (void*)entry->site,
+                    entry->live_bytes, entry->live_count, entry->peak_live_bytes,
+                    entry->alloc_count, entry->free_count);
+    }
+}
+
+HeapProfSnapshot* heap_prof_snapshot(void)
+{
+    // Snapshot'in kendisi profile yazilmaz; aksi halde diff'te sizinti gibi gorunur
+    size_t flags = mm_lock();
+    HeapProfSnapshot* snapshot = (HeapProfSnapshot*)heap_alloc_internal(sizeof(HeapProfSnapshot));
+    if (snapshot)
+    {
+        for (uint32_t slot = 0; slot < HEAP_PROF_SITES; slot++)
+        {
+            snapshot->live_bytes[slot] = s_prof_sites[slot].live_bytes;
+            snapshot->live_count[slot] = s_prof_sites[slot].live_count;
         }
+    }
+    mm_unlock(flags);
+    return snapshot;
+}
+
+void heap_prof_snapshot_free(HeapProfSnapshot* snapshot)
+{
+    size_t flags = mm_lock();
+    heap_free_internal(snapshot);
+    mm_unlock(flags);
+}
+
+void heap_prof_diff(const HeapProfSnapshot* before, const HeapProfSnapshot* after, size_t top_n)
+{
+    if (!before) return;
+
+    uint32_t top[HEAP_PROF_TOP_MAX];
+    if (top_n == 0 || top_n > HEAP_PROF_TOP_MAX) top_n = HEAP_PROF_TOP_MAX;
+
+    HeapProfDiffCtx ctx = { before, after };
+    size_t count = heap_prof_select_top(heap_prof_key_growth, &ctx, top, top_n);
+
+    uart_printf("heapprof: %zu sites grew since snapshot\n", count);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t slot = top[i];
+        size_t after_count = after ? after->live_count[slot] : s_prof_sites[slot].live_count;
+        uart_printf("  %-18p +%zu bytes (%zu -> %zu), blocks %zu -> %zu\n",
+                    (void*)s_prof_sites[slot].site, heap_prof_key_growth(slot, &ctx),
+                    before->live_bytes[slot], heap_prof_after_bytes(&ctx, slot),
+                    before->live_count[slot], after_count);
+    }
+}
+
+#else
+
+#define heap_prof_track(ptr, size, site)  ((void)(site))
+#define heap_prof_untrack(block)          ((void)(block))
 
-        LOG("Heap expanded by %zu bytes", regionSize);
+bool heap_prof_enabled(void)
+{
+    return false;
+}
+
+void heap_prof_dump(size_t top_n)
+{
+    (void)top_n;
+    uart_printf("heapprof: disabled (build with HEAPPROF=1 or DEBUG=1)\n");
+}
+
+HeapProfSnapshot* heap_prof_snapshot(void)
+{
+    return NULL;
+}
+
+void heap_prof_snapshot_free(HeapProfSnapshot* snapshot)
+{
+    (void)snapshot;
+}
+
+void heap_prof_diff(const HeapProfSnapshot* before, const HeapProfSnapshot* after, size_t top_n)
+{
+    (void)before; (void)after; (void)top_n;
+}
+
+#endif
+
+static void* heap_alloc_internal(size_t n) {
+    size_t adjusted = adjust_request_size(n);
+    if (adjusted == 0) return NULL;
+
+    if (first_heap_region == NULL) {
+        heap_init();
+    }
+
+    void* ptr = heap_alloc_block(adjusted);
+    if (ptr) {
+        return ptr;
+    }
+
+    if (memory_regions && pmm_get_total_bytes() != 0)
+    {
+        LOG("Heap exhausted, attempting to expand...");
 
-        return _Ret;
+        // Arama bir ust dilime yuvarladigi icin yeni bolge o boyutu karsilamali
+        size_t search_size = adjusted;
+        if (search_size >= HEAP_SMALL_BLOCK)
+            search_size += ((size_t)1 << (heap_fls(search_size) - HEAP_SL_INDEX_LOG2)) - 1;
 
+        if (heap_expand(search_size)) {
+            ptr = heap_alloc_block(adjusted);
+            if (!ptr) {
+                ERROR("heap_alloc: allocation failed after expanding heap");
+            }
+            return ptr;
+        }
     }else {
-        ERROR("heap_alloc: memory_regions is NULL, cannot allocate more heap");
+        ERROR("heap_alloc: PMM is not ready, cannot allocate more heap");
     }
 
     return NULL; // No memory available
 }
 
-void heap_free(void* ptr) {
+// Basit tutarlilik kontrolu: kullanilan blok ve fiziksel komsusu birbirini gostermeli
+static HeapBlock* heap_validate_ptr(void* ptr, const char* who)
+{
+    HeapBlock* block = block_from_ptr(ptr);
+    if (block_is_free(block)) {
+        WARN("%s: double free or invalid pointer %p", who, ptr);
+        return NULL;
+    }
+    if (block_size(block) == 0 || block_next(block)->prev_phys != block) {
+        WARN("%s: pointer %p is not a heap block", who, ptr);
+        return NULL;
+    }
+    return block;
+}
+
+static void heap_release_block(HeapBlock* block)
+{
+    block->size |= HEAP_BLOCK_FREE;
+    block = block_merge_prev(block);
+    block = block_merge_next(block);
+
+    // Bolgenin tamami bosaldiysa (ilk blok + hemen ardindan sentinel) PMM'e donebilir
+    if (block->prev_phys == NULL && block_size(block_next(block)) == 0 && heap_try_release(block)) {
+        return;
+    }
+
+    block_insert(block);
+}
+
+#if HEAP_PROFILER
+// Profil etiketi olmayan bloklar icin (snapshot tamponlari)
+static void heap_free_internal(void* ptr)
+{
     if (ptr == NULL) return;
 
     if (first_heap_region == NULL) {
         heap_init();
     }
 
-    HeapRegion* region = first_heap_region;
-    while (region) {
-        if (free_region(region, ptr)) {
-            return; // Successfully freed
-        }
-        region = region->next;
+    HeapBlock* block = heap_validate_ptr(ptr, "heap_free");
+    if (!block) return;
+
+    heap_release_block(block);
+}
+#endif
+
+// Heap tek bir global yapı; dış giriş noktaları mm_lock altında çalışır (IRQ ve diğer CPU'lar)
+void* heap_alloc_from(size_t n, void* site)
+{
+    size_t flags = mm_lock();
+    void* ptr = heap_alloc_internal(n);
+    heap_prof_track(ptr, n, site);
+    mm_unlock(flags);
+    return ptr;
+}
+
+void* heap_alloc(size_t n)
+{
+    return heap_alloc_from(n, __builtin_return_address(0));
+}
+
+static void __heap_free(void* ptr) {
+    if (ptr == NULL) return;
+
+    if (first_heap_region == NULL) {
+        heap_init();
     }
+
+    HeapBlock* block = heap_validate_ptr(ptr, "heap_free");
+    if (!block) return;
+
+    heap_prof_untrack(block);
+    heap_release_block(block);
+}
+
+void heap_free(void* ptr)
+{
+    size_t flags = mm_lock();
+    __heap_free(ptr);
+    mm_unlock(flags);
 }
 
-void *heap_realloc(void* ptr, size_t new_size) {
+static void* __heap_realloc_from(void* ptr, size_t new_size, void* site)
+{
     if (new_size <= 0) {
         heap_free(ptr);
         return NULL;
     }
 
     if (ptr == NULL) {
-        return heap_alloc(new_size);
+        return heap_alloc_from(new_size, site);
     }
 
-    HeapNode* node = (HeapNode*)((char*)ptr - sizeof(HeapNode));
-    if (node->magic != HEAP_MAGIC) {
+    HeapBlock* block = heap_validate_ptr(ptr, "heap_realloc");
+    if (!block) {
         return NULL; // Invalid pointer
     }
 
-    size_t old_size = NODE_SIZE(node);
-    if (new_size <= old_size) {
-        return ptr; // No need to reallocate
+    size_t adjusted = adjust_request_size(new_size);
+    if (adjusted == 0) return NULL;
+
+    size_t old_size = block_size(block);
+
+    // Eski etiket blok boyutu degismeden once dusulmeli (basarisizlikta blok aynen kalir)
+    HeapBlock* next = block_next(block);
+    bool in_place = adjusted <= old_size ||
+        (block_is_free(next) && old_size + HEAP_BLOCK_HDR + block_size(next) >= adjusted);
+    if (!in_place) {
+        void* new_ptr = heap_alloc_internal(new_size);
+        if (new_ptr) {
+            memcpy(new_ptr, ptr, old_size - HEAP_PROF_TAG_SIZE); // Copy old data to new location
+            heap_prof_untrack(block);
+            heap_release_block(block); // Free old memory
+            heap_prof_track(new_ptr, new_size, site);
+        }
+        return new_ptr;
     }
 
-    void* new_ptr = heap_alloc(new_size);
-    if (new_ptr) {
-        memcpy(new_ptr, ptr, old_size); // Copy old data to new location
-        heap_free(ptr); // Free old memory
+    heap_prof_untrack(block);
+
+    // Sonraki komsu serbest ve yeterliyse yerinde buyut
+    if (adjusted > old_size)
+    {
+        block_remove(next);
+        block_absorb(block, next);
     }
-    
-    return new_ptr;
+
+    block_trim_used(block, adjusted);
+    heap_prof_track(ptr, new_size, site);
+    return ptr;
 }
 
-void *heap_calloc(size_t count, size_t size) {
+void* heap_realloc_from(void* ptr, size_t new_size, void* site)
+{
+    size_t flags = mm_lock();
+    void* result = __heap_realloc_from(ptr, new_size, site);
+    mm_unlock(flags);
+    return result;
+}
+
+void* heap_realloc(void* ptr, size_t new_size)
+{
+    return heap_realloc_from(ptr, new_size, __builtin_return_address(0));
+}
+
+void* heap_calloc_from(size_t count, size_t size, void* site)
+{
     if (count == 0 || size == 0) return NULL;
+    if (count > SIZE_MAX / size) return NULL;
 
-    void* ptr = heap_alloc(count * size);
+    void* ptr = heap_alloc_from(count * size, site);
     if (ptr) {
         memset(ptr, 0, count * size); // Zero out the allocated memory
     }
-    
+
     return ptr;
 }
 
-void* heap_aligned_alloc(size_t alignment, size_t size)
+void* heap_calloc(size_t count, size_t size)
+{
+    return heap_calloc_from(count, size, __builtin_return_address(0));
+}
+
+static void* __heap_aligned_alloc_from(size_t alignment, size_t size, void* site)
 {
     if (alignment == 0 || size == 0 || (alignment & (alignment - 1)) != 0) {
         return NULL; // Invalid alignment or size
     }
 
-    void* ptr = heap_alloc(size + alignment - 1 + sizeof(HeapNode));
+    if (alignment <= HEAP_ALIGN) {
+        return heap_alloc_from(size, site);
+    }
+
+    size_t adjusted = adjust_request_size(size);
+    if (adjusted == 0) return NULL;
+
+    // On kisimda hizalama boslugu kalirsa ayri bir serbest blok olabilmeli
+    size_t gap_min = HEAP_BLOCK_HDR + HEAP_BLOCK_MIN;
+    void* ptr = heap_alloc_internal(adjusted + alignment + gap_min);
     if (!ptr) return NULL;
 
-    // Align the pointer
-    uintptr_t aligned_ptr = ((uintptr_t)ptr + sizeof(HeapNode) + alignment - 1) & ~(alignment - 1);
-    
-    HeapNode* node = (HeapNode*)((char*)aligned_ptr - sizeof(HeapNode));
-    node->magic = HEAP_MAGIC;
-    node->is_free = false;
-    node->next = NULL;
+    uintptr_t aligned = align_up((uintptr_t)ptr, alignment);
+    size_t gap = aligned - (uintptr_t)ptr;
+    if (gap && gap < gap_min) {
+        aligned = align_up((uintptr_t)ptr + gap_min, alignment);
+        gap = aligned - (uintptr_t)ptr;
+    }
 
-    return (void*)aligned_ptr;
+    HeapBlock* block = block_from_ptr(ptr);
+    if (gap) {
+        // Bastaki boslugu serbest blok olarak ayir, hizali kismi kullan
+        HeapBlock* aligned_block = block_split(block, gap - HEAP_BLOCK_HDR);
+        block->size |= HEAP_BLOCK_FREE;
+        block = block_merge_prev(block);
+        block_insert(block);
+        block = aligned_block;
+    }
+
+    block_trim_used(block, adjusted);
+    heap_prof_track(block_to_ptr(block), size, site);
+    return block_to_ptr(block);
+}
+
+void* heap_aligned_alloc_from(size_t alignment, size_t size, void* site)
+{
+    size_t flags = mm_lock();
+    void* result = __heap_aligned_alloc_from(alignment, size, site);
+    mm_unlock(flags);
+    return result;
+}
+
+void* heap_aligned_alloc(size_t alignment, size_t size)
+{
+    return heap_aligned_alloc_from(alignment, size, __builtin_return_address(0));
 }
 
 void heap_register_region(HeapRegion* region)
 {
     if (region == NULL) return;
     if (region->base == 0 || region->size == 0) return;
-    if (region->size < 2 * sizeof(HeapNode)) return;
 
-    // Initialize the region's free list
-    initRegion(region);
+    if (first_heap_region == NULL) {
+        heap_init();
+    }
+
+    // Initialize the region's free block and add it to the shared free lists
+    if (!initRegion(region)) return;
 
     // Insert at the end of the linked list
-    region->next = NULL;
-    first_heap_region->next = region;
+    region->flags = 0;
+    heap_link_region(region);
+}
+
+void heap_set_release_watermark(size_t bytes)
+{
+    s_heap_release_watermark = bytes;
+}
+
+void heap_get_stats(HeapStats* out_stats)
+{
+    if (!out_stats) return;
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    for (HeapRegion* region = first_heap_region; region; region = region->next) {
+        out_stats->total_bytes += region->size;
+        out_stats->region_count++;
+        if (region->flags & HEAP_REGION_PMM)
+            out_stats->pmm_bytes += region->size;
+    }
+    out_stats->free_bytes = s_heap_free_bytes;
+    out_stats->grow_count = s_heap_grow_count;
+    out_stats->release_count = s_heap_release_count;
 }
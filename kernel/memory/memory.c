@@ -1,9 +1,27 @@
 #include <memory/memory.h>
 #include <memory/heap.h>
+#include <spinlock.h>
+
+static RecursiveSpinlock s_mm_lock = RECURSIVE_SPINLOCK_INIT;
+
+size_t mm_lock(void)
+{
+    return rspin_lock_irqsave(&s_mm_lock);
+}
+
+void mm_unlock(size_t flags)
+{
+    rspin_unlock_irqrestore(&s_mm_lock, flags);
+}
+
+bool mm_lock_held(void)
+{
+    return rspin_held(&s_mm_lock);
+}
 
 void *malloc(size_t size)
 {
-    return heap_alloc(size);
+    return heap_alloc_from(size, __builtin_return_address(0));
 }
 void free(void *ptr)
 {
@@ -11,42 +29,18 @@ void free(void *ptr)
 }
 void *realloc(void *ptr, size_t size)
 {
-    return heap_realloc(ptr, size);
+    return heap_realloc_from(ptr, size, __builtin_return_address(0));
 }
 void *calloc(size_t count, size_t size)
 {
-    return heap_calloc(count, size);
+    return heap_calloc_from(count, size, __builtin_return_address(0));
 }
 void *malloc_aligned(size_t alignment, size_t size)
 {
-    return heap_aligned_alloc(alignment, size);
-}
-
-void memset(void *ptr, char value, size_t num)
-{
-    for (size_t i = 0; i < num; i++)
-    {
-        ((char *)ptr)[i] = value;
-    }
+    return heap_aligned_alloc_from(alignment, size, __builtin_return_address(0));
 }
 
-void memmove(void *dest, const void *src, size_t n)
-{
-    if (!dest || !src || n == 0) return;
-
-    unsigned char *d = (unsigned char *)dest;
-    const unsigned char *s = (const unsigned char *)src;
-
-    if (d < s) {
-        for (size_t i = 0; i < n; ++i) {
-            d[i] = s[i];
-        }
-    } else if (d > s) {
-        for (size_t i = n; i != 0; --i) {
-            d[i - 1] = s[i - 1];
-        }
-    }
-}
+// memcpy/memmove/memset: kernel/<arch>/memcpy.asm (CPUID ile SSE2/AVX2/ERMS secimi)
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
@@ -6,6 +6,7 @@
 #include <memory/memory.h>
 #include <list.h>
 #include <graphics/screen.h>
+#include <arch.h>
 
 List *memory_regions = NULL; // Bellek bölgelerinin başı
 
@@ -14,9 +15,12 @@ extern char __kernel_start[];
 extern char __kernel_end[];
 extern char __kernel_size[];
 
+extern uint32_t mb2_tagptr; // Multiboot2 bilgi blogunun fiziksel adresi
+
 void efi_mr_init(void);
 void bios_mr_init(void);
 void print_memory_regions();
+static void pmm_buddy_init(void);
 
 UINTN bs_map_key;
 UINTN bs_mr_memory_map_size = 0; // İlk çağrıda 0
@@ -186,6 +190,8 @@ void pmm_init(void)
         }
     }
 
+    // Son haritadan buddy allocator'u kur
+    pmm_buddy_init();
 }
 
 void bios_mr_init(void)
@@ -348,6 +354,9 @@ void print_memory_regions(void)
             LOG("Base: 0x%016lX, Size: 0x%016lX, Type: %s", region->base, region->size, mrTypeToString(region->type));
         }
     }
+
+    if (pmm_get_reclaimed_bytes())
+        LOG("Reclaimed boot memory: %zu KB", pmm_get_reclaimed_bytes() / 1024);
 }
 
 // Ard arda gelen USABLE blokları birleştir
@@ -397,241 +406,563 @@ void pmm_maintain()
     }
 }
 
-void *pmm_alloc(size_t sizeInKB)
+
+/*
+ * Buddy page allocator
+ *
+ * memory_regions listesi firmware haritasini temsil etmeye devam eder; sayfa
+ * tahsisi ise asagidaki buddy yapisindan yapilir. Serbest bloklar kendi ilk
+ * sayfalarinda tutulan cift yonlu listelere baglanir, sayfa basina bir byte'lik
+ * bilgi dizisi de (s_pmm_page_info) kullanilabilir bellekten ayrilir. Boylece
+ * tahsis ve serbest birakma heap'e hic dokunmadan O(log n) calisir.
+ */
+
+#define PMM_PAGE_SIZE        EFI_PAGE_SIZE
+#define PMM_PAGE_SHIFT       12
+#define PMM_MAX_ORDER        18                      // 2^18 sayfa = 1 GiB
+#define PMM_PHYS_LIMIT       0x100000000ULL          // Yalnizca identity-map edilen ilk 4 GiB
+
+// s_pmm_page_info bayraklari (yalnizca blok basi sayfalar icin anlamli)
+#define PMM_INFO_ORDER_MASK  0x1Fu
+#define PMM_INFO_CONT        0x20u   // Ayni pmm_alloc cagrisinin devam parcasi
+#define PMM_INFO_ALLOC       0x40u   // Tahsis edilmis blok basi
+#define PMM_INFO_FREE        0x80u   // Serbest blok basi
+
+typedef struct PmmFreeBlock {
+    struct PmmFreeBlock* next;
+    struct PmmFreeBlock* prev;
+} PmmFreeBlock;
+
+static PmmFreeBlock* s_pmm_free_lists[PMM_MAX_ORDER + 1];
+static uint32_t s_pmm_order_mask = 0;       // bit n: order n listesi bos degil
+static uint8_t* s_pmm_page_info = NULL;
+static size_t s_pmm_max_pfn = 0;
+static size_t s_pmm_total_pages = 0;
+static size_t s_pmm_free_pages = 0;
+static size_t s_pmm_reclaimed_pages = 0;    // Acilistan sonra buddy'ye devredilen sayfalar
+
+static inline PmmFreeBlock* pmm_pfn_to_block(size_t pfn)
+{
+    return (PmmFreeBlock*)(uintptr_t)(pfn << PMM_PAGE_SHIFT);
+}
+
+static inline size_t pmm_block_to_pfn(const void* block)
+{
+    return (size_t)(uintptr_t)block >> PMM_PAGE_SHIFT;
+}
+
+static void pmm_list_push(size_t pfn, size_t order)
+{
+    PmmFreeBlock* block = pmm_pfn_to_block(pfn);
+    block->prev = NULL;
+    block->next = s_pmm_free_lists[order];
+    if (block->next)
+        block->next->prev = block;
+    s_pmm_free_lists[order] = block;
+    s_pmm_order_mask |= (1u << order);
+    s_pmm_page_info[pfn] = (uint8_t)(PMM_INFO_FREE | order);
+}
+
+static void pmm_list_remove(size_t pfn, size_t order)
+{
+    PmmFreeBlock* block = pmm_pfn_to_block(pfn);
+    if (block->prev)
+        block->prev->next = block->next;
+    else
+        s_pmm_free_lists[order] = block->next;
+    if (block->next)
+        block->next->prev = block->prev;
+    if (!s_pmm_free_lists[order])
+        s_pmm_order_mask &= ~(1u << order);
+    s_pmm_page_info[pfn] = 0;
+}
+
+// Blogu serbest listeye koy; buddy'si ayni order'da serbestse birlestir
+static void pmm_free_block(size_t pfn, size_t order)
 {
-    if (!memory_regions || sizeInKB == 0)
+    s_pmm_free_pages += (size_t)1 << order;
+    s_pmm_page_info[pfn] = 0;
+
+    while (order < PMM_MAX_ORDER)
     {
-        LOG("pmm_alloc: invalid parameters (memory_regions=%p, sizeInKB=%zu)", (void *)memory_regions, sizeInKB);
-        return NULL;
+        size_t buddy = pfn ^ ((size_t)1 << order);
+        if (buddy >= s_pmm_max_pfn || s_pmm_page_info[buddy] != (PMM_INFO_FREE | order))
+            break;
+        pmm_list_remove(buddy, order);
+        if (buddy < pfn)
+            pfn = buddy;
+        order++;
     }
 
-    // KB -> bytes, overflow guard
-    if (sizeInKB > (SIZE_MAX / 1024))
+    pmm_list_push(pfn, order);
+}
+
+// [start, end) sayfa araligini mumkun olan en buyuk hizali bloklar halinde serbest birak
+static void pmm_free_range(size_t start, size_t end)
+{
+    while (start < end)
     {
-        LOG("pmm_alloc: sizeInKB too large: %zu", sizeInKB);
-        return NULL; // overflow korumasi
+        size_t order = PMM_MAX_ORDER;
+        if (start)
+        {
+            size_t align = (size_t)__builtin_ctzl((unsigned long)start);
+            if (align < order)
+                order = align;
+        }
+        while (start + ((size_t)1 << order) > end)
+            order--;
+
+        pmm_free_block(start, order);
+        start += (size_t)1 << order;
     }
-    size_t bytes = sizeInKB * 1024;
+}
+
+static void* pmm_alloc_block(size_t order)
+{
+    if (order > PMM_MAX_ORDER)
+        return NULL;
+
+    uint32_t candidates = s_pmm_order_mask >> order;
+    if (!candidates)
+        return NULL;
+
+    size_t found = order + (size_t)__builtin_ctz(candidates);
+    PmmFreeBlock* block = s_pmm_free_lists[found];
+    size_t pfn = pmm_block_to_pfn(block);
+    pmm_list_remove(pfn, found);
 
-    // 4KiB hizalama (EFI_PAGE_SIZE)
-    const size_t PAGE = EFI_PAGE_SIZE; // 4096
-    size_t alloc_size = (bytes + PAGE - 1) & ~(PAGE - 1);
-    if (alloc_size == 0)
+    // Artan yarilari bir alt order'a geri ver
+    while (found > order)
     {
-        LOG("pmm_alloc: alloc_size overflow for sizeInKB=%zu", sizeInKB);
-        return NULL; // overflow korumasi
+        found--;
+        pmm_list_push(pfn + ((size_t)1 << found), found);
     }
 
-    // Birlestirme uygula ki duzgun buyuk blok bulalim
-    pmm_maintain();
+    s_pmm_free_pages -= (size_t)1 << order;
+    s_pmm_page_info[pfn] = (uint8_t)(PMM_INFO_ALLOC | order);
+    return (void*)block;
+}
 
-    size_t index = 0;
-    for (ListNode *node = memory_regions->head; node; node = node->next, ++index)
+static bool pmm_region_is_reclaimable(MemoryRegionType type)
+{
+    switch (type)
     {
-        MemoryRegion *cur = (MemoryRegion *)node->data;
-        if (!cur || cur->type != MemoryRegionType_USABLE)
+    case MemoryRegionType_USABLE:
+    case MemoryRegionType_EFI_BS_CODE:
+    case MemoryRegionType_EFI_BS_DATA:
+    case MemoryRegionType_EFI_LOADER_CODE:
+    case MemoryRegionType_EFI_LOADER_DATA:
+    case MemoryRegionType_ACPI_RECLAIMABLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Bolgenin icine tam oturan sayfa araligini hesapla (PMM_PHYS_LIMIT ile kirpilir)
+static bool pmm_region_pages(uint64_t base, uint64_t size, size_t* out_start, size_t* out_end)
+{
+    uint64_t end = base + size;
+    if (end > PMM_PHYS_LIMIT)
+        end = PMM_PHYS_LIMIT;
+
+    uint64_t first = (base + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+    uint64_t last = end >> PMM_PAGE_SHIFT;
+    if (first >= last)
+        return false;
+
+    *out_start = (size_t)first;
+    *out_end = (size_t)last;
+    return true;
+}
+
+// [start, end) araligini, holes ile verilen sayfalari atlayarak buddy'ye aktar
+static void pmm_seed_range(size_t start, size_t end, const size_t (*holes)[2], size_t hole_count)
+{
+    if (start == 0)
+        start = 1; // NULL sayfasini asla dagitma
+
+    for (size_t i = 0; i < hole_count && start < end; i++)
+    {
+        size_t hs = holes[i][0];
+        size_t he = holes[i][1];
+        if (he <= start || hs >= end)
             continue;
+        if (hs > start)
+            pmm_seed_range(start, hs, holes + i + 1, hole_count - i - 1);
+        start = he;
+    }
 
-        // Tahsis baslangic adresini 4KiB'e hizala
-        size_t aligned_base = (cur->base + PAGE - 1) & ~(PAGE - 1);
-        if (aligned_base < cur->base)
-            continue; // overflow korumasi
+    if (start < end)
+    {
+        s_pmm_total_pages += end - start;
+        pmm_free_range(start, end);
+    }
+}
 
-        size_t gap = aligned_base - cur->base; // on kisim (USABLE kalacak)
-        if (cur->size < gap + alloc_size)
-            continue; // bu bolge yeterli degil
+// Acilistan sonra da okunan ve loader bellegi icinde duran alanlar:
+// Multiboot2 bilgi blogu (mb2_* etiketleri) ve ilk modul. Artan sirada doner.
+static size_t pmm_boot_holes(size_t holes[2][2])
+{
+    size_t count = 0;
 
-        // Durum 1: gap == 0 ve tam uyan blok -> mevcut dugumu RESERVED yap
-        if (gap == 0 && cur->size == alloc_size)
+    if (mb2_tagptr)
+    {
+        holes[count][0] = mb2_tagptr >> PMM_PAGE_SHIFT;
+        holes[count][1] = (mb2_tagptr + *(uint32_t*)(uintptr_t)mb2_tagptr + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+        count++;
+    }
+
+    if (mb2_module && mb2_module->mod_end > mb2_module->mod_start)
+    {
+        holes[count][0] = mb2_module->mod_start >> PMM_PAGE_SHIFT;
+        holes[count][1] = ((size_t)mb2_module->mod_end + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+        if (count == 1 && holes[1][0] < holes[0][0])
         {
-            void *ret = (void *)(uintptr_t)cur->base;
-            cur->type = MemoryRegionType_RESERVED;
-            return ret;
+            size_t s0 = holes[0][0], e0 = holes[0][1];
+            holes[0][0] = holes[1][0]; holes[0][1] = holes[1][1];
+            holes[1][0] = s0; holes[1][1] = e0;
         }
+        count++;
+    }
 
-        size_t cur_end = cur->base + cur->size;
-        size_t alloc_end = aligned_base + alloc_size;
+    return count;
+}
 
-        // gap == 0 ise: mevcut dugumu ALLOCATED yap, sadece suffix icin tek malloc kullan
-        if (gap == 0)
-        {
-            void *ret = (void *)(uintptr_t)cur->base;
-            // Mevcut dugumu allocated'a cevir
-            cur->type = MemoryRegionType_RESERVED;
-            cur->size = alloc_size;
+static void pmm_buddy_init(void)
+{
+    // 1) Yonetilecek en yuksek sayfa numarasini bul
+    size_t max_pfn = 0;
+    for (ListNode* node = memory_regions->head; node; node = node->next)
+    {
+        MemoryRegion* region = (MemoryRegion*)node->data;
+        size_t start, end;
+        if (!region || !pmm_region_is_reclaimable(region->type))
+            continue;
+        if (pmm_region_pages(region->base, region->size, &start, &end) && end > max_pfn)
+            max_pfn = end;
+    }
 
-            // Suffix var mi?
-            if (alloc_end < cur_end)
-            {
-                MemoryRegion *suffix = (MemoryRegion *)malloc(sizeof(MemoryRegion));
-                if (!suffix)
-                {
-                    ERROR("pmm_alloc: suffix allocation failed for size %lu", (unsigned long)alloc_size);
-                    return NULL;
-                }
-                suffix->base = alloc_end;
-                suffix->size = cur_end - alloc_end;
-                suffix->type = MemoryRegionType_USABLE;
-
-                // allocated nodenin hemen arkasina suffix ekle
-                if (!List_InsertAt(memory_regions, index + 1, suffix))
-                {
-                    ERROR("pmm_alloc: List_InsertAt failed while inserting suffix");
-                    free(suffix);
-                    return NULL;
-                }
-            }
-            return ret;
-        }
+    if (max_pfn == 0)
+    {
+        ERROR("pmm: no usable memory found in memory map");
+        return;
+    }
 
-        // gap > 0 ise: cur prefix olarak kalir; ayrica alloc ve gerekirse suffix nodelari eklenir
-        MemoryRegion *alloc_region = (MemoryRegion *)malloc(sizeof(MemoryRegion));
-        if (!alloc_region)
+    // 2) Multiboot2 bilgi blogu ve modul hala kullaniliyor (mb2_* etiketleri), dagitma
+    size_t boot_holes[2][2];
+    size_t boot_hole_count = pmm_boot_holes(boot_holes);
+
+    // 3) Sayfa bilgi dizisini ilk uygun USABLE bolgeye yerlestir
+    size_t info_pages = (max_pfn + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    size_t info_pfn = 0;
+    for (ListNode* node = memory_regions->head; node; node = node->next)
+    {
+        MemoryRegion* region = (MemoryRegion*)node->data;
+        size_t start, end;
+        if (!region || region->type != MemoryRegionType_USABLE)
+            continue;
+        if (!pmm_region_pages(region->base, region->size, &start, &end))
+            continue;
+        if (start == 0)
+            start = 1;
+        for (size_t i = 0; i < boot_hole_count; i++)
         {
-            ERROR("pmm_alloc: alloc_region allocation failed");
-            return NULL;
+            if (start < boot_holes[i][1] && start + info_pages > boot_holes[i][0])
+                start = boot_holes[i][1];
         }
-        alloc_region->base = aligned_base;
-        alloc_region->size = alloc_size;
-        alloc_region->type = MemoryRegionType_RESERVED;
+        if (end > start && end - start >= info_pages)
+        {
+            info_pfn = start;
+            break;
+        }
+    }
 
-        // cur'u prefixe daralt
-        cur->size = gap;
-        if (!List_InsertAt(memory_regions, index + 1, alloc_region))
+    if (info_pfn == 0)
+    {
+        ERROR("pmm: no region large enough for page info (%zu pages)", info_pages);
+        return;
+    }
+
+    s_pmm_page_info = (uint8_t*)pmm_pfn_to_block(info_pfn);
+    memset(s_pmm_page_info, 0, max_pfn);
+    s_pmm_max_pfn = max_pfn;
+
+    // pmm_seed_range artan sirada delik listesi bekler: bilgi dizisini araya sok
+    size_t holes[3][2];
+    size_t hole_count = 0;
+    bool info_placed = false;
+    for (size_t i = 0; i < boot_hole_count; i++)
+    {
+        if (!info_placed && info_pfn < boot_holes[i][0])
         {
-            ERROR("pmm_alloc: List_InsertAt failed while inserting alloc_region");
-            free(alloc_region);
-            return NULL;
+            holes[hole_count][0] = info_pfn;
+            holes[hole_count][1] = info_pfn + info_pages;
+            hole_count++;
+            info_placed = true;
         }
+        holes[hole_count][0] = boot_holes[i][0];
+        holes[hole_count][1] = boot_holes[i][1];
+        hole_count++;
+    }
+    if (!info_placed)
+    {
+        holes[hole_count][0] = info_pfn;
+        holes[hole_count][1] = info_pfn + info_pages;
+        hole_count++;
+    }
+
+    // 4) USABLE bolgeleri buddy listelerine aktar
+    for (ListNode* node = memory_regions->head; node; node = node->next)
+    {
+        MemoryRegion* region = (MemoryRegion*)node->data;
+        size_t start, end;
+        if (!region || region->type != MemoryRegionType_USABLE)
+            continue;
+        if (pmm_region_pages(region->base, region->size, &start, &end))
+            pmm_seed_range(start, end, (const size_t (*)[2])holes, hole_count);
+    }
 
-        // Suffix var mi?
-        if (alloc_end < cur_end)
+    LOG("PMM: buddy allocator ready, %zu KB free of %zu KB managed (page info at 0x%lX, %zu pages)",
+        s_pmm_free_pages * (PMM_PAGE_SIZE / 1024), s_pmm_total_pages * (PMM_PAGE_SIZE / 1024),
+        (unsigned long)(info_pfn << PMM_PAGE_SHIFT), info_pages);
+}
+
+// pfn zaten buddy'ye devredilmis bir blogun (serbest ya da tahsisli) icindeyse
+// o blogun sonunu, degilse 0 dondur. Blok baslari kendi order'ina hizalidir.
+static size_t pmm_managed_block_end(size_t pfn)
+{
+    for (size_t order = 0; order <= PMM_MAX_ORDER; order++)
+    {
+        size_t head = pfn & ~(((size_t)1 << order) - 1);
+        uint8_t info = s_pmm_page_info[head];
+        if ((info & (PMM_INFO_FREE | PMM_INFO_ALLOC)) && (info & PMM_INFO_ORDER_MASK) == order)
+            return head + ((size_t)1 << order);
+    }
+    return 0;
+}
+
+size_t pmm_release_region(size_t base, size_t size)
+{
+    if (!s_pmm_page_info || size == 0)
+        return 0;
+
+    size_t start, end;
+    if (!pmm_region_pages(base, size, &start, &end))
+        return 0;
+    if (end > s_pmm_max_pfn)
+        end = s_pmm_max_pfn;
+    if (start >= end)
+        return 0;
+
+    size_t holes[2][2];
+    size_t hole_count = pmm_boot_holes(holes);
+
+    size_t flags = mm_lock();
+    size_t before = s_pmm_total_pages;
+
+    // Ayni bolge iki kez birakilirsa ya da harita cakisirsa zaten yonetilen
+    // sayfalari atla; yalnizca hic dagitilmamis araliklar buddy'ye gider
+    size_t pfn = start;
+    while (pfn < end)
+    {
+        size_t managed_end = pmm_managed_block_end(pfn);
+        if (managed_end)
         {
-            MemoryRegion *suffix = (MemoryRegion *)malloc(sizeof(MemoryRegion));
-            if (!suffix)
-            {
-                ERROR("pmm_alloc: suffix allocation failed");
-                return NULL;
-            }
-            suffix->base = alloc_end;
-            suffix->size = cur_end - alloc_end;
-            suffix->type = MemoryRegionType_USABLE;
-            if (!List_InsertAt(memory_regions, index + 2, suffix))
-            {
-                ERROR("pmm_alloc: List_InsertAt failed while inserting suffix (gap>0)");
-                free(suffix);
-                return NULL;
-            }
+            pfn = managed_end;
+            continue;
         }
 
-        return (void *)(uintptr_t)alloc_region->base;
+        size_t run = pfn + 1;
+        while (run < end && !pmm_managed_block_end(run))
+            run++;
+        pmm_seed_range(pfn, run, (const size_t (*)[2])holes, hole_count);
+        pfn = run;
+    }
+
+    size_t released = s_pmm_total_pages - before;
+    s_pmm_reclaimed_pages += released;
+    mm_unlock(flags);
+    return released * PMM_PAGE_SIZE;
+}
+
+static bool pmm_region_is_boot_only(MemoryRegionType type)
+{
+    switch (type)
+    {
+    case MemoryRegionType_EFI_LOADER_CODE:
+    case MemoryRegionType_EFI_LOADER_DATA:
+    case MemoryRegionType_ACPI_RECLAIMABLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t pmm_reclaim_boot_memory(void)
+{
+    if (!memory_regions || !s_pmm_page_info)
+        return 0;
+
+    size_t reclaimed = 0;
+    for (ListNode* node = memory_regions->head; node; node = node->next)
+    {
+        MemoryRegion* region = (MemoryRegion*)node->data;
+        if (!region || !pmm_region_is_boot_only(region->type))
+            continue;
+
+        reclaimed += pmm_release_region(region->base, region->size);
+        region->type = MemoryRegionType_USABLE;
+    }
+
+    pmm_maintain();
+
+    LOG("PMM: reclaimed %zu KB of loader/ACPI memory, %zu KB free of %zu KB managed",
+        reclaimed / 1024, pmm_get_free_bytes() / 1024, pmm_get_total_bytes() / 1024);
+    return reclaimed;
+}
+
+size_t pmm_get_reclaimed_bytes(void)
+{
+    return s_pmm_reclaimed_pages * PMM_PAGE_SIZE;
+}
+
+static void* __pmm_alloc_pages(size_t order)
+{
+    if (!s_pmm_page_info)
+    {
+        ERROR("pmm_alloc_pages: PMM not initialized");
+        return NULL;
+    }
+
+    void* block = pmm_alloc_block(order);
+    if (!block)
+        ERROR("pmm_alloc_pages: no free block for order %zu", order);
+    return block;
+}
+
+// Dış giriş noktaları mm_lock altında çalışır: kesmeler kapalı, diğer CPU'lar bekler
+void* pmm_alloc_pages(size_t order)
+{
+    size_t flags = mm_lock();
+    void* result = __pmm_alloc_pages(order);
+    mm_unlock(flags);
+    return result;
+}
+
+static void *__pmm_alloc(size_t sizeInKB)
+{
+    if (!s_pmm_page_info || sizeInKB == 0)
+    {
+        LOG("pmm_alloc: invalid parameters (initialized=%d, sizeInKB=%zu)", s_pmm_page_info != NULL, sizeInKB);
+        return NULL;
     }
 
-    ERROR("pmm_alloc: no suitable block found for sizeInKB=%08u", (uint32_t)sizeInKB);
-    return NULL; // uygun blok yok
+    // KB -> sayfa, overflow guard
+    if (sizeInKB > (SIZE_MAX / 1024) - PMM_PAGE_SIZE)
+    {
+        LOG("pmm_alloc: sizeInKB too large: %zu", sizeInKB);
+        return NULL;
+    }
+    size_t pages = (sizeInKB * 1024 + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+
+    size_t order = 0;
+    while (order <= PMM_MAX_ORDER && ((size_t)1 << order) < pages)
+        order++;
+
+    void* block = pmm_alloc_block(order);
+    if (!block)
+    {
+        ERROR("pmm_alloc: no suitable block found for sizeInKB=%08u", (uint32_t)sizeInKB);
+        return NULL;
+    }
+
+    // 2^order'a yuvarlanan blogun fazlasini geri ver. Istenen sayfalar ikilik
+    // ayrisimina gore parcalara bolunur; ilk parca disindakiler CONT ile
+    // isaretlenir ki pmm_free tum tahsisi tek cagrida geri verebilsin.
+    size_t pfn = pmm_block_to_pfn(block);
+    size_t block_end = pfn + ((size_t)1 << order);
+    size_t cur = pfn;
+    for (size_t o = order + 1; o-- > 0;)
+    {
+        if (!(pages & ((size_t)1 << o)))
+            continue;
+        s_pmm_page_info[cur] = (uint8_t)(PMM_INFO_ALLOC | (cur != pfn ? PMM_INFO_CONT : 0) | o);
+        cur += (size_t)1 << o;
+    }
+
+    if (cur < block_end)
+        pmm_free_range(cur, block_end);
+
+    return block;
+}
+
+void* pmm_alloc(size_t sizeInKB)
+{
+    size_t flags = mm_lock();
+    void* result = __pmm_alloc(sizeInKB);
+    mm_unlock(flags);
+    return result;
 }
 
-void pmm_free(void *ptr)
+static void __pmm_free(void *ptr)
 {
-    if (!ptr || !memory_regions)
+    if (!ptr || !s_pmm_page_info)
         return;
 
     size_t addr = (size_t)(uintptr_t)ptr;
 
-    if (addr % 4096 != 0)
+    if (addr % PMM_PAGE_SIZE != 0)
     {
         // Align down to page size
         LOG("pmm_free: address is not page-aligned: 0x%lX", (unsigned long)addr);
-        addr = addr & ~(4096 - 1);
+        addr = addr & ~(PMM_PAGE_SIZE - 1);
         LOG("pmm_free: aligned address: 0x%lX", (unsigned long)addr);
     }
 
-    // Ilgili bolgeyi bul
-    ListNode *node = memory_regions->head;
-    MemoryRegion *freed = NULL;
-    while (node)
+    size_t pfn = addr >> PMM_PAGE_SHIFT;
+    if (pfn >= s_pmm_max_pfn)
     {
-        MemoryRegion *r = (MemoryRegion *)node->data;
-        if (r && r->base == addr)
-        {
-            freed = r;
-            break;
-        }
-        node = node->next;
+        LOG("pmm_free: adres yonetilen aralik disinda: 0x%lX", (unsigned long)addr);
+        return;
     }
 
-    if (!freed)
+    uint8_t info = s_pmm_page_info[pfn];
+    if (info & PMM_INFO_FREE)
     {
-        LOG("pmm_free: adres bulunamadi: 0x%lX", (unsigned long)addr);
+        LOG("pmm_free: cift free: 0x%lX", (unsigned long)addr);
         return;
     }
-
-    if (freed->type == MemoryRegionType_USABLE)
+    if (!(info & PMM_INFO_ALLOC) || (info & PMM_INFO_CONT))
     {
-        LOG("pmm_free: cift free veya zaten USABLE: 0x%lX", (unsigned long)addr);
+        LOG("pmm_free: adres bir tahsis basi degil: 0x%lX", (unsigned long)addr);
         return;
     }
 
-    // Serbest birak ve USABLE yap
-    freed->type = MemoryRegionType_USABLE;
-
-    // Hedefe komsu/dahil USABLE bloklarla birlestir (liste sirali olmasa bile tum listeyi tara)
-    bool merged;
+    // Ilk parca ve ardindaki CONT parcalari serbest birak
     do
     {
-        merged = false;
-        size_t freed_end = freed->base + freed->size;
-
-        for (ListNode *n = memory_regions->head; n; n = n->next)
-        {
-            MemoryRegion *mr = (MemoryRegion *)n->data;
-            if (!mr || mr == freed || mr->type != MemoryRegionType_USABLE)
-                continue;
-
-            size_t mr_end = mr->base + mr->size;
-
-            // Bitişik ya da örtüşen durum
-            if (!(mr->base > freed_end || mr_end < freed->base))
-            {
-                // kapsayici aralik
-                size_t new_base = (freed->base < mr->base) ? freed->base : mr->base;
-                size_t new_end = (freed_end > mr_end) ? freed_end : mr_end;
-                freed->base = new_base;
-                freed->size = new_end - new_base;
-
-                // mr dugumunu listeden cikar ve verisini serbest birak
-                MemoryRegion *to_free = mr;
-                List_Remove(memory_regions, to_free);
-                free(to_free);
-
-                // birlesme oldu; tekrar tara
-                merged = true;
-                break;
-            }
+        size_t order = info & PMM_INFO_ORDER_MASK;
+        size_t next = pfn + ((size_t)1 << order);
+        pmm_free_block(pfn, order);
+        pfn = next;
+        info = (pfn < s_pmm_max_pfn) ? s_pmm_page_info[pfn] : 0;
+    } while ((info & (PMM_INFO_ALLOC | PMM_INFO_CONT)) == (PMM_INFO_ALLOC | PMM_INFO_CONT));
+}
 
-            // Sol bitisik: mr_end == freed->base
-            if (mr_end == freed->base)
-            {
-                freed->base = mr->base;
-                freed->size += mr->size;
-                MemoryRegion *to_free = mr;
-                List_Remove(memory_regions, to_free);
-                free(to_free);
-                merged = true;
-                break;
-            }
+void pmm_free(void* ptr)
+{
+    size_t flags = mm_lock();
+    __pmm_free(ptr);
+    mm_unlock(flags);
+}
 
-            // Sag bitisik: freed_end == mr->base
-            if (freed_end == mr->base)
-            {
-                freed->size += mr->size;
-                MemoryRegion *to_free = mr;
-                List_Remove(memory_regions, to_free);
-                free(to_free);
-                merged = true;
-                break;
-            }
-        }
+size_t pmm_get_free_bytes(void)
+{
+    return s_pmm_free_pages * PMM_PAGE_SIZE;
+}
 
-    } while (merged);
+size_t pmm_get_total_bytes(void)
+{
+    return s_pmm_total_pages * PMM_PAGE_SIZE;
 }
@@ -0,0 +1,381 @@
+#include <memory/slab.h>
+#include <memory/pmm.h>
+#include <memory/heap.h>
+#include <memory/memory.h>
+#include <util/string.h>
+#include <debug/debug.h>
+#include <arch.h>
+
+#define KMEM_PAGE_SIZE          4096u
+#define KMEM_SLAB_MAX_ORDER     3       // En fazla 32 KiB'lik slab
+#define KMEM_SLAB_MIN_OBJECTS   8
+#define KMEM_MAX_EMPTY_SLABS    1       // Bundan fazla boş slab sayfa ayırıcıya döner
+#define KMEM_NAME_MAX           32
+
+typedef struct KmemSlab {
+    KmemCache* cache;
+    struct KmemSlab* next;
+    struct KmemSlab* prev;
+    void* free_list;        // Serbest nesneler, ilk word'lerinde bir sonrakini tutar
+    uint32_t inuse;
+    bool from_heap;         // PMM hazır olmadan alınan slab'lar heap'e döner
+} KmemSlab;
+
+struct KmemCache {
+    char name[KMEM_NAME_MAX];
+    size_t object_size;
+    size_t first_offset;    // Slab başlığından sonra ilk nesnenin ofseti
+    size_t objects_per_slab;
+    uint32_t order;
+    KmemSlab* partial;
+    KmemSlab* full;
+    KmemSlab* empty;
+    size_t slab_count;
+    size_t empty_count;
+    size_t active_objects;
+    size_t alloc_count;
+    size_t free_count;
+    struct KmemCache* next; // Tüm cache'lerin listesi (istatistik için)
+};
+
+// KmemCache nesnelerinin kendisi de bir slab cache'ten gelir
+static KmemCache s_cache_cache;
+static bool s_cache_cache_ready = false;
+static KmemCache* s_caches = NULL;
+
+static void* __kmem_cache_alloc(KmemCache* cache);
+static void __kmem_cache_free(KmemCache* cache, void* object);
+
+static inline size_t kmem_align_up(size_t x, size_t align)
+{
+    return (x + (align - 1)) & ~(align - 1);
+}
+
+static inline size_t kmem_slab_bytes(const KmemCache* cache)
+{
+    return (size_t)KMEM_PAGE_SIZE << cache->order;
+}
+
+static void kmem_slab_list_push(KmemSlab** head, KmemSlab* slab)
+{
+    slab->prev = NULL;
+    slab->next = *head;
+    if (*head) (*head)->prev = slab;
+    *head = slab;
+}
+
+static void kmem_slab_list_remove(KmemSlab** head, KmemSlab* slab)
+{
+    if (slab->prev) slab->prev->next = slab->next;
+    else *head = slab->next;
+    if (slab->next) slab->next->prev = slab->prev;
+    slab->next = slab->prev = NULL;
+}
+
+static bool kmem_cache_setup(KmemCache* cache, const char* name, size_t object_size, size_t align)
+{
+    if (align == 0) align = sizeof(void*);
+    if (align < sizeof(void*) || (align & (align - 1)) != 0)
+        return false;
+
+    if (object_size < sizeof(void*))
+        object_size = sizeof(void*);
+
+    memset(cache, 0, sizeof(*cache));
+    if (name)
+    {
+        size_t len = strlen(name);
+        if (len >= KMEM_NAME_MAX) len = KMEM_NAME_MAX - 1;
+        memcpy(cache->name, name, len);
+        cache->name[len] = '\0';
+    }
+
+    cache->object_size = kmem_align_up(object_size, align);
+    cache->first_offset = kmem_align_up(sizeof(KmemSlab), align);
+
+    // Slab başına en az KMEM_SLAB_MIN_OBJECTS nesne sığacak en küçük order
+    for (cache->order = 0; cache->order < KMEM_SLAB_MAX_ORDER; cache->order++)
+    {
+        if ((kmem_slab_bytes(cache) - cache->first_offset) / cache->object_size >= KMEM_SLAB_MIN_OBJECTS)
+            break;
+    }
+
+    if (cache->first_offset + cache->object_size > kmem_slab_bytes(cache))
+        return false; // Nesne tek bir slab'a bile sığmıyor
+
+    cache->objects_per_slab = (kmem_slab_bytes(cache) - cache->first_offset) / cache->object_size;
+
+    cache->next = s_caches;
+    s_caches = cache;
+    return true;
+}
+
+static KmemSlab* kmem_slab_create(KmemCache* cache)
+{
+    size_t bytes = kmem_slab_bytes(cache);
+    bool from_heap = false;
+    void* mem = NULL;
+
+    if (pmm_get_total_bytes() != 0)
+        mem = pmm_alloc_pages(cache->order);
+
+    if (!mem)
+    {
+        // Erken açılış: buddy allocator henüz kurulmadı
+        mem = heap_aligned_alloc(bytes, bytes);
+        from_heap = true;
+    }
+
+    if (!mem)
+        return NULL;
+
+    KmemSlab* slab = (KmemSlab*)mem;
+    slab->cache = cache;
+    slab->next = slab->prev = NULL;
+    slab->inuse = 0;
+    slab->from_heap = from_heap;
+
+    // Serbest listeyi adres sırasıyla kur
+    uint8_t* obj = (uint8_t*)mem + cache->first_offset;
+    slab->free_list = obj;
+    for (size_t i = 0; i + 1 < cache->objects_per_slab; i++, obj += cache->object_size)
+        *(void**)obj = obj + cache->object_size;
+    *(void**)obj = NULL;
+
+    cache->slab_count++;
+    return slab;
+}
+
+static void kmem_slab_release(KmemCache* cache, KmemSlab* slab)
+{
+    cache->slab_count--;
+    if (slab->from_heap)
+        heap_free(slab);
+    else
+        pmm_free(slab);
+}
+
+static void kmem_cache_cache_init(void)
+{
+    if (s_cache_cache_ready) return;
+    kmem_cache_setup(&s_cache_cache, "kmem_cache", sizeof(KmemCache), 0);
+    s_cache_cache_ready = true;
+}
+
+// s_caches ve slab listeleri de mm_lock altında değişir (kilit aynı CPU'da iç içe alınabilir)
+KmemCache* kmem_cache_create(const char* name, size_t object_size, size_t align)
+{
+    if (object_size == 0) return NULL;
+
+    size_t flags = mm_lock();
+    kmem_cache_cache_init();
+
+    KmemCache* cache = (KmemCache*)__kmem_cache_alloc(&s_cache_cache);
+    if (cache && !kmem_cache_setup(cache, name, object_size, align))
+    {
+        ERROR("kmem_cache_create: invalid geometry for '%s' (size=%zu align=%zu)",
+              name ? name : "?", object_size, align);
+        __kmem_cache_free(&s_cache_cache, cache);
+        cache = NULL;
+    }
+    mm_unlock(flags);
+
+    return cache;
+}
+
+KmemCache* kmem_cache_get(KmemCache** slot, const char* name, size_t object_size, size_t align)
+{
+    if (!slot) return NULL;
+    KmemCache* cache = *(KmemCache* volatile*)slot;
+    if (cache) return cache;
+
+    // Yavaş yol: kilit altında yeniden bak, yarışı kaybeden ikinci cache açmasın
+    size_t flags = mm_lock();
+    cache = *slot;
+    if (!cache)
+    {
+        cache = kmem_cache_create(name, object_size, align);
+        __asm__ __volatile__("" ::: "memory"); // Cache kurulumu işaretçiden önce görünür
+        *(KmemCache* volatile*)slot = cache;
+    }
+    mm_unlock(flags);
+    return cache;
+}
+
+static void kmem_release_list(KmemCache* cache, KmemSlab** head)
+{
+    while (*head)
+    {
+        KmemSlab* slab = *head;
+        kmem_slab_list_remove(head, slab);
+        kmem_slab_release(cache, slab);
+    }
+}
+
+void kmem_cache_destroy(KmemCache* cache)
+{
+    if (!cache || cache == &s_cache_cache) return;
+
+    size_t flags = mm_lock();
+    if (cache->active_objects)
+        WARN("kmem_cache_destroy: '%s' still has %zu active objects", cache->name, cache->active_objects);
+
+    kmem_release_list(cache, &cache->empty);
+    kmem_release_list(cache, &cache->partial);
+    kmem_release_list(cache, &cache->full);
+
+    for (KmemCache** it = &s_caches; *it; it = &(*it)->next)
+    {
+        if (*it == cache)
+        {
+            *it = cache->next;
+            break;
+        }
+    }
+
+    __kmem_cache_free(&s_cache_cache, cache);
+    mm_unlock(flags);
+}
+
+static void* __kmem_cache_alloc(KmemCache* cache)
+{
+    if (!cache) return NULL;
+
+    KmemSlab* slab = cache->partial;
+    if (!slab)
+    {
+        slab = cache->empty;
+        if (slab)
+        {
+            kmem_slab_list_remove(&cache->empty, slab);
+            cache->empty_count--;
+        }
+        else
+        {
+            slab = kmem_slab_create(cache);
+            if (!slab)
+            {
+                ERROR("kmem_cache_alloc: out of memory for cache '%s'", cache->name);
+                return NULL;
+            }
+        }
+        kmem_slab_list_push(&cache->partial, slab);
+    }
+
+    void* obj = slab->free_list;
+    slab->free_list = *(void**)obj;
+    slab->inuse++;
+
+    if (slab->inuse == cache->objects_per_slab)
+    {
+        kmem_slab_list_remove(&cache->partial, slab);
+        kmem_slab_list_push(&cache->full, slab);
+    }
+
+    cache->active_objects++;
+    cache->alloc_count++;
+    return obj;
+}
+
+// mm_lock altında çalışır (iş parçacıkları, IRQ'lar ve AP'ler aynı cache'leri paylaşır)
+void* kmem_cache_alloc(KmemCache* cache)
+{
+    size_t flags = mm_lock();
+    void* result = __kmem_cache_alloc(cache);
+    mm_unlock(flags);
+    return result;
+}
+
+void* kmem_cache_zalloc(KmemCache* cache)
+{
+    void* obj = kmem_cache_alloc(cache);
+    if (obj) memset(obj, 0, cache->object_size);
+    return obj;
+}
+
+static void __kmem_cache_free(KmemCache* cache, void* object)
+{
+    if (!cache || !object) return;
+
+    KmemSlab* slab = (KmemSlab*)((uintptr_t)object & ~(uintptr_t)(kmem_slab_bytes(cache) - 1));
+    if (slab->cache != cache)
+    {
+        WARN("kmem_cache_free: %p does not belong to cache '%s'", object, cache->name);
+        return;
+    }
+
+    bool was_full = (slab->inuse == cache->objects_per_slab);
+
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+    slab->inuse--;
+    cache->active_objects--;
+    cache->free_count++;
+
+    if (slab->inuse == 0)
+    {
+        kmem_slab_list_remove(was_full ? &cache->full : &cache->partial, slab);
+        if (cache->empty_count >= KMEM_MAX_EMPTY_SLABS)
+        {
+            kmem_slab_release(cache, slab);
+        }
+        else
+        {
+            kmem_slab_list_push(&cache->empty, slab);
+            cache->empty_count++;
+        }
+    }
+    else if (was_full)
+    {
+        kmem_slab_list_remove(&cache->full, slab);
+        kmem_slab_list_push(&cache->partial, slab);
+    }
+}
+
+void kmem_cache_free(KmemCache* cache, void* object)
+{
+    size_t flags = mm_lock();
+    __kmem_cache_free(cache, object);
+    mm_unlock(flags);
+}
+
+void kmem_cache_shrink(KmemCache* cache)
+{
+    if (!cache) return;
+    size_t flags = mm_lock();
+    kmem_release_list(cache, &cache->empty);
+    cache->empty_count = 0;
+    mm_unlock(flags);
+}
+
+void kmem_cache_get_stats(KmemCache* cache, KmemCacheStats* out_stats)
+{
+    if (!cache || !out_stats) return;
+    size_t flags = mm_lock();
+    out_stats->name = cache->name;
+    out_stats->object_size = cache->object_size;
+    out_stats->objects_per_slab = cache->objects_per_slab;
+    out_stats->slab_bytes = kmem_slab_bytes(cache);
+    out_stats->slab_count = cache->slab_count;
+    out_stats->active_objects = cache->active_objects;
+    out_stats->total_objects = cache->slab_count * cache->objects_per_slab;
+    out_stats->alloc_count = cache->alloc_count;
+    out_stats->free_count = cache->free_count;
+    mm_unlock(flags);
+}
+
+void kmem_cache_dump_stats(void)
+{
+    LOG("Slab caches:");
+    // Liste kilit altında gezilir; LOG'un realloc'u aynı kilidi iç içe alır
+    size_t flags = mm_lock();
+    for (KmemCache* cache = s_caches; cache; cache = cache->next)
+    {
+        KmemCacheStats stats;
+        kmem_cache_get_stats(cache, &stats);
+        LOG("  %-16s obj=%zu active=%zu/%zu slabs=%zu (%zu B each) allocs=%zu frees=%zu",
+            stats.name, stats.object_size, stats.active_objects, stats.total_objects,
+            stats.slab_count, stats.slab_bytes, stats.alloc_count, stats.free_count);
+    }
+    mm_unlock(flags);
+}
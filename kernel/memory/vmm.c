@@ -0,0 +1,401 @@
+#include <memory/vmm.h>
+#include <memory/pmm.h>
+#include <memory/heap.h>
+#include <memory/slab.h>
+#include <memory/memory.h>
+#include <debug/debug.h>
+#include <arch.h>
+
+#define VMM_PAGE_SIZE        4096u
+#define VMM_GUARD_PAGES      1       // Her alanın arkasında eşlenmemiş bir sayfa bırak
+
+#define VM_AREA_OWNS_PAGES   (1u << 0)  // vmalloc: sayfalar vfree ile PMM'e döner
+#define VM_AREA_CONTIG_PMM   (1u << 1)  // Pencere yok: tek parça pmm_alloc bloğu
+#define VM_AREA_HEAP         (1u << 2)  // PMM hazır değil: heap'ten sayfa hizalı blok
+
+typedef struct VmArea {
+    uintptr_t base;
+    size_t pages;
+    uint32_t flags;
+    uintptr_t* phys;        // vmalloc alanlarının fiziksel sayfaları
+    struct VmArea* next;
+} VmArea;
+
+static KmemCache* s_area_cache = NULL;
+static VmArea* s_areas = NULL;          // Penceredeki alanlar, adrese göre sıralı
+static VmArea* s_fallback_areas = NULL; // Pencere dışındaki (fiziksel) alanlar
+
+static bool s_window_probed = false;
+static bool s_has_window = false;
+static uintptr_t s_window_start = 0;
+static uintptr_t s_window_end = 0;
+
+static size_t s_mapped_pages = 0;
+static size_t s_fallback_bytes = 0;
+
+static bool vmm_window(void)
+{
+    if (!s_window_probed)
+    {
+        s_has_window = arch_vmm_get_window(&s_window_start, &s_window_end);
+        s_window_probed = true;
+    }
+    return s_has_window;
+}
+
+static VmArea* vmm_area_new(void)
+{
+    KmemCache* cache = kmem_cache_get(&s_area_cache, "VmArea", sizeof(VmArea), 0);
+    return cache ? (VmArea*)kmem_cache_zalloc(cache) : NULL;
+}
+
+// İlk uygun boşluğu bul ve alanı sıralı listeye ekle
+static VmArea* vmm_reserve(size_t pages)
+{
+    size_t span = (pages + VMM_GUARD_PAGES) * VMM_PAGE_SIZE;
+    if (pages == 0 || span / VMM_PAGE_SIZE != pages + VMM_GUARD_PAGES)
+        return NULL;
+
+    uintptr_t cursor = s_window_start;
+    VmArea** link = &s_areas;
+
+    while (*link)
+    {
+        VmArea* area = *link;
+        if (area->base - cursor >= span)
+            break;
+        cursor = area->base + (area->pages + VMM_GUARD_PAGES) * VMM_PAGE_SIZE;
+        link = &area->next;
+    }
+
+    if (s_window_end - cursor < span)
+        return NULL;
+
+    VmArea* area = vmm_area_new();
+    if (!area) return NULL;
+
+    area->base = cursor;
+    area->pages = pages;
+    area->next = *link;
+    *link = area;
+    return area;
+}
+
+static VmArea* vmm_unlink(VmArea** head, uintptr_t base)
+{
+    for (VmArea** link = head; *link; link = &(*link)->next)
+    {
+        VmArea* area = *link;
+        if (area->base == base)
+        {
+            *link = area->next;
+            area->next = NULL;
+            return area;
+        }
+        if (head == &s_areas && area->base > base)
+            break;
+    }
+    return NULL;
+}
+
+static void* vmm_fallback_alloc(size_t pages)
+{
+    VmArea* area = vmm_area_new();
+    if (!area) return NULL;
+
+    void* mem;
+    if (pmm_get_total_bytes() != 0)
+    {
+        mem = pmm_alloc(pages * (VMM_PAGE_SIZE / 1024));
+        area->flags = VM_AREA_CONTIG_PMM;
+    }
+    else
+    {
+        mem = heap_aligned_alloc(VMM_PAGE_SIZE, pages * VMM_PAGE_SIZE);
+        area->flags = VM_AREA_HEAP;
+    }
+
+    if (!mem)
+    {
+        kmem_cache_free(s_area_cache, area);
+        return NULL;
+    }
+
+    area->base = (uintptr_t)mem;
+    area->pages = pages;
+    area->next = s_fallback_areas;
+    s_fallback_areas = area;
+    s_fallback_bytes += pages * VMM_PAGE_SIZE;
+    return mem;
+}
+
+static void vmm_release_pages(uintptr_t* phys, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (phys[i]) pmm_free((void*)phys[i]);
+    }
+}
+
+// Penceredeki bir alanın eşlemesini kaldır; vmalloc alanıysa sayfaları da geri ver
+static void vmm_destroy_area(VmArea* area)
+{
+    // Önce tüm PTE'ler temizlenir ve her CPU'nun TLB'si boşaltılır (shootdown), sonra sayfalar PMM'e döner
+    arch_vmm_unmap_pages(area->base, area->pages, NULL);
+    if (area->flags & VM_AREA_OWNS_PAGES)
+    {
+        vmm_release_pages(area->phys, area->pages);
+        heap_free(area->phys);
+    }
+    s_mapped_pages -= area->pages;
+    kmem_cache_free(s_area_cache, area);
+}
+
+static void* __vmalloc(size_t size)
+{
+    if (size == 0) return NULL;
+
+    size_t pages = (size + VMM_PAGE_SIZE - 1) / VMM_PAGE_SIZE;
+
+    if (!vmm_window() || pmm_get_total_bytes() == 0)
+        return vmm_fallback_alloc(pages);
+
+    uintptr_t* phys = (uintptr_t*)heap_alloc(pages * sizeof(uintptr_t));
+    if (!phys) return NULL;
+
+    // Sayfalar tek tek alınır; fiziksel süreklilik gerekmez
+    for (size_t i = 0; i < pages; i++)
+    {
+        phys[i] = (uintptr_t)pmm_alloc_pages(0);
+        if (!phys[i])
+        {
+            ERROR("vmalloc: out of physical pages (%zu/%zu)", i, pages);
+            vmm_release_pages(phys, i);
+            heap_free(phys);
+            return NULL;
+        }
+    }
+
+    VmArea* area = vmm_reserve(pages);
+    if (!area)
+    {
+        ERROR("vmalloc: no virtual space for %zu pages", pages);
+        vmm_release_pages(phys, pages);
+        heap_free(phys);
+        return NULL;
+    }
+
+    if (!arch_vmm_map_pages(area->base, phys, pages, ARCH_PAGING_MT_WB))
+    {
+        ERROR("vmalloc: mapping %zu pages at %p failed", pages, (void*)area->base);
+        vmm_unlink(&s_areas, area->base);
+        kmem_cache_free(s_area_cache, area);
+        vmm_release_pages(phys, pages);
+        heap_free(phys);
+        return NULL;
+    }
+
+    area->flags = VM_AREA_OWNS_PAGES;
+    area->phys = phys;
+    s_mapped_pages += pages;
+    return (void*)area->base;
+}
+
+// Alan listesi iş parçacıkları ve CPU'lar arasında paylaşılır; değişiklikler mm_lock altında yapılır
+void* vmalloc(size_t size)
+{
+    size_t flags = mm_lock();
+    void* result = __vmalloc(size);
+    mm_unlock(flags);
+    return result;
+}
+
+void* vzalloc(size_t size)
+{
+    void* mem = vmalloc(size);
+    if (mem) memset(mem, 0, size);
+    return mem;
+}
+
+static void __vfree(void* addr)
+{
+    if (!addr) return;
+
+    VmArea* area = vmm_unlink(&s_areas, (uintptr_t)addr);
+    if (area)
+    {
+        if (!(area->flags & VM_AREA_OWNS_PAGES))
+            WARN("vfree: %p was created by vmap, use vunmap", addr);
+        vmm_destroy_area(area);
+        return;
+    }
+
+    area = vmm_unlink(&s_fallback_areas, (uintptr_t)addr);
+    if (!area)
+    {
+        WARN("vfree: %p is not a vmalloc address", addr);
+        return;
+    }
+
+    if (area->flags & VM_AREA_CONTIG_PMM)
+        pmm_free(addr);
+    else if (area->flags & VM_AREA_HEAP)
+        heap_free(addr);
+
+    s_fallback_bytes -= area->pages * VMM_PAGE_SIZE;
+    kmem_cache_free(s_area_cache, area);
+}
+
+void vfree(void* addr)
+{
+    size_t flags = mm_lock();
+    __vfree(addr);
+    mm_unlock(flags);
+}
+
+static void* __vmap(const uintptr_t* phys_pages, size_t count, arch_paging_memtype_t type)
+{
+    if (!phys_pages || count == 0) return NULL;
+
+    if (!vmm_window())
+    {
+        // Paging yok: yalnızca zaten sürekli olan sayfalar "eşlenebilir"
+        for (size_t i = 1; i < count; i++)
+        {
+            if (phys_pages[i] != phys_pages[0] + i * VMM_PAGE_SIZE)
+                return NULL;
+        }
+
+        VmArea* area = vmm_area_new();
+        if (!area) return NULL;
+        area->base = phys_pages[0];
+        area->pages = count;
+        area->next = s_fallback_areas;
+        s_fallback_areas = area;
+        return (void*)area->base;
+    }
+
+    VmArea* area = vmm_reserve(count);
+    if (!area) return NULL;
+
+    if (!arch_vmm_map_pages(area->base, phys_pages, count, type))
+    {
+        vmm_unlink(&s_areas, area->base);
+        kmem_cache_free(s_area_cache, area);
+        return NULL;
+    }
+
+    s_mapped_pages += count;
+    return (void*)area->base;
+}
+
+void* vmap(const uintptr_t* phys_pages, size_t count, arch_paging_memtype_t type)
+{
+    size_t flags = mm_lock();
+    void* result = __vmap(phys_pages, count, type);
+    mm_unlock(flags);
+    return result;
+}
+
+static void __vunmap(void* addr)
+{
+    if (!addr) return;
+
+    VmArea* area = vmm_unlink(&s_areas, (uintptr_t)addr);
+    if (area)
+    {
+        if (area->flags & VM_AREA_OWNS_PAGES)
+            WARN("vunmap: %p was created by vmalloc, use vfree", addr);
+        vmm_destroy_area(area);
+        return;
+    }
+
+    area = vmm_unlink(&s_fallback_areas, (uintptr_t)addr);
+    if (!area || area->flags != 0)
+    {
+        WARN("vunmap: %p is not a vmap address", addr);
+        if (area)
+        {
+            area->next = s_fallback_areas;
+            s_fallback_areas = area;
+        }
+        return;
+    }
+    kmem_cache_free(s_area_cache, area);
+}
+
+void vunmap(void* addr)
+{
+    size_t flags = mm_lock();
+    __vunmap(addr);
+    mm_unlock(flags);
+}
+
+bool vmm_is_vmalloc_addr(const void* addr)
+{
+    uintptr_t a = (uintptr_t)addr;
+
+    if (vmm_window() && a >= s_window_start && a < s_window_end)
+        return true;
+
+    for (VmArea* area = s_fallback_areas; area; area = area->next)
+    {
+        if (a >= area->base && a < area->base + area->pages * VMM_PAGE_SIZE)
+            return true;
+    }
+    return false;
+}
+
+static size_t __vmm_dma_extent(uintptr_t a, size_t len, uintptr_t* out_phys)
+{
+    if (!vmm_window() || a < s_window_start || a >= s_window_end)
+    {
+        // Identity map ya da pencere dışı sürekli blok: virt == phys
+        *out_phys = a;
+        return len;
+    }
+
+    for (VmArea* area = s_areas; area; area = area->next)
+    {
+        uintptr_t end = area->base + area->pages * VMM_PAGE_SIZE;
+        if (a < area->base || a >= end) continue;
+        if (!area->phys) return 0; // vmap: fiziksel sayfalar çağıranda
+
+        size_t page = (a - area->base) / VMM_PAGE_SIZE;
+        size_t offset = (a - area->base) % VMM_PAGE_SIZE;
+        uintptr_t phys = area->phys[page] + offset;
+        size_t run = VMM_PAGE_SIZE - offset;
+
+        // Ardışık fiziksel sayfaları birleştir
+        while (run < len && ++page < area->pages && area->phys[page] == area->phys[page - 1] + VMM_PAGE_SIZE)
+            run += VMM_PAGE_SIZE;
+
+        *out_phys = phys;
+        return run < len ? run : len;
+    }
+    return 0;
+}
+
+size_t vmm_dma_extent(const void* addr, size_t len, uintptr_t* out_phys)
+{
+    if (!out_phys || len == 0) return 0;
+
+    size_t flags = mm_lock();
+    size_t run = __vmm_dma_extent((uintptr_t)addr, len, out_phys);
+    mm_unlock(flags);
+    return run;
+}
+
+void vmm_get_stats(VmmStats* out_stats)
+{
+    if (!out_stats) return;
+
+    size_t count = 0;
+    for (VmArea* area = s_areas; area; area = area->next) count++;
+    for (VmArea* area = s_fallback_areas; area; area = area->next) count++;
+
+    out_stats->area_count = count;
+    out_stats->mapped_pages = s_mapped_pages;
+    out_stats->fallback_bytes = s_fallback_bytes;
+    out_stats->window_bytes = vmm_window() ? (size_t)(s_window_end - s_window_start) : 0;
+}
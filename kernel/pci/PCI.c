@@ -4,6 +4,8 @@
 #include <memory/heap.h>
 #include <memory/mmio.h>
 #include <debug/debug.h>
+#include <task/Executor.h>
+#include <spinlock.h>
 #include <stddef.h>
 #include <limits.h>
 
@@ -24,17 +26,35 @@ typedef struct {
 static pci_mmio_region_t g_pci_mmio_regions[PCI_MAX_TRACKED_MMIO];
 static size_t g_pci_mmio_region_count = 0;
 
+// Mechanism #1 is an address/data register pair shared by all CPUs; the
+// address write and the data access must not interleave with another CPU's.
+static Spinlock g_pciConfigLock = SPINLOCK_INIT;
+
 static inline uint32_t pci_make_config_address(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
 {
 	return (uint32_t)(0x80000000u | ((uint32_t)bus << 16) | ((uint32_t)dev << 11) | ((uint32_t)func << 8) | (offset & 0xFC));
 }
 
-uint32_t PCI_ConfigRead32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
+static inline uint32_t pci_config_read32_locked(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
 {
 	outl(PCI_CONFIG_ADDRESS, pci_make_config_address(bus, dev, func, offset));
 	return inl(PCI_CONFIG_DATA);
 }
 
+static inline void pci_config_write32_locked(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint32_t value)
+{
+	outl(PCI_CONFIG_ADDRESS, pci_make_config_address(bus, dev, func, offset));
+	outl(PCI_CONFIG_DATA, value);
+}
+
+uint32_t PCI_ConfigRead32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
+{
+	size_t flags = spin_lock_irqsave(&g_pciConfigLock);
+	uint32_t value = pci_config_read32_locked(bus, dev, func, offset);
+	spin_unlock_irqrestore(&g_pciConfigLock, flags);
+	return value;
+}
+
 uint16_t PCI_ConfigRead16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
 {
 	uint32_t shift = (offset & 2) * 8;
@@ -49,28 +69,33 @@ uint8_t PCI_ConfigRead8(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset)
 
 void PCI_ConfigWrite32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint32_t value)
 {
-	outl(PCI_CONFIG_ADDRESS, pci_make_config_address(bus, dev, func, offset));
-	outl(PCI_CONFIG_DATA, value);
+	size_t flags = spin_lock_irqsave(&g_pciConfigLock);
+	pci_config_write32_locked(bus, dev, func, offset, value);
+	spin_unlock_irqrestore(&g_pciConfigLock, flags);
 }
 
 void PCI_ConfigWrite16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint16_t value)
 {
 	uint32_t alignedOffset = offset & ~3;
 	uint32_t shift = (offset & 2) * 8;
-	uint32_t cur = PCI_ConfigRead32(bus, dev, func, alignedOffset);
+	size_t flags = spin_lock_irqsave(&g_pciConfigLock);
+	uint32_t cur = pci_config_read32_locked(bus, dev, func, alignedOffset);
 	cur &= ~(0xFFFFu << shift);
 	cur |= ((uint32_t)value) << shift;
-	PCI_ConfigWrite32(bus, dev, func, alignedOffset, cur);
+	pci_config_write32_locked(bus, dev, func, alignedOffset, cur);
+	spin_unlock_irqrestore(&g_pciConfigLock, flags);
 }
 
 void PCI_ConfigWrite8(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint8_t value)
 {
 	uint32_t alignedOffset = offset & ~3;
 	uint32_t shift = (offset & 3) * 8;
-	uint32_t cur = PCI_ConfigRead32(bus, dev, func, alignedOffset);
+	size_t flags = spin_lock_irqsave(&g_pciConfigLock);
+	uint32_t cur = pci_config_read32_locked(bus, dev, func, alignedOffset);
 	cur &= ~(0xFFu << shift);
 	cur |= ((uint32_t)value) << shift;
-	PCI_ConfigWrite32(bus, dev, func, alignedOffset, cur);
+	pci_config_write32_locked(bus, dev, func, alignedOffset, cur);
+	spin_unlock_irqrestore(&g_pciConfigLock, flags);
 }
 
 static PCIDevice* pci_find_in_list(uint8_t bus, uint8_t dev, uint8_t func)
@@ -315,7 +340,7 @@ static void pci_visit_function(uint8_t bus, uint8_t dev, uint8_t func, bool enab
 		}
 	}
 
-	pci_parse_bars(d);
+	// BARs are sized afterwards by pci_probe_all_bars, possibly on other CPUs
 
 	// Recurse into secondary bus for bridges
 	if (d->isBridge && d->secondaryBus > 0 && d->secondaryBus <= d->subordinateBus) {
@@ -340,6 +365,39 @@ static void pci_scan_bus(uint8_t bus, bool enableBridges)
 	}
 }
 
+static void pci_parse_bars_task(void* arg)
+{
+	pci_parse_bars((PCIDevice*)arg);
+}
+
+// Bus numbering needs the depth-first walk to stay serial, but BAR sizing
+// (two to four config cycles per BAR) only touches its own function and is
+// spread over the executor once the topology is known.
+static void pci_probe_all_bars(void)
+{
+	size_t count = g_pciDevices->count;
+	if (count == 0) return;
+
+	Task** tasks = (Task**)malloc(count * sizeof(Task*));
+	size_t spawned = 0;
+
+	for (ListNode* node = g_pciDevices->head; node != NULL; node = node->next) {
+		PCIDevice* d = (PCIDevice*)node->data;
+		if (d->lastSeenEpoch != g_epoch) continue;
+		if (tasks) {
+			tasks[spawned++] = task_spawn(pci_parse_bars_task, d);
+		} else {
+			pci_parse_bars(d);
+		}
+	}
+
+	if (!tasks) return;
+	for (size_t i = 0; i < spawned; ++i) {
+		task_join(tasks[i]);
+	}
+	free(tasks);
+}
+
 void PCI_Init(void)
 {
 	if (!g_pciDevices) {
@@ -363,6 +421,7 @@ void PCI_Rescan(bool enableBridges)
 	g_nextBus = 1;
 	pci_scan_bus(0, enableBridges);
 	pci_remove_not_seen();
+	pci_probe_all_bars();
 	PCI_ConfigureMMIORegions();
 }
 
@@ -1,5 +1,9 @@
 #include <sleep.h>
 #include <time/timer.h>
+#include <time/clock.h>
+#include <task/Thread.h>
+#include <task/Fiber.h>
+#include <arch.h>
 
 void sleep_ms(uint32_t milliseconds)
 {
@@ -7,9 +11,105 @@ void sleep_ms(uint32_t milliseconds)
         return;
     }
 
+    // Fiber'da thread'i uyutmak aynı thread'in diğer fiber'larını da durdurur
+    if (fiber_current()) {
+        mdelay(milliseconds);
+        return;
+    }
+
+    // Thread bağlamında uyu; IRQ içinde (kesmeler kapalı) eski bekleme döngüsü
+    if (scheduler_is_running() && arch_irq_enabled()) {
+        thread_sleep_ms(milliseconds);
+        return;
+    }
+
+    // Kesmeler kapalıyken uptimeMs ilerlemez, hlt de uyanmaz
+    if (!arch_irq_enabled()) {
+        mdelay(milliseconds);
+        return;
+    }
+
     uint64_t endTime = uptimeMs + milliseconds;
     while (uptimeMs < endTime) {
         asm volatile ("hlt");
     }
 }
 
+static inline bool delay_has_clock(void)
+{
+    return clock_source() != CLOCK_SOURCE_UPTIME;
+}
+
+static void delay_ns(uint64_t ns)
+{
+    if (!delay_has_clock()) {
+        for (uint64_t us = (ns + 999) / 1000; us; us--) io_wait();
+        return;
+    }
+
+    uint64_t start = time_now_ns();
+    while (time_now_ns() - start < ns) {
+        if (!fiber_yield()) asm volatile ("pause");
+    }
+}
+
+void ndelay(uint32_t ns)
+{
+    delay_ns(ns);
+}
+
+void udelay(uint32_t us)
+{
+    delay_ns((uint64_t)us * 1000ull);
+}
+
+void mdelay(uint32_t ms)
+{
+    delay_ns((uint64_t)ms * 1000000ull);
+}
+
+void wait_deadline_start(WaitDeadline* wait, uint32_t timeout_us)
+{
+    wait->start_ns = time_now_ns();
+    wait->timeout_ns = (uint64_t)timeout_us * 1000ull;
+    wait->polls = 0;
+}
+
+bool wait_deadline_poll(WaitDeadline* wait)
+{
+    wait->polls++;
+
+    if (!delay_has_clock()) {
+        // Her yoklama ~1 us sayılır
+        if ((uint64_t)wait->polls * 1000ull >= wait->timeout_ns) return false;
+        io_wait();
+        return true;
+    }
+
+    uint64_t elapsed = time_now_ns() - wait->start_ns;
+    if (elapsed >= wait->timeout_ns) return false;
+
+    if (fiber_yield()) {
+        // Aynı CPU'daki diğer fiber'lar bu arada kendi beklemelerini ilerletti
+    } else if (elapsed < WAIT_SPIN_US * 1000ull) {
+        asm volatile ("pause");
+    } else if (scheduler_is_running() && arch_irq_enabled()) {
+        thread_sleep_ms(1);
+    } else if (arch_irq_enabled()) {
+        asm volatile ("hlt"); // Bir sonraki tick/kesme
+    } else {
+        asm volatile ("pause");
+    }
+    return true;
+}
+
+bool wait_until(bool (*cond)(void* arg), void* arg, uint32_t timeout_us)
+{
+    WaitDeadline wait;
+    wait_deadline_start(&wait, timeout_us);
+
+    while (!cond(arg)) {
+        if (!wait_deadline_poll(&wait)) return cond(arg);
+    }
+    return true;
+}
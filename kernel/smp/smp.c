@@ -0,0 +1,493 @@
+#include <smp/smp.h>
+#include <driver/apic/apic.h>
+#include <acpi/acpi.h>
+#include <memory/memory.h>
+#include <debug/debug.h>
+#include <sleep.h>
+#include <spinlock.h>
+#include <arch.h>
+
+#define SMP_AP_START_TIMEOUT_US  1000000
+#define SMP_INIT_DELAY_MS        10
+#define SMP_SIPI_DELAY_US        200
+
+#define MADT_LAPIC_ENABLED       (1u << 0)
+#define SMP_TLB_PAGE_SIZE        4096u
+
+#define IA32_MTRR_CAP_MSR        0x000000FEu
+#define IA32_PAT_MSR             0x00000277u
+#define IA32_MTRR_DEF_TYPE_MSR   0x000002FFu
+#define IA32_MTRR_PHYSBASE(n)    (0x00000200u + ((n) * 2u))
+#define IA32_MTRR_PHYSMASK(n)    (0x00000200u + ((n) * 2u) + 1u)
+#define IA32_MTRR_DEF_ENABLE     (1ull << 11)
+#define IA32_MTRR_DEF_FIXED      (1ull << 10)
+#define SMP_MTRR_MAX_VAR         16
+
+#define CR0_NW                   (1ul << 29)
+#define CR0_CD                   (1ul << 30)
+
+// ap_trampoline.asm'deki ap_trampoline_params ile aynı düzen
+typedef struct {
+    uint64_t cr3;
+    uint64_t stack;
+    uint64_t cpu;
+    uint64_t entry;
+} __attribute__((packed)) ApTrampolineParams;
+
+// BSP'nin bellek türü ayarları; AP'ler aynısını yükler (SDM: tüm CPU'larda MTRR/PAT aynı olmalı)
+typedef struct {
+    bool has_pat;
+    bool has_mtrr;
+    uint64_t pat;
+    uint64_t def_type;
+    uint32_t var_count;
+    uint64_t var[SMP_MTRR_MAX_VAR][2];
+} SmpMemAttrs;
+
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+extern uint8_t ap_trampoline_params[];
+
+extern void enable_cpu_simd(void);
+extern void smp_lapic_timer_isr(void);
+extern void smp_ipi_wake_isr(void);
+extern void smp_ipi_tlb_isr(void);
+
+void smp_ap_entry(PerCpu* cpu) __attribute__((noreturn));
+
+static PerCpu s_bsp_cpu;
+static PerCpu* s_cpus[SMP_MAX_CPUS];
+static volatile uint32_t s_cpu_count = 0;
+static SmpMemAttrs s_mem_attrs;
+static SmpIdleFunc volatile s_idle_work = NULL;
+
+// Aynı anda tek shootdown; istek alanları s_tlb_lock altında yazılır
+static Spinlock s_tlb_lock = SPINLOCK_INIT;
+static uintptr_t s_tlb_va;
+static size_t s_tlb_count;
+static volatile uint32_t s_tlb_acks;
+volatile uint32_t smp_tlb_active = 0;
+
+static inline uint64_t rdmsr(uint32_t msr)
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value)
+{
+    uint32_t lo = (uint32_t)(value & 0xFFFFFFFFu);
+    uint32_t hi = (uint32_t)(value >> 32);
+    __asm__ __volatile__("wrmsr" :: "c"(msr), "a"(lo), "d"(hi));
+}
+
+static inline size_t read_cr0(void)
+{
+    size_t value;
+    __asm__ __volatile__("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr0(size_t value)
+{
+    __asm__ __volatile__("mov %0, %%cr0" :: "r"(value) : "memory");
+}
+
+static inline size_t read_cr3(void)
+{
+    size_t value;
+    __asm__ __volatile__("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+static void smp_capture_mem_attrs(void)
+{
+    size_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+    arch_cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    SmpMemAttrs* st = &s_mem_attrs;
+    st->has_pat = (edx & (1u << 16)) != 0;
+    st->has_mtrr = (edx & (1u << 12)) != 0;
+
+    if (st->has_pat) st->pat = rdmsr(IA32_PAT_MSR);
+    if (!st->has_mtrr) return;
+
+    st->def_type = rdmsr(IA32_MTRR_DEF_TYPE_MSR);
+    st->var_count = (uint32_t)(rdmsr(IA32_MTRR_CAP_MSR) & 0xFFu);
+    if (st->var_count > SMP_MTRR_MAX_VAR) st->var_count = SMP_MTRR_MAX_VAR;
+    for (uint32_t i = 0; i < st->var_count; ++i) {
+        st->var[i][0] = rdmsr(IA32_MTRR_PHYSBASE(i));
+        st->var[i][1] = rdmsr(IA32_MTRR_PHYSMASK(i));
+    }
+}
+
+// SDM 11.11.8: önbellek kapalıyken MTRR'leri yaz, sonra geri aç
+static void smp_apply_mem_attrs(void)
+{
+    const SmpMemAttrs* st = &s_mem_attrs;
+
+    if (st->has_mtrr) {
+        size_t cr0 = read_cr0();
+        write_cr0((cr0 | CR0_CD) & ~CR0_NW);
+        __asm__ __volatile__("wbinvd" ::: "memory");
+        arch_tlb_flush_all();
+
+        wrmsr(IA32_MTRR_DEF_TYPE_MSR, st->def_type & ~(IA32_MTRR_DEF_ENABLE | IA32_MTRR_DEF_FIXED));
+        for (uint32_t i = 0; i < st->var_count; ++i) {
+            wrmsr(IA32_MTRR_PHYSBASE(i), st->var[i][0]);
+            wrmsr(IA32_MTRR_PHYSMASK(i), st->var[i][1]);
+        }
+
+        __asm__ __volatile__("wbinvd" ::: "memory");
+        arch_tlb_flush_all();
+        wrmsr(IA32_MTRR_DEF_TYPE_MSR, st->def_type);
+        write_cr0(cr0);
+    }
+
+    if (st->has_pat) wrmsr(IA32_PAT_MSR, st->pat);
+}
+
+void smp_bsp_init(void)
+{
+    PerCpu* cpu = &s_bsp_cpu;
+    if (cpu->self) return;
+
+    cpu->self = cpu;
+    cpu->id = 0;
+    cpu->online = true;
+
+    size_t flags = arch_irq_save();
+    arch_cpu_tables_load(&cpu->tables, cpu);
+    arch_irq_restore(flags);
+
+    s_cpus[0] = cpu;
+    s_cpu_count = 1;
+}
+
+void smp_lapic_timer_handler(void)
+{
+    this_cpu()->lapic_ticks++;
+    lapic_eoi();
+}
+
+void smp_ipi_wake_handler(void)
+{
+    // Yalnızca hlt'den uyandırır; iş yuvasına idle döngüsü bakar
+    lapic_eoi();
+}
+
+static void smp_tlb_flush_local(uintptr_t va, size_t count)
+{
+    if (count == 0) {
+        arch_tlb_flush_all();
+        return;
+    }
+    for (size_t i = 0; i < count; ++i)
+        arch_tlb_flush_one((void*)(va + i * SMP_TLB_PAGE_SIZE));
+}
+
+void smp_tlb_poll(void)
+{
+    PerCpu* cpu = this_cpu();
+    if (!cpu->tlb_pending) return;
+
+    smp_tlb_flush_local(s_tlb_va, s_tlb_count);
+    cpu->tlb_pending = 0;
+    __sync_fetch_and_add(&s_tlb_acks, 1);
+}
+
+void smp_ipi_tlb_handler(void)
+{
+    smp_tlb_poll();
+    lapic_eoi();
+}
+
+static void __attribute__((noreturn)) smp_idle_loop(PerCpu* cpu)
+{
+    for (;;) {
+        // Bundan sonra gelen her smp_wake_cpu hlt'den önce fark edilir
+        uint32_t seq = cpu->wake_seq;
+
+        __asm__ __volatile__("cli" ::: "memory");
+
+        SmpCallFunc func = cpu->call_func;
+        if (func) {
+            void* arg = cpu->call_arg;
+            cpu->call_func = NULL;
+            __asm__ __volatile__("" ::: "memory");
+            cpu->call_busy = 0;  // Yuva yeni işe açık
+
+            __asm__ __volatile__("sti" ::: "memory");
+            func(arg);
+            continue;
+        }
+
+        __asm__ __volatile__("sti" ::: "memory");
+
+        SmpIdleFunc work = s_idle_work;
+        if (work && work(cpu)) continue;
+
+        __asm__ __volatile__("cli" ::: "memory");
+
+        // idle yazısı wake_seq okumasından önce görünmeli; smp_wake_cpu tersini yapar
+        cpu->idle = true;
+        __sync_synchronize();
+        if (cpu->call_func || cpu->wake_seq != seq) {
+            cpu->idle = false;
+            __asm__ __volatile__("sti" ::: "memory");
+            continue;
+        }
+
+        // sti'nin gölgesi hlt'yi kapsar: araya giren IPI kaybolmaz
+        __asm__ __volatile__("sti; hlt" ::: "memory");
+        cpu->idle = false;
+        cpu->idle_wakeups++;
+    }
+}
+
+void smp_ap_entry(PerCpu* cpu)
+{
+    // Trampoline'in geçici GDT'sinden kendi tablolarımıza geç
+    arch_cpu_tables_load(&cpu->tables, cpu);
+
+    enable_cpu_simd();
+    smp_apply_mem_attrs();
+
+    lapic_enable_controller();
+    lapic_timer_start_periodic(LAPIC_TIMER_VECTOR, SMP_AP_TIMER_HZ);
+
+    // BSP bunu görünce bir sonraki AP için trampoline parametrelerini yeniden yazar
+    __asm__ __volatile__("" ::: "memory");
+    cpu->online = true;
+
+    smp_idle_loop(cpu);
+}
+
+static bool smp_start_ap(uint8_t apic_id, uint8_t acpi_id, volatile ApTrampolineParams* params)
+{
+    PerCpu* cpu = (PerCpu*)malloc(sizeof(PerCpu));
+    void* stack = malloc(SMP_AP_STACK_SIZE);
+    uint8_t* fpu_nest = (uint8_t*)malloc_aligned(64, FPU_NEST_BYTES);
+    if (!cpu || !stack || !fpu_nest) {
+        ERROR("SMP: out of memory for CPU with APIC id %u", apic_id);
+        if (cpu) free(cpu);
+        if (stack) free(stack);
+        if (fpu_nest) free(fpu_nest);
+        return false;
+    }
+
+    memset(cpu, 0, sizeof(*cpu));
+    cpu->fpu_nest_areas = fpu_nest;
+    cpu->self = cpu;
+    cpu->id = s_cpu_count;
+    cpu->lapic_id = apic_id;
+    cpu->acpi_id = acpi_id;
+    cpu->stack = stack;
+
+    params->stack = (uint64_t)((uintptr_t)stack + SMP_AP_STACK_SIZE);
+    params->cpu = (uint64_t)(uintptr_t)cpu;
+
+    lapic_send_init(apic_id);
+    mdelay(SMP_INIT_DELAY_MS);
+
+    // İkinci SIPI yalnızca ilki kaçırıldıysa gerekir
+    for (int i = 0; i < 2 && !cpu->online; ++i) {
+        lapic_send_startup(apic_id, SMP_TRAMPOLINE_ADDR);
+        udelay(SMP_SIPI_DELAY_US);
+    }
+
+    WaitDeadline wait;
+    wait_deadline_start(&wait, SMP_AP_START_TIMEOUT_US);
+    while (!cpu->online && wait_deadline_poll(&wait)) ;
+
+    if (!cpu->online) {
+        // AP trampoline'i geç de olsa çalıştırabilir: INIT ile durdur, belleği bırakma
+        WARN("SMP: CPU with APIC id %u did not come online", apic_id);
+        lapic_send_init(apic_id);
+        return false;
+    }
+
+    s_cpus[cpu->id] = cpu;
+    s_cpu_count++;
+    return true;
+}
+
+uint32_t smp_init(void)
+{
+    PerCpu* bsp = &s_bsp_cpu;
+    smp_bsp_init();
+
+    const acpi_madt* madt = acpi_get_madt();
+    if (!madt || !(lapic_read(LAPIC_REG_SVR) & LAPIC_SVR_APIC_ENABLE)) {
+        LOG("SMP: no MADT or LAPIC, running on the boot CPU only");
+        return s_cpu_count;
+    }
+
+    bsp->lapic_id = lapic_get_id();
+
+    if (!lapic_timer_calibrate())
+        WARN("SMP: LAPIC timer calibration failed, APs run without a timer");
+
+    idt_set_gate(LAPIC_TIMER_VECTOR, (size_t)(uintptr_t)smp_lapic_timer_isr);
+    idt_set_gate(LAPIC_IPI_WAKE_VECTOR, (size_t)(uintptr_t)smp_ipi_wake_isr);
+    idt_set_gate(LAPIC_IPI_TLB_VECTOR, (size_t)(uintptr_t)smp_ipi_tlb_isr);
+
+    smp_capture_mem_attrs();
+
+    memcpy((void*)(uintptr_t)SMP_TRAMPOLINE_ADDR, ap_trampoline_start,
+           (size_t)(ap_trampoline_end - ap_trampoline_start));
+
+    volatile ApTrampolineParams* params = (volatile ApTrampolineParams*)(uintptr_t)
+        (SMP_TRAMPOLINE_ADDR + (uintptr_t)(ap_trampoline_params - ap_trampoline_start));
+    params->cr3 = (uint64_t)read_cr3();
+    params->entry = (uint64_t)(uintptr_t)smp_ap_entry;
+
+    // Aynı APIC id hem LAPIC hem x2APIC girişinde listelenebilir
+    uint32_t seen[256 / 32] = { 0 };
+    seen[bsp->lapic_id / 32] |= 1u << (bsp->lapic_id % 32);
+
+    const uint8_t* p = madt->Entries;
+    const uint8_t* end = ((const uint8_t*)madt) + madt->Header.Length;
+
+    while (p + sizeof(acpi_madt_entry_header) < end) {
+        const acpi_madt_entry_header* h = (const acpi_madt_entry_header*)p;
+        if (h->Length == 0) break;
+
+        uint32_t apic_id = 0xFFFFFFFFu;
+        uint32_t acpi_id = 0;
+        uint32_t flags = 0;
+
+        if (h->Type == ACPI_MADT_PROCESSOR_LOCAL_APIC && h->Length >= 8) {
+            const struct { uint8_t Type, Length; uint8_t AcpiProcessorId; uint8_t ApicId; uint32_t Flags; } __attribute__((packed)) *e = (void*)p;
+            apic_id = e->ApicId;
+            acpi_id = e->AcpiProcessorId;
+            flags = e->Flags;
+        } else if (h->Type == ACPI_MADT_PROCESSOR_LOCAL_X2APIC && h->Length >= 16) {
+            const struct { uint8_t Type, Length; uint16_t Reserved; uint32_t X2ApicId; uint32_t Flags; uint32_t AcpiUid; } __attribute__((packed)) *e = (void*)p;
+            apic_id = e->X2ApicId;
+            acpi_id = e->AcpiUid;
+            flags = e->Flags;
+        }
+
+        p += h->Length;
+
+        if (apic_id == 0xFFFFFFFFu || !(flags & MADT_LAPIC_ENABLED)) continue;
+        if (apic_id >= 0xFF) {
+            WARN("SMP: APIC id %u needs x2APIC mode, skipped", apic_id);
+            continue;
+        }
+        if (seen[apic_id / 32] & (1u << (apic_id % 32))) continue;
+        seen[apic_id / 32] |= 1u << (apic_id % 32);
+
+        if (s_cpu_count >= SMP_MAX_CPUS) {
+            WARN("SMP: more than %u CPUs, ignoring the rest", SMP_MAX_CPUS);
+            break;
+        }
+
+        if (smp_start_ap((uint8_t)apic_id, (uint8_t)acpi_id, params))
+            LOG("SMP: CPU%u online (APIC id %u)", s_cpu_count - 1, apic_id);
+    }
+
+    LOG("SMP: %u CPU(s) online", s_cpu_count);
+    return s_cpu_count;
+}
+
+uint32_t smp_cpu_count(void)
+{
+    return s_cpu_count ? s_cpu_count : 1;
+}
+
+PerCpu* smp_cpu(uint32_t id)
+{
+    return id < s_cpu_count ? s_cpus[id] : NULL;
+}
+
+bool smp_call_on_cpu(uint32_t id, SmpCallFunc func, void* arg)
+{
+    PerCpu* cpu = smp_cpu(id);
+    if (!cpu || !func || !cpu->online) return false;
+
+    if (cpu == this_cpu()) {
+        func(arg);
+        return true;
+    }
+
+    if (!__sync_bool_compare_and_swap(&cpu->call_busy, 0, 1)) return false;
+
+    cpu->call_arg = arg;
+    __asm__ __volatile__("" ::: "memory");
+    cpu->call_func = func;  // Yayınla: idle döngüsü func'ı görünce arg hazırdır
+
+    lapic_send_ipi(cpu->lapic_id, LAPIC_ICR_FIXED | LAPIC_IPI_WAKE_VECTOR);
+    return true;
+}
+
+void smp_set_idle_work(SmpIdleFunc func)
+{
+    s_idle_work = func;
+}
+
+bool smp_wake_cpu(uint32_t id)
+{
+    PerCpu* cpu = smp_cpu(id);
+    if (!cpu || !cpu->online || cpu == this_cpu()) return false;
+
+    // lock'lu toplama tam bariyer: çağıranın yayınladığı iş, idle okumasından önce görünür
+    __sync_fetch_and_add(&cpu->wake_seq, 1);
+    if (!cpu->idle) return false;
+
+    lapic_send_ipi(cpu->lapic_id, LAPIC_ICR_FIXED | LAPIC_IPI_WAKE_VECTOR);
+    return true;
+}
+
+void smp_tlb_shootdown(uintptr_t va, size_t count)
+{
+    if (s_cpu_count <= 1) {
+        smp_tlb_flush_local(va, count);
+        return;
+    }
+
+    // Bekleyen başka bir shootdown varsa spin_lock onu burada karşılar
+    size_t flags = spin_lock_irqsave(&s_tlb_lock);
+    PerCpu* me = this_cpu();
+
+    s_tlb_va = va;
+    s_tlb_count = count;
+    s_tlb_acks = 0;
+
+    uint32_t targets = 0;
+    for (uint32_t i = 0; i < s_cpu_count; ++i) {
+        PerCpu* cpu = s_cpus[i];
+        if (cpu == me || !cpu->online) continue;
+        cpu->tlb_pending = 1;
+        targets++;
+    }
+
+    // İstek alanları bayraklardan önce görünmeli; lock'lu yazma tam bariyer
+    __sync_lock_test_and_set(&smp_tlb_active, 1);
+
+    for (uint32_t i = 0; i < s_cpu_count; ++i) {
+        PerCpu* cpu = s_cpus[i];
+        if (cpu->tlb_pending)
+            lapic_send_ipi(cpu->lapic_id, LAPIC_ICR_FIXED | LAPIC_IPI_TLB_VECTOR);
+    }
+
+    smp_tlb_flush_local(va, count);
+
+    // Hedef kesmeleri kapalı bir kilitte bekliyorsa onayı spin_lock'tan gelir
+    while (s_tlb_acks != targets) cpu_relax();
+
+    __sync_lock_release(&smp_tlb_active);
+    spin_unlock_irqrestore(&s_tlb_lock, flags);
+}
+
+void smp_dump(void)
+{
+    for (uint32_t i = 0; i < s_cpu_count; ++i) {
+        PerCpu* cpu = s_cpus[i];
+        LOG("CPU%u: APIC id %u, ACPI id %u, %s, LAPIC ticks %llu, idle wakeups %llu",
+            cpu->id, cpu->lapic_id, cpu->acpi_id, cpu->online ? "online" : "offline",
+            (unsigned long long)cpu->lapic_ticks, (unsigned long long)cpu->idle_wakeups);
+    }
+}
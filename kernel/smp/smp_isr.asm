@@ -0,0 +1,80 @@
+section .text
+
+; Yerel LAPIC kesmeleri: zamanlayıcı, uyandırma ve TLB shootdown IPI'ları
+
+global smp_lapic_timer_isr
+global smp_ipi_wake_isr
+global smp_ipi_tlb_isr
+extern smp_lapic_timer_handler
+extern smp_ipi_wake_handler
+extern smp_ipi_tlb_handler
+extern irq_fpu_call
+
+%if __BITS__ == 64
+use64
+
+%macro SMP_ISR 2
+%1:
+    cli
+
+    push rax
+    push rbx
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push r8
+    push r9
+    push r10
+    push r11
+    push r12
+    push r13
+    push r14
+    push r15
+
+    mov rax, %2
+    call irq_fpu_call
+
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
+    pop rbx
+    pop rax
+
+    sti
+    iretq
+%endmacro
+
+%else
+
+use32
+
+%macro SMP_ISR 2
+%1:
+    cli
+
+    pushad
+
+    mov eax, %2
+    call irq_fpu_call
+
+    popad
+
+    sti
+    iret
+%endmacro
+
+%endif
+
+SMP_ISR smp_lapic_timer_isr, smp_lapic_timer_handler
+SMP_ISR smp_ipi_wake_isr, smp_ipi_wake_handler
+SMP_ISR smp_ipi_tlb_isr, smp_ipi_tlb_handler
@@ -1,9 +1,29 @@
 #include <storage/BlockDevice.h>
 #include <memory/memory.h>
+#include <memory/vmm.h>
+#include <task/Thread.h>
+#include <task/Fiber.h>
 #include <debug/debug.h>
+#include <time/clock.h>
+#include <arch.h>
+
+// blkq_run modes
+#define BLKQ_RUN_BLOCKING  (1u << 0)  // Thread context: may run declined commands synchronously
+#define BLKQ_RUN_FORCE     (1u << 1)  // Ignore the plug
+
+// One command handed to the driver: a chain of merged requests
+typedef struct BlockQueueUnit {
+    BlockRequest req;
+    BlockRequest* members;
+    struct BlockQueueUnit* next;  // free_units / deferred
+    BlockSegment sg[BLKQ_MAX_SEGMENTS];
+} BlockQueueUnit;
 
 static List* s_blkdev_list = NULL;
 
+static void blkq_run(BlockDevice* dev, uint32_t how);
+static bool blkreq_run_sync(BlockDevice* dev, BlockRequest* req);
+
 void BlockDevice_InitRegistry(void)
 {
     if (!s_blkdev_list) s_blkdev_list = List_Create();
@@ -29,6 +49,15 @@ BlockDevice* BlockDevice_Register(const char* name,
     d->total_blocks = total_blocks;
     d->ops = ops;
     d->driver_ctx = driver_ctx;
+    d->flags = 0;
+    d->io_busy = 0;
+    d->io_waiter = NULL;
+    memset(&d->queue, 0, sizeof(d->queue));
+    spin_init(&d->queue.lock);
+    if (!BlockDevice_SetQueueDepth(d, ops->submit ? BLKQ_DEFAULT_DEPTH : 1)) {
+        free(d);
+        return NULL;
+    }
     List_Add(s_blkdev_list, d);
     LOG("BlockDevice: registered '%s' type=%u block=%u total=%u", d->name, (unsigned)d->type, d->logical_block_size, (unsigned)(d->total_blocks));
     return d;
@@ -45,21 +74,533 @@ BlockDevice* BlockDevice_GetAt(size_t index)
     return (BlockDevice*)List_GetAt(s_blkdev_list, index);
 }
 
+// Most drivers keep one command in flight per device (ATA taskfile, ATAPI
+// slot 0). Their waits may sleep (wait_deadline_poll -> thread_sleep_ms), so
+// this is a sleeping lock: contenders give the CPU away instead of spinning
+// on a holder that is not running. Queued devices (AHCI NCQ) take concurrent
+// callers themselves.
+static void blkdev_lock(BlockDevice* dev)
+{
+    if (dev->flags & BLKDEV_FLAG_QUEUED) return;
+
+    while (!__sync_bool_compare_and_swap(&dev->io_busy, 0, 1)) {
+        if (scheduler_is_running() && !fiber_current() && arch_irq_enabled()) {
+            dev->io_waiter = thread_current();
+            __sync_synchronize(); // waiter is visible before io_busy is re-read
+            if (dev->io_busy) thread_sleep_ms(BLKREQ_WAIT_SLICE_MS);
+        } else if (!fiber_yield()) {
+            cpu_relax();
+        }
+    }
+    // Got it after the slice ran out: do not leave a stale waiter behind
+    if (dev->io_waiter && dev->io_waiter == thread_current()) dev->io_waiter = NULL;
+}
+
+static void blkdev_unlock(BlockDevice* dev)
+{
+    if (dev->flags & BLKDEV_FLAG_QUEUED) return;
+
+    __sync_lock_release(&dev->io_busy);
+    __sync_synchronize();
+    // Only the last sleeper is recorded; any others re-check when their slice ends
+    Thread* waiter = dev->io_waiter;
+    if (waiter) {
+        dev->io_waiter = NULL;
+        thread_wake(waiter);
+    }
+}
+
+static bool blkdev_read_direct(BlockDevice* dev, uint64_t lba, uint32_t count, void* buffer)
+{
+    blkdev_lock(dev);
+    bool ok = dev->ops->read(dev, lba, count, buffer);
+    blkdev_unlock(dev);
+    return ok;
+}
+
+static bool blkdev_write_direct(BlockDevice* dev, uint64_t lba, uint32_t count, const void* buffer)
+{
+    blkdev_lock(dev);
+    bool ok = dev->ops->write(dev, lba, count, buffer);
+    blkdev_unlock(dev);
+    return ok;
+}
+
+// Through the queue, so concurrent callers merge. Anything the request API
+// rejects (e.g. > 4 GiB in one call) keeps the old direct path.
 bool BlockDevice_Read(BlockDevice* dev, uint64_t lba, uint32_t count, void* buffer)
 {
     if (!dev || !dev->ops || !dev->ops->read) return false;
-    return dev->ops->read(dev, lba, count, buffer);
+    BlockRequest req;
+    BlockRequest_Init(&req, BLKREQ_READ, lba, count, buffer);
+    if (!BlockDevice_Submit(dev, &req)) return blkdev_read_direct(dev, lba, count, buffer);
+    return BlockDevice_Wait(&req);
 }
 
 bool BlockDevice_Write(BlockDevice* dev, uint64_t lba, uint32_t count, const void* buffer)
 {
     if (!dev || !dev->ops || !dev->ops->write) return false;
-    return dev->ops->write(dev, lba, count, buffer);
+    BlockRequest req;
+    BlockRequest_Init(&req, BLKREQ_WRITE, lba, count, (void*)buffer);
+    if (!BlockDevice_Submit(dev, &req)) return blkdev_write_direct(dev, lba, count, buffer);
+    return BlockDevice_Wait(&req);
 }
 
 bool BlockDevice_Flush(BlockDevice* dev)
 {
     if (!dev || !dev->ops || !dev->ops->flush) return true;
-    return dev->ops->flush(dev);
+    blkdev_lock(dev);
+    bool ok = dev->ops->flush(dev);
+    blkdev_unlock(dev);
+    return ok;
+}
+
+bool BlockDevice_SetQueueDepth(BlockDevice* dev, uint32_t depth)
+{
+    if (!dev || depth == 0) return false;
+    BlockQueue* q = &dev->queue;
+
+    // Units are only added; a lower depth leaves the extra ones unused
+    while (q->depth < depth) {
+        BlockQueueUnit* unit = (BlockQueueUnit*)malloc(sizeof(BlockQueueUnit));
+        if (!unit) {
+            ERROR("BlockDevice_SetQueueDepth('%s'): out of memory at %u", dev->name, q->depth);
+            return q->depth != 0;
+        }
+        size_t flags = spin_lock_irqsave(&q->lock);
+        unit->next = q->free_units;
+        q->free_units = unit;
+        q->depth++;
+        spin_unlock_irqrestore(&q->lock, flags);
+    }
+    return true;
+}
+
+void BlockDevice_Plug(BlockDevice* dev)
+{
+    if (!dev) return;
+    size_t flags = spin_lock_irqsave(&dev->queue.lock);
+    dev->queue.plugged++;
+    spin_unlock_irqrestore(&dev->queue.lock, flags);
+}
+
+void BlockDevice_Unplug(BlockDevice* dev)
+{
+    if (!dev) return;
+    size_t flags = spin_lock_irqsave(&dev->queue.lock);
+    if (dev->queue.plugged) dev->queue.plugged--;
+    bool run = dev->queue.plugged == 0;
+    spin_unlock_irqrestore(&dev->queue.lock, flags);
+    if (run) blkq_run(dev, BLKQ_RUN_BLOCKING);
+}
+
+// --- Request queue ---------------------------------------------------------
+
+// a is immediately followed by b on disk and the result fits one command
+static bool blkq_can_merge(const BlockDevice* dev, const BlockRequest* a, const BlockRequest* b)
+{
+    if (a->op != b->op || a->no_merge || b->no_merge) return false;
+    if (a->lba + a->merge_blocks != b->lba) return false;
+    if ((uint64_t)(a->merge_blocks + b->merge_blocks) * dev->logical_block_size > BLKQ_MAX_MERGE_BYTES) return false;
+    return a->merge_segs + b->merge_segs <= BLKQ_MAX_SEGMENTS;
+}
+
+static void blkq_join(BlockQueue* q, BlockRequest* a, BlockRequest* b)
+{
+    a->merge_tail->merge_next = b;
+    a->merge_tail = b->merge_tail;
+    a->merge_blocks += b->merge_blocks;
+    a->merge_segs += b->merge_segs;
+    if (b->deadline_ns < a->deadline_ns) a->deadline_ns = b->deadline_ns;
+    q->merges++;
+}
+
+// Sorted insert with back/front merge; q->lock held
+static void blkq_insert(BlockDevice* dev, BlockRequest* req, uint64_t now)
+{
+    BlockQueue* q = &dev->queue;
+    bool relaxed = req->op != BLKREQ_READ || (req->flags & BLKREQ_FLAG_READAHEAD);
+    req->next = NULL;
+    req->merge_next = NULL;
+    req->merge_tail = req;
+    req->merge_blocks = req->count;
+    req->merge_segs = req->sg_count;
+    req->deadline_ns = now + (uint64_t)(relaxed ? BLKQ_WRITE_EXPIRE_MS : BLKQ_READ_EXPIRE_MS) * 1000000ull;
+    req->queued = true;
+
+    BlockRequest* prev = NULL;
+    BlockRequest* next = q->sorted;
+    while (next && next->lba <= req->lba) {
+        prev = next;
+        next = next->next;
+    }
+
+    if (prev && blkq_can_merge(dev, prev, req)) {
+        // Back merge; the gap to the following chain may have closed too
+        blkq_join(q, prev, req);
+        if (next && blkq_can_merge(dev, prev, next)) {
+            prev->next = next->next;
+            blkq_join(q, prev, next);
+            q->queued--;
+        }
+        return;
+    }
+
+    if (next && blkq_can_merge(dev, req, next)) {
+        // Front merge: req takes next's place as the head of the chain
+        req->next = next->next;
+        blkq_join(q, req, next);
+    } else {
+        req->next = next;
+        q->queued++;
+    }
+    if (prev) prev->next = req;
+    else q->sorted = req;
+}
+
+// mq-deadline style choice: the chain with the oldest expired deadline,
+// otherwise the next one at or after the elevator position, wrapping to the
+// lowest LBA (one-way scan). q->lock held, queue not empty.
+static BlockRequest* blkq_pick(BlockQueue* q, uint64_t now)
+{
+    BlockRequest* oldest = NULL;
+    BlockRequest* oldest_prev = NULL;
+    BlockRequest* ahead = NULL;
+    BlockRequest* ahead_prev = NULL;
+    BlockRequest* prev = NULL;
+    for (BlockRequest* r = q->sorted; r; prev = r, r = r->next) {
+        if (!oldest || r->deadline_ns < oldest->deadline_ns) {
+            oldest = r;
+            oldest_prev = prev;
+        }
+        if (!ahead && r->lba >= q->next_lba) {
+            ahead = r;
+            ahead_prev = prev;
+        }
+    }
+
+    BlockRequest* pick = q->sorted;
+    prev = NULL;
+    if (oldest->deadline_ns <= now) {
+        pick = oldest;
+        prev = oldest_prev;
+    } else if (ahead) {
+        pick = ahead;
+        prev = ahead_prev;
+    }
+
+    if (prev) prev->next = pick->next;
+    else q->sorted = pick->next;
+    pick->next = NULL;
+    q->queued--;
+    q->next_lba = pick->lba + pick->merge_blocks;
+    return pick;
+}
+
+static void blkq_unit_done(BlockRequest* ureq);
+
+// Build the driver command for a chain; adjacent buffers become one segment
+static void blkq_prepare(BlockQueueUnit* unit)
+{
+    BlockRequest* head = unit->members;
+    BlockRequest* ureq = &unit->req;
+    memset(ureq, 0, sizeof(*ureq));
+    ureq->op = head->op;
+    ureq->flags = head->flags;
+    ureq->lba = head->lba;
+    ureq->count = head->merge_blocks;
+    ureq->done = blkq_unit_done;
+    ureq->private_data = unit;
+
+    if (!head->merge_next) {
+        ureq->sg = head->sg;
+        ureq->sg_count = head->sg_count;
+        return;
+    }
+
+    uint32_t n = 0;
+    for (BlockRequest* m = head; m; m = m->merge_next) {
+        ureq->flags &= m->flags;
+        for (uint32_t i = 0; i < m->sg_count; ++i) {
+            const BlockSegment* seg = &m->sg[i];
+            BlockSegment* last = n ? &unit->sg[n - 1] : NULL;
+            if (last && (uint8_t*)last->buffer + last->bytes == (uint8_t*)seg->buffer &&
+                last->bytes <= UINT32_MAX - seg->bytes) {
+                last->bytes += seg->bytes;
+            } else {
+                unit->sg[n++] = *seg;
+            }
+        }
+    }
+    ureq->sg = unit->sg;
+    ureq->sg_count = n;
+}
+
+// Hand a request to the driver; without native support (or when it declines)
+// run it here if the caller may block. Otherwise the driver is told not to
+// wait for resources (BLKREQ_FLAG_NOWAIT) and a decline leaves it queued.
+static bool blkreq_dispatch(BlockDevice* dev, BlockRequest* req, bool may_block)
+{
+    req->dev = dev;
+    req->waiter = NULL;
+    req->pending = 0;
+    req->failed = false;
+    req->next = NULL;
+    req->status = BLKREQ_PENDING;
+    if (may_block) req->flags &= ~BLKREQ_FLAG_NOWAIT;
+    else req->flags |= BLKREQ_FLAG_NOWAIT;
+
+    if (dev->ops->submit && dev->ops->submit(dev, req)) return true;
+    if (!may_block) return false;
+    BlockRequest_Complete(req, blkreq_run_sync(dev, req));
+    return true;
+}
+
+// Dispatch while there are free units. Only one context runs the loop; the
+// others return and the runner picks up their requests because it re-checks
+// the queue under the lock before leaving.
+static void blkq_run(BlockDevice* dev, uint32_t how)
+{
+    BlockQueue* q = &dev->queue;
+    bool may_block = (how & BLKQ_RUN_BLOCKING) != 0;
+
+    size_t flags = spin_lock_irqsave(&q->lock);
+    if (q->running) {
+        spin_unlock_irqrestore(&q->lock, flags);
+        return;
+    }
+    q->running = true;
+
+    for (;;) {
+        BlockQueueUnit* unit = NULL;
+        if (may_block && q->deferred) {
+            unit = q->deferred;
+            q->deferred = unit->next;
+        } else if (q->sorted && q->free_units &&
+                   ((how & BLKQ_RUN_FORCE) || !q->plugged || q->queued >= BLKQ_PLUG_MAX)) {
+            unit = q->free_units;
+            q->free_units = unit->next;
+            q->inflight++;
+            unit->members = blkq_pick(q, time_now_ns());
+            blkq_prepare(unit);
+        }
+        if (!unit) break;
+        unit->next = NULL;
+        spin_unlock_irqrestore(&q->lock, flags);
+
+        // Members may be freed by their waiters once the command completes
+        for (BlockRequest* m = unit->members; m; m = m->merge_next) m->queued = false;
+
+        if (!blkreq_dispatch(dev, &unit->req, may_block)) {
+            // Declined in IRQ context: a waiter (or the next submitter) runs it
+            for (BlockRequest* m = unit->members; m; m = m->merge_next) {
+                m->queued = true;
+                if (m->waiter && scheduler_is_running()) thread_wake(m->waiter);
+            }
+            flags = spin_lock_irqsave(&q->lock);
+            unit->next = q->deferred;
+            q->deferred = unit;
+            continue;
+        }
+        flags = spin_lock_irqsave(&q->lock);
+    }
+
+    q->running = false;
+    spin_unlock_irqrestore(&q->lock, flags);
+}
+
+// Completion of a unit; may run in IRQ context (drivers that complete from
+// their ISR) or in the softirq thread. The refill below never blocks: drivers
+// get BLKREQ_FLAG_NOWAIT and declined units wait for a thread-context run.
+static void blkq_unit_done(BlockRequest* ureq)
+{
+    BlockQueueUnit* unit = (BlockQueueUnit*)ureq->private_data;
+    BlockDevice* dev = ureq->dev;
+    BlockQueue* q = &dev->queue;
+    bool ok = ureq->status == BLKREQ_OK;
+    BlockRequest* m = unit->members;
+    bool retry = !ok && m->merge_next;
+
+    size_t flags = spin_lock_irqsave(&q->lock);
+    unit->next = q->free_units;
+    q->free_units = unit;
+    q->inflight--;
+    q->dispatched++;
+    if (retry) {
+        // A merged command failed: retry each request alone so one bad block
+        // does not fail its neighbours
+        uint64_t now = time_now_ns();
+        while (m) {
+            BlockRequest* n = m->merge_next;
+            m->no_merge = true;
+            blkq_insert(dev, m, now);
+            m = n;
+        }
+    }
+    spin_unlock_irqrestore(&q->lock, flags);
+
+    while (m) {
+        BlockRequest* n = m->merge_next;
+        BlockRequest_Complete(m, ok);
+        m = n;
+    }
+    blkq_run(dev, 0);
+}
+
+void BlockRequest_Init(BlockRequest* req, BlockRequestOp op, uint64_t lba, uint32_t count, void* buffer)
+{
+    if (!req) return;
+    memset(req, 0, sizeof(*req));
+    req->op = op;
+    req->lba = lba;
+    req->count = count;
+    req->inline_sg.buffer = buffer;
+    req->sg = buffer ? &req->inline_sg : NULL;
+    req->sg_count = buffer ? 1 : 0;
+}
+
+static bool blkreq_validate(BlockDevice* dev, BlockRequest* req)
+{
+    if (!dev || !dev->ops) return false;
+    if (req->op == BLKREQ_FLUSH) return true;
+    if (req->op == BLKREQ_READ ? !dev->ops->read : !dev->ops->write) return false;
+    if (req->count == 0 || !req->sg || req->sg_count == 0) return false;
+    if (dev->total_blocks && req->lba + req->count > dev->total_blocks) return false;
+
+    // BlockRequest_Init does not know the block size yet
+    uint64_t bytes = (uint64_t)req->count * dev->logical_block_size;
+    if (req->sg == &req->inline_sg && req->inline_sg.bytes == 0 && bytes <= UINT32_MAX)
+        req->inline_sg.bytes = (uint32_t)bytes;
+
+    uint64_t covered = 0;
+    for (uint32_t i = 0; i < req->sg_count; ++i) {
+        const BlockSegment* seg = &req->sg[i];
+        if (!seg->buffer || seg->bytes == 0 || seg->bytes % dev->logical_block_size) return false;
+        covered += seg->bytes;
+    }
+    return covered == bytes;
+}
+
+// Fallback for drivers without ops->submit, and for requests they decline
+static bool blkreq_run_sync(BlockDevice* dev, BlockRequest* req)
+{
+    if (req->op == BLKREQ_FLUSH) return BlockDevice_Flush(dev);
+
+    uint64_t lba = req->lba;
+    for (uint32_t i = 0; i < req->sg_count; ++i) {
+        const BlockSegment* seg = &req->sg[i];
+        uint32_t blocks = seg->bytes / dev->logical_block_size;
+        bool ok = (req->op == BLKREQ_READ)
+            ? blkdev_read_direct(dev, lba, blocks, seg->buffer)
+            : blkdev_write_direct(dev, lba, blocks, seg->buffer);
+        if (!ok) return false;
+        lba += blocks;
+    }
+    return true;
+}
+
+bool BlockDevice_Submit(BlockDevice* dev, BlockRequest* req)
+{
+    if (!req) return false;
+    req->dev = dev;
+    req->waiter = NULL;
+    req->pending = 0;
+    req->failed = false;
+    req->next = NULL;
+    req->queued = false;
+    req->no_merge = false;
+    req->status = BLKREQ_PENDING;
+
+    if (!blkreq_validate(dev, req)) {
+        req->status = BLKREQ_ERROR;
+        return false;
+    }
+
+    if (req->op == BLKREQ_FLUSH) return blkreq_dispatch(dev, req, true);
+
+    size_t flags = spin_lock_irqsave(&dev->queue.lock);
+    blkq_insert(dev, req, time_now_ns());
+    spin_unlock_irqrestore(&dev->queue.lock, flags);
+    blkq_run(dev, BLKQ_RUN_BLOCKING);
+    return true;
+}
+
+void BlockRequest_Complete(BlockRequest* req, bool ok)
+{
+    // The waiter may free the request as soon as it sees the status; read
+    // everything needed afterwards first. A waiter that registers after this
+    // read sleeps one BLKREQ_WAIT_SLICE_MS at most.
+    BlockRequestDone done = req->done;
+    struct Thread* waiter = req->waiter;
+    __asm__ __volatile__("" ::: "memory");
+    req->status = ok ? BLKREQ_OK : BLKREQ_ERROR;
+
+    if (done) done(req);
+    // The scheduler only runs on the BSP; elsewhere the waiter wakes on its own
+    if (waiter && scheduler_is_running()) thread_wake(waiter);
+}
+
+bool BlockDevice_Wait(BlockRequest* req)
+{
+    if (!req) return false;
+    BlockDevice* dev = req->dev;
+
+    while (req->status == BLKREQ_PENDING) {
+        // Still queued (plugged, all units busy, or deferred): push it out
+        if (req->queued) blkq_run(dev, BLKQ_RUN_BLOCKING | BLKQ_RUN_FORCE);
+        if (req->status != BLKREQ_PENDING) break;
+        if (dev && dev->ops && dev->ops->poll) dev->ops->poll(dev);
+        if (req->status != BLKREQ_PENDING) break;
+
+        if (scheduler_is_running() && !fiber_current() && arch_irq_enabled()) {
+            req->waiter = thread_current();
+            __sync_synchronize(); // waiter is visible before status is re-read
+            if (req->status == BLKREQ_PENDING) thread_sleep_ms(BLKREQ_WAIT_SLICE_MS);
+            req->waiter = NULL;
+        } else if (!fiber_yield()) {
+            cpu_relax();
+        }
+    }
+    return req->status == BLKREQ_OK;
+}
+
+bool BlockDevice_WaitAll(BlockRequest* reqs, size_t count)
+{
+    bool ok = true;
+    for (size_t i = 0; i < count; ++i) {
+        if (!BlockDevice_Wait(&reqs[i])) ok = false;
+    }
+    return ok;
+}
+
+void BlockSegIter_Init(BlockSegIter* it, const BlockSegment* sg, uint32_t count)
+{
+    it->sg = sg;
+    it->count = count;
+    it->idx = 0;
+    it->off = 0;
+    while (it->idx < it->count && it->sg[it->idx].bytes == 0) it->idx++;
+}
+
+uint32_t BlockSegIter_Extent(const BlockSegIter* it, uint32_t max, uintptr_t* out_phys)
+{
+    if (it->idx >= it->count || max == 0) return 0;
+    const BlockSegment* seg = &it->sg[it->idx];
+    uint32_t left = seg->bytes - it->off;
+    return (uint32_t)vmm_dma_extent((uint8_t*)seg->buffer + it->off, left < max ? left : max, out_phys);
 }
 
+void BlockSegIter_Advance(BlockSegIter* it, uint32_t bytes)
+{
+    while (bytes && it->idx < it->count) {
+        uint32_t left = it->sg[it->idx].bytes - it->off;
+        if (bytes < left) {
+            it->off += bytes;
+            return;
+        }
+        bytes -= left;
+        it->idx++;
+        it->off = 0;
+    }
+    while (it->idx < it->count && it->sg[it->idx].bytes == 0) it->idx++;
+}
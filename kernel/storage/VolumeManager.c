@@ -3,6 +3,8 @@
 #include <util/string.h>
 #include <util/convert.h>
 #include <debug/debug.h>
+#include <task/Executor.h>
+#include <boot/boot_trace.h>
 #include <list.h>
 
 #include <stddef.h>
@@ -145,6 +147,15 @@ static void volume_manager_add(Volume* volume)
         (unsigned long long)volume->block_count);
 }
 
+// Per-device scan job. Devices are probed in parallel on the executor; each
+// job collects its volumes privately and Rebuild registers them in device
+// order so names and log output stay deterministic.
+typedef struct VolumeScanJob {
+    BlockDevice* device;
+    List* found;
+    Task* task;
+} VolumeScanJob;
+
 static bool volume_read_device(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer)
 {
     if (!device) return false;
@@ -166,7 +177,7 @@ static void gpt_decode_name(const uint16_t* name_utf16, size_t length, char* out
     out[pos] = '\0';
 }
 
-static void volume_scan_gpt(BlockDevice* device, uint32_t block_size)
+static void volume_scan_gpt(BlockDevice* device, uint32_t block_size, List* found)
 {
     uint8_t* header_block = (uint8_t*)malloc(block_size);
     if (!header_block)
@@ -263,7 +274,7 @@ static void volume_scan_gpt(BlockDevice* device, uint32_t block_size)
             LOG("VolumeManager: GPT part %s label '%s'", volume->name, name_buf);
         }
 
-        volume_manager_add(volume);
+        List_Add(found, volume);
         partition_index++;
     }
 
@@ -271,7 +282,7 @@ static void volume_scan_gpt(BlockDevice* device, uint32_t block_size)
     free(header_block);
 }
 
-static void volume_scan_mbr(BlockDevice* device, uint32_t block_size)
+static void volume_scan_mbr(BlockDevice* device, uint32_t block_size, List* found)
 {
     uint8_t* sector = (uint8_t*)malloc(block_size);
     if (!sector)
@@ -303,7 +314,7 @@ static void volume_scan_mbr(BlockDevice* device, uint32_t block_size)
     if (gpt_protective)
     {
         free(sector);
-        volume_scan_gpt(device, block_size);
+        volume_scan_gpt(device, block_size, found);
         return;
     }
 
@@ -332,7 +343,7 @@ static void volume_scan_mbr(BlockDevice* device, uint32_t block_size)
             volume_free(volume);
             continue;
         }
-        volume_manager_add(volume);
+        List_Add(found, volume);
     }
 
     free(sector);
@@ -343,6 +354,34 @@ void VolumeManager_Init(void)
     volume_manager_ensure_init();
 }
 
+static void volume_scan_device(void* arg)
+{
+    VolumeScanJob* job = (VolumeScanJob*)arg;
+    BlockDevice* device = job->device;
+
+    uint32_t block_size = device->logical_block_size ? device->logical_block_size : 512;
+    if (block_size == 0)
+        block_size = 512;
+
+    const char* base_name = device->name ? device->name : "disk";
+    Volume* whole = volume_allocate(device,
+                                    VOLUME_TYPE_WHOLE_DEVICE,
+                                    base_name,
+                                    0,
+                                    device->total_blocks,
+                                    block_size);
+    if (whole)
+    {
+        whole->mbr_type = 0;
+        List_Add(job->found, whole);
+    }
+
+    if (device->type != BLKDEV_TYPE_CDROM)
+    {
+        volume_scan_mbr(device, block_size, job->found);
+    }
+}
+
 void VolumeManager_Rebuild(void)
 {
     volume_manager_ensure_init();
@@ -351,34 +390,47 @@ void VolumeManager_Rebuild(void)
     volume_manager_clear();
 
     size_t device_count = BlockDevice_Count();
+    if (device_count == 0)
+        return;
+
+    VolumeScanJob* jobs = (VolumeScanJob*)malloc(device_count * sizeof(VolumeScanJob));
+    if (!jobs)
+    {
+        ERROR("VolumeManager: out of memory for %zu scan jobs", device_count);
+        return;
+    }
+    memset(jobs, 0, device_count * sizeof(VolumeScanJob));
+
+    uint32_t span = boot_trace_begin("volumes", "scan");
+
+    // Partition table reads dominate and devices are locked independently,
+    // so with more than one CPU the probes overlap.
     for (size_t i = 0; i < device_count; ++i)
     {
-        BlockDevice* device = BlockDevice_GetAt(i);
-        if (!device)
+        jobs[i].device = BlockDevice_GetAt(i);
+        if (!jobs[i].device)
+            continue;
+        jobs[i].found = List_Create();
+        if (!jobs[i].found)
             continue;
+        jobs[i].task = task_spawn(volume_scan_device, &jobs[i]);
+    }
 
-        uint32_t block_size = device->logical_block_size ? device->logical_block_size : 512;
-        if (block_size == 0)
-            block_size = 512;
-
-        const char* base_name = device->name ? device->name : "disk";
-        Volume* whole = volume_allocate(device,
-                                        VOLUME_TYPE_WHOLE_DEVICE,
-                                        base_name,
-                                        0,
-                                        device->total_blocks,
-                                        block_size);
-        if (whole)
-        {
-            whole->mbr_type = 0;
-            volume_manager_add(whole);
-        }
+    for (size_t i = 0; i < device_count; ++i)
+    {
+        task_join(jobs[i].task);
+        if (!jobs[i].found)
+            continue;
 
-        if (device->type != BLKDEV_TYPE_CDROM)
+        for (ListNode* node = jobs[i].found->head; node != NULL; node = node->next)
         {
-            volume_scan_mbr(device, block_size);
+            volume_manager_add((Volume*)node->data);
         }
+        List_Destroy(jobs[i].found, false);
     }
+
+    boot_trace_end(span);
+    free(jobs);
 }
 
 size_t VolumeManager_Count(void)
@@ -434,3 +486,16 @@ bool Volume_WriteSectors(Volume* volume, uint64_t lba, uint32_t count, const voi
         return false;
     return BlockDevice_Write(volume->device, absolute_lba, count, buffer);
 }
+
+bool Volume_SubmitSectors(Volume* volume, BlockRequest* req)
+{
+    if (!volume || !req) return false;
+    if (req->op != BLKREQ_FLUSH) {
+        if (req->count == 0 || req->lba + req->count > volume->block_count) {
+            req->status = BLKREQ_ERROR;
+            return false;
+        }
+        req->lba += volume->start_lba;
+    }
+    return BlockDevice_Submit(volume->device, req);
+}
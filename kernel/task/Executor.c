@@ -0,0 +1,220 @@
+#include <task/Executor.h>
+#include <smp/smp.h>
+#include <memory/memory.h>
+#include <debug/debug.h>
+#include <spinlock.h>
+#include <arch.h>
+
+#define EXECUTOR_DEQUE_MASK  (EXECUTOR_DEQUE_SIZE - 1)
+
+struct Task {
+    TaskFunc func;
+    void* arg;
+    volatile uint32_t done;
+};
+
+/*
+ * Chase-Lev deque (Lê ve ark. 2013, sabit boyutlu halka). top ve bottom hiç
+ * sarmayan sayaçlardır, farkları eleman sayısıdır. x86'da (TSO) yalnızca iki
+ * yerde StoreLoad bariyeri gerekir: pop'ta bottom yazısı top okumasından,
+ * steal'de top okuması bottom okumasından önce görünmeli.
+ */
+typedef struct {
+    volatile size_t top;        // Hırsızlar CAS ile ilerletir
+    volatile size_t bottom;     // Yalnızca sahibi yazar
+    Task* volatile slots[EXECUTOR_DEQUE_SIZE];
+
+    volatile uint64_t executed;
+    volatile uint64_t stolen;
+    volatile uint64_t overflows;
+} __attribute__((aligned(64))) TaskDeque;
+
+static TaskDeque s_deques[SMP_MAX_CPUS];
+static volatile bool s_running = false;
+
+static bool deque_push(TaskDeque* dq, Task* task)
+{
+    size_t b = dq->bottom;
+    size_t t = dq->top;
+    if (b - t >= EXECUTOR_DEQUE_SIZE) return false;
+
+    dq->slots[b & EXECUTOR_DEQUE_MASK] = task;
+    __asm__ __volatile__("" ::: "memory");  // Yuva, bottom'dan önce yayınlanır
+    dq->bottom = b + 1;
+    return true;
+}
+
+static Task* deque_pop(TaskDeque* dq)
+{
+    size_t b = dq->bottom - 1;
+    dq->bottom = b;
+    __sync_synchronize();
+    size_t t = dq->top;
+
+    if ((intptr_t)(b - t) < 0) {
+        // Boş
+        dq->bottom = b + 1;
+        return NULL;
+    }
+
+    Task* task = dq->slots[b & EXECUTOR_DEQUE_MASK];
+    if (b == t) {
+        // Son eleman: bir hırsızla yarışıyoruz, top'u kim ilerletirse onundur
+        if (!__sync_bool_compare_and_swap(&dq->top, t, t + 1)) task = NULL;
+        dq->bottom = b + 1;
+    }
+    return task;
+}
+
+static Task* deque_steal(TaskDeque* dq)
+{
+    size_t t = dq->top;
+    __sync_synchronize();
+    size_t b = dq->bottom;
+
+    if ((intptr_t)(b - t) <= 0) return NULL;
+
+    Task* task = dq->slots[t & EXECUTOR_DEQUE_MASK];
+    if (!__sync_bool_compare_and_swap(&dq->top, t, t + 1)) return NULL;  // Başka hırsız ya da sahibi aldı
+    return task;
+}
+
+// BSP'de birden çok thread aynı deque'nin sahibidir; sahip işlemleri
+// kesmeler kapalıyken yapılınca zamanlayıcı araya giremez
+static bool executor_push_local(uint32_t id, Task* task)
+{
+    size_t flags = arch_irq_save();
+    bool ok = deque_push(&s_deques[id], task);
+    arch_irq_restore(flags);
+    return ok;
+}
+
+static Task* executor_find_task(uint32_t id)
+{
+    size_t flags = arch_irq_save();
+    Task* task = deque_pop(&s_deques[id]);
+    arch_irq_restore(flags);
+    if (task) return task;
+
+    // Kurbanları kendimizden sonrakinden başlayarak dolaş; herkes CPU0'a yüklenmesin
+    uint32_t n = smp_cpu_count();
+    for (uint32_t i = 1; i < n; ++i) {
+        uint32_t victim = (id + i) % n;
+        task = deque_steal(&s_deques[victim]);
+        if (task) {
+            s_deques[id].stolen++;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static void executor_run(uint32_t id, Task* task)
+{
+    task->func(task->arg);
+    s_deques[id].executed++;
+
+    // Görevin yazdıkları done'dan önce görünür; bundan sonra task'a dokunulmaz
+    __asm__ __volatile__("" ::: "memory");
+    task->done = 1;
+}
+
+static bool executor_idle_work(PerCpu* cpu)
+{
+    Task* task = executor_find_task(cpu->id);
+    if (!task) return false;
+    executor_run(cpu->id, task);
+    return true;
+}
+
+// Uyuyan bir AP'yi uyandır. Hiçbiri hlt'de değilse hepsinin wake_seq'i artar:
+// hlt'ye girmek üzere olan CPU uyumadan deque'lere yeniden bakar
+static void executor_kick(uint32_t self)
+{
+    uint32_t n = smp_cpu_count();
+    for (uint32_t i = 1; i < n; ++i) {
+        if (smp_wake_cpu((self + i) % n)) return;
+    }
+}
+
+bool executor_init(void)
+{
+    if (s_running) return true;
+
+    uint32_t cpus = smp_cpu_count();
+    if (cpus < 2) {
+        LOG("Executor: single CPU, tasks run inline");
+        return false;
+    }
+
+    s_running = true;
+    smp_set_idle_work(executor_idle_work);
+
+    // Kayıttan önce uyuyan AP'ler de deque'lere bir kez baksın
+    executor_kick(0);
+
+    LOG("Executor: %u workers, %u-slot deque per CPU", cpus, EXECUTOR_DEQUE_SIZE);
+    return true;
+}
+
+bool executor_is_running(void)
+{
+    return s_running;
+}
+
+Task* task_spawn(TaskFunc func, void* arg)
+{
+    if (!func) return NULL;
+
+    if (!s_running) {
+        func(arg);
+        return NULL;
+    }
+
+    Task* task = (Task*)malloc(sizeof(Task));
+    if (!task) {
+        func(arg);
+        return NULL;
+    }
+    task->func = func;
+    task->arg = arg;
+    task->done = 0;
+
+    uint32_t id = this_cpu()->id;
+    if (!executor_push_local(id, task)) {
+        // Deque dolu: üretici hızını kendiliğinden düşürür
+        s_deques[id].overflows++;
+        free(task);
+        func(arg);
+        return NULL;
+    }
+
+    executor_kick(id);
+    return task;
+}
+
+void task_join(Task* task)
+{
+    if (!task) return;
+
+    uint32_t id = this_cpu()->id;
+    while (!task->done) {
+        Task* other = executor_find_task(id);
+        if (other) executor_run(id, other);
+        else cpu_relax();
+    }
+
+    __asm__ __volatile__("" ::: "memory");
+    free(task);
+}
+
+void executor_dump(void)
+{
+    uint32_t n = smp_cpu_count();
+    for (uint32_t i = 0; i < n; ++i) {
+        const TaskDeque* dq = &s_deques[i];
+        LOG("Executor CPU%u: executed %llu, stolen %llu, overflows %llu, queued %zu",
+            i, (unsigned long long)dq->executed, (unsigned long long)dq->stolen,
+            (unsigned long long)dq->overflows, (size_t)(dq->bottom - dq->top));
+    }
+}
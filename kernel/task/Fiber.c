@@ -0,0 +1,195 @@
+#include <task/Fiber.h>
+#include <task/Thread.h>
+#include <smp/smp.h>
+#include <memory/memory.h>
+#include <debug/debug.h>
+#include <spinlock.h>
+#include <panic.h>
+#include <sleep.h>
+#include <arch.h>
+
+#ifdef ARCH_AMD
+#define FIBER_SAVED_REGS     6   // rbp, rbx, r12-r15
+#else
+#define FIBER_SAVED_REGS     4   // ebp, ebx, esi, edi
+#endif
+#define FIBER_INITIAL_FLAGS  0x2 // IF=0; fiber_bootstrap çağıranın durumunu geri yükler
+
+struct Fiber {
+    size_t sp;                  // arch_context_switch'in kaydettiği yığın işaretçisi
+    const char* name;
+    FiberFunc func;
+    void* arg;
+    bool done;
+    struct Fiber* next;         // Hazır kuyruğu
+    void* stack;                // Havuz bloğu; Fiber bloğun tepesinde durur
+};
+
+// Bir thread'in (zamanlayıcı yoksa CPU'nun) fiber'ları. İlk fiber_create'te
+// ayrılır, fiber_run_all bitince serbest kalır.
+typedef struct FiberContext {
+    Fiber* ready_head;
+    Fiber* ready_tail;
+    Fiber* current;
+    size_t host_sp;             // fiber_run_all'ın yığını
+    size_t host_flags;          // Yeni fiber'lar bu kesme durumuyla başlar
+} FiberContext;
+
+#define FIBER_DESC_SIZE  ((sizeof(Fiber) + 15) & ~(size_t)15)
+
+extern void arch_fiber_trampoline(void);
+
+static void* s_stack_pool[FIBER_STACK_POOL];
+static uint32_t s_stack_pool_count = 0;
+static Spinlock s_stack_pool_lock = SPINLOCK_INIT;
+
+static void* fiber_stack_get(void)
+{
+    size_t flags = spin_lock_irqsave(&s_stack_pool_lock);
+    void* stack = s_stack_pool_count ? s_stack_pool[--s_stack_pool_count] : NULL;
+    spin_unlock_irqrestore(&s_stack_pool_lock, flags);
+
+    return stack ? stack : malloc_aligned(16, FIBER_STACK_SIZE);
+}
+
+static void fiber_stack_put(void* stack)
+{
+    size_t flags = spin_lock_irqsave(&s_stack_pool_lock);
+    if (s_stack_pool_count < FIBER_STACK_POOL) {
+        s_stack_pool[s_stack_pool_count++] = stack;
+        stack = NULL;
+    }
+    spin_unlock_irqrestore(&s_stack_pool_lock, flags);
+
+    if (stack) free(stack);
+}
+
+static FiberContext** fiber_context_slot(void)
+{
+    if (scheduler_is_running())
+        return &thread_current()->fibers;
+    return &this_cpu()->fibers;
+}
+
+static void fiber_ready_push(FiberContext* ctx, Fiber* fiber)
+{
+    fiber->next = NULL;
+    if (ctx->ready_tail) ctx->ready_tail->next = fiber;
+    else ctx->ready_head = fiber;
+    ctx->ready_tail = fiber;
+}
+
+// arch_fiber_trampoline'dan çağrılır, dönmez
+void fiber_bootstrap(void)
+{
+    FiberContext* ctx = *fiber_context_slot();
+    Fiber* fiber = ctx->current;
+
+    arch_irq_restore(ctx->host_flags);
+    fiber->func(fiber->arg);
+
+    (void)arch_irq_save();
+    fiber->done = true;
+    arch_context_switch(&fiber->sp, ctx->host_sp);
+
+    PANIC("fiber_bootstrap: finished fiber resumed");
+}
+
+Fiber* fiber_create(const char* name, FiberFunc func, void* arg)
+{
+    if (!func) return NULL;
+
+    FiberContext** slot = fiber_context_slot();
+    if (!*slot) {
+        FiberContext* ctx = (FiberContext*)malloc(sizeof(FiberContext));
+        if (!ctx) return NULL;
+        memset(ctx, 0, sizeof(*ctx));
+        *slot = ctx;
+    }
+
+    uint8_t* stack = (uint8_t*)fiber_stack_get();
+    if (!stack) {
+        ERROR("fiber_create: out of memory for '%s'", name ? name : "?");
+        return NULL;
+    }
+
+    Fiber* fiber = (Fiber*)(stack + FIBER_STACK_SIZE - FIBER_DESC_SIZE);
+    memset(fiber, 0, sizeof(*fiber));
+    fiber->name = name ? name : "fiber";
+    fiber->func = func;
+    fiber->arg = arg;
+    fiber->stack = stack;
+
+    // arch_context_switch'in pop edeceği ilk çerçeve: kayıtlar, flags, dönüş adresi
+    size_t* sp = (size_t*)fiber;
+    *--sp = 0;
+    *--sp = (size_t)arch_fiber_trampoline;
+    *--sp = FIBER_INITIAL_FLAGS;
+    for (int i = 0; i < FIBER_SAVED_REGS; i++)
+        *--sp = 0;
+    fiber->sp = (size_t)sp;
+
+    fiber_ready_push(*slot, fiber);
+    return fiber;
+}
+
+void fiber_run_all(void)
+{
+    FiberContext** slot = fiber_context_slot();
+    FiberContext* ctx = *slot;
+    if (!ctx) return;
+
+    if (ctx->current) {
+        WARN("fiber_run_all: called from fiber '%s'", ctx->current->name);
+        return;
+    }
+
+    while (ctx->ready_head) {
+        Fiber* fiber = ctx->ready_head;
+        ctx->ready_head = fiber->next;
+        if (!ctx->ready_head) ctx->ready_tail = NULL;
+
+        ctx->current = fiber;
+        size_t flags = arch_irq_save();
+        ctx->host_flags = flags;
+        arch_context_switch(&ctx->host_sp, fiber->sp);
+        arch_irq_restore(flags);
+        ctx->current = NULL;
+
+        // Bitmiş fiber'ın yığınından artık çıkıldı, havuza geri verilebilir
+        if (fiber->done) fiber_stack_put(fiber->stack);
+        else fiber_ready_push(ctx, fiber);
+    }
+
+    *slot = NULL;
+    free(ctx);
+}
+
+bool fiber_yield(void)
+{
+    FiberContext* ctx = *fiber_context_slot();
+    if (!ctx || !ctx->current || !ctx->ready_head) return false;
+
+    Fiber* fiber = ctx->current;
+    size_t flags = arch_irq_save();
+    arch_context_switch(&fiber->sp, ctx->host_sp);
+    arch_irq_restore(flags);
+    return true;
+}
+
+bool fiber_wait_event(bool (*cond)(void* arg), void* arg, uint32_t timeout_us)
+{
+    // wait_deadline_poll fiber içinde önce sırayı bırakır
+    return wait_until(cond, arg, timeout_us);
+}
+
+Fiber* fiber_current(void)
+{
+    FiberContext* ctx = *fiber_context_slot();
+    return ctx ? ctx->current : NULL;
+}
+
+const char* fiber_name(const Fiber* fiber)
+{
+    return fiber ? fiber->name : NULL;
+}
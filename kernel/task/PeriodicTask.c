@@ -3,9 +3,87 @@
 #include <time/timer.h>
 #include <memory/memory.h>
 #include <util/string.h>
+#include <task/Thread.h>
+#include <arch.h>
 
 List* periodicTasks = NULL;
 
+// Görevler zamanlayıcı IRQ'sunda değil bu thread'de çalışır
+static Thread* s_periodic_worker = NULL;
+
+// Zamanlayıcısı dolmuş, worker'da çalışmayı bekleyen görevler (FIFO)
+static PeriodicTask* s_due_head = NULL;
+static PeriodicTask* s_due_tail = NULL;
+
+static void periodic_task_run(PeriodicTask* task)
+{
+    if (!task->running) return;
+    if (task->taskFunction) task->taskFunction((void*)task, task->arg);
+    task->lastRunMs = uptimeMs;
+}
+
+// Çarktan, softirq bağlamında çağrılır
+static void periodic_task_expired(KTimer* timer, void* arg)
+{
+    (void)timer;
+    PeriodicTask* task = (PeriodicTask*)arg;
+
+    if (!s_periodic_worker)
+    {
+        periodic_task_run(task);
+        return;
+    }
+
+    size_t flags = arch_irq_save();
+    if (!task->due)
+    {
+        // Görev hâlâ çalışıyorsa kaçırılan periyot biriktirilmez
+        task->due = true;
+        task->dueNext = NULL;
+        if (s_due_tail) s_due_tail->dueNext = task;
+        else s_due_head = task;
+        s_due_tail = task;
+    }
+    arch_irq_restore(flags);
+
+    thread_wake(s_periodic_worker);
+}
+
+static PeriodicTask* periodic_task_pop_due(void)
+{
+    size_t flags = arch_irq_save();
+    PeriodicTask* task = s_due_head;
+    if (task)
+    {
+        s_due_head = task->dueNext;
+        if (!s_due_head) s_due_tail = NULL;
+        task->dueNext = NULL;
+        task->due = false;
+    }
+    arch_irq_restore(flags);
+    return task;
+}
+
+static void periodic_task_unqueue(PeriodicTask* task)
+{
+    size_t flags = arch_irq_save();
+    if (task->due)
+    {
+        PeriodicTask* prev = NULL;
+        for (PeriodicTask* it = s_due_head; it; prev = it, it = it->dueNext)
+        {
+            if (it != task) continue;
+            if (prev) prev->dueNext = it->dueNext;
+            else s_due_head = it->dueNext;
+            if (s_due_tail == it) s_due_tail = prev;
+            break;
+        }
+        task->due = false;
+        task->dueNext = NULL;
+    }
+    arch_irq_restore(flags);
+}
+
 PeriodicTask* periodic_task_create(const char* name, void(*taskFunction)(void* task, void* arg), void* arg, size_t intervalMs)
 {
     if (!periodicTasks)
@@ -21,8 +99,13 @@ PeriodicTask* periodic_task_create(const char* name, void(*taskFunction)(void* t
     task->intervalMs = intervalMs;
     task->lastRunMs = 0;
     task->running = false;
+    task->due = false;
+    task->dueNext = NULL;
+    ktimer_init(&task->timer, periodic_task_expired, task);
 
+    size_t flags = arch_irq_save();
     List_Add(periodicTasks, task);
+    arch_irq_restore(flags);
 
     return task;
 }
@@ -32,7 +115,8 @@ void periodic_task_start(PeriodicTask* task)
     if (task)
     {
         task->running = true;
-        task->lastRunMs = 0; // Reset last run time to ensure immediate execution
+        // İlk çalıştırma bir sonraki tick'te, sonra intervalMs aralıklarla
+        ktimer_arm_at(&task->timer, uptimeMs, task->intervalMs ? (uint32_t)task->intervalMs : 1);
     }
 }
 
@@ -41,6 +125,8 @@ void periodic_task_stop(PeriodicTask* task)
     if (task)
     {
         task->running = false;
+        ktimer_cancel(&task->timer);
+        periodic_task_unqueue(task);
     }
 }
 
@@ -48,9 +134,12 @@ void periodic_task_destroy(PeriodicTask* task)
 {
     if (task)
     {
+        periodic_task_stop(task);
         if (periodicTasks)
         {
+            size_t flags = arch_irq_save();
             List_Remove(periodicTasks, task);
+            arch_irq_restore(flags);
         }
         free(task->name);
         free(task);
@@ -59,19 +148,25 @@ void periodic_task_destroy(PeriodicTask* task)
 
 void periodic_task_run_all()
 {
-    if (!periodicTasks)
-        return;
-
-    uint64_t currentTimeMs = uptimeMs; // Assume uptimeMs is a global variable tracking system uptime in milliseconds
+    PeriodicTask* task;
+    while ((task = periodic_task_pop_due()) != NULL)
+        periodic_task_run(task);
+}
 
-    for (ListNode* node = periodicTasks->head; node != NULL; node = node->next)
+static void periodic_task_worker(void* arg)
+{
+    (void)arg;
+    for (;;)
     {
-        PeriodicTask* task = (PeriodicTask*)node->data;
-        if (task->running && (currentTimeMs - task->lastRunMs >= task->intervalMs))
-        {
-            if (task->taskFunction) task->taskFunction((void*)task, task->arg);
-            task->lastRunMs = currentTimeMs;
-        }
+        periodic_task_run_all();
+        thread_block(); // Zamanlayıcı callback'i uyandırır
     }
+}
+
+bool periodic_task_init(void)
+{
+    if (s_periodic_worker) return true;
 
+    s_periodic_worker = thread_create("periodic", periodic_task_worker, NULL);
+    return s_periodic_worker != NULL;
 }
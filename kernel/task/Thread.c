@@ -0,0 +1,530 @@
+#include <task/Thread.h>
+#include <memory/memory.h>
+#include <memory/heap.h>
+#include <memory/slab.h>
+#include <memory/vmm.h>
+#include <time/timer.h>
+#include <time/tick.h>
+#include <util/string.h>
+#include <debug/debug.h>
+#include <smp/smp.h>
+#include <panic.h>
+#include <arch.h>
+
+/*
+ * Tek işlemcili, öncelikli (preemptive) round-robin zamanlayıcı.
+ *
+ * Geçişler iki yoldan olur: thread'in kendisi (yield/sleep/block/exit) ya da
+ * zamanlayıcı IRQ'su. IRQ yolunda kesilen thread'in ISR çerçevesi kendi
+ * yığınında kalır; geri seçildiğinde handler kaldığı yerden dönüp iret yapar.
+ * Tüm kuyruk işlemleri kesmeler kapalıyken yapılır.
+ */
+
+#ifdef ARCH_AMD
+#define THREAD_SAVED_REGS    6   // rbp, rbx, r12-r15
+#else
+#define THREAD_SAVED_REGS    4   // ebp, ebx, esi, edi
+#endif
+#define THREAD_INITIAL_FLAGS 0x2 // IF=0; thread_bootstrap kesmeleri açar
+
+static KmemCache* s_thread_cache = NULL;
+static Thread s_boot_thread;
+
+static Thread* s_current = NULL;
+static Thread* s_idle = NULL;
+static Thread* s_all = NULL;
+static Thread* s_run_head = NULL;
+static Thread* s_run_tail = NULL;
+static Thread* s_sleepers = NULL;       // wake_ms'e göre sıralı
+static Thread* s_zombies = NULL;
+
+static uint32_t s_next_id = 0;
+static uint32_t s_slice_left = THREAD_TIME_SLICE_MS;
+static volatile uint32_t s_preempt_count = 0;
+static volatile bool s_need_resched = false;
+static bool s_running = false;
+
+static const char* const s_state_names[] = { "ready", "running", "sleeping", "blocked", "dead" };
+
+void thread_bootstrap(void);
+
+/* ---- Kuyruk yardımcıları (kesmeler kapalı) ---- */
+
+static void runq_push(Thread* thread)
+{
+    if (thread->urgent)
+    {
+        thread->next = s_run_head;
+        s_run_head = thread;
+        if (!s_run_tail) s_run_tail = thread;
+        return;
+    }
+
+    thread->next = NULL;
+    if (s_run_tail) s_run_tail->next = thread;
+    else s_run_head = thread;
+    s_run_tail = thread;
+}
+
+static Thread* runq_pop(void)
+{
+    Thread* thread = s_run_head;
+    if (thread)
+    {
+        s_run_head = thread->next;
+        if (!s_run_head) s_run_tail = NULL;
+        thread->next = NULL;
+    }
+    return thread;
+}
+
+static void sleepq_insert(Thread* thread)
+{
+    Thread** link = &s_sleepers;
+    while (*link && (*link)->wake_ms <= thread->wake_ms)
+        link = &(*link)->next;
+    thread->next = *link;
+    *link = thread;
+}
+
+static void sleepq_remove(Thread* thread)
+{
+    for (Thread** link = &s_sleepers; *link; link = &(*link)->next)
+    {
+        if (*link == thread)
+        {
+            *link = thread->next;
+            thread->next = NULL;
+            return;
+        }
+    }
+}
+
+static void thread_make_ready(Thread* thread)
+{
+    thread->state = THREAD_READY;
+    runq_push(thread);
+    if (s_current == s_idle || thread->urgent)
+        s_need_resched = true;
+}
+
+/* ---- Geçiş ---- */
+
+// Kesmeler kapalı çağrılır. Çağıran thread'in durumu önceden ayarlanmış olmalı
+// (RUNNING kalırsa run queue'nun sonuna eklenir).
+static void schedule(void)
+{
+    Thread* prev = s_current;
+    Thread* next = runq_pop();
+
+    s_need_resched = false;
+    s_slice_left = THREAD_TIME_SLICE_MS;
+
+    if (!next)
+    {
+        if (prev->state == THREAD_RUNNING)
+            return; // Başka iş yok, devam
+        next = s_idle;
+    }
+
+    if (prev->state == THREAD_RUNNING)
+    {
+        prev->state = THREAD_READY;
+        if (prev != s_idle) runq_push(prev);
+    }
+
+    next->state = THREAD_RUNNING;
+    if (next == prev)
+        return;
+
+    next->switch_count++;
+    s_current = next;
+
+    // Idle'dan çıkılıyor: durdurulmuş tick'i geri getir
+    if (prev == s_idle) tick_nohz_idle_exit();
+
+    if (prev->fpu_state) fpu_save(prev->fpu_state);
+    arch_context_switch(&prev->sp, next->sp);
+
+    // prev yeniden seçildi; s_current artık yine bu thread
+    if (s_current->fpu_state) fpu_restore(s_current->fpu_state);
+}
+
+void thread_bootstrap(void)
+{
+    Thread* self = s_current;
+    if (self->fpu_state) fpu_restore(self->fpu_state);
+
+    __asm__ __volatile__("sti" : : : "memory");
+
+    self->entry(self->arg);
+    thread_exit();
+}
+
+/* ---- Oluşturma / temizlik ---- */
+
+static void thread_free(Thread* thread)
+{
+    if (thread->stack) vfree(thread->stack);
+    if (thread->fpu_state) heap_free(thread->fpu_state);
+    kmem_cache_free(s_thread_cache, thread);
+}
+
+// Çıkmış thread'lerin yığınlarını geri ver (kendi yığınında çalışmayan biri yapar)
+static void thread_reap(void)
+{
+    size_t flags = arch_irq_save();
+    Thread* zombies = s_zombies;
+    s_zombies = NULL;
+
+    for (Thread* dead = zombies; dead; dead = dead->next)
+    {
+        for (Thread** link = &s_all; *link; link = &(*link)->all_next)
+        {
+            if (*link == dead)
+            {
+                *link = dead->all_next;
+                break;
+            }
+        }
+    }
+    arch_irq_restore(flags);
+
+    while (zombies)
+    {
+        Thread* next = zombies->next;
+        thread_free(zombies);
+        zombies = next;
+    }
+}
+
+static bool thread_alloc_fpu(Thread* thread)
+{
+    size_t size = fpu_state_size();
+    if (size == 0) return true;
+
+    thread->fpu_state = heap_aligned_alloc(64, size);
+    if (!thread->fpu_state) return false;
+
+    // XSAVE başlığın XCOMP_BV'sini ve 8-63. baytlarını yazmaz; heap artığı
+    // kalırsa thread'in ilk XRSTOR'u #GP verir
+    memset(thread->fpu_state, 0, size);
+
+    // Geçerli bir XSAVE başlığı olsun diye oluşturanın durumu başlangıç olarak alınır
+    size_t flags = arch_irq_save();
+    fpu_save(thread->fpu_state);
+    arch_irq_restore(flags);
+    return true;
+}
+
+static Thread* __thread_create(const char* name, void (*entry)(void* arg), void* arg, bool enqueue)
+{
+    if (!entry) return NULL;
+
+    thread_reap();
+
+    Thread* thread = (Thread*)kmem_cache_zalloc(s_thread_cache);
+    if (!thread) return NULL;
+
+    thread->stack = vmalloc(THREAD_STACK_SIZE);
+    if (!thread->stack || !thread_alloc_fpu(thread))
+    {
+        ERROR("thread_create: out of memory for '%s'", name ? name : "?");
+        thread_free(thread);
+        return NULL;
+    }
+
+    strncpy(thread->name, name ? name : "thread", THREAD_NAME_MAX - 1);
+    thread->entry = entry;
+    thread->arg = arg;
+
+    // arch_context_switch'in pop edeceği ilk çerçeve: kayıtlar, flags, dönüş adresi
+    size_t* sp = (size_t*)((uint8_t*)thread->stack + THREAD_STACK_SIZE);
+    *--sp = 0;
+    *--sp = (size_t)arch_thread_trampoline;
+    *--sp = THREAD_INITIAL_FLAGS;
+    for (int i = 0; i < THREAD_SAVED_REGS; i++)
+        *--sp = 0;
+    thread->sp = (size_t)sp;
+
+    size_t flags = arch_irq_save();
+    thread->id = ++s_next_id;
+    thread->all_next = s_all;
+    s_all = thread;
+    thread->state = THREAD_READY;
+    if (enqueue) runq_push(thread);
+    arch_irq_restore(flags);
+
+    return thread;
+}
+
+Thread* thread_create(const char* name, void (*entry)(void* arg), void* arg)
+{
+    if (!s_running)
+    {
+        ERROR("thread_create: scheduler not initialized");
+        return NULL;
+    }
+    return __thread_create(name, entry, arg, true);
+}
+
+static void idle_thread(void* arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        thread_reap();
+
+        __asm__ __volatile__("cli" : : : "memory");
+        if (s_run_head)
+        {
+            __asm__ __volatile__("sti" : : : "memory");
+            thread_yield();
+        }
+        else
+        {
+            // Tickless: bir sonraki vadeye kadar zamanlayıcı kesmesi gelmez.
+            // sti'den sonraki tek komut (hlt) kesilmez, uyandırma kaçmaz.
+            tick_nohz_idle_enter();
+            __asm__ __volatile__("sti; hlt" : : : "memory");
+        }
+    }
+}
+
+bool scheduler_init(void)
+{
+    if (s_running) return true;
+
+    s_thread_cache = kmem_cache_create("Thread", sizeof(Thread), 0);
+    if (!s_thread_cache)
+    {
+        ERROR("scheduler_init: cannot create thread cache");
+        return false;
+    }
+
+    // Boot akışı yığınıyla birlikte "main" thread'i olur
+    Thread* boot = &s_boot_thread;
+    strncpy(boot->name, "main", THREAD_NAME_MAX - 1);
+    boot->id = 0;
+    boot->state = THREAD_RUNNING;
+    if (!thread_alloc_fpu(boot))
+    {
+        ERROR("scheduler_init: cannot allocate FPU state");
+        return false;
+    }
+    s_all = boot;
+    s_current = boot;
+
+    s_idle = __thread_create("idle", idle_thread, NULL, false);
+    if (!s_idle)
+    {
+        ERROR("scheduler_init: cannot create idle thread");
+        s_current = NULL;
+        s_all = NULL;
+        return false;
+    }
+
+    s_running = true;
+    LOG("Scheduler initialized (slice %u ms, stack %u KiB, fpu %zu bytes)",
+        THREAD_TIME_SLICE_MS, THREAD_STACK_SIZE / 1024, fpu_state_size());
+    return true;
+}
+
+bool scheduler_is_running(void)
+{
+    // Zamanlayıcı yalnızca BSP'de; AP'de çalışan executor işleri uyumak yerine meşgul bekler
+    return s_running && this_cpu()->id == 0;
+}
+
+void scheduler_tick(void)
+{
+    if (!s_running) return;
+
+    uint64_t now = uptimeMs;
+    while (s_sleepers && s_sleepers->wake_ms <= now)
+    {
+        Thread* thread = s_sleepers;
+        s_sleepers = thread->next;
+        thread_make_ready(thread);
+    }
+
+    if (s_current == s_idle)
+    {
+        if (s_run_head) s_need_resched = true;
+    }
+    else if (s_slice_left && --s_slice_left == 0)
+    {
+        if (s_run_head) s_need_resched = true;
+        else s_slice_left = THREAD_TIME_SLICE_MS;
+    }
+}
+
+uint64_t scheduler_next_wake_ms(void)
+{
+    return s_sleepers ? s_sleepers->wake_ms : UINT64_MAX;
+}
+
+void scheduler_irq_exit(void)
+{
+    if (s_running && s_need_resched && s_preempt_count == 0)
+        schedule();
+}
+
+/* ---- Thread API ---- */
+
+Thread* thread_current(void)
+{
+    return s_current;
+}
+
+void thread_yield(void)
+{
+    if (!s_running) return;
+
+    size_t flags = arch_irq_save();
+    schedule();
+    arch_irq_restore(flags);
+}
+
+void thread_sleep_until(uint64_t wake_ms)
+{
+    if (!s_running)
+    {
+        while (uptimeMs < wake_ms)
+            __asm__ __volatile__("hlt");
+        return;
+    }
+
+    size_t flags = arch_irq_save();
+    Thread* self = s_current;
+
+    if (self->wake_pending)
+    {
+        self->wake_pending = false;
+    }
+    else if (wake_ms > uptimeMs)
+    {
+        self->wake_ms = wake_ms;
+        self->state = THREAD_SLEEPING;
+        if (wake_ms != UINT64_MAX) sleepq_insert(self);
+        schedule();
+    }
+
+    arch_irq_restore(flags);
+}
+
+void thread_sleep_ms(uint32_t ms)
+{
+    if (ms == 0)
+    {
+        thread_yield();
+        return;
+    }
+    thread_sleep_until(uptimeMs + ms);
+}
+
+void thread_block(void)
+{
+    if (!s_running) return;
+
+    size_t flags = arch_irq_save();
+    Thread* self = s_current;
+
+    if (self->wake_pending)
+    {
+        self->wake_pending = false;
+    }
+    else
+    {
+        self->state = THREAD_BLOCKED;
+        schedule();
+    }
+
+    arch_irq_restore(flags);
+}
+
+void thread_wake(Thread* thread)
+{
+    if (!thread) return;
+
+    size_t flags = arch_irq_save();
+    switch (thread->state)
+    {
+    case THREAD_SLEEPING:
+        if (thread->wake_ms != UINT64_MAX) sleepq_remove(thread);
+        thread_make_ready(thread);
+        break;
+    case THREAD_BLOCKED:
+        thread_make_ready(thread);
+        break;
+    case THREAD_READY:
+    case THREAD_RUNNING:
+        thread->wake_pending = true;
+        break;
+    default:
+        break;
+    }
+    arch_irq_restore(flags);
+}
+
+void thread_exit(void)
+{
+    arch_irq_save();
+
+    Thread* self = s_current;
+    if (self == &s_boot_thread || self == s_idle)
+        PANIC("thread_exit: boot/idle thread cannot exit");
+
+    self->state = THREAD_DEAD;
+    self->next = s_zombies;
+    s_zombies = self;
+
+    schedule();
+    PANIC("thread_exit: dead thread was scheduled");
+    for (;;) __asm__ __volatile__("hlt");
+}
+
+void thread_set_urgent(Thread* thread, bool urgent)
+{
+    if (thread) thread->urgent = urgent;
+}
+
+void preempt_disable(void)
+{
+    s_preempt_count++;
+    __asm__ __volatile__("" : : : "memory");
+}
+
+void preempt_enable(void)
+{
+    __asm__ __volatile__("" : : : "memory");
+    if (s_preempt_count == 0)
+    {
+        WARN("preempt_enable: unbalanced call");
+        return;
+    }
+
+    if (--s_preempt_count == 0 && s_need_resched)
+    {
+        // Yalnızca thread bağlamından (kesmeler açıkken) geçiş yapılır
+        if (arch_irq_enabled())
+        {
+            size_t flags = arch_irq_save();
+            schedule();
+            arch_irq_restore(flags);
+        }
+    }
+}
+
+void scheduler_dump(void)
+{
+    size_t flags = arch_irq_save();
+    LOG("Threads:");
+    for (Thread* thread = s_all; thread; thread = thread->all_next)
+    {
+        LOG("  %-3u %-16s %-8s switches=%llu%s", thread->id, thread->name,
+            s_state_names[thread->state], (unsigned long long)thread->switch_count,
+            thread == s_current ? " (current)" : "");
+    }
+    arch_irq_restore(flags);
+}
@@ -0,0 +1,127 @@
+#include <task/WorkQueue.h>
+#include <task/Thread.h>
+#include <debug/debug.h>
+#include <arch.h>
+
+// Öncelik başına FIFO; s_pending_mask'ın i. biti i. kuyruğun dolu olduğunu gösterir
+static WorkItem* s_queue_head[WORK_PRIO_COUNT];
+static WorkItem* s_queue_tail[WORK_PRIO_COUNT];
+static volatile uint32_t s_pending_mask = 0;
+
+static Thread* s_softirq_thread = NULL;
+static bool s_draining = false;
+
+void work_init(WorkItem* work, void (*func)(void* arg), void* arg, WorkPriority priority)
+{
+    if (!work) return;
+    work->func = func;
+    work->arg = arg;
+    work->priority = (uint8_t)(priority < WORK_PRIO_COUNT ? priority : WORK_PRIO_LOW);
+    work->pending = false;
+    work->next = NULL;
+}
+
+bool work_queue_post(WorkItem* work)
+{
+    if (!work || !work->func) return false;
+
+    size_t flags = arch_irq_save();
+
+    if (work->pending)
+    {
+        arch_irq_restore(flags);
+        return false;
+    }
+
+    uint32_t prio = work->priority < WORK_PRIO_COUNT ? work->priority : WORK_PRIO_LOW;
+    work->pending = true;
+    work->next = NULL;
+    if (s_queue_tail[prio]) s_queue_tail[prio]->next = work;
+    else s_queue_head[prio] = work;
+    s_queue_tail[prio] = work;
+    s_pending_mask |= 1u << prio;
+
+    // Thread bağlamından postlanırsa bir sonraki IRQ çıkışında/tick'te geçilir
+    thread_wake(s_softirq_thread);
+
+    arch_irq_restore(flags);
+    return true;
+}
+
+static bool work_queue_run_one(void)
+{
+    size_t flags = arch_irq_save();
+
+    uint32_t mask = s_pending_mask;
+    if (!mask)
+    {
+        arch_irq_restore(flags);
+        return false;
+    }
+
+    uint32_t prio = (uint32_t)__builtin_ctz(mask);
+    WorkItem* work = s_queue_head[prio];
+    s_queue_head[prio] = work->next;
+    if (!s_queue_head[prio])
+    {
+        s_queue_tail[prio] = NULL;
+        s_pending_mask &= ~(1u << prio);
+    }
+    work->next = NULL;
+    work->pending = false; // Çalışırken yeniden postlanabilir
+
+    arch_irq_restore(flags);
+
+    work->func(work->arg);
+    return true;
+}
+
+void work_queue_run_pending(void)
+{
+    // IRQ'dan inline boşaltma sırasında iç içe çağrılmasın
+    if (s_draining) return;
+    s_draining = true;
+    while (work_queue_run_one())
+        ;
+    s_draining = false;
+}
+
+bool work_queue_has_pending(void)
+{
+    return s_pending_mask != 0;
+}
+
+static void softirq_thread(void* arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        work_queue_run_pending();
+        thread_block(); // post, bloklanmadan önce geldiyse wake_pending sayesinde hemen döner
+    }
+}
+
+bool work_queue_init(void)
+{
+    if (s_softirq_thread) return true;
+
+    s_softirq_thread = thread_create("softirq", softirq_thread, NULL);
+    if (!s_softirq_thread)
+    {
+        WARN("WorkQueue: softirq thread could not be created, draining on IRQ exit");
+        return false;
+    }
+
+    thread_set_urgent(s_softirq_thread, true);
+    return true;
+}
+
+void work_queue_irq_exit(void)
+{
+    if (!s_pending_mask) return;
+
+    if (s_softirq_thread)
+        scheduler_irq_exit(); // softirq urgent: kesilen thread yerine hemen o çalışır
+    else
+        work_queue_run_pending();
+}
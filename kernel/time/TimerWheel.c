@@ -0,0 +1,321 @@
+#include <time/TimerWheel.h>
+#include <time/timer.h>
+#include <task/WorkQueue.h>
+#include <arch.h>
+
+// Kök çark 256 ms'yi tek tek, her üst seviye 64 kat daha geniş aralığı tutar:
+// 8 + 4 * 6 = 32 bit (~49 gün). Daha uzak vadeler en üst seviyenin son
+// yuvasına kısılır ve vadeleri gelmeden tekrar yerleştirilir.
+#define TW_ROOT_BITS   8
+#define TW_LEVEL_BITS  6
+#define TW_ROOT_SIZE   (1u << TW_ROOT_BITS)
+#define TW_LEVEL_SIZE  (1u << TW_LEVEL_BITS)
+#define TW_ROOT_MASK   (TW_ROOT_SIZE - 1)
+#define TW_LEVEL_MASK  (TW_LEVEL_SIZE - 1)
+#define TW_LEVELS      4
+#define TW_MAX_SPAN    0xFFFFFFFFull
+
+#define TW_LEVEL_INDEX(clock, n) \
+    ((size_t)(((clock) >> (TW_ROOT_BITS + (n) * TW_LEVEL_BITS)) & TW_LEVEL_MASK))
+
+static KTimer* s_root[TW_ROOT_SIZE];
+static KTimer* s_levels[TW_LEVELS][TW_LEVEL_SIZE];
+
+// Vadesi gelmiş, callback'i softirq'da çalışacak zamanlayıcılar (FIFO)
+static KTimer* s_expired_head = NULL;
+static KTimer** s_expired_tail = &s_expired_head;
+
+static uint64_t s_clock = 0;        // Çarkın işleyeceği sıradaki ms
+static bool s_clock_valid = false;
+static size_t s_armed = 0;          // Çarktaki zamanlayıcı sayısı
+
+static void timer_wheel_run_expired(void* arg);
+static WorkItem s_expire_work = WORK_ITEM_INIT(timer_wheel_run_expired, NULL, WORK_PRIO_HIGH);
+
+static inline void slot_link(KTimer** slot, KTimer* timer)
+{
+    timer->next = *slot;
+    if (*slot) (*slot)->pprev = &timer->next;
+    *slot = timer;
+    timer->pprev = slot;
+}
+
+static inline void timer_unlink(KTimer* timer)
+{
+    if (timer->next) timer->next->pprev = timer->pprev;
+    else if (timer->expired) s_expired_tail = timer->pprev;
+    *timer->pprev = timer->next;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// Kesmeler kapalıyken çağrılır
+static void wheel_insert(KTimer* timer)
+{
+    if (!s_clock_valid)
+    {
+        s_clock = uptimeMs;
+        s_clock_valid = true;
+    }
+
+    uint64_t expires = timer->expires;
+    KTimer** slot;
+
+    if (expires < s_clock)
+    {
+        // Zaten geçmiş: bir sonraki tick'te çalışsın
+        slot = &s_root[s_clock & TW_ROOT_MASK];
+    }
+    else
+    {
+        uint64_t delta = expires - s_clock;
+        if (delta > TW_MAX_SPAN)
+        {
+            delta = TW_MAX_SPAN;
+            expires = s_clock + delta;
+        }
+
+        if (delta < TW_ROOT_SIZE)
+        {
+            slot = &s_root[expires & TW_ROOT_MASK];
+        }
+        else
+        {
+            size_t level = 0;
+            while (level + 1 < TW_LEVELS && delta >= (1ull << (TW_ROOT_BITS + (level + 1) * TW_LEVEL_BITS)))
+                level++;
+            slot = &s_levels[level][TW_LEVEL_INDEX(expires, level)];
+        }
+    }
+
+    slot_link(slot, timer);
+    s_armed++;
+}
+
+// Üst seviyedeki bir yuvayı boşaltıp zamanlayıcıları alt seviyelere dağıt
+static size_t wheel_cascade(size_t level, size_t index)
+{
+    KTimer* timer = s_levels[level][index];
+    s_levels[level][index] = NULL;
+
+    while (timer)
+    {
+        KTimer* next = timer->next;
+        s_armed--;
+        wheel_insert(timer);
+        timer = next;
+    }
+    return index;
+}
+
+static void expired_append(KTimer* timer)
+{
+    timer->expired = true;
+    timer->next = NULL;
+    timer->pprev = s_expired_tail;
+    *s_expired_tail = timer;
+    s_expired_tail = &timer->next;
+}
+
+void timer_wheel_tick(void)
+{
+    uint64_t now = uptimeMs;
+    bool fired = false;
+
+    if (!s_clock_valid || s_armed == 0)
+    {
+        // Boş çarkı adım adım ilerletmeye gerek yok
+        s_clock = now + 1;
+        s_clock_valid = true;
+        return;
+    }
+
+    while (s_clock <= now)
+    {
+        size_t index = (size_t)(s_clock & TW_ROOT_MASK);
+
+        // Kök çark döndü: bir üst seviyenin sıradaki yuvasını indir (gerekirse zincirleme)
+        if (index == 0)
+        {
+            for (size_t level = 0; level < TW_LEVELS; level++)
+            {
+                if (wheel_cascade(level, TW_LEVEL_INDEX(s_clock, level)) != 0)
+                    break;
+            }
+        }
+
+        KTimer* timer = s_root[index];
+        s_root[index] = NULL;
+        uint64_t current = s_clock;
+        s_clock++;
+
+        while (timer)
+        {
+            KTimer* next = timer->next;
+            s_armed--;
+            if (timer->expires > current)
+            {
+                // Aralık dışına kısılmış uzak vade
+                wheel_insert(timer);
+            }
+            else
+            {
+                expired_append(timer);
+                fired = true;
+            }
+            timer = next;
+        }
+    }
+
+    if (fired) work_queue_post(&s_expire_work);
+}
+
+uint64_t timer_wheel_next_expiry(void)
+{
+    if (s_expired_head) return uptimeMs;
+    if (!s_clock_valid || s_armed == 0) return UINT64_MAX;
+
+    uint64_t next = UINT64_MAX;
+
+    // Kök çarkta ilk dolu yuva tam vadeyi verir
+    for (size_t i = 0; i < TW_ROOT_SIZE; i++)
+    {
+        uint64_t when = s_clock + i;
+        if (s_root[when & TW_ROOT_MASK])
+        {
+            next = when;
+            break;
+        }
+
+        // Kök çark dönmeden önce bakılacak kadarı yeter; sonrası cascade ile gelir
+        if (((when + 1) & TW_ROOT_MASK) == 0)
+            break;
+    }
+
+    // Üst seviyelerde yuvanın indirileceği (cascade) an, vadeden önce ya da ona eşittir
+    for (size_t level = 0; level < TW_LEVELS; level++)
+    {
+        size_t shift = TW_ROOT_BITS + level * TW_LEVEL_BITS;
+        // s_clock bir sınırın tam üstündeyse o yuva henüz indirilmedi
+        size_t first = (s_clock & ((1ull << shift) - 1)) == 0 ? 0 : 1;
+        for (size_t i = first; i <= TW_LEVEL_SIZE; i++)
+        {
+            uint64_t when = ((s_clock >> shift) + i) << shift;
+            if (when >= next) break;
+            if (s_levels[level][TW_LEVEL_INDEX(when, level)])
+            {
+                next = when;
+                break;
+            }
+        }
+    }
+
+    // Kök çarkın dönüş anı da bir cascade noktasıdır
+    uint64_t wrap = (s_clock | TW_ROOT_MASK) + 1;
+    for (size_t i = (size_t)(wrap & TW_ROOT_MASK); i < TW_ROOT_SIZE && wrap + i < next; i++)
+    {
+        if (s_root[(wrap + i) & TW_ROOT_MASK])
+        {
+            next = wrap + i;
+            break;
+        }
+    }
+
+    return next;
+}
+
+static void timer_wheel_run_expired(void* arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        size_t flags = arch_irq_save();
+
+        KTimer* timer = s_expired_head;
+        if (!timer)
+        {
+            arch_irq_restore(flags);
+            return;
+        }
+        timer_unlink(timer);
+        timer->expired = false;
+
+        // Periyodik: callback kendini iptal edebilsin diye önce yeniden kur.
+        // Kaçırılan periyotlar biriktirilmez.
+        if (timer->period_ms)
+        {
+            uint64_t next = timer->expires + timer->period_ms;
+            if (next <= uptimeMs) next = uptimeMs + timer->period_ms;
+            timer->expires = next;
+            wheel_insert(timer);
+        }
+
+        KTimerFunc func = timer->func;
+        void* func_arg = timer->arg;
+        arch_irq_restore(flags);
+
+        if (func) func(timer, func_arg);
+    }
+}
+
+void ktimer_init(KTimer* timer, KTimerFunc func, void* arg)
+{
+    if (!timer) return;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->period_ms = 0;
+    timer->expired = false;
+    timer->func = func;
+    timer->arg = arg;
+}
+
+static bool ktimer_detach(KTimer* timer)
+{
+    if (!timer->pprev) return false;
+
+    bool in_wheel = !timer->expired;
+    timer_unlink(timer);
+    timer->expired = false;
+    if (in_wheel) s_armed--;
+    return true;
+}
+
+void ktimer_arm_at(KTimer* timer, uint64_t expires_ms, uint32_t period_ms)
+{
+    if (!timer) return;
+
+    size_t flags = arch_irq_save();
+    ktimer_detach(timer);
+    timer->expires = expires_ms;
+    timer->period_ms = period_ms;
+    wheel_insert(timer);
+    arch_irq_restore(flags);
+}
+
+void ktimer_start_oneshot(KTimer* timer, uint32_t delay_ms)
+{
+    ktimer_arm_at(timer, uptimeMs + delay_ms, 0);
+}
+
+void ktimer_start_periodic(KTimer* timer, uint32_t period_ms)
+{
+    if (period_ms == 0) period_ms = 1;
+    ktimer_arm_at(timer, uptimeMs + period_ms, period_ms);
+}
+
+bool ktimer_cancel(KTimer* timer)
+{
+    if (!timer) return false;
+
+    size_t flags = arch_irq_save();
+    bool was_pending = ktimer_detach(timer);
+    arch_irq_restore(flags);
+    return was_pending;
+}
+
+bool ktimer_pending(const KTimer* timer)
+{
+    return timer && timer->pprev != NULL;
+}
@@ -0,0 +1,192 @@
+#include <time/clock.h>
+#include <debug/debug.h>
+#include <arch.h>
+
+#define NS_PER_SEC          1000000000ull
+#define CLOCK_CALIBRATE_MS  10
+
+// PIT kanal 2 (hoparlör kapısı) ile kalibrasyon
+#define PIT_BASE_FREQ       1193182u
+#define PIT_CH2_PORT        0x42
+#define PIT_MODE_PORT       0x43
+#define PIT_GATE_PORT       0x61
+
+static ClockSource s_source = CLOCK_SOURCE_UPTIME;
+static HardwareTimer* s_hpet = NULL;
+static uint64_t s_cycles_hz = 0;
+static uint64_t s_base_cycles = 0;  // time_now_ns() == 0 anı (uptimeMs ile hizalı)
+
+// ns = cycles * s_to_ns_mult >> s_to_ns_shift, ters yön için de aynısı
+static uint32_t s_to_ns_mult = 1, s_to_ns_shift = 0;
+static uint32_t s_to_cyc_mult = 1, s_to_cyc_shift = 0;
+
+static const char* const s_source_names[] = { "uptime", "hpet", "tsc" };
+
+// 64x32 çarpımın üst bitlerini taşmadan al (shift <= 32)
+static inline uint64_t mul_u64_u32_shr(uint64_t value, uint32_t mult, uint32_t shift)
+{
+    uint64_t lo = (uint64_t)(uint32_t)value * mult;
+    uint64_t hi = (uint64_t)(uint32_t)(value >> 32) * mult;
+    if (shift == 0) return lo + (hi << 32);
+    return (lo >> shift) + (hi << (32 - shift));
+}
+
+// from Hz'lik birimi to Hz'e çeviren, 32 bite sığan en hassas mult/shift
+static void clock_calc_mult_shift(uint64_t from, uint64_t to, uint32_t* mult, uint32_t* shift)
+{
+    for (uint32_t sft = 32; sft > 0; sft--)
+    {
+        uint64_t m = ((to << sft) + from / 2) / from;
+        if ((to << sft) >> sft == to && m <= 0xFFFFFFFFull)
+        {
+            *mult = (uint32_t)m;
+            *shift = sft;
+            return;
+        }
+    }
+    *mult = (uint32_t)(to / from);
+    *shift = 0;
+}
+
+static bool clock_tsc_present(bool* invariant)
+{
+    size_t a, b, c, d;
+    arch_cpuid(1, &a, &b, &c, &d);
+    if (!(d & (1u << 4))) return false;
+
+    arch_cpuid(0x80000000u, &a, &b, &c, &d);
+    *invariant = false;
+    if ((uint32_t)a >= 0x80000007u)
+    {
+        arch_cpuid(0x80000007u, &a, &b, &c, &d);
+        *invariant = (d & (1u << 8)) != 0;
+    }
+    return true;
+}
+
+static uint64_t clock_calibrate_tsc_hpet(void)
+{
+    uint64_t ns0 = s_hpet->read_ns();
+    uint64_t tsc0 = arch_rdtsc();
+    uint64_t target = ns0 + CLOCK_CALIBRATE_MS * 1000000ull;
+
+    uint64_t ns1;
+    while ((ns1 = s_hpet->read_ns()) < target)
+        __asm__ __volatile__("pause");
+    uint64_t tsc1 = arch_rdtsc();
+
+    return (tsc1 - tsc0) * NS_PER_SEC / (ns1 - ns0);
+}
+
+static uint64_t clock_calibrate_tsc_pit(void)
+{
+    uint32_t latch = PIT_BASE_FREQ * CLOCK_CALIBRATE_MS / 1000;
+
+    // Kapı açık, hoparlör kapalı; kanal 2 mod 0 (terminal count'ta OUT=1)
+    outb(PIT_GATE_PORT, (uint8_t)((inb(PIT_GATE_PORT) & ~0x02) | 0x01));
+    outb(PIT_MODE_PORT, 0xB0);
+    outb(PIT_CH2_PORT, (uint8_t)(latch & 0xFF));
+    outb(PIT_CH2_PORT, (uint8_t)(latch >> 8));
+
+    uint64_t tsc0 = arch_rdtsc();
+    uint32_t spins = 0;
+    while (!(inb(PIT_GATE_PORT) & 0x20))
+    {
+        if (++spins > 100000000u) return 0; // Kanal 2 çalışmıyor
+    }
+    uint64_t tsc1 = arch_rdtsc();
+
+    return (tsc1 - tsc0) * 1000 / CLOCK_CALIBRATE_MS;
+}
+
+void clock_init(HardwareTimer* hpet)
+{
+    size_t flags = arch_irq_save();
+
+    // Yeniden kalibrasyonda (örn. HPET açıldıktan sonra) zaman geri gitmesin
+    uint64_t continue_ns = time_now_ns();
+    s_source = CLOCK_SOURCE_UPTIME;
+
+    s_hpet = (hpet && hpet->read_ns) ? hpet : NULL;
+
+    bool invariant = false;
+    bool tsc = clock_tsc_present(&invariant);
+
+    if (tsc && (invariant || !s_hpet))
+    {
+        s_cycles_hz = s_hpet ? clock_calibrate_tsc_hpet() : clock_calibrate_tsc_pit();
+        if (s_cycles_hz)
+        {
+            if (!invariant) WARN("clock: TSC is not invariant and there is no HPET, using it anyway");
+            s_source = CLOCK_SOURCE_TSC;
+        }
+    }
+
+    if (s_source != CLOCK_SOURCE_TSC && s_hpet)
+    {
+        s_source = CLOCK_SOURCE_HPET;
+        s_cycles_hz = NS_PER_SEC;
+    }
+
+    if (s_source == CLOCK_SOURCE_UPTIME)
+    {
+        arch_irq_restore(flags);
+        WARN("clock: no TSC or HPET, time_now_ns() has millisecond resolution");
+        return;
+    }
+
+    clock_calc_mult_shift(s_cycles_hz, NS_PER_SEC, &s_to_ns_mult, &s_to_ns_shift);
+    clock_calc_mult_shift(NS_PER_SEC, s_cycles_hz, &s_to_cyc_mult, &s_to_cyc_shift);
+
+    // uptimeMs (ya da önceki kaynak) ile aynı sıfır noktasından devam et
+    uint64_t now = (s_source == CLOCK_SOURCE_TSC) ? arch_rdtsc() : s_hpet->read_ns();
+    s_base_cycles = now - clock_ns_to_cycles(continue_ns);
+
+    arch_irq_restore(flags);
+
+    LOG("clock: source %s, %llu.%03llu MHz%s", s_source_names[s_source],
+        (unsigned long long)(s_cycles_hz / 1000000), (unsigned long long)(s_cycles_hz / 1000 % 1000),
+        (s_source == CLOCK_SOURCE_TSC && invariant) ? " (invariant)" : "");
+}
+
+ClockSource clock_source(void)
+{
+    return s_source;
+}
+
+const char* clock_source_name(void)
+{
+    return s_source_names[s_source];
+}
+
+uint64_t clock_cycles_hz(void)
+{
+    return s_source == CLOCK_SOURCE_UPTIME ? 1000 : s_cycles_hz;
+}
+
+uint64_t time_now_cycles(void)
+{
+    switch (s_source)
+    {
+    case CLOCK_SOURCE_TSC:  return arch_rdtsc() - s_base_cycles;
+    case CLOCK_SOURCE_HPET: return s_hpet->read_ns() - s_base_cycles;
+    default:                return uptimeMs;
+    }
+}
+
+uint64_t clock_cycles_to_ns(uint64_t cycles)
+{
+    if (s_source == CLOCK_SOURCE_UPTIME) return cycles * 1000000ull;
+    return mul_u64_u32_shr(cycles, s_to_ns_mult, s_to_ns_shift);
+}
+
+uint64_t clock_ns_to_cycles(uint64_t ns)
+{
+    if (s_source == CLOCK_SOURCE_UPTIME) return ns / 1000000ull;
+    return mul_u64_u32_shr(ns, s_to_cyc_mult, s_to_cyc_shift);
+}
+
+uint64_t time_now_ns(void)
+{
+    return clock_cycles_to_ns(time_now_cycles());
+}
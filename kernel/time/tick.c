@@ -0,0 +1,99 @@
+#include <time/tick.h>
+#include <time/TimerWheel.h>
+#include <task/Thread.h>
+#include <debug/debug.h>
+#include <arch.h>
+
+#define NS_PER_MS 1000000ull
+
+static HardwareTimer* s_tick_timer = NULL;
+static bool s_tickless = false;
+static bool s_nohz_idle = false;    // Idle'da, tick durduruldu
+static uint64_t s_base_ns = 0;      // uptimeMs == 0 anındaki sayaç değeri
+static uint64_t s_nohz_idle_count = 0;
+
+static inline void tick_update_uptime(void)
+{
+    uint64_t now = s_tick_timer->read_ns();
+    uint64_t ms = (now - s_base_ns) / NS_PER_MS;
+    if (ms > uptimeMs) uptimeMs = ms; // Monotonluk: geri gitmesin
+}
+
+static void tick_program_ms(uint64_t deadline_ms)
+{
+    if (deadline_ms <= uptimeMs) deadline_ms = uptimeMs + 1;
+
+    // Sürücü geçmiş vadeyi kendisi en kısa süreye yuvarlar
+    if (s_tick_timer->set_oneshot(s_base_ns + deadline_ms * NS_PER_MS) != 0)
+        WARN("tick: one-shot programming failed");
+}
+
+static uint64_t tick_next_event_ms(void)
+{
+    uint64_t next = timer_wheel_next_expiry();
+    uint64_t wake = scheduler_next_wake_ms();
+    if (wake < next) next = wake;
+
+    uint64_t limit = uptimeMs + TICK_NOHZ_MAX_SLEEP_MS;
+    return next < limit ? next : limit;
+}
+
+static void tick_handler(void)
+{
+    if (s_tickless) tick_update_uptime();
+    else uptimeMs++;
+
+    scheduler_tick();
+    timer_wheel_tick();
+
+    if (s_tickless)
+        tick_program_ms(s_nohz_idle ? tick_next_event_ms() : uptimeMs + 1);
+}
+
+bool tick_init(HardwareTimer* timer)
+{
+    if (!timer) return false;
+    s_tick_timer = timer;
+
+    if (timer->read_ns && timer->set_oneshot)
+    {
+        // uptimeMs kaldığı yerden devam etsin
+        s_base_ns = timer->read_ns() - uptimeMs * NS_PER_MS;
+        s_tickless = true;
+        timer->add_callback(tick_handler);
+        tick_program_ms(uptimeMs + 1);
+        LOG("tick: %s one-shot, tickless idle enabled", timer->name);
+    }
+    else
+    {
+        timer->setFrequency(TICK_HZ);
+        timer->add_callback(tick_handler);
+        LOG("tick: %s periodic at %u Hz", timer->name, TICK_HZ);
+    }
+    return true;
+}
+
+bool tick_is_tickless(void)
+{
+    return s_tickless;
+}
+
+void tick_nohz_idle_enter(void)
+{
+    if (!s_tickless) return;
+
+    tick_update_uptime();
+    s_nohz_idle = true;
+    s_nohz_idle_count++;
+    tick_program_ms(tick_next_event_ms());
+}
+
+void tick_nohz_idle_exit(void)
+{
+    if (!s_nohz_idle) return;
+    s_nohz_idle = false;
+
+    // Uyurken geçen zamanı yakala, periyodik tick'i geri getir
+    tick_update_uptime();
+    tick_program_ms(uptimeMs + 1);
+}
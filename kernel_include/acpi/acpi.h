@@ -149,7 +149,9 @@ typedef struct ACPI_PACKED {
     acpi_gas XGpe1Block;
 } ACPI_FADT;
 
-/* Basit ACPI init ve tablo erişim fonksiyonları */
+/* Basit ACPI init ve tablo erişim fonksiyonları.
+ * Dönen tablolar heap kopyalarıdır (ACPI reclaimable bellek PMM'e geri verilir);
+ * XSDT/RSDT yalnızca acpi_init sırasında taranır ve sonrasında NULL döner. */
 void acpi_init(void);
 const struct acpi_sdt_header* acpi_get_xsdt(void);
 const struct acpi_sdt_header* acpi_get_rsdt(void);
@@ -157,6 +159,7 @@ const struct acpi_madt* acpi_get_madt(void);
 const struct acpi_sdt_header* acpi_get_fadt(void);
 const struct acpi_hpet* acpi_get_hpet(void);
 const struct acpi_sdt_header* acpi_get_mcfg(void);
+const struct acpi_sdt_header* acpi_get_dsdt(void);
 
 extern size_t acpi_version; /* ACPI sürümü (1.0, 2.0, 3.0, 4.0, 5.0, 6.0) */
 
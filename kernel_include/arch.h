@@ -142,6 +142,36 @@ extern void arch_cpuid(uint32_t leaf, size_t* regA, size_t* regB, size_t* regC,
 
 extern void arch_bios_int(uint8_t int_no, arch_processor_regs_t* in, arch_processor_regs_t* out);
 
+/* Disable interrupts and return the previous flags register; restore
+ * re-enables them only if they were enabled before (nests safely). */
+static inline size_t arch_irq_save(void)
+{
+    size_t flags;
+    __asm__ __volatile__("pushf\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void arch_irq_restore(size_t flags)
+{
+    if (flags & (1u << 9))
+        __asm__ __volatile__("sti" : : : "memory");
+}
+
+static inline bool arch_irq_enabled(void)
+{
+    size_t flags;
+    __asm__ __volatile__("pushf\n\tpop %0" : "=r"(flags));
+    return (flags & (1u << 9)) != 0;
+}
+
+/* Time-stamp counter (not serializing; callers needing ordering fence themselves). */
+static inline uint64_t arch_rdtsc(void)
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
 /* -------------------------------------------------------------------------- */
 /* Paging Memory Type / Attribute Control (architecture-level interface)      */
 /* -------------------------------------------------------------------------- */
@@ -186,6 +216,122 @@ void arch_tlb_flush_one(void* addr);
 /* Invalidate entire TLB by reloading CR3 (fallback for large batches) */
 void arch_tlb_flush_all(void);
 
+/* -------------------------------------------------------------------------- */
+/* Kernel virtual area (vmalloc / vmap backend)                               */
+/* -------------------------------------------------------------------------- */
+
+/* Return the VA window reserved for vmalloc/vmap above the identity map.
+ * false -> paging is not active on this architecture (virt == phys). */
+bool arch_vmm_get_window(uintptr_t* out_start, uintptr_t* out_end);
+
+/* Map count 4 KiB pages starting at virt (must be inside the window).
+ * Entries were not present before, so no TLB invalidation is done. */
+bool arch_vmm_map_pages(uintptr_t virt, const uintptr_t* phys_pages, size_t count,
+                        arch_paging_memtype_t type);
+
+/* Unmap count pages starting at virt. Old physical addresses are written to
+ * out_phys (may be NULL). The TLB is invalidated once for the whole batch on
+ * every online CPU before returning, so the pages may be freed afterwards. */
+void arch_vmm_unmap_pages(uintptr_t virt, size_t count, uintptr_t* out_phys);
+
+/* Translate a kernel virtual address, 0 if not mapped. */
+uintptr_t arch_vmm_translate(uintptr_t virt);
+
+/* -------------------------------------------------------------------------- */
+/* Kernel FPU / SIMD state                                                    */
+/* -------------------------------------------------------------------------- */
+
+/* Probe the state save method (XSAVEOPT > XSAVE > FXSAVE > FNSAVE) and the
+ * state size for the XCR0 set up by enable_cpu_simd. Safe to call repeatedly. */
+void fpu_init(void);
+
+/* Bracket kernel code that touches x87/SSE/AVX registers. The caller's
+ * vector state is saved into a per-CPU, per-nesting-level area and restored
+ * by kernel_fpu_end, so IRQ handlers may nest their own begin/end pairs.
+ * IRQ handlers themselves need no bracket: every IRQ stub calls its handler
+ * through irq_fpu_call (kernel/<arch>/irq_fpu.asm), which saves the
+ * interrupted vector state on the stack using the method in fpu_irq_method. */
+#define FPU_MAX_NESTING   4      /* thread -> IRQ -> nested IRQ */
+#define FPU_AREA_SIZE     1024   /* x87+SSE+AVX XSAVE area is 832 bytes (no AVX-512) */
+#define FPU_NEST_BYTES    (FPU_MAX_NESTING * FPU_AREA_SIZE)  /* per CPU, 64-byte aligned */
+void kernel_fpu_begin(void);
+void kernel_fpu_end(void);
+extern uint32_t fpu_irq_method;
+
+/* Explicit save/restore for context switching. The area must be
+ * fpu_state_size() bytes and 64-byte aligned. */
+size_t fpu_state_size(void);
+void fpu_save(void* area);
+void fpu_restore(const void* area);
+
+/* -------------------------------------------------------------------------- */
+/* Kernel thread context switch                                               */
+/* -------------------------------------------------------------------------- */
+
+/* Push callee-saved registers + flags, store the stack pointer in *old_sp
+ * and resume the frame saved at new_sp. Call with interrupts disabled. */
+void arch_context_switch(size_t* old_sp, size_t new_sp);
+
+/* Entry point placed as the return address of a new thread's first frame;
+ * aligns the stack and calls thread_bootstrap(). */
+void arch_thread_trampoline(void);
+
+/* -------------------------------------------------------------------------- */
+/* Per-CPU descriptor tables (SMP)                                            */
+/* -------------------------------------------------------------------------- */
+
+#ifdef ARCH_AMD
+typedef struct __attribute__((packed)) {
+    uint32_t reserved0;
+    uint64_t rsp[3];
+    uint64_t reserved1;
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iomap_base;
+} arch_tss_t;
+#else
+typedef struct __attribute__((packed)) {
+    uint32_t prev_task;
+    uint32_t esp0, ss0;
+    uint32_t esp1, ss1;
+    uint32_t esp2, ss2;
+    uint32_t cr3, eip, eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} arch_tss_t;
+#endif
+
+#define ARCH_GDT_ENTRIES   10
+#define ARCH_GDT_TSS_SEL   0x28    /* Boot GDT'deki TSS yuvası (amd64'te 2 giriş) */
+#define ARCH_GDT_PERCPU_SEL 0x40   /* i386: FS için taban adresi per-CPU blok olan veri segmenti */
+
+typedef struct {
+    uint64_t gdt[ARCH_GDT_ENTRIES];
+    arch_tss_t tss;
+} arch_cpu_tables_t;
+
+/* Copy the boot GDT into tables, add this CPU's TSS (and on i386 the per-CPU
+ * data segment), then load GDT/TR/IDT on the calling CPU and point GS base
+ * (amd64) or FS (i386) at percpu. Call with interrupts disabled. */
+void arch_cpu_tables_load(arch_cpu_tables_t* tables, void* percpu);
+
+/* First word of the per-CPU block, read through GS/FS. Only valid after
+ * arch_cpu_tables_load ran on this CPU. */
+static inline void* arch_percpu_self(void)
+{
+    void* self;
+#ifdef ARCH_AMD
+    __asm__ __volatile__("mov %%gs:0, %0" : "=r"(self));
+#else
+    __asm__ __volatile__("mov %%fs:0, %0" : "=r"(self));
+#endif
+    return self;
+}
+
 
 #ifdef __cplusplus
 }
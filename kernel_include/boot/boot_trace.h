@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Açılış profili. __boot_kernel_start her aşamanın sonunda boot_trace_mark
+ * çağırır; aşamanın süresi bir önceki işaretten bu yanadır. Sürücü
+ * init/enable çağrıları ve mount'lar boot_trace_begin/end ile iç içe span
+ * olarak kaydedilir. Zaman damgaları ham TSC'dir, heap ve saat kaynağı
+ * hazır olmadan da çalışır; ns'ye çeviri boot_trace_finish'te yapılır.
+ *
+ * boot_trace_finish rapor metnini bir kez üretip loglar; sonradan
+ * boot_trace_report ile okunabilir. Kök dosya sistemi o anda bağlıysa, değilse
+ * finish'ten sonraki ilk başarılı VFS_Mount'ta BOOT_TRACE_FILE'a bir kez yazılır.
+ * Kayıt her bağlamdan (executor görevleri, fiber'lar) yapılabilir; girinti her
+ * bağlamın kendi açık span'lerine göredir. finish'ten sonra çağrılar etkisizdir.
+ */
+
+#define BOOT_TRACE_MAX_EVENTS  128
+#define BOOT_TRACE_NAME_MAX    32
+#define BOOT_TRACE_NONE        0xFFFFFFFFu
+#define BOOT_TRACE_FILE        "/boot_trace.txt"
+
+// __boot_kernel_start'ın ilk satırı: sıfır anı
+void boot_trace_start(void);
+
+// Bir önceki işaretten bu yana geçen süreyi 'stage' adıyla kaydet
+void boot_trace_mark(const char* stage);
+
+// İç içe span; tag NULL olabilir ("init", "enable", "mount" ...)
+uint32_t boot_trace_begin(const char* tag, const char* name);
+void boot_trace_end(uint32_t span);
+
+// Kaydı kapatır ve süreye göre sıralı dökümü loglar
+void boot_trace_finish(void);
+bool boot_trace_finished(void);
+
+// boot_trace_finish'ten sonra rapor metni, öncesinde NULL
+const char* boot_trace_report(void);
+bool boot_trace_save(const char* path);
+
+// VFS_Mount başarıyla bitince çağırır; rapor henüz kaydedilmediyse kaydeder
+void boot_trace_on_mount(void);
+
+#ifdef __cplusplus
+}
+#endif
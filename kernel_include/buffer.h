@@ -46,6 +46,7 @@ bool buffer_is_empty(Buffer* buffer);
 int buffer_push_copy(Buffer* buffer, const void* data);
 BufferNode* buffer_pop_node(Buffer* buffer);
 void buffer_free_node(BufferNode* node);
+void buffer_free_data(void* data);  // buffer_pop() ile alınan veriyi serbest bırak
 
 // Iterator functions
 BufferNode* buffer_iterator_begin(Buffer* buffer);
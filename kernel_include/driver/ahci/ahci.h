@@ -69,13 +69,22 @@ typedef volatile struct {
 #define HBA_PxCMD_FR   (1u << 14)
 #define HBA_PxCMD_CR   (1u << 15)
 
-// PxIS Task File Error Status
-#define HBA_PxIS_TFES  (1u << 30)
+// PxIS bits
+#define HBA_PxIS_SDBS  (1u << 3)   // Set Device Bits FIS (NCQ completion)
+#define HBA_PxIS_IFS   (1u << 27)  // Interface Fatal Error
+#define HBA_PxIS_HBDS  (1u << 28)  // Host Bus Data Error
+#define HBA_PxIS_HBFS  (1u << 29)  // Host Bus Fatal Error
+#define HBA_PxIS_TFES  (1u << 30)  // Task File Error Status
+#define HBA_PxIS_ERRORS (HBA_PxIS_IFS | HBA_PxIS_HBDS | HBA_PxIS_HBFS | HBA_PxIS_TFES)
 
 // PxTFD bits
 #define HBA_PxTFD_BSY  (1u << 7)
 #define HBA_PxTFD_DRQ  (1u << 3)
 
+// CAP bits
+#define HBA_CAP_NCS(x) ((((x) >> 8) & 0x1Fu) + 1u) // Number of command slots
+#define HBA_CAP_SNCQ   (1u << 30)  // Supports Native Command Queuing
+
 // GHC bits
 #define HBA_GHC_HR     (1u << 0)   // HBA reset
 #define HBA_GHC_IE     (1u << 1)   // Interrupt enable (global)
@@ -118,16 +127,32 @@ typedef struct {
     uint32_t dbc_i;   // [21:0]dbc (byte count-1), [31] ioc
 } __attribute__((packed)) hba_prdt_entry_t;
 
+// PRDT entries per command table: 128-byte header + 248 * 16 = one 4 KiB page
+#define AHCI_PRDT_ENTRIES   248
+#define AHCI_PRDT_MAX_BYTES (4u * 1024 * 1024) // 22-bit DBC, even byte count
+
 typedef struct {
     uint8_t  cfis[64];   // Command FIS
     uint8_t  acmd[16];   // ATAPI command (not used for ATA)
     uint8_t  rsv[48];
-    hba_prdt_entry_t prdt[1]; // We use a single PRDT for simple transfers
+    hba_prdt_entry_t prdt[AHCI_PRDT_ENTRIES]; // scatter-gather list
 } __attribute__((packed)) hba_cmd_table_t;
 
 // FIS types and structures
 #define FIS_TYPE_REG_H2D 0x27
 
+// ATA commands issued through the command slots
+#define ATA_CMD_READ_DMA_EXT        0x25
+#define ATA_CMD_WRITE_DMA_EXT       0x35
+#define ATA_CMD_READ_FPDMA_QUEUED   0x60  // NCQ: count in FEATURE, tag in COUNT[7:3]
+#define ATA_CMD_WRITE_FPDMA_QUEUED  0x61
+#define ATA_CMD_READ_LOG_EXT        0x2F  // LBA[7:0] = log address, LBA[15:8] = page
+#define ATA_CMD_FLUSH_CACHE         0xE7
+#define ATA_CMD_FLUSH_CACHE_EXT     0xEA
+
+#define ATA_LOG_NCQ_ERROR           0x10  // NCQ Command Error log; reading it clears the error
+#define ATA_LOG_NCQ_NQ              0x80  // byte 0: the failed command was not queued
+
 typedef struct {
     // DWORD 0
     uint8_t fis_type; // 0x27
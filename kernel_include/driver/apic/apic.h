@@ -11,16 +11,40 @@ extern "C" {
 
 /* LAPIC register offsets (MMIO) */
 #define LAPIC_REG_ID            0x020
+#define LAPIC_REG_TPR           0x080
 #define LAPIC_REG_EOI           0x0B0
 #define LAPIC_REG_SVR           0x0F0
+#define LAPIC_REG_ICR_LOW       0x300
+#define LAPIC_REG_ICR_HIGH      0x310
 #define LAPIC_REG_LVT_TIMER     0x320
 #define LAPIC_REG_LVT_LINT0     0x350
 #define LAPIC_REG_LVT_LINT1     0x360
 #define LAPIC_REG_LVT_ERROR     0x370
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE  0x3E0
 
 /* LAPIC SVR bits */
 #define LAPIC_SVR_APIC_ENABLE   (1u << 8)
 
+/* ICR (low dword) bits */
+#define LAPIC_ICR_FIXED         (0u << 8)
+#define LAPIC_ICR_INIT          (5u << 8)
+#define LAPIC_ICR_STARTUP       (6u << 8)
+#define LAPIC_ICR_PENDING       (1u << 12)
+#define LAPIC_ICR_ASSERT        (1u << 14)
+#define LAPIC_ICR_LEVEL         (1u << 15)
+
+/* LVT bits */
+#define LAPIC_LVT_MASKED        (1u << 16)
+#define LAPIC_TIMER_PERIODIC    (1u << 17)
+#define LAPIC_TIMER_DIV_16      0x3u
+
+/* Legacy IRQ'ler 32..47'de, spurious 0xFF; yerel vektörler bunların arasında */
+#define LAPIC_TIMER_VECTOR      0xF0
+#define LAPIC_IPI_WAKE_VECTOR   0xF1
+#define LAPIC_IPI_TLB_VECTOR    0xF2
+
 /* IOAPIC MMIO offsets relative to IOAPIC base */
 #define IOAPIC_MMIO_IOREGSEL    0x00
 #define IOAPIC_MMIO_IOWIN       0x10
@@ -62,6 +86,17 @@ uint32_t lapic_read(uint32_t reg);
 void lapic_write(uint32_t reg, uint32_t value);
 uint8_t lapic_get_id(void);
 
+/* IPI: ICR'ye yazar ve teslim edilene kadar (en fazla ~10 ms) bekler */
+bool lapic_send_ipi(uint8_t apic_id, uint32_t icr_low);
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uintptr_t entry_phys); // entry_phys: 4 KiB hizalı, < 1 MiB
+
+/* LAPIC zamanlayıcısı. Kalibrasyon bir kez (BSP'de, clock_init sonrası) yapılır;
+ * tüm çekirdeklerin LAPIC'leri aynı veri yolu saatiyle sayar. */
+uint32_t lapic_timer_calibrate(void);          // bölücü 16 ile saniyedeki tick
+void lapic_timer_start_periodic(uint8_t vector, uint32_t hz);
+void lapic_timer_stop(void);
+
 void ioapic_set_base(uintptr_t phys, uint32_t gsi_base);
 uint32_t ioapic_read(uint32_t reg);
 void ioapic_write(uint32_t reg, uint32_t value);
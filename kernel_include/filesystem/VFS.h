@@ -159,6 +159,10 @@ void       VFS_CacheDumpStats(void);
 VFSResult  VFS_RegisterFileSystem(VFSFileSystem* fs);
 VFSFileSystem* VFS_GetFileSystem(const char* name);
 
+// Node storage for filesystem drivers (slab-backed; pair Alloc with Free)
+VFSNode*   VFS_AllocNode(void);
+void       VFS_FreeNode(VFSNode* node);
+
 // Mount management
 VFSMount*  VFS_Mount(const char* target, VFSFileSystem* fs, const VFSMountParams* params);
 VFSMount*  VFS_MountAuto(const char* target, const VFSMountParams* params);
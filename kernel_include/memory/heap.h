@@ -8,13 +8,26 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#define HEAP_REGION_PMM  (1u << 0)  // Heap büyürken PMM'den alındı, boşalınca geri verilebilir
+
 typedef struct HeapRegion
 {
     size_t base;
     size_t size;
     struct HeapRegion* next;
+    uint32_t flags;
 } HeapRegion;
 
+typedef struct HeapStats
+{
+    size_t total_bytes;     // Tüm bölgelerin toplam boyutu
+    size_t free_bytes;      // Serbest bloklardaki payload toplamı
+    size_t region_count;
+    size_t pmm_bytes;       // PMM'den büyütülerek alınmış bölgelerin toplamı
+    size_t grow_count;
+    size_t release_count;
+} HeapStats;
+
 void heap_init();
 
 void* heap_alloc(size_t size);
@@ -23,6 +36,37 @@ void* heap_realloc(void* ptr, size_t size);
 void* heap_calloc(size_t count, size_t size);
 void* heap_aligned_alloc(size_t alignment, size_t size);
 
+// Ek bir bellek alanini heap'e ekle (region, heap'ten ayrilmamis kalici bir yerde durmali)
+void heap_register_region(HeapRegion* region);
+
+// Tamamen boşalan PMM bölgeleri, heap'te en az bu kadar serbest bellek
+// kalacaksa PMM'e geri verilir (varsayılan: HEAP_DEFAULT_RELEASE_WATERMARK)
+void heap_set_release_watermark(size_t bytes);
+void heap_get_stats(HeapStats* out_stats);
+
+// malloc gibi sarmalayıcılar tahsisi kendi çağıranına yazdırmak için
+// dönüş adreslerini bu varyantlarla iletir (profil kapalıyken site yok sayılır)
+void* heap_alloc_from(size_t size, void* site);
+void* heap_realloc_from(void* ptr, size_t size, void* site);
+void* heap_calloc_from(size_t count, size_t size, void* site);
+void* heap_aligned_alloc_from(size_t alignment, size_t size, void* site);
+
+/*
+ * Çağrı noktası bazlı heap profili (HEAPPROF=1 veya DEBUG=1 derlemelerinde).
+ * Her site için tahsis/serbest sayısı, toplam ve canlı bayt tutulur; raporlar
+ * UART'a yazılır. Site adresleri addr2line ile kaynağa çevrilebilir.
+ */
+typedef struct HeapProfSnapshot HeapProfSnapshot;
+
+bool heap_prof_enabled(void);
+// Canlı bayta göre en büyük top_n siteyi yazdır
+void heap_prof_dump(size_t top_n);
+// O anki canlı sayaçların kopyası (profil kapalıysa NULL)
+HeapProfSnapshot* heap_prof_snapshot(void);
+void heap_prof_snapshot_free(HeapProfSnapshot* snapshot);
+// before -> after arasında canlı baytı artan siteleri yazdır (after NULL: şimdiki durum)
+void heap_prof_diff(const HeapProfSnapshot* before, const HeapProfSnapshot* after, size_t top_n);
+
 #ifdef __cplusplus
 }
 #endif
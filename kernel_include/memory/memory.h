@@ -14,6 +14,13 @@ extern void* realloc(void* ptr, size_t size);
 extern void* calloc(size_t count, size_t size);
 extern void* malloc_aligned(size_t alignment, size_t size);
 
+// Bellek yöneticilerinin (heap, pmm, slab, vmm) ortak kilidi. Kesmeleri kapatır
+// ve CPU'lar arasında dışlama sağlar; aynı CPU iç içe alabilir (heap -> pmm,
+// heap içinden LOG -> journald -> realloc).
+size_t mm_lock(void);
+void mm_unlock(size_t flags);
+bool mm_lock_held(void);
+
 extern void memcpy(void* dest, const void* src, size_t n);
 
 extern void memset(void* ptr, char value, size_t num);
@@ -35,12 +35,28 @@ typedef struct MemoryRegion {
 // Ard arda gelen USABLE blokları birleştir 
 void pmm_maintain();
 
-// Fiziksel bellekten blok tahsis et
+// Fiziksel bellekten blok tahsis et (sayfaya yuvarlanır, 4 KiB hizalı)
 void* pmm_alloc(size_t sizeInKB);
 
-// Fiziksel bellekteki bloğu serbest bırak
+// 2^order sayfalık, kendi boyutuna hizalı blok tahsis et
+void* pmm_alloc_pages(size_t order);
+
+// Fiziksel bellekteki bloğu serbest bırak (pmm_alloc / pmm_alloc_pages sonucu)
 void pmm_free(void* ptr);
 
+// Daha önce rezerve edilmiş bir aralığı buddy allocator'a ekle
+// (ör. ExitBootServices sonrası EFI boot services bölgeleri).
+// Multiboot2 bilgi bloğu ve modül atlanır; eklenen byte sayısını döner.
+size_t pmm_release_region(size_t base, size_t size);
+
+// Loader (EFI_LOADER_*) ve ACPI_RECLAIMABLE bölgelerini PMM'e devret.
+// acpi_init tabloları kopyaladıktan sonra çağrılmalı.
+size_t pmm_reclaim_boot_memory(void);
+size_t pmm_get_reclaimed_bytes(void);
+
+size_t pmm_get_free_bytes(void);
+size_t pmm_get_total_bytes(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
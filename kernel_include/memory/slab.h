@@ -0,0 +1,48 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sabit boyutlu kernel nesneleri için slab cache.
+// Her slab, PMM'den alınan (PMM hazır değilse heap'ten) kendi boyutuna hizalı
+// bir sayfa bloğudur; nesnenin slab başlığı adres maskelenerek bulunur.
+typedef struct KmemCache KmemCache;
+
+typedef struct KmemCacheStats {
+    const char* name;
+    size_t object_size;       // Hizalanmış nesne boyutu
+    size_t objects_per_slab;
+    size_t slab_bytes;
+    size_t slab_count;
+    size_t active_objects;    // Şu an kullanımda olan nesneler
+    size_t total_objects;     // slab_count * objects_per_slab
+    size_t alloc_count;
+    size_t free_count;
+} KmemCacheStats;
+
+// align == 0 -> pointer hizası
+KmemCache* kmem_cache_create(const char* name, size_t object_size, size_t align);
+void       kmem_cache_destroy(KmemCache* cache);
+
+// *slot boşsa cache'i bir kez oluşturup yazar; eşzamanlı ilk çağıranlar aynı
+// cache'i alır. Tembel oluşturulan cache'ler bununla açılmalı.
+KmemCache* kmem_cache_get(KmemCache** slot, const char* name, size_t object_size, size_t align);
+
+void* kmem_cache_alloc(KmemCache* cache);
+void* kmem_cache_zalloc(KmemCache* cache);
+void  kmem_cache_free(KmemCache* cache, void* object);
+
+// Boş slab'ları sayfa ayırıcıya geri ver
+void  kmem_cache_shrink(KmemCache* cache);
+
+void  kmem_cache_get_stats(KmemCache* cache, KmemCacheStats* out_stats);
+void  kmem_cache_dump_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
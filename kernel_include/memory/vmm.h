@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch.h>
+
+// Kernel sanal bellek alanı (vmalloc/vmap).
+// Büyük tamponlar fiziksel olarak dağınık sayfalardan, identity map'in
+// üstündeki sanal pencerede sürekli görünecek şekilde eşlenir. Paging'in
+// kapalı olduğu mimarilerde (i386) fiziksel olarak sürekli bloklara düşer.
+
+typedef struct VmmStats {
+    size_t area_count;
+    size_t mapped_pages;      // Pencerede eşlenmiş sayfalar
+    size_t fallback_bytes;    // Pencere/PMM yokken sürekli bloklardan verilen bellek
+    size_t window_bytes;      // Pencerenin boyutu (0: pencere yok)
+} VmmStats;
+
+// Sayfa sayısına yuvarlanmış, sanal olarak sürekli bellek
+void* vmalloc(size_t size);
+void* vzalloc(size_t size);
+void  vfree(void* addr);
+
+// Verilen fiziksel sayfaları sürekli bir sanal aralığa eşle (sayfalar çağırana ait kalır)
+void* vmap(const uintptr_t* phys_pages, size_t count, arch_paging_memtype_t type);
+void  vunmap(void* addr);
+
+// addr bir vmalloc/vmap alanına ait mi?
+bool  vmm_is_vmalloc_addr(const void* addr);
+
+// DMA için: addr'dan başlayan, fiziksel olarak sürekli en uzun parçanın
+// (en fazla len) uzunluğu ve *out_phys'e başlangıcı. Identity map'teki
+// bellekte len'in tamamıdır; vmalloc'ta sayfa sınırlarında kesilebilir.
+// Çevrilemeyen adreste (vmap, eşlenmemiş pencere) 0.
+size_t vmm_dma_extent(const void* addr, size_t len, uintptr_t* out_phys);
+
+void  vmm_get_stats(VmmStats* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,37 @@ extern "C" {
 
 void sleep_ms(uint32_t milliseconds);
 
+// Kalibre edilmiş meşgul bekleme (time/clock.h). Saat kaynağı yoksa
+// io_wait (~1 us) sayılarak yaklaşık bekler.
+void ndelay(uint32_t ns);
+void udelay(uint32_t us);
+void mdelay(uint32_t ms);
+
+/*
+ * Zamana bağlı yoklama. Örnek:
+ *
+ *     WaitDeadline wait;
+ *     wait_deadline_start(&wait, 500000);
+ *     while ((p->cmd & HBA_PxCMD_CR) && wait_deadline_poll(&wait)) ;
+ *
+ * İlk WAIT_SPIN_US boyunca pause ile döner; sonra thread bağlamında uyur,
+ * kesmeler açıksa hlt ile bir sonraki kesmeyi bekler, değilse dönmeye devam eder.
+ * Fiber içinde başka hazır fiber varsa her yoklamada önce sıra ona geçer.
+ */
+#define WAIT_SPIN_US 100
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t timeout_ns;
+    uint32_t polls;
+} WaitDeadline;
+
+void wait_deadline_start(WaitDeadline* wait, uint32_t timeout_us);
+// Süre dolduysa false; değilse bir sonraki yoklamaya kadar bekleyip true döner
+bool wait_deadline_poll(WaitDeadline* wait);
+
+// cond true olana ya da süre dolana kadar bekle; son durumu döndürür
+bool wait_until(bool (*cond)(void* arg), void* arg, uint32_t timeout_us);
 
 #ifdef __cplusplus
 }
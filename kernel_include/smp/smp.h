@@ -0,0 +1,110 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <arch.h>
+
+/*
+ * Çok işlemcili başlatma. MADT'deki her etkin LAPIC için bir AP, INIT-SIPI-SIPI
+ * ile SMP_TRAMPOLINE_ADDR'deki gerçek mod kodundan başlatılır. Her CPU'nun
+ * kendi PerCpu bloğu (GS tabanı / FS segmenti), GDT+TSS'i ve LAPIC
+ * zamanlayıcısı vardır. Zamanlayıcı şimdilik yalnızca BSP'de çalışır; AP'ler
+ * hlt döngüsünde bekler, smp_call_on_cpu ile iş alabilir ve uyanınca
+ * smp_set_idle_work ile kaydedilen işi (task/Executor) çalıştırır.
+ */
+
+#define SMP_MAX_CPUS          32
+#define SMP_TRAMPOLINE_ADDR   0x8000    // ap_trampoline.asm AP_BASE ile aynı; < 1 MiB, PMM'e verilmez
+#define SMP_AP_STACK_SIZE     (16 * 1024)
+#define SMP_AP_TIMER_HZ       100
+
+typedef void (*SmpCallFunc)(void* arg);
+
+struct PerCpu;
+
+// İş yaptıysa true döner; döngü hlt'ye girmeden yeniden çağırır
+typedef bool (*SmpIdleFunc)(struct PerCpu* cpu);
+
+typedef struct PerCpu {
+    struct PerCpu* self;            // GS:0 / FS:0; this_cpu() buradan okur, ilk alan kalmalı
+    uint32_t id;                    // Mantıksal numara, BSP = 0
+    uint8_t lapic_id;
+    uint8_t acpi_id;
+    volatile bool online;
+
+    volatile uint64_t lapic_ticks;
+    volatile uint64_t idle_wakeups;
+
+    // hlt'de uyuyor; smp_wake_cpu yalnızca bu durumda IPI gönderir
+    volatile bool idle;
+    // smp_wake_cpu her çağrıda artırır; hlt'ye girmeden önce değiştiyse döngü yeniden bakar
+    volatile uint32_t wake_seq;
+
+    // Boştaki çekirdeğe verilen tek iş yuvası (smp_call_on_cpu)
+    volatile uint32_t call_busy;
+    SmpCallFunc volatile call_func;
+    void* volatile call_arg;
+
+    // smp_tlb_shootdown bu CPU'dan onay bekliyor
+    volatile uint32_t tlb_pending;
+
+    struct FiberContext* fibers;    // Zamanlayıcı dışındaki fiber'lar (task/Fiber.c)
+
+    // kernel_fpu_begin/end iç içe kayıt alanları (FPU_NEST_BYTES, kernel/fpu.c)
+    uint8_t* fpu_nest_areas;
+    uint32_t fpu_nest_depth;
+
+    void* stack;                    // AP: SMP_AP_STACK_SIZE; BSP: NULL (boot yığını)
+    arch_cpu_tables_t tables;       // Kendi GDT'si ve TSS'i
+} PerCpu;
+
+// BSP'nin PerCpu bloğunu ve tablolarını kur; this_cpu() bundan sonra geçerli
+void smp_bsp_init(void);
+
+// APIC etkinleştirildikten ve clock_init'ten sonra: AP'leri başlatır,
+// çevrimiçi CPU sayısını döndürür
+uint32_t smp_init(void);
+
+uint32_t smp_cpu_count(void);
+PerCpu* smp_cpu(uint32_t id);       // id >= smp_cpu_count() ise NULL
+
+static inline PerCpu* this_cpu(void)
+{
+    return (PerCpu*)arch_percpu_self();
+}
+
+// func'ı id numaralı CPU'da, onun idle döngüsünden çalıştırır. Yuva doluysa
+// (önceki iş henüz alınmadıysa) false döner. Çağıran CPU'nun kendisi için
+// func hemen çalıştırılır.
+bool smp_call_on_cpu(uint32_t id, SmpCallFunc func, void* arg);
+
+// AP idle döngüsünün her turda, kesmeler açıkken çağıracağı iş (NULL = yok)
+void smp_set_idle_work(SmpIdleFunc func);
+
+// id numaralı AP'ye "yeni iş var" de. CPU hlt'deyse IPI gönderir ve true döner;
+// hlt'ye girmek üzereyse wake_seq değiştiği için uyumadan işe yeniden bakar.
+bool smp_wake_cpu(uint32_t id);
+
+// Tüm çevrimiçi CPU'larda va'dan başlayan count sayfanın TLB girdilerini geçersiz
+// kılar (count == 0: tüm TLB) ve her CPU onaylayana kadar bekler; dönüşten sonra
+// eski eşlemenin sayfaları serbest bırakılabilir. Başka bir CPU'nun
+// kesmeler kapalı dönebileceği bir kilit tutulurken çağrılabilir: spin_lock
+// beklerken bekleyen isteği kendisi yerine getirir (smp_tlb_poll).
+void smp_tlb_shootdown(uintptr_t va, size_t count);
+
+// Bir shootdown sürerken sıfırdan farklı; kilit bekleyen döngüler bakar
+extern volatile uint32_t smp_tlb_active;
+
+// Bu CPU'dan bekleyen TLB isteği varsa yerine getir ve onayla
+void smp_tlb_poll(void);
+
+void smp_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <arch.h>
+#include <smp/smp.h>
+
+/*
+ * Çekirdekler arası kilitler. IRQ handler'ı ile paylaşılan veride _irqsave
+ * sürümleri kullanılmalı: kilit tutulurken aynı CPU'ya gelen bir kesme aynı
+ * kilidi beklerse sonsuza dek döner.
+ *
+ * RecursiveSpinlock aynı CPU'nun kilidi yeniden almasına izin verir (ör. heap
+ * içinden LOG -> journald -> realloc). Sahip this_cpu()->id ile tutulduğu için
+ * yalnızca smp_bsp_init'ten sonra kullanılabilir.
+ */
+
+typedef struct {
+    volatile uint32_t locked;
+} Spinlock;
+
+#define SPINLOCK_INIT { 0 }
+
+#define SPINLOCK_NO_OWNER 0xFFFFFFFFu
+
+typedef struct {
+    Spinlock lock;
+    volatile uint32_t owner;    // Tutan CPU'nun id'si, SPINLOCK_NO_OWNER = serbest
+    uint32_t depth;
+} RecursiveSpinlock;
+
+#define RECURSIVE_SPINLOCK_INIT { SPINLOCK_INIT, SPINLOCK_NO_OWNER, 0 }
+
+static inline void cpu_relax(void)
+{
+    __asm__ __volatile__("pause" ::: "memory");
+}
+
+static inline void spin_init(Spinlock* lock)
+{
+    lock->locked = 0;
+}
+
+static inline bool spin_trylock(Spinlock* lock)
+{
+    return __sync_lock_test_and_set(&lock->locked, 1) == 0;
+}
+
+static inline void spin_lock(Spinlock* lock)
+{
+    // Test-and-test-and-set: beklerken önbellek satırını yalnızca oku. Kesmeler
+    // kapalı beklenebileceği için TLB shootdown IPI'ı burada elle karşılanır.
+    while (!spin_trylock(lock)) {
+        while (lock->locked) {
+            if (smp_tlb_active) smp_tlb_poll();
+            cpu_relax();
+        }
+    }
+}
+
+static inline void spin_unlock(Spinlock* lock)
+{
+    __sync_lock_release(&lock->locked);
+}
+
+static inline size_t spin_lock_irqsave(Spinlock* lock)
+{
+    size_t flags = arch_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(Spinlock* lock, size_t flags)
+{
+    spin_unlock(lock);
+    arch_irq_restore(flags);
+}
+
+static inline bool rspin_held(const RecursiveSpinlock* lock)
+{
+    return lock->owner == this_cpu()->id;
+}
+
+// Kesmeler kapalı döner; kilit alınamazsa kesme durumu geri yüklenir
+static inline bool rspin_trylock_irqsave(RecursiveSpinlock* lock, size_t* flags)
+{
+    *flags = arch_irq_save();
+    uint32_t me = this_cpu()->id;
+    if (lock->owner == me) {
+        lock->depth++;
+        return true;
+    }
+    if (!spin_trylock(&lock->lock)) {
+        arch_irq_restore(*flags);
+        return false;
+    }
+    lock->owner = me;
+    lock->depth = 1;
+    return true;
+}
+
+static inline size_t rspin_lock_irqsave(RecursiveSpinlock* lock)
+{
+    size_t flags = arch_irq_save();
+    uint32_t me = this_cpu()->id;
+    if (lock->owner == me) {
+        lock->depth++;
+        return flags;
+    }
+    spin_lock(&lock->lock);
+    lock->owner = me;
+    lock->depth = 1;
+    return flags;
+}
+
+static inline void rspin_unlock_irqrestore(RecursiveSpinlock* lock, size_t flags)
+{
+    if (--lock->depth == 0) {
+        lock->owner = SPINLOCK_NO_OWNER;
+        spin_unlock(&lock->lock);
+    }
+    arch_irq_restore(flags);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,8 +5,10 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <list.h>
+#include <spinlock.h>
 
 typedef enum {
     BLKDEV_TYPE_DISK = 0,  // Fixed or removable block device (HDD/SSD)
@@ -14,14 +16,131 @@ typedef enum {
     BLKDEV_TYPE_VIRTUAL = 2
 } BlockDeviceType;
 
+// BlockDevice.flags
+#define BLKDEV_FLAG_QUEUED  (1u << 0)  // Driver queues/locks internally; io_busy is skipped
+
 struct BlockDevice;
+struct Thread;
+
+/*
+ * Asynchronous requests. The submitter fills op/lba/count/sg (or uses
+ * BlockRequest_Init for a single buffer), optionally a completion callback,
+ * and calls BlockDevice_Submit; several requests may be outstanding at once
+ * and are collected with BlockDevice_Wait/WaitAll. Drivers with a native
+ * submit op complete requests from their IRQ handler or poll op; for the
+ * others BlockDevice_Submit runs the request synchronously through
+ * read/write/flush before returning.
+ *
+ * The request and its buffers must stay valid until completion. Buffers are
+ * DMA targets: word aligned, and each segment a multiple of the block size.
+ *
+ * Reads and writes pass through a per-device queue (BlockQueue) before the
+ * driver sees them: contiguous requests are merged front and back into one
+ * command, and the queue dispatches in LBA order (one-way elevator) unless a
+ * request's deadline has expired. Requests that are in flight together are
+ * not ordered against each other. FLUSH bypasses the queue and covers the
+ * writes that have completed. Submit from thread context only.
+ */
+typedef enum {
+    BLKREQ_READ = 0,
+    BLKREQ_WRITE,
+    BLKREQ_FLUSH
+} BlockRequestOp;
+
+// BlockRequest.flags
+#define BLKREQ_FLAG_READAHEAD  (1u << 0)  // Speculative read; nobody is waiting for it yet
+#define BLKREQ_FLAG_NOWAIT     (1u << 1)  // Set by the queue: ops->submit must decline rather than wait
+
+// BlockRequest.status
+#define BLKREQ_PENDING   0
+#define BLKREQ_OK        1
+#define BLKREQ_ERROR   (-1)
+
+#define BLKREQ_WAIT_SLICE_MS 10  // A sleeping waiter re-polls the device this often
+
+typedef struct BlockSegment {
+    void* buffer;
+    uint32_t bytes;
+} BlockSegment;
+
+typedef struct BlockRequest BlockRequest;
+typedef void (*BlockRequestDone)(BlockRequest* req);
+
+struct BlockRequest {
+    // Set by the submitter
+    BlockRequestOp op;
+    uint32_t flags;              // BLKREQ_FLAG_*
+    uint64_t lba;
+    uint32_t count;              // Logical blocks; the segments cover exactly this much
+    BlockSegment* sg;
+    uint32_t sg_count;
+    BlockRequestDone done;       // Optional; may run in IRQ context, must not block
+    void* private_data;
+
+    // Owned by the block layer and the driver while the request is in flight
+    volatile int32_t status;     // BLKREQ_PENDING until completion
+    struct BlockDevice* dev;
+    struct Thread* volatile waiter;
+    volatile uint32_t pending;   // Driver: commands in flight plus the submit reference
+    volatile bool failed;        // Driver: one of the commands failed
+    BlockRequest* next;          // Driver queue link; block queue LBA order before dispatch
+    BlockSegment inline_sg;      // sg storage for BlockRequest_Init
+
+    // Block queue merge state (first request of a chain carries the totals)
+    BlockRequest* merge_next;
+    BlockRequest* merge_tail;
+    uint32_t merge_blocks;
+    uint32_t merge_segs;
+    uint64_t deadline_ns;
+    volatile bool queued;        // Not yet handed to the driver
+    bool no_merge;               // Retried on its own after a merged command failed
+};
+
+// Byte cursor over a request's segment list, for drivers building PRD tables
+typedef struct BlockSegIter {
+    const BlockSegment* sg;
+    uint32_t count;
+    uint32_t idx;
+    uint32_t off;
+} BlockSegIter;
 
 typedef struct BlockDeviceOps {
     bool (*read)(struct BlockDevice* dev, uint64_t lba, uint32_t count, void* buffer);
     bool (*write)(struct BlockDevice* dev, uint64_t lba, uint32_t count, const void* buffer);
     bool (*flush)(struct BlockDevice* dev);
+    // Optional native async path. Returning true hands the request over: the
+    // driver calls BlockRequest_Complete exactly once. Returning false (e.g. a
+    // buffer the DMA engine cannot reach) makes the block layer run it synchronously.
+    bool (*submit)(struct BlockDevice* dev, BlockRequest* req);
+    // Optional: reap completions when interrupts are not (yet) delivered
+    void (*poll)(struct BlockDevice* dev);
 } BlockDeviceOps;
 
+// Request queue limits and deadlines
+#define BLKQ_MAX_MERGE_BYTES  (512u * 1024u)  // Largest command built by merging
+#define BLKQ_MAX_SEGMENTS     32              // Segments in a merged command
+#define BLKQ_PLUG_MAX         32              // A plugged queue dispatches anyway at this many
+#define BLKQ_READ_EXPIRE_MS   50
+#define BLKQ_WRITE_EXPIRE_MS  500             // Also used for read-ahead
+#define BLKQ_DEFAULT_DEPTH    2               // Commands in flight for drivers with submit
+
+struct BlockQueueUnit;
+
+typedef struct BlockQueue {
+    Spinlock lock;               // irqsave: completions arrive in IRQ context
+    BlockRequest* sorted;        // Queued chains by LBA; merged requests hang off merge_next
+    uint32_t queued;             // Chains in sorted
+    uint32_t inflight;           // Units handed to the driver (or deferred)
+    uint32_t depth;              // Units allocated; at most this many in flight
+    uint32_t plugged;            // BlockDevice_Plug nesting
+    uint64_t next_lba;           // Elevator position: end of the last dispatch
+    bool running;                // One context dispatches at a time
+    struct BlockQueueUnit* free_units;
+    struct BlockQueueUnit* deferred; // Declined by the driver in IRQ context; run synchronously later
+    uint64_t merges;
+    uint64_t dispatched;
+} BlockQueue;
+
 typedef struct BlockDevice {
     const char* name;
     BlockDeviceType type;
@@ -29,6 +148,10 @@ typedef struct BlockDevice {
     uint64_t total_blocks;       // total logical blocks
     const BlockDeviceOps* ops;   // function table
     void* driver_ctx;            // driver-private context
+    uint32_t flags;              // BLKDEV_FLAG_*; set by the driver after registering
+    volatile uint32_t io_busy;   // serializes driver calls across CPUs (executor tasks); held while sleeping
+    struct Thread* volatile io_waiter; // woken when io_busy is released
+    BlockQueue queue;            // Merging/elevator queue in front of ops
 } BlockDevice;
 
 // Registry API
@@ -48,6 +171,30 @@ bool BlockDevice_Read(BlockDevice* dev, uint64_t lba, uint32_t count, void* buff
 bool BlockDevice_Write(BlockDevice* dev, uint64_t lba, uint32_t count, const void* buffer);
 bool BlockDevice_Flush(BlockDevice* dev);
 
+// Commands the queue keeps in flight; drivers that queue internally raise it
+// after registering (default BLKQ_DEFAULT_DEPTH with submit, else 1)
+bool BlockDevice_SetQueueDepth(BlockDevice* dev, uint32_t depth);
+
+// Hold back dispatch while a batch is submitted so neighbours can merge.
+// Nests; the last Unplug dispatches. Waiting on a held request also unplugs.
+void BlockDevice_Plug(BlockDevice* dev);
+void BlockDevice_Unplug(BlockDevice* dev);
+
+// Async requests
+void BlockRequest_Init(BlockRequest* req, BlockRequestOp op, uint64_t lba, uint32_t count, void* buffer);
+// false: invalid request (status is BLKREQ_ERROR, the callback is not called)
+bool BlockDevice_Submit(BlockDevice* dev, BlockRequest* req);
+bool BlockDevice_Wait(BlockRequest* req);
+bool BlockDevice_WaitAll(BlockRequest* reqs, size_t count);
+// Drivers: finish a request handed over by ops->submit
+void BlockRequest_Complete(BlockRequest* req, bool ok);
+
+void BlockSegIter_Init(BlockSegIter* it, const BlockSegment* sg, uint32_t count);
+// Physically contiguous run of at most max bytes at the cursor; 0 at the end
+// or when the buffer is not DMA-mappable
+uint32_t BlockSegIter_Extent(const BlockSegIter* it, uint32_t max, uintptr_t* out_phys);
+void BlockSegIter_Advance(BlockSegIter* it, uint32_t bytes);
+
 #ifdef __cplusplus
 }
 #endif
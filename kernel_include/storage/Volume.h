@@ -42,6 +42,8 @@ uint64_t Volume_StartLBA(const Volume* volume);
 
 bool Volume_ReadSectors(Volume* volume, uint64_t lba, uint32_t count, void* buffer);
 bool Volume_WriteSectors(Volume* volume, uint64_t lba, uint32_t count, const void* buffer);
+// req->lba is volume-relative and is rebased to the device on submit
+bool Volume_SubmitSectors(Volume* volume, BlockRequest* req);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * İş çalan (work-stealing) çok çekirdekli görev yürütücü. Her CPU'nun kendi
+ * Chase-Lev deque'si vardır: sahibi alttan push/pop yapar (LIFO, veri
+ * önbellekte sıcak), boştaki CPU'lar üstten çalar (en eski görev). AP'ler
+ * görevleri smp idle döngüsünden çalıştırır; task_join'de bekleyen CPU da
+ * beklerken görev çalıştırır, bu yüzden iç içe spawn/join kilitlenmez.
+ *
+ * Görevler bağımsız, kısa ömürlü işler içindir. AP'lerde zamanlayıcı yoktur:
+ * görev uyuyamaz, beklemeler meşgul bekleme olur (sleep.h bunu kendisi seçer).
+ * IRQ handler'larından spawn edilmemeli.
+ */
+
+#define EXECUTOR_DEQUE_SIZE  256    // 2'nin kuvveti; dolunca görev çağıranda hemen çalışır
+
+typedef void (*TaskFunc)(void* arg);
+
+typedef struct Task Task;
+
+// smp_init'ten sonra. Tek CPU varsa false döner; görevler spawn anında çalışır.
+bool executor_init(void);
+bool executor_is_running(void);
+
+// func(arg)'ı çağıran CPU'nun deque'sine koyar ve uyuyan bir AP'yi uyandırır.
+// NULL dönerse görev çağıranda zaten çalışmıştır (yürütücü yok, deque dolu
+// ya da bellek yetmedi); task_join(NULL) geçerlidir.
+Task* task_spawn(TaskFunc func, void* arg);
+
+// Görev bitene kadar bekler, bu sırada başka görevleri çalıştırır. Task'ı
+// serbest bırakır; her spawn edilen görev tam bir kez join edilmeli.
+void task_join(Task* task);
+
+void executor_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
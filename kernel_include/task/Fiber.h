@@ -0,0 +1,57 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Tek çekirdek üzerinde işbirlikçi (cooperative) fiber'lar. Uzun donanım
+ * beklemeleri olan sürücü dizileri (port reset, IDENTIFY, kanal probe) her
+ * biri kendi fiber'ında yazılır; bekleme noktalarında diğerine geçilir,
+ * böylece aynı CPU'da gecikmeleri üst üste biner.
+ *
+ * Fiber'lar oluşturuldukları bağlamda (thread; zamanlayıcı yoksa CPU)
+ * fiber_run_all çağrılınca çalışır ve hepsi bitince o döner. Geçiş yalnızca
+ * fiber_yield'da olur: wait_deadline_poll, udelay/mdelay ve fiber_wait_event
+ * fiber içindeyken dönmek yerine sırayı bırakır, sürücü kodu değişmeden
+ * fiber'da çalışabilir. Bir fiber'ın içinden yeni fiber oluşturulabilir;
+ * aynı fiber_run_all'a katılır.
+ *
+ * Yığınlar küçüktür (FIBER_STACK_SIZE) ve havuzdan verilir; Fiber
+ * tanımlayıcısı yığın bloğunun tepesinde durur, ayrı tahsis yoktur.
+ * Spinlock tutarken beklenmemeli: sıra aynı kilidi isteyen fiber'a geçerse
+ * CPU kendini bekler (ör. BlockDevice_Read'i fiber'lardan çağırmayın).
+ */
+
+#define FIBER_STACK_SIZE   (8 * 1024)
+#define FIBER_STACK_POOL   8        // Havuzda tutulan en fazla boş yığın
+
+typedef void (*FiberFunc)(void* arg);
+
+typedef struct Fiber Fiber;
+
+// Çağıranın bağlamında çalışmaya hazır bir fiber ekler; bellek yoksa NULL
+Fiber* fiber_create(const char* name, FiberFunc func, void* arg);
+
+// Bu bağlamın tüm fiber'ları bitene kadar onları sırayla çalıştırır
+void fiber_run_all(void);
+
+// Sırayı bir sonraki fiber'a bırak. Fiber dışındaysa ya da bekleyen başka
+// fiber yoksa geçiş yapmadan false döner; çağıran normal beklemesine devam eder.
+bool fiber_yield(void);
+
+// cond true olana ya da süre dolana kadar sırayı bırakarak bekler; son durumu
+// döndürür. Fiber dışında ya da tek fiber kaldığında wait_until gibi bekler.
+bool fiber_wait_event(bool (*cond)(void* arg), void* arg, uint32_t timeout_us);
+
+// Çalışan fiber (fiber dışında NULL)
+Fiber* fiber_current(void);
+const char* fiber_name(const Fiber* fiber);
+
+#ifdef __cplusplus
+}
+#endif
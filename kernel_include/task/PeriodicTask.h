@@ -7,15 +7,19 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <time/TimerWheel.h>
 
-
-typedef struct {
+typedef struct PeriodicTask {
     char* name;
     void(*taskFunction)(void* task, void* arg);
     void* arg;
     size_t intervalMs;
     uint64_t lastRunMs;
     bool running;
+
+    KTimer timer;               // Periyodik zamanlayıcı (çarkta)
+    bool due;                   // Worker kuyruğunda
+    struct PeriodicTask* dueNext;
 } PeriodicTask;
 
 PeriodicTask* periodic_task_create(const char* name, void(*taskFunction)(void* task, void* arg), void* arg, size_t intervalMs);
@@ -24,8 +28,13 @@ void periodic_task_stop(PeriodicTask* task);
 
 void periodic_task_destroy(PeriodicTask* task);
 
+// Vadesi gelmiş (kuyruktaki) görevleri çalıştır
 void periodic_task_run_all();
 
+// Görevleri çalıştıracak worker thread'i başlat (scheduler_init sonrası).
+// Worker yoksa görevler zamanlayıcı callback'inde (softirq) çalışır.
+bool periodic_task_init(void);
+
 #ifdef __cplusplus
 }
 #endif
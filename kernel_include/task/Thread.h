@@ -0,0 +1,79 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define THREAD_STACK_SIZE    (16 * 1024)
+#define THREAD_TIME_SLICE_MS 10        // Zamanlayıcı bu kadar tick sonra yeniden planlar
+#define THREAD_NAME_MAX      24
+
+typedef enum {
+    THREAD_READY = 0,
+    THREAD_RUNNING,
+    THREAD_SLEEPING,    // wake_ms'e kadar veya thread_wake ile
+    THREAD_BLOCKED,     // yalnızca thread_wake ile
+    THREAD_DEAD
+} ThreadState;
+
+typedef struct Thread {
+    size_t sp;                  // arch_context_switch'in kaydettiği yığın işaretçisi
+    uint32_t id;
+    char name[THREAD_NAME_MAX];
+    ThreadState state;
+
+    void (*entry)(void* arg);
+    void* arg;
+
+    void* stack;                // vmalloc; boot thread'inde NULL
+    void* fpu_state;            // fpu_state_size() bayt, 64 hizalı
+
+    uint64_t wake_ms;
+    bool wake_pending;          // Uyumadan önce gelen thread_wake kaybolmasın
+    bool urgent;                // Run queue'nun başına girer ve uyanınca hemen araya girer
+    uint64_t switch_count;
+
+    struct FiberContext* fibers;  // task/Fiber.c; fiber_run_all süresince
+
+    struct Thread* next;        // run queue / uyku listesi
+    struct Thread* all_next;    // tüm thread'ler
+} Thread;
+
+// Çağıran boot akışını "main" thread'ine çevirir ve idle thread'i oluşturur
+bool scheduler_init(void);
+bool scheduler_is_running(void);   // Çağıran CPU'da (yalnızca BSP) thread'ler çalışıyor mu
+
+// Zamanlayıcı IRQ'sundan (uptimeMs artırıldıktan sonra) çağrılır: uyuyanları
+// uyandırır ve zaman dilimini sayar. Geçiş yapmaz.
+void scheduler_tick(void);
+// En erken uyanacak thread'in vadesi (ms), yoksa UINT64_MAX. Kesmeler kapalıyken.
+uint64_t scheduler_next_wake_ms(void);
+// Zamanlayıcı IRQ'sunun sonunda, EOI gönderildikten sonra çağrılır;
+// gerekiyorsa kesilen thread'den başka bir thread'e geçer.
+void scheduler_irq_exit(void);
+
+Thread* thread_create(const char* name, void (*entry)(void* arg), void* arg);
+Thread* thread_current(void);
+void thread_yield(void);
+void thread_sleep_ms(uint32_t ms);
+void thread_sleep_until(uint64_t wake_ms);   // UINT64_MAX: thread_wake'e kadar
+void thread_block(void);
+void thread_wake(Thread* thread);
+void thread_exit(void) __attribute__((noreturn));
+
+// Bottom-half işçileri gibi gecikmeye duyarlı thread'ler için
+void thread_set_urgent(Thread* thread, bool urgent);
+
+// İç içe sayılır; sayaç sıfırken zamanlayıcı geçiş yapabilir
+void preempt_disable(void);
+void preempt_enable(void);
+
+void scheduler_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
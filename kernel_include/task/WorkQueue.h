@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Ertelenmiş iş (bottom half). ISR donanımı onaylar, gerekli veriyi alır ve
+ * kendi WorkItem'ını postlar; asıl işlem kesmeler açıkken "softirq" thread'inde
+ * öncelik sırasıyla yapılır. WorkItem'lar sahiplerinin içinde durur, post
+ * işlemi bellek ayırmaz.
+ */
+
+typedef enum {
+    WORK_PRIO_HIGH = 0,     // Giriş aygıtları, depolama tamamlanmaları
+    WORK_PRIO_NORMAL,
+    WORK_PRIO_LOW,
+    WORK_PRIO_COUNT
+} WorkPriority;
+
+typedef struct WorkItem {
+    void (*func)(void* arg);
+    void* arg;
+    uint8_t priority;
+    volatile bool pending;      // Kuyrukta; çalışmadan hemen önce temizlenir
+    struct WorkItem* next;
+} WorkItem;
+
+#define WORK_ITEM_INIT(fn, a, prio) { .func = (fn), .arg = (a), .priority = (prio), .pending = false, .next = NULL }
+
+void work_init(WorkItem* work, void (*func)(void* arg), void* arg, WorkPriority priority);
+
+// ISR'dan güvenle çağrılabilir. İş zaten bekliyorsa false döner (tek sefer çalışır).
+bool work_queue_post(WorkItem* work);
+
+// "softirq" thread'ini başlat (scheduler_init sonrası). Başlatılmazsa işler
+// work_queue_irq_exit içinde, kesmeler kapalıyken çalıştırılır.
+bool work_queue_init(void);
+
+// ISR sonunda, EOI gönderildikten sonra çağrılır
+void work_queue_irq_exit(void);
+
+// Bekleyen tüm işleri öncelik sırasıyla çalıştır
+void work_queue_run_pending(void);
+bool work_queue_has_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
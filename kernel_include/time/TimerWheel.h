@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Hiyerarşik zamanlama çarkı (ms çözünürlüklü, uptimeMs ile aynı saat).
+ * Kurma ve iptal O(1); tick başına iş yalnızca vadesi gelen zamanlayıcılarla
+ * orantılıdır. Callback'ler softirq thread'inde (WorkQueue, WORK_PRIO_HIGH)
+ * kesmeler açıkken çalışır; uzun işler kendi thread'ine devredilmeli.
+ */
+
+struct KTimer;
+typedef void (*KTimerFunc)(struct KTimer* timer, void* arg);
+
+typedef struct KTimer {
+    struct KTimer* next;
+    struct KTimer** pprev;      // İptal için: listedeki önceki bağlantı (NULL = kurulu değil)
+    uint64_t expires;           // Mutlak vade (uptimeMs)
+    uint32_t period_ms;         // 0 = tek seferlik
+    bool expired;               // Çarktan alındı, callback sırası bekliyor
+    KTimerFunc func;
+    void* arg;
+} KTimer;
+
+#define KTIMER_INIT(fn, a) { .next = NULL, .pprev = NULL, .expires = 0, .period_ms = 0, .expired = false, .func = (fn), .arg = (a) }
+
+void ktimer_init(KTimer* timer, KTimerFunc func, void* arg);
+
+// Kuruluysa önce iptal edilir. ISR dahil her bağlamdan çağrılabilir.
+void ktimer_start_oneshot(KTimer* timer, uint32_t delay_ms);
+void ktimer_start_periodic(KTimer* timer, uint32_t period_ms);
+void ktimer_arm_at(KTimer* timer, uint64_t expires_ms, uint32_t period_ms);
+
+// Bekliyorsa true döner. Callback o anda çalışıyorsa beklemez.
+bool ktimer_cancel(KTimer* timer);
+bool ktimer_pending(const KTimer* timer);
+
+// Tick ISR'ından, uptimeMs ilerletildikten sonra çağrılır
+void timer_wheel_tick(void);
+
+// En erken olası vade (ms); tahmin erken tarafa yuvarlanır. Boşsa UINT64_MAX.
+// Kesmeler kapalıyken çağrılmalı.
+uint64_t timer_wheel_next_expiry(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time/timer.h>
+
+/*
+ * Monoton saat kaynağı. Değişmez (invariant) TSC varsa açılışta HPET'e
+ * (yoksa PIT kanal 2'ye) göre kalibre edilip kullanılır; değilse HPET ana
+ * sayacı kullanılır. clock_init öncesinde ve hiçbiri yoksa uptimeMs'e düşer.
+ *
+ * "Cycle" etkin kaynağın birimidir (TSC'de CPU saati, HPET'te ns).
+ * Dönüşümler bölme içermez (mult/shift), i386'da da ucuzdur.
+ */
+
+typedef enum {
+    CLOCK_SOURCE_UPTIME = 0,    // uptimeMs (ms çözünürlük)
+    CLOCK_SOURCE_HPET,
+    CLOCK_SOURCE_TSC,
+} ClockSource;
+
+// hpet etkin zamanlayıcı değilse NULL geçilebilir; PIT kanal 2 ile kalibre edilir.
+// Tekrar çağrılabilir (HPET açıldıktan sonra); zaman kesintisiz devam eder.
+void clock_init(HardwareTimer* hpet);
+
+ClockSource clock_source(void);
+const char* clock_source_name(void);
+uint64_t clock_cycles_hz(void);
+
+uint64_t time_now_cycles(void);
+uint64_t time_now_ns(void);
+
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+uint64_t clock_ns_to_cycles(uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
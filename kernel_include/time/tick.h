@@ -0,0 +1,31 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time/timer.h>
+
+#define TICK_HZ                 1000
+#define TICK_NOHZ_MAX_SLEEP_MS  1000    // 32-bit sayaçların taşmasını kaçırmamak için üst sınır
+
+/*
+ * Sistem tick'i. Zamanlayıcı read_ns + set_oneshot destekliyorsa (HPET)
+ * tickless çalışır: uptimeMs serbest sayaçtan türetilir, meşgulken her ms
+ * için tek seferlik kesme kurulur, idle'da ise bir sonraki vadeye kadar
+ * (zamanlayıcı çarkı / uyuyan thread'ler) hiç kesme gelmez.
+ * Aksi halde TICK_HZ'de periyodik çalışır ve uptimeMs sayılarak ilerler.
+ */
+bool tick_init(HardwareTimer* timer);
+bool tick_is_tickless(void);
+
+// Idle thread'den, kesmeler kapalıyken hlt öncesi / idle'dan çıkarken
+void tick_nohz_idle_enter(void);
+void tick_nohz_idle_exit(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,6 +19,8 @@ typedef struct {
     int (*setFrequency)(uint32_t frequency); // Function to set the timer frequency
     void (*add_callback)(void (*callback)()); // Function to add a callback
     void (*remove_callback)(void (*callback)()); // Function to remove a callback
+    uint64_t (*read_ns)(); // Free-running counter in ns (optional, NULL if none)
+    int (*set_oneshot)(uint64_t deadline_ns); // Fire once at read_ns() deadline (optional)
 } HardwareTimer;
 
 typedef struct {
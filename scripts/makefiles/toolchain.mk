@@ -51,6 +51,12 @@ else
     CFLAGS_64 += -O2 -DNDEBUG
 endif
 
+# Per-callsite heap profiler (always on in DEBUG builds)
+ifdef HEAPPROF
+	CFLAGS_32 += -DHEAPPROF
+	CFLAGS_64 += -DHEAPPROF
+endif
+
 # Toolchain verification
 define verify_toolchain
 	@echo "Verifying cross-compilation toolchain..."